@@ -1,3 +1,8 @@
+newoption {
+   trigger = "no-profiler",
+   description = "Compile out the per-phase profiling instrumentation"
+}
+
 workspace "Transport-Sim"
    architecture "x64"
    startproject "Transport-Sim"
@@ -54,7 +59,11 @@ project "Transport-Sim"
       "vendor/glfw/src/null_init.c",        -- (REQUIRED for null platform stub)
       "vendor/glfw/src/null_monitor.c",
       "vendor/glfw/src/null_window.c",
-      "vendor/glfw/src/null_joystick.c"
+      "vendor/glfw/src/null_joystick.c",
+      "vendor/glfw/src/posix_module.c",       -- (empty on Windows) with the null platform above,
+      "vendor/glfw/src/posix_poll.c",         -- an offscreen-only build for Linux servers
+      "vendor/glfw/src/posix_thread.c",
+      "vendor/glfw/src/posix_time.c"
    }
 
    includedirs {
@@ -67,10 +76,6 @@ project "Transport-Sim"
       "src/"
    }
 
-   links {
-      "opengl32"
-   }
-
    filter "system:windows"
       systemversion "latest"
       defines {
@@ -78,6 +83,61 @@ project "Transport-Sim"
          "GLFW_BUILD_WIN32",
          "_CRT_SECURE_NO_WARNINGS"
       }
+      links {
+         "opengl32"
+      }
+
+   -- GL, EGL and OSMesa are all loaded at run time
+   filter "system:linux"
+      links {
+         "dl",
+         "pthread"
+      }
+
+   filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"
+
+   filter "options:no-profiler"
+      defines { "TS_ENABLE_PROFILER=0" }
+
+project "Transport-Sim-Bench"
+   location "Transport-Sim-Bench"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++20"
+   staticruntime "on"
+
+   targetdir ("bin/" .. outputdir)
+   objdir ("build/" .. outputdir .. "/bench")
+
+   -- Simulation and CPU-side mesh code only; no window or GL context
+   files {
+      "bench/**.cpp",
+      "bench/**.h",
+      "src/Simulation/**.cpp",
+      "src/Core/Compression.cpp",
+      "src/Core/Log.cpp",
+      "src/Core/MappedFile.cpp",
+      "src/Core/Profiler.cpp",
+      "src/Renderer/NetworkMesh.cpp"
+   }
+
+   includedirs {
+      "vendor/glm",
+      "src/",
+      "bench/"
+   }
+
+   filter "system:windows"
+      systemversion "latest"
+      defines {
+         "_CRT_SECURE_NO_WARNINGS"
+      }
 
    filter "configurations:Debug"
       defines { "DEBUG" }
@@ -86,3 +146,6 @@ project "Transport-Sim"
    filter "configurations:Release"
       defines { "NDEBUG" }
       optimize "On"
+
+   filter "options:no-profiler"
+      defines { "TS_ENABLE_PROFILER=0" }
@@ -0,0 +1,96 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+bool BenchmarkRunner::IsEnabled(const std::string& name) const {
+    return m_Options.filter.empty() || name.find(m_Options.filter) != std::string::npos;
+}
+
+BenchmarkResult* BenchmarkRunner::Run(const std::string& name, const Params& params,
+                                      const std::function<void()>& body,
+                                      const std::function<void()>& setup) {
+    if (!IsEnabled(name)) return nullptr;
+    
+    std::vector<double> samples;
+    double total = 0.0;
+    while ((int)samples.size() < m_Options.maxIterations &&
+           ((int)samples.size() < m_Options.minIterations || total < m_Options.minSeconds * 1.0e9)) {
+        if (setup) setup();
+        
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        samples.push_back(ns);
+        total += ns;
+    }
+    
+    BenchmarkResult result;
+    result.name = name;
+    result.params = params;
+    result.iterations = (int)samples.size();
+    result.meanNs = total / samples.size();
+    std::sort(samples.begin(), samples.end());
+    result.p50Ns = samples[(samples.size() - 1) / 2];
+    result.p99Ns = samples[(samples.size() - 1) * 99 / 100];
+    result.minNs = samples.front();
+    
+    std::cout << name;
+    for (const auto& [key, value] : params) {
+        std::cout << " " << key << "=" << value;
+    }
+    std::cout << ": p50 " << result.p50Ns / 1.0e6 << " ms, p99 " << result.p99Ns / 1.0e6
+              << " ms (" << result.iterations << " iterations)" << std::endl;
+    
+    m_Results.push_back(result);
+    return &m_Results.back();
+}
+
+bool BenchmarkRunner::WriteJson(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+    
+    char date[32] = {};
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    
+#ifdef NDEBUG
+    const char* build = "release";
+#else
+    const char* build = "debug";
+#endif
+    
+    std::fprintf(file, "{\n  \"context\": {\"date\": \"%s\", \"build\": \"%s\", \"hardware_threads\": %u},\n",
+                 date, build, std::thread::hardware_concurrency());
+    std::fprintf(file, "  \"benchmarks\": [");
+    for (size_t i = 0; i < m_Results.size(); i++) {
+        const BenchmarkResult& result = m_Results[i];
+        std::fprintf(file, "%s\n    {\"name\": \"%s\", \"params\": {", i == 0 ? "" : ",", result.name.c_str());
+        for (size_t p = 0; p < result.params.size(); p++) {
+            std::fprintf(file, "%s\"%s\": %.17g", p == 0 ? "" : ", ", result.params[p].first.c_str(), result.params[p].second);
+        }
+        std::fprintf(file, "}, \"iterations\": %d, \"mean_ns\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"min_ns\": %.1f",
+                     result.iterations, result.meanNs, result.p50Ns, result.p99Ns, result.minNs);
+        std::fprintf(file, ", \"counters\": {");
+        for (size_t c = 0; c < result.counters.size(); c++) {
+            std::fprintf(file, "%s\"%s\": %.17g", c == 0 ? "" : ", ", result.counters[c].first.c_str(), result.counters[c].second);
+        }
+        std::fprintf(file, "}}");
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+    
+    if (std::fclose(file) != 0) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << m_Results.size() << " results to " << path << std::endl;
+    return true;
+}
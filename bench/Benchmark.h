@@ -0,0 +1,46 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One measured case: per-iteration timings of the same piece of work
+struct BenchmarkResult {
+    std::string name;
+    std::vector<std::pair<std::string, double>> params;    // Sweep coordinates, e.g. grid = 100
+    std::vector<std::pair<std::string, double>> counters;  // Extra outputs, e.g. vertex counts
+    int iterations = 0;
+    double meanNs = 0.0;
+    double p50Ns = 0.0;
+    double p99Ns = 0.0;
+    double minNs = 0.0;
+};
+
+// Runs cases, prints a line per case and collects results for JSON output
+class BenchmarkRunner {
+public:
+    struct Options {
+        double minSeconds = 0.5;  // Keep iterating until this much time was measured...
+        int minIterations = 3;    // ...and at least this many iterations ran
+        int maxIterations = 100000;
+        std::string filter;       // Only run cases whose name contains this
+    };
+    
+    using Params = std::vector<std::pair<std::string, double>>;
+    
+    explicit BenchmarkRunner(const Options& options) : m_Options(options) {}
+    
+    bool IsEnabled(const std::string& name) const;
+    
+    // Times 'body' per iteration. 'setup' runs before each iteration and is not timed.
+    // Returns nullptr if the case is filtered out.
+    BenchmarkResult* Run(const std::string& name, const Params& params,
+                         const std::function<void()>& body,
+                         const std::function<void()>& setup = nullptr);
+    
+    bool WriteJson(const std::string& path) const;
+    
+private:
+    Options m_Options;
+    std::vector<BenchmarkResult> m_Results;
+};
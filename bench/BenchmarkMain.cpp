@@ -0,0 +1,437 @@
+#include "Benchmark.h"
+#include "Core/Log.h"
+#include "Renderer/NetworkMesh.h"
+#include "Simulation/Graph.h"
+#include "Simulation/GridGenerator.h"
+#include "Simulation/NetworkFile.h"
+#include "Simulation/NextHopTable.h"
+#include "Simulation/Pathfinding.h"
+#include "Simulation/RouteOverlay.h"
+#include "Simulation/TransitNetwork.h"
+#include "Simulation/TransportSimulation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+    const int kGridSizes[] = { 20, 50, 100, 200, 500, 1000 };
+    const int kFleetSizes[] = { 200, 1000, 10000, 100000, 1000000 };
+    const float kSpacing = 10.0f;
+
+    struct Config {
+        std::string outputFile = "benchmark_results.json";
+        int maxGrid = 1000;
+        int maxVehicles = 1000000;
+        int threads = 1;
+        BenchmarkRunner::Options runner;
+    };
+
+    // Keeps the network loading messages out of the benchmark output
+    class ScopedSilence {
+    public:
+        ScopedSilence() : m_Buffer(std::cout.rdbuf(nullptr)) {}
+        ~ScopedSilence() {
+            std::cout.rdbuf(m_Buffer);
+            std::cout.clear();
+        }
+    private:
+        std::streambuf* m_Buffer;
+    };
+
+    // The built-in network layout at any size: two-way roads on even rows and
+    // columns, one-way on odd ones, diagonal shortcuts every 4th block.
+    // Node (x, z) gets ID x * gridSize + z.
+    template<typename AddEdge>
+    void ForEachGridRoad(int gridSize, AddEdge&& addEdge) {
+        auto id = [gridSize](int x, int z) { return x * gridSize + z; };
+        for (int x = 0; x < gridSize; x++) {
+            for (int z = 0; z < gridSize; z++) {
+                if (x < gridSize - 1) addEdge(id(x, z), id(x + 1, z), kSpacing, z % 2 == 0);
+                if (z < gridSize - 1) addEdge(id(x, z), id(x, z + 1), kSpacing, x % 2 == 0);
+            }
+        }
+        float diagonal = kSpacing * std::sqrt(2.0f);
+        for (int x = 0; x < gridSize - 1; x += 4) {
+            for (int z = 0; z < gridSize - 1; z += 4) {
+                addEdge(id(x, z), id(x + 1, z + 1), diagonal, true);
+                addEdge(id(x + 1, z), id(x, z + 1), diagonal, true);
+            }
+        }
+    }
+
+    void DescribeGrid(int gridSize, std::vector<glm::vec3>& positions, std::vector<EdgeDescription>& edges) {
+        positions.clear();
+        edges.clear();
+        for (int x = 0; x < gridSize; x++) {
+            for (int z = 0; z < gridSize; z++) {
+                positions.push_back(glm::vec3(x * kSpacing, 0.0f, z * kSpacing));
+            }
+        }
+        ForEachGridRoad(gridSize, [&](int from, int to, float weight, bool twoWay) {
+            edges.push_back({ from, to, weight });
+            if (twoWay) edges.push_back({ to, from, weight });
+        });
+    }
+
+    std::shared_ptr<Graph> BuildGridBulk(int gridSize) {
+        std::vector<glm::vec3> positions;
+        std::vector<EdgeDescription> edges;
+        DescribeGrid(gridSize, positions, edges);
+        auto graph = std::make_shared<Graph>();
+        graph->Build(positions, edges);
+        return graph;
+    }
+
+    // Route endpoints 5-70 blocks apart, the range the simulation spawns with
+    std::vector<std::pair<int, int>> MakeRoutes(int gridSize, int count, std::mt19937& rng) {
+        std::uniform_int_distribution<int> cell(0, gridSize - 1);
+        std::vector<std::pair<int, int>> routes;
+        while ((int)routes.size() < count) {
+            int x0 = cell(rng), z0 = cell(rng), x1 = cell(rng), z1 = cell(rng);
+            float blocks = std::sqrt((float)((x1 - x0) * (x1 - x0) + (z1 - z0) * (z1 - z0)));
+            if (blocks >= 5.0f && blocks <= 70.0f) {
+                routes.push_back({ x0 * gridSize + z0, x1 * gridSize + z1 });
+            }
+        }
+        return routes;
+    }
+
+    bool ShouldSweepGrid(const Config& config, int gridSize) {
+        return gridSize <= config.maxGrid;
+    }
+
+    void RunGraphConstruction(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("graph_build")) return;
+        for (int gridSize : kGridSizes) {
+            if (!ShouldSweepGrid(config, gridSize)) continue;
+
+            std::shared_ptr<Graph> graph;
+            std::vector<glm::vec3> positions;
+            std::vector<EdgeDescription> edges;
+            DescribeGrid(gridSize, positions, edges);
+            runner.Run("graph_build/bulk", { { "grid", gridSize } },
+                [&] {
+                    graph = std::make_shared<Graph>();
+                    graph->Build(positions, edges);
+                },
+                [&] { graph.reset(); });
+
+            // The scenario generator alone, before the graph is materialised
+            Scenario scenario;
+            scenario.gridWidth = scenario.gridHeight = gridSize;
+            GeneratedNetwork network;
+            runner.Run("graph_build/generate", { { "grid", gridSize }, { "threads", config.threads } },
+                [&] { GridGenerator::Generate(scenario, 1, config.threads, network); });
+        }
+    }
+
+    void RunNetworkMesh(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("network_mesh")) return;
+        for (int gridSize : kGridSizes) {
+            if (!ShouldSweepGrid(config, gridSize)) continue;
+
+            auto graph = BuildGridBulk(gridSize);
+            NetworkMesh mesh;
+            BenchmarkResult* result = runner.Run("network_mesh", { { "grid", gridSize } },
+                [&] { mesh = NetworkMesh::Build(*graph); },
+                [&] { mesh = NetworkMesh(); });
+            if (result) {
+                result->counters.push_back({ "vertices", (double)mesh.GetVertexCount(NetworkMesh::Detail) });
+                result->counters.push_back({ "coarse_vertices", (double)mesh.GetVertexCount(NetworkMesh::Coarse) });
+                result->counters.push_back({ "tiles", (double)mesh.tiles.size() });
+            }
+        }
+    }
+
+    void RunAStar(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("astar")) return;
+        for (int gridSize : kGridSizes) {
+            if (!ShouldSweepGrid(config, gridSize)) continue;
+
+            auto graph = BuildGridBulk(gridSize);
+            std::mt19937 rng(1234);
+            auto routes = MakeRoutes(gridSize, 256, rng);
+            size_t next = 0;
+            size_t pathNodes = 0;
+
+            BenchmarkResult* result = runner.Run("astar", { { "grid", gridSize } }, [&] {
+                const auto& [from, to] = routes[next++ % routes.size()];
+                pathNodes += Pathfinding::AStar(graph, from, to).size();
+            });
+            if (result) {
+                result->counters.push_back({ "mean_path_nodes", (double)pathNodes / result->iterations });
+            }
+        }
+    }
+
+    // Hierarchical planning: the overlay build, and what a spawn costs with it
+    // (corridor plus the first refined stretch) next to a full A* route
+    void RunRouteOverlay(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("route_overlay")) return;
+        for (int gridSize : kGridSizes) {
+            if (!ShouldSweepGrid(config, gridSize)) continue;
+
+            auto graph = BuildGridBulk(gridSize);
+            std::unique_ptr<RouteOverlay> overlay;
+            BenchmarkResult* result = runner.Run("route_overlay/build", { { "grid", gridSize } },
+                [&] { overlay = std::make_unique<RouteOverlay>(*graph); });
+            if (!overlay) overlay = std::make_unique<RouteOverlay>(*graph);
+            if (result) {
+                result->counters.push_back({ "cells", (double)overlay->GetCellCount() });
+                result->counters.push_back({ "arcs", (double)overlay->GetArcCount() });
+            }
+
+            std::mt19937 rng(1234);
+            auto routes = MakeRoutes(gridSize, 256, rng);
+            size_t next = 0;
+            size_t pathNodes = 0;
+            result = runner.Run("route_overlay/plan", { { "grid", gridSize } }, [&] {
+                const auto& [from, to] = routes[next++ % routes.size()];
+                std::vector<int32_t> corridor = overlay->FindCorridor(from, to);
+                size_t reached = 0;
+                pathNodes += overlay->Refine(*graph, from, to, corridor, 0, reached).size();
+            });
+            if (result) {
+                result->counters.push_back({ "mean_path_nodes", (double)pathNodes / result->iterations });
+            }
+        }
+    }
+
+    void RunNextHop(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("next_hop")) return;
+        for (int gridSize : kGridSizes) {
+            if (!ShouldSweepGrid(config, gridSize)) continue;
+            if ((size_t)gridSize * gridSize > NextHopTable::AutoNodeThreshold) continue;
+
+            auto graph = BuildGridBulk(gridSize);
+            NextHopTable table;
+            BenchmarkResult* result = runner.Run("next_hop/build", { { "grid", gridSize } },
+                [&] { table.Build(*graph, 1); });
+            if (table.IsEmpty()) table.Build(*graph, 1);
+            if (result) {
+                result->counters.push_back({ "runs", (double)table.GetRunCount() });
+                result->counters.push_back({ "bytes", (double)table.GetMemoryBytes() });
+            }
+
+            std::mt19937 rng(1234);
+            auto routes = MakeRoutes(gridSize, 256, rng);
+            size_t next = 0;
+            size_t pathNodes = 0;
+            result = runner.Run("next_hop/path", { { "grid", gridSize } }, [&] {
+                const auto& [from, to] = routes[next++ % routes.size()];
+                pathNodes += table.FindPath(*graph, from, to).size();
+            });
+            if (result) {
+                result->counters.push_back({ "mean_path_nodes", (double)pathNodes / result->iterations });
+            }
+        }
+    }
+
+    void RunTransit(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("transit")) return;
+        for (int gridSize : kGridSizes) {
+            if (!ShouldSweepGrid(config, gridSize)) continue;
+
+            auto graph = BuildGridBulk(gridSize);
+            Scenario scenario;
+            scenario.transitLines = 16;
+            TransitNetwork network;
+            network.Build(graph, scenario, 1);
+            if (network.GetStopCount() < 2) continue;
+
+            // Journeys between random stops through the first hour of service
+            std::mt19937 rng(4321);
+            std::uniform_int_distribution<int> stop(0, (int)network.GetStopCount() - 1);
+            std::uniform_real_distribution<float> departure(0.0f, 3600.0f);
+            size_t legs = 0;
+            size_t found = 0;
+            BenchmarkResult* result = runner.Run("transit/raptor", { { "grid", gridSize } }, [&] {
+                auto journey = network.FindJourney(stop(rng), stop(rng), departure(rng));
+                legs += journey.size();
+                found += journey.empty() ? 0 : 1;
+            });
+            if (result) {
+                result->counters.push_back({ "stops", (double)network.GetStopCount() });
+                result->counters.push_back({ "trips", (double)network.GetTripCount() });
+                result->counters.push_back({ "found", (double)found / result->iterations });
+                result->counters.push_back({ "mean_legs", found ? (double)legs / found : 0.0 });
+            }
+        }
+    }
+
+    void RunEdgeBuckets(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("edge_buckets")) return;
+
+        const int gridSize = 100;
+        std::mt19937 rng(99);
+        std::uniform_int_distribution<int> cell(0, gridSize - 2);
+        std::uniform_real_distribution<float> along(0.0f, kSpacing);
+
+        for (int fleet : kFleetSizes) {
+            if (fleet > config.maxVehicles) continue;
+
+            // Vehicles spread over the +x roads, each driving towards the next node.
+            // The road starting at node n has edge ID n here.
+            std::vector<VehicleProxy> proxies(fleet);
+            for (int i = 0; i < fleet; i++) {
+                int x = cell(rng), z = cell(rng);
+                VehicleProxy& proxy = proxies[i];
+                proxy.id = i;
+                proxy.edgeId = x * gridSize + z;
+                proxy.offset = along(rng);
+                proxy.fromNodeId = x * gridSize + z;
+                proxy.targetNodeId = (x + 1) * gridSize + z;
+                proxy.lane = 0;
+            }
+
+            // What every tile does once per phase
+            EdgeBuckets buckets;
+            auto build = [&] {
+                buckets.Clear();
+                buckets.Add(proxies);
+                buckets.Sort();
+            };
+            build();
+            runner.Run("edge_buckets/build", { { "vehicles", fleet } }, build);
+
+            size_t query = 0;
+            int found = 0;
+            runner.Run("edge_buckets/count", { { "vehicles", fleet } }, [&] {
+                int x = (int)(query * 7919 % (gridSize - 1));
+                int z = (int)(query * 104729 % gridSize);
+                query++;
+                found += buckets.GetCount(x * gridSize + z);
+            });
+            if (found < 0) std::cout << found;  // Keeps the calls observable
+        }
+    }
+
+    void RunUpdate(BenchmarkRunner& runner, const Config& config) {
+        if (!runner.IsEnabled("update")) return;
+
+        // Fleets grow tenfold per step; past this, the next step would take minutes per sample
+        constexpr double kMaxTickNs = 2.0e9;
+        double slowestTickNs = 0.0;
+
+        for (int fleet : kFleetSizes) {
+            if (fleet > config.maxVehicles) continue;
+            if (slowestTickNs > kMaxTickNs) {
+                std::cout << "update vehicles=" << fleet << ": skipped, the previous fleet already took over "
+                          << kMaxTickNs / 1.0e9 << "s per tick" << std::endl;
+                continue;
+            }
+
+            // Smallest swept grid with at least one intersection per vehicle
+            int gridSize = 0;
+            for (int size : kGridSizes) {
+                if (size * size >= fleet) {
+                    gridSize = size;
+                    break;
+                }
+            }
+            if (gridSize == 0 || !ShouldSweepGrid(config, gridSize)) continue;
+
+            // Networks reach the simulation the same way real ones do: through a .tsnet file
+            auto networkPath = std::filesystem::temp_directory_path() / ("bench_grid_" + std::to_string(gridSize) + ".tsnet");
+            auto simulation = std::make_shared<TransportSimulation>();
+            {
+                ScopedSilence silence;
+                if (!NetworkFile::Write(networkPath.string(), *BuildGridBulk(gridSize), SignalTable())) continue;
+                simulation->SetNetworkFile(networkPath.string());
+                simulation->SetSeed(7);
+                simulation->SetThreadCount(config.threads);
+                simulation->Initialize();
+                simulation->SetTrafficLightsEnabled(true);
+
+                // Straight runs of up to 10 blocks along the +x roads
+                std::mt19937 rng(fleet);
+                std::uniform_int_distribution<int> cell(0, gridSize - 2);
+                std::vector<int> path;
+                while ((int)simulation->GetVehicles().size() < fleet) {
+                    int x = cell(rng), z = cell(rng);
+                    int length = std::min(10, gridSize - 1 - x);
+                    path.clear();
+                    for (int i = 0; i <= length; i++) {
+                        path.push_back((x + i) * gridSize + z);
+                    }
+                    simulation->AddVehicle(path);
+                }
+
+                for (int i = 0; i < 5; i++) {
+                    simulation->Update(1.0f / 60.0f);
+                }
+            }
+            std::filesystem::remove(networkPath);
+
+            BenchmarkResult* result = runner.Run("update",
+                { { "grid", gridSize }, { "vehicles", fleet }, { "threads", config.threads } },
+                [&] { simulation->Update(1.0f / 60.0f); });
+            if (result) {
+                result->counters.push_back({ "final_vehicles", (double)simulation->GetVehicles().size() });
+                slowestTickNs = std::max(slowestTickNs, result->p50Ns);
+            }
+        }
+    }
+
+    void PrintUsage(const char* program) {
+        std::cout << "Usage: " << program << " [options]" << std::endl;
+        std::cout << "  --out <file.json>     Results file (default benchmark_results.json)" << std::endl;
+        std::cout << "  --filter <text>       Only run cases whose name contains <text>" << std::endl;
+        std::cout << "  --max-grid <n>        Largest grid side to sweep (default 1000)" << std::endl;
+        std::cout << "  --max-vehicles <n>    Largest fleet to sweep (default 1000000)" << std::endl;
+        std::cout << "  --min-time <s>        Minimum measured time per case (default 0.5)" << std::endl;
+        std::cout << "  --threads <n>         Simulation threads for the update cases (default 1)" << std::endl;
+        std::cout << "Compare two result files with bench/compare_results.py" << std::endl;
+    }
+
+    bool ParseArgs(int argc, char** argv, Config& config) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            try {
+                if (arg == "--out" && hasValue) config.outputFile = argv[++i];
+                else if (arg == "--filter" && hasValue) config.runner.filter = argv[++i];
+                else if (arg == "--max-grid" && hasValue) config.maxGrid = std::stoi(argv[++i]);
+                else if (arg == "--max-vehicles" && hasValue) config.maxVehicles = std::stoi(argv[++i]);
+                else if (arg == "--min-time" && hasValue) config.runner.minSeconds = std::stod(argv[++i]);
+                else if (arg == "--threads" && hasValue) config.threads = std::max(std::stoi(argv[++i]), 1);
+                else {
+                    PrintUsage(argv[0]);
+                    return false;
+                }
+            } catch (const std::exception&) {
+                std::cerr << "Invalid value for " << arg << ": " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+
+    // Failed routes and progress reports would otherwise be timed along with the work
+    Log::SetLevel(LogLevel::Off);
+
+    BenchmarkRunner runner(config.runner);
+    RunGraphConstruction(runner, config);
+    RunNetworkMesh(runner, config);
+    RunAStar(runner, config);
+    RunRouteOverlay(runner, config);
+    RunNextHop(runner, config);
+    RunTransit(runner, config);
+    RunEdgeBuckets(runner, config);
+    RunUpdate(runner, config);
+
+    return runner.WriteJson(config.outputFile) ? 0 : 1;
+}
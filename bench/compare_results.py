@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Compares two Transport-Sim-Bench result files and flags regressions.
+
+Usage: compare_results.py baseline.json current.json [--threshold 0.10] [--metric p50_ns]
+
+Exits with status 1 when any benchmark present in both files got slower by more
+than the threshold, so it can gate a CI job.
+"""
+
+import argparse
+import json
+import sys
+
+METRICS = ("mean_ns", "p50_ns", "p99_ns", "min_ns")
+
+
+def load(path):
+    with open(path, "r", encoding="utf-8") as f:
+        data = json.load(f)
+    results = {}
+    for bench in data.get("benchmarks", []):
+        params = ",".join(f"{k}={v}" for k, v in sorted(bench.get("params", {}).items()))
+        key = f"{bench['name']}[{params}]" if params else bench["name"]
+        results[key] = bench
+    return data.get("context", {}), results
+
+
+def format_ns(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return f"{ns / scale:.3f} {unit}"
+    return f"{ns:.0f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark result files.")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown counted as a regression (default 0.10 = 10%%)")
+    parser.add_argument("--metric", choices=METRICS, default="p50_ns",
+                        help="timing compared between the runs (default p50_ns)")
+    args = parser.parse_args()
+
+    base_context, baseline = load(args.baseline)
+    current_context, current = load(args.current)
+    if base_context.get("build") != current_context.get("build"):
+        print(f"warning: comparing a {base_context.get('build', '?')} baseline against a "
+              f"{current_context.get('build', '?')} run", file=sys.stderr)
+
+    regressions = []
+    width = max((len(key) for key in baseline.keys() | current.keys()), default=10)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'current':>12}  {'change':>8}")
+    for key in sorted(baseline.keys() | current.keys()):
+        if key not in current:
+            print(f"{key:<{width}}  {format_ns(baseline[key][args.metric]):>12}  {'missing':>12}")
+            continue
+        if key not in baseline:
+            print(f"{key:<{width}}  {'new':>12}  {format_ns(current[key][args.metric]):>12}")
+            continue
+
+        before = baseline[key][args.metric]
+        after = current[key][args.metric]
+        change = (after - before) / before if before > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append((key, change))
+        elif change < -args.threshold:
+            flag = "  improved"
+        print(f"{key:<{width}}  {format_ns(before):>12}  {format_ns(after):>12}  {change * 100:+7.1f}%{flag}")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) above {args.threshold * 100:.0f}% in {args.metric}:")
+        for key, change in regressions:
+            print(f"  {key}: {change * 100:+.1f}%")
+        return 1
+
+    print(f"\nNo regressions above {args.threshold * 100:.0f}% in {args.metric}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
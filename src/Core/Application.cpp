@@ -1,8 +1,21 @@
 #include "Application.h"
+#include "CommandLine.h"
+#include "ImageSequenceWriter.h"
+#include "Profiler.h"
 #include "../Renderer/Camera.h"
-#include "../Renderer/Shader.h"
+#include "../Renderer/FrameCapture.h"
+#include "../Renderer/Framebuffer.h"
+#include "../Renderer/NetworkMesh.h"
+#include "../Renderer/NetworkRenderer.h"
+#include "../Renderer/RenderQueue.h"
+#include "../Renderer/TrafficLightRenderer.h"
+#include "../Renderer/VehicleRenderer.h"
+#include "../Simulation/ReplayPlayer.h"
+#include "../Simulation/SimulationThread.h"
 #include "../Simulation/TransportSimulation.h"
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -12,27 +25,14 @@
 
 static GLFWwindow* s_Window = nullptr;
 
-static const char* vertexShaderSource = R"(
-    #version 460 core
-    layout (location = 0) in vec3 aPos;
-    uniform mat4 u_Model;
-    uniform mat4 u_View;
-    uniform mat4 u_Projection;
-    void main() {
-        gl_Position = u_Projection * u_View * u_Model * vec4(aPos, 1.0);
-    }
-)";
-
-static const char* fragmentShaderSource = R"(
-    #version 460 core
-    out vec4 FragColor;
-    uniform vec4 u_Color;
-    void main() {
-        FragColor = u_Color;
-    }
-)";
-
-Application::Application() {
+Application::Application(const CommandLineArgs& args) {
+    // Offscreen runs need no display or GPU: GLFW's null platform, with the
+    // context from EGL or, failing that, OSMesa (Mesa's software renderer)
+    m_Offscreen = args.offscreenFrames > 0;
+    if (m_Offscreen) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+    
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return;
@@ -42,7 +42,17 @@ Application::Application() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    s_Window = glfwCreateWindow(1280, 720, "Transport Simulator 3D - C++ DSA", NULL, NULL);
+    const char* title = "Transport Simulator 3D - C++ DSA";
+    if (m_Offscreen) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        for (int api : { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API }) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+            s_Window = glfwCreateWindow(args.width, args.height, title, NULL, NULL);
+            if (s_Window) break;
+        }
+    } else {
+        s_Window = glfwCreateWindow(args.width, args.height, title, NULL, NULL);
+    }
     if (!s_Window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -59,18 +69,68 @@ Application::Application() {
     std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
     std::cout << "GPU: " << glGetString(GL_RENDERER) << std::endl;
     
-    glViewport(0, 0, 1280, 720);
+    glViewport(0, 0, args.width, args.height);
     glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
     glEnable(GL_DEPTH_TEST);
     glLineWidth(2.0f);
     
-    m_Shader = std::make_shared<Shader>(vertexShaderSource, fragmentShaderSource);
-    m_Camera = std::make_shared<Camera>(45.0f, 1280.0f / 720.0f, 0.1f, 1000.0f);
+    m_RenderQueue = std::make_shared<RenderQueue>();
+    m_Camera = std::make_shared<Camera>(45.0f, (float)args.width / (float)args.height, 0.1f, 1000.0f);
     m_Camera->SetPosition(glm::vec3(20.0f, 30.0f, 40.0f));
     m_Camera->SetRotation(-30.0f, -135.0f);
     
+    TS_PROFILE_THREAD_NAME("Main");
     m_Simulation = std::make_shared<TransportSimulation>();
+    m_Simulation->SetScenario(LoadScenario(args));
+    m_Simulation->SetThreadCount(args.threads);
     m_Simulation->Initialize();
+    if (!args.exportNetworkFile.empty()) {
+        m_Simulation->ExportNetwork(args.exportNetworkFile);
+    }
+    if (!args.checkpointFile.empty()) {
+        m_CheckpointFile = args.checkpointFile;
+        m_Simulation->LoadCheckpoint(m_CheckpointFile);
+    }
+    if (!args.recordFile.empty()) {
+        m_RecordingFile = args.recordFile;
+        m_Simulation->StartRecording(m_RecordingFile);
+    }
+    
+    // Imported and generated networks can be kilometres across; frame the orbit around them
+    const Scenario& scenario = m_Simulation->GetScenario();
+    const Scenario builtIn;
+    if (!scenario.network.empty() || scenario.gridWidth != builtIn.gridWidth || scenario.gridHeight != builtIn.gridHeight) {
+        glm::vec3 minBounds(std::numeric_limits<float>::max());
+        glm::vec3 maxBounds(std::numeric_limits<float>::lowest());
+        const Graph& graph = *m_Simulation->GetGraph();
+        for (int id = 0; id < (int)graph.GetNodeCount(); id++) {
+            minBounds = glm::min(minBounds, graph.GetPosition(id));
+            maxBounds = glm::max(maxBounds, graph.GetPosition(id));
+        }
+        if (minBounds.x <= maxBounds.x) {
+            glm::vec3 extent = maxBounds - minBounds;
+            m_OrbitCenter = (minBounds + maxBounds) * 0.5f;
+            m_OrbitRadius = std::max(std::max(extent.x, extent.z) * 0.6f, 50.0f);
+            m_OrbitHeight = m_OrbitRadius * 0.55f;
+            m_Camera->SetClipPlanes(0.1f, m_OrbitRadius * 4.0f);
+        }
+    }
+    
+    m_TraceSeconds = args.traceSeconds;
+    if (!args.traceFile.empty()) {
+        m_TraceFile = args.traceFile;
+        Profiler::StartTrace(m_TraceFile, m_TraceSeconds);
+    }
+    
+    if (!args.replayFile.empty()) {
+        m_Replay = std::make_shared<ReplayPlayer>();
+        if (!m_Replay->Open(args.replayFile)) {
+            m_Replay.reset();
+        } else if (m_Replay->GetEdgeCount() != m_Simulation->GetGraph()->GetEdgeCount()) {
+            std::cerr << "Warning: recording has " << m_Replay->GetEdgeCount() << " roads but the loaded network has "
+                      << m_Simulation->GetGraph()->GetEdgeCount() << "; load the network it was recorded on" << std::endl;
+        }
+    }
     
     float cubeVertices[] = {
         -0.5f, -0.5f,  0.5f, 0.5f, -0.5f,  0.5f, 0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f,
@@ -84,15 +144,25 @@ Application::Application() {
     glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    
-    glGenVertexArrays(1, &m_LineVAO);
-    glGenBuffers(1, &m_LineVBO);
-    glBindVertexArray(m_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_LineVBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
     glBindVertexArray(0);
     
+    m_VehicleRenderer = std::make_shared<VehicleRenderer>();
+    
+    if (m_Offscreen) {
+        m_OffscreenFrames = args.offscreenFrames;
+        m_FrameTime = 1.0f / args.frameRate;
+        m_Framebuffer = std::make_shared<Framebuffer>(args.width, args.height);
+        m_Framebuffer->Bind();
+        std::cout << "Offscreen: " << m_OffscreenFrames << " frames at " << args.width << "x" << args.height
+                  << ", " << args.frameRate << " per simulated second" << std::endl;
+    }
+    if (!args.captureDir.empty()) {
+        m_ImageWriter = std::make_shared<ImageSequenceWriter>();
+        if (m_ImageWriter->Start(args.captureDir)) {
+            m_FrameCapture = std::make_shared<FrameCapture>(m_ImageWriter);
+        }
+    }
+    
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
@@ -104,49 +174,83 @@ Application::Application() {
     std::cout << "Initialization complete!" << std::endl;
     std::cout << "Controls: SPACE = Toggle Auto/Manual Camera" << std::endl;
     std::cout << "  Manual: WASD = Move, QE = Up/Down, Arrows = Rotate" << std::endl;
+    std::cout << "  F9 = Capture a " << m_TraceSeconds << "s trace to " << m_TraceFile << std::endl;
+    std::cout << "  H = Toggle congestion heatmap" << std::endl;
     
     BuildGridMesh();
     
+    // From here on the simulation belongs to its thread; the UI only posts commands to it.
+    // Offscreen frames step it from the main thread instead, in lockstep with the frames.
+    if (!m_Replay) {
+        m_SimulationThread = std::make_shared<SimulationThread>(m_Simulation);
+        if (!m_Offscreen) {
+            m_SimulationThread->Start();
+        }
+    }
+    
     glfwSetWindowUserPointer(s_Window, this);
     glfwSetFramebufferSizeCallback(s_Window, OnResize);
 }
 
 Application::~Application() {
+    m_SimulationThread.reset();
+    Profiler::StopTrace();
+    
+    m_FrameCapture.reset();
+    m_ImageWriter.reset();  // Writes the frames still queued
+    m_Framebuffer.reset();
+    
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
     
     glDeleteVertexArrays(1, &m_CubeVAO);
     glDeleteBuffers(1, &m_CubeVBO);
-    glDeleteVertexArrays(1, &m_LineVAO);
-    glDeleteBuffers(1, &m_LineVBO);
-    
-    // Cleanup batch buffers
-    glDeleteVertexArrays(1, &m_BatchNodesVAO);
-    glDeleteBuffers(1, &m_BatchNodesVBO);
-    glDeleteVertexArrays(1, &m_BatchOneWayVAO);
-    glDeleteBuffers(1, &m_BatchOneWayVBO);
-    glDeleteVertexArrays(1, &m_BatchTwoWayVAO);
-    glDeleteBuffers(1, &m_BatchTwoWayVBO);
-    glDeleteVertexArrays(1, &m_BatchLightsVAO);
-    glDeleteBuffers(1, &m_BatchLightsVBO);
+    m_VehicleRenderer.reset();
+    
+    m_NetworkRenderer.reset();
+    m_TrafficLightRenderer.reset();
     
     if (s_Window) glfwDestroyWindow(s_Window);
     glfwTerminate();
 }
 
 void Application::Run() {
+    int frame = 0;
     while (s_Window && !glfwWindowShouldClose(s_Window)) {
-        float currentTime = (float)glfwGetTime();
-        float deltaTime = currentTime - m_LastFrameTime;
-        m_LastFrameTime = currentTime;
+        float deltaTime = m_FrameTime;
+        if (!m_Offscreen) {
+            float currentTime = (float)glfwGetTime();
+            deltaTime = currentTime - m_LastFrameTime;
+            m_LastFrameTime = currentTime;
+        }
         
         Update(deltaTime);
         Render();
         
-        glfwSwapBuffers(s_Window);
+        // Read back before the swap, while the finished frame is still the read buffer
+        if (m_FrameCapture) {
+            int width = 0, height = 0;
+            if (m_Framebuffer) {
+                width = m_Framebuffer->GetWidth();
+                height = m_Framebuffer->GetHeight();
+            } else {
+                glfwGetFramebufferSize(s_Window, &width, &height);
+            }
+            m_FrameCapture->Capture(width, height);
+        }
+        
+        if (m_Offscreen) {
+            if (++frame >= m_OffscreenFrames) break;
+        } else {
+            glfwSwapBuffers(s_Window);
+        }
         glfwPollEvents();
     }
+    
+    if (m_FrameCapture) {
+        m_FrameCapture->Finish();
+    }
 }
 
 void Application::Update(float deltaTime) {
@@ -166,6 +270,30 @@ void Application::Update(float deltaTime) {
         spacePressed = false;
     }
     
+    static bool tracePressed = false;
+    if (glfwGetKey(s_Window, GLFW_KEY_F9) == GLFW_PRESS) {
+        if (!tracePressed) {
+            tracePressed = true;
+            if (Profiler::IsTracing()) {
+                Profiler::StopTrace();
+            } else {
+                Profiler::StartTrace(m_TraceFile, m_TraceSeconds);
+            }
+        }
+    } else {
+        tracePressed = false;
+    }
+    
+    static bool heatmapPressed = false;
+    if (glfwGetKey(s_Window, GLFW_KEY_H) == GLFW_PRESS) {
+        if (!heatmapPressed) {
+            heatmapPressed = true;
+            m_NetworkRenderer->SetHeatmapEnabled(!m_NetworkRenderer->IsHeatmapEnabled());
+        }
+    } else {
+        heatmapPressed = false;
+    }
+    
     if (manualControl) {
         float cameraSpeed = 20.0f * deltaTime;
         if (glfwGetKey(s_Window, GLFW_KEY_W) == GLFW_PRESS) manualCameraPos.z -= cameraSpeed;
@@ -185,16 +313,16 @@ void Application::Update(float deltaTime) {
         static float angle = 0.0f;
         angle += deltaTime * 10.0f;
         
-        float radius = 120.0f;
-        float height = 65.0f;
+        float radius = m_OrbitRadius;
+        float height = m_OrbitHeight;
         glm::vec3 cameraPos(
-            cos(glm::radians(angle)) * radius + 55.0f,
+            cos(glm::radians(angle)) * radius + m_OrbitCenter.x,
             height,
-            sin(glm::radians(angle)) * radius + 55.0f
+            sin(glm::radians(angle)) * radius + m_OrbitCenter.z
         );
         m_Camera->SetPosition(cameraPos);
         
-        glm::vec3 center(55.0f, 0.0f, 55.0f);
+        glm::vec3 center(m_OrbitCenter.x, 0.0f, m_OrbitCenter.z);
         glm::vec3 direction = glm::normalize(center - cameraPos);
         
         float pitch = glm::degrees(asin(direction.y));
@@ -203,317 +331,82 @@ void Application::Update(float deltaTime) {
     }
     
     m_Camera->Update(deltaTime);
-    m_Simulation->Update(deltaTime);
+    if (m_Replay) {
+        m_Replay->Update(deltaTime);
+    } else {
+        // The simulation steps on its own; pick up the newest state it published
+        if (m_Offscreen) {
+            m_SimulationThread->Step(deltaTime);
+        }
+        m_SimulationThread->AcquireSnapshot();
+    }
 }
 
 void Application::Render() {
+    TS_PROFILE_SCOPE(ProfilePhase::Render);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    m_Shader->Bind();
-    m_Shader->SetMat4("u_View", m_Camera->GetViewMatrix());
-    m_Shader->SetMat4("u_Projection", m_Camera->GetProjectionMatrix());
-    
+    // Renderers only queue their draws; they go out sorted by state in one pass
+    m_RenderQueue->BeginFrame(m_Camera->GetViewMatrix(), m_Camera->GetProjectionMatrix());
     RenderGrid();
     RenderVehicles();
+    {
+        TS_PROFILE_SCOPE(ProfilePhase::RenderFlush);
+        m_RenderQueue->Flush();
+    }
     
-    m_Shader->Unbind();
     RenderUI();
 }
 
 void Application::BuildGridMesh() {
-    auto graph = m_Simulation->GetGraph();
-    std::vector<float> nodeVertices;
-    std::vector<float> oneWayVertices;
-    std::vector<float> twoWayVertices;
-    
-    // 1. Build Node Mesh (Pentagons)
-    for (const auto& [id, node] : graph->GetNodes()) {
-        float rotation = 0.0f;
-        if (!node->edges.empty()) {
-            glm::vec3 dir = glm::normalize(node->edges[0]->to->position - node->position);
-            rotation = atan2(dir.x, dir.z);
-        }
-        
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, node->position + glm::vec3(0.0f, 0.1f, 0.0f));
-        model = glm::rotate(model, rotation, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.8f, 1.0f, 0.8f));
-        
-        // Pentagon vertices (local space)
-        float localVerts[] = {
-             0.0f,  0.5f, 0.0f, 
-            -0.48f, 0.15f, 0.0f, 
-            -0.29f, -0.4f, 0.0f,
-            0.29f, -0.4f, 0.0f, 
-             0.48f,  0.15f, 0.0f
-        };
-        
-        glm::vec3 v0 = glm::vec3(model * glm::vec4(localVerts[0], localVerts[1], localVerts[2], 1.0f));
-        glm::vec3 v1 = glm::vec3(model * glm::vec4(localVerts[3], localVerts[4], localVerts[5], 1.0f));
-        glm::vec3 v2 = glm::vec3(model * glm::vec4(localVerts[6], localVerts[7], localVerts[8], 1.0f));
-        glm::vec3 v3 = glm::vec3(model * glm::vec4(localVerts[9], localVerts[10], localVerts[11], 1.0f));
-        glm::vec3 v4 = glm::vec3(model * glm::vec4(localVerts[12], localVerts[13], localVerts[14], 1.0f));
-        
-        // Triangle 1
-        nodeVertices.insert(nodeVertices.end(), {v0.x, v0.y, v0.z, v1.x, v1.y, v1.z, v2.x, v2.y, v2.z});
-        // Triangle 2
-        nodeVertices.insert(nodeVertices.end(), {v0.x, v0.y, v0.z, v2.x, v2.y, v2.z, v3.x, v3.y, v3.z});
-        // Triangle 3
-        nodeVertices.insert(nodeVertices.end(), {v0.x, v0.y, v0.z, v3.x, v3.y, v3.z, v4.x, v4.y, v4.z});
-    }
-    // 2. Build Road Meshes
-    for (const auto& [id, node] : graph->GetNodes()) {
-        for (const auto& edge : node->edges) {
-            bool isBidirectional = false;
-            for (const auto& reverseEdge : edge->to->edges) {
-                if (reverseEdge->to->id == node->id) {
-                    isBidirectional = true;
-                    break;
-                }
-            }
-            
-            if (isBidirectional) {
-                // Two-way: Parallel lines
-                if (node->id < edge->to->id) {
-                    glm::vec3 roadDir = glm::normalize(edge->to->position - node->position);
-                    glm::vec3 perp = glm::normalize(glm::cross(roadDir, glm::vec3(0.0f, 1.0f, 0.0f)));
-                    float offset = 0.2f;
-                    
-                    glm::vec3 p1 = node->position + perp * offset;
-                    glm::vec3 p2 = edge->to->position + perp * offset;
-                    glm::vec3 p3 = node->position - perp * offset;
-                    glm::vec3 p4 = edge->to->position - perp * offset;
-                    
-                    twoWayVertices.insert(twoWayVertices.end(), {p1.x, p1.y, p1.z, p2.x, p2.y, p2.z});
-                    twoWayVertices.insert(twoWayVertices.end(), {p3.x, p3.y, p3.z, p4.x, p4.y, p4.z});
-
-                    // Add arrows for two-way roads (reuse oneWayVertices for arrows)
-                    // Lane 1: Node -> Edge->To (Right side)
-                    {
-                        glm::vec3 mid = (node->position + edge->to->position) * 0.5f;
-                        glm::vec3 dir = glm::normalize(edge->to->position - node->position);
-                        glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
-                        float size = 0.5f;
-                        glm::vec3 arrowPos = mid + right * 0.2f; // Offset to right lane
-
-                        glm::vec3 tip = arrowPos + dir * size;
-                        glm::vec3 left = arrowPos - dir * size + right * size;
-                        glm::vec3 rightP = arrowPos - dir * size - right * size;
-
-                        oneWayVertices.insert(oneWayVertices.end(), {tip.x, tip.y, tip.z, left.x, left.y, left.z});
-                        oneWayVertices.insert(oneWayVertices.end(), {tip.x, tip.y, tip.z, rightP.x, rightP.y, rightP.z});
-                    }
-
-                    // Lane 2: Edge->To -> Node (Right side relative to return direction)
-                    {
-                        glm::vec3 mid = (node->position + edge->to->position) * 0.5f;
-                        glm::vec3 dir = glm::normalize(node->position - edge->to->position); // Reverse direction
-                        glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
-                        float size = 0.5f;
-                        glm::vec3 arrowPos = mid + right * 0.2f; // Offset to right lane (which is left from original perspective)
-
-                        glm::vec3 tip = arrowPos + dir * size;
-                        glm::vec3 left = arrowPos - dir * size + right * size;
-                        glm::vec3 rightP = arrowPos - dir * size - right * size;
-
-                        oneWayVertices.insert(oneWayVertices.end(), {tip.x, tip.y, tip.z, left.x, left.y, left.z});
-                        oneWayVertices.insert(oneWayVertices.end(), {tip.x, tip.y, tip.z, rightP.x, rightP.y, rightP.z});
-                    }
-                }
-            } else {
-                // One-way: Single line + Arrow
-                oneWayVertices.insert(oneWayVertices.end(), {
-                    node->position.x, node->position.y, node->position.z,
-                    edge->to->position.x, edge->to->position.y, edge->to->position.z
-                });
-                
-                // Arrow
-                glm::vec3 mid = (node->position + edge->to->position) * 0.5f;
-                glm::vec3 dir = glm::normalize(edge->to->position - node->position);
-                glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
-                float size = 0.5f;
-                
-                glm::vec3 tip = mid + dir * size;
-                glm::vec3 left = mid - dir * size + right * size;
-                glm::vec3 rightP = mid - dir * size - right * size;
-                
-                oneWayVertices.insert(oneWayVertices.end(), {tip.x, tip.y, tip.z, left.x, left.y, left.z});
-                oneWayVertices.insert(oneWayVertices.end(), {tip.x, tip.y, tip.z, rightP.x, rightP.y, rightP.z});
-            }
-        }
-    }
-    // Nodes
-    glGenVertexArrays(1, &m_BatchNodesVAO);
-    glGenBuffers(1, &m_BatchNodesVBO);
-    glBindVertexArray(m_BatchNodesVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_BatchNodesVBO);
-    glBufferData(GL_ARRAY_BUFFER, nodeVertices.size() * sizeof(float), nodeVertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    m_BatchNodesCount = nodeVertices.size() / 3;
-    
-    // One-Way
-    glGenVertexArrays(1, &m_BatchOneWayVAO);
-    glGenBuffers(1, &m_BatchOneWayVBO);
-    glBindVertexArray(m_BatchOneWayVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_BatchOneWayVBO);
-    glBufferData(GL_ARRAY_BUFFER, oneWayVertices.size() * sizeof(float), oneWayVertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    m_BatchOneWayCount = oneWayVertices.size() / 3;
-    
-    // Two-Way
-    glGenVertexArrays(1, &m_BatchTwoWayVAO);
-    glGenBuffers(1, &m_BatchTwoWayVBO);
-    glBindVertexArray(m_BatchTwoWayVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_BatchTwoWayVBO);
-    glBufferData(GL_ARRAY_BUFFER, twoWayVertices.size() * sizeof(float), twoWayVertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    m_BatchTwoWayCount = twoWayVertices.size() / 3;
-    
-    // Init Lights Buffer (Dynamic)
-    glGenVertexArrays(1, &m_BatchLightsVAO);
-    glGenBuffers(1, &m_BatchLightsVBO);
-    glBindVertexArray(m_BatchLightsVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_BatchLightsVBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    glBindVertexArray(0);
+    NetworkMesh mesh = NetworkMesh::Build(*m_Simulation->GetGraph());
+    m_NetworkRenderer = std::make_shared<NetworkRenderer>(mesh, *m_RenderQueue);
+    m_TrafficLightRenderer = std::make_shared<TrafficLightRenderer>(*m_Simulation->GetGraph(), m_Simulation->GetSignals());
 }
 
 void Application::RenderGrid() {
-    glm::mat4 identity = glm::mat4(1.0f);
-    m_Shader->SetMat4("u_Model", identity);
-    
-    // 1. Render Nodes
-    m_Shader->SetFloat4("u_Color", glm::vec4(0.9f, 0.9f, 0.95f, 1.0f));
-    glBindVertexArray(m_BatchNodesVAO);
-    glDrawArrays(GL_TRIANGLES, 0, m_BatchNodesCount);
-    
-    // 2. Render One-Way Roads
-    m_Shader->SetFloat4("u_Color", glm::vec4(0.8f, 0.2f, 0.2f, 1.0f));
-    glBindVertexArray(m_BatchOneWayVAO);
-    glDrawArrays(GL_LINES, 0, m_BatchOneWayCount);
-    
-    // 3. Render Two-Way Roads
-    m_Shader->SetFloat4("u_Color", glm::vec4(0.4f, 0.5f, 0.4f, 1.0f));
-    glBindVertexArray(m_BatchTwoWayVAO);
-    glDrawArrays(GL_LINES, 0, m_BatchTwoWayCount);
-    
-    // 4. Render Traffic Lights (Dynamic Batching)
-    auto graph = m_Simulation->GetGraph();
-    std::vector<float> redLights;
-    std::vector<float> greenLights;
-    std::vector<float> yellowLights;
-    
-    // Cube template
-    float cube[] = {
-        -0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f, -0.5f,
-        -0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f, -0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f,
-         0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f,
-        -0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f,
-        -0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f
-    };
+    TS_PROFILE_SCOPE(ProfilePhase::RenderGrid);
     
-    for (const auto& [id, node] : graph->GetNodes()) {
-        // Iterate over incoming lights
-        for (const auto& [neighborId, state] : node->incomingLights) {
-            if (state == TrafficLightState::OFF) continue;
-            
-            std::vector<float>* targetList = nullptr;
-            if (state == TrafficLightState::RED) targetList = &redLights;
-            else if (state == TrafficLightState::GREEN) targetList = &greenLights;
-            else targetList = &yellowLights;
-            
-            // Calculate position: Towards the neighbor
-            auto neighbor = graph->GetNode(neighborId);
-            if (!neighbor) continue;
-            
-            glm::vec3 dir = glm::normalize(neighbor->position - node->position);
-            // Offset slightly towards the incoming road and up
-            glm::vec3 pos = node->position + dir * 2.5f + glm::vec3(0.0f, 3.0f, 0.0f);
-            
-            // Offset to the right side of the road (assuming right-hand traffic)
-            glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
-            pos += right * 1.5f;
-            
-            float scale = 0.6f;
-            
-            for (int i = 0; i < 36; i++) {
-                targetList->push_back(pos.x + cube[i*3] * scale);
-                targetList->push_back(pos.y + cube[i*3+1] * scale);
-                targetList->push_back(pos.z + cube[i*3+2] * scale);
-            }
-        }
-    }
-    
-    glBindVertexArray(m_BatchLightsVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_BatchLightsVBO);
-    
-    if (!redLights.empty()) {
-        glBufferData(GL_ARRAY_BUFFER, redLights.size() * sizeof(float), redLights.data(), GL_DYNAMIC_DRAW);
-        m_Shader->SetFloat4("u_Color", glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
-        glDrawArrays(GL_TRIANGLES, 0, redLights.size() / 3);
+    // 1. Nodes and roads of the tiles in view, far ones at the coarse level.
+    //    Replays carry no per-edge counts or signal states, so those stay as loaded.
+    if (!m_Replay) {
+        m_NetworkRenderer->UpdateHeatmap(m_SimulationThread->GetSnapshot());
     }
+    m_NetworkRenderer->Submit(*m_RenderQueue, *m_Camera);
     
-    if (!greenLights.empty()) {
-        glBufferData(GL_ARRAY_BUFFER, greenLights.size() * sizeof(float), greenLights.data(), GL_DYNAMIC_DRAW);
-        m_Shader->SetFloat4("u_Color", glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-        glDrawArrays(GL_TRIANGLES, 0, greenLights.size() / 3);
-    }
-    
-    if (!yellowLights.empty()) {
-        glBufferData(GL_ARRAY_BUFFER, yellowLights.size() * sizeof(float), yellowLights.data(), GL_DYNAMIC_DRAW);
-        m_Shader->SetFloat4("u_Color", glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
-        glDrawArrays(GL_TRIANGLES, 0, yellowLights.size() / 3);
+    // 2. Render Traffic Lights (static instances, changed state pages only)
+    if (!m_Replay) {
+        m_TrafficLightRenderer->Update(m_SimulationThread->GetSnapshot());
     }
+    m_TrafficLightRenderer->Submit(*m_RenderQueue);
 }
 
 void Application::RenderVehicles() {
-    const auto& vehicles = m_Simulation->GetVehicles();
-    
-    for (size_t i = 0; i < vehicles.size(); i++) {
-        const auto& vehicle = vehicles[i];
-        
-        float hue = (i * 60.0f) / 360.0f;
-        glm::vec3 color(
-            0.5f + 0.5f * sin(hue * 6.28f),
-            0.5f + 0.5f * sin((hue + 0.33f) * 6.28f),
-            0.5f + 0.5f * sin((hue + 0.67f) * 6.28f)
-        );
-        
-        m_Shader->SetFloat4("u_Color", glm::vec4(color, 1.0f));
-        
-        float triangleVertices[] = {
-             0.0f,  0.5f,  1.0f,
-            -0.5f,  0.5f, -0.5f,
-             0.5f,  0.5f, -0.5f
-        };
-        
-        glBindBuffer(GL_ARRAY_BUFFER, m_LineVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_DYNAMIC_DRAW);
-        glBindVertexArray(m_LineVAO);
-        
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, vehicle->GetPosition());
-        
-        glm::vec3 direction = vehicle->GetDirection();
-        if (glm::length(direction) > 0.01f) {
-            float angle = atan2(direction.x, direction.z);
-            model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    TS_PROFILE_SCOPE(ProfilePhase::RenderVehicles);
+    
+    // Vehicles come from the live simulation or, in replay mode, the recording.
+    // Instances are written straight into the mapped buffer and drawn in one call.
+    size_t count = 0;
+    if (m_Replay) {
+        const auto& vehicles = m_Replay->GetVehicles();
+        count = vehicles.size();
+        VehicleRenderer::Instance* instances = m_VehicleRenderer->Begin(count);
+        for (size_t i = 0; i < count; i++) {
+            instances[i] = { vehicles[i].position, VehicleRenderer::GetHeading(vehicles[i].direction), VehicleRenderer::GetColor(i) };
+        }
+    } else {
+        const auto& vehicles = m_SimulationThread->GetSnapshot().vehicles;
+        count = vehicles.size();
+        VehicleRenderer::Instance* instances = m_VehicleRenderer->Begin(count);
+        for (size_t i = 0; i < count; i++) {
+            instances[i] = { vehicles[i].position, VehicleRenderer::GetHeading(vehicles[i].direction), VehicleRenderer::GetColor(i) };
         }
-        
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        
-        m_Shader->SetMat4("u_Model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
     }
+    m_VehicleRenderer->Submit(*m_RenderQueue, count);
 }
 
 void Application::RenderUI() {
+    TS_PROFILE_SCOPE(ProfilePhase::RenderUI);
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -530,53 +423,150 @@ void Application::RenderUI() {
     ImGui::Text("SPACE: Toggle Auto/Manual Camera");
     ImGui::Text("WASD: Move | QE: Up/Down");
     ImGui::Text("Arrow Keys: Rotate Camera");
+    ImGui::Text("F9: %s", Profiler::IsTracing() ? "Tracing... (press to stop)" : "Capture Trace");
+    ImGui::Text("H: Toggle Congestion Heatmap");
     ImGui::Separator();
     
     ImGui::TextColored(ImVec4(0.4f, 0.8f, 0.4f, 1.0f), "Network");
     auto graph = m_Simulation->GetGraph();
     ImGui::Text("Nodes: %zu", graph->GetNodeCount());
-    ImGui::Text("Grid: 20x20 (Single Level)");
-    
-    int totalEdges = 0, oneWayEdges = 0, twoWayEdges = 0;
-    for (const auto& [id, node] : graph->GetNodes()) {
-        for (const auto& edge : node->edges) {
-            totalEdges++;
-            bool isBi = false;
-            for (const auto& re : edge->to->edges) {
-                if (re->to->id == node->id) { isBi = true; break; }
-            }
-            if (isBi) twoWayEdges++; else oneWayEdges++;
-        }
+    if (!m_Simulation->GetNetworkFile().empty()) {
+        ImGui::Text("Source: %s", m_Simulation->GetNetworkFile().c_str());
+    } else {
+        ImGui::Text("Grid: %dx%d (Single Level)", m_Simulation->GetScenario().gridWidth, m_Simulation->GetScenario().gridHeight);
     }
     
-    ImGui::Text("Total Roads: %d", totalEdges);
-    ImGui::TextColored(ImVec4(0.5f, 0.8f, 0.5f, 1.0f), "  Two-Way: %d", twoWayEdges / 2);
-    ImGui::TextColored(ImVec4(0.8f, 0.5f, 0.5f, 1.0f), "  One-Way: %d", oneWayEdges);
+    // Network totals are fixed once loaded, so a replay can show them from the idle simulation
+    const TrafficStatistics::Snapshot& stats = m_Replay ? m_Simulation->GetStatistics().GetSnapshot()
+                                                        : m_SimulationThread->GetSnapshot().statistics;
+    ImGui::Text("Total Roads: %zu", stats.roads);
+    ImGui::TextColored(ImVec4(0.5f, 0.8f, 0.5f, 1.0f), "  Two-Way: %zu", stats.twoWayRoads);
+    ImGui::TextColored(ImVec4(0.8f, 0.5f, 0.5f, 1.0f), "  One-Way: %zu", stats.oneWayRoads);
+    ImGui::Text("Tiles: %zu / %zu drawn (%zu coarse)", m_NetworkRenderer->GetVisibleTileCount(),
+                m_NetworkRenderer->GetTileCount(), m_NetworkRenderer->GetCoarseTileCount());
+    bool heatmap = m_NetworkRenderer->IsHeatmapEnabled();
+    if (ImGui::Checkbox("Congestion Heatmap", &heatmap)) {
+        m_NetworkRenderer->SetHeatmapEnabled(heatmap);
+    }
+    if (heatmap) {
+        ImGui::SameLine();
+        ImGui::Text("(%zu B sent)", m_NetworkRenderer->GetHeatmapBytesUploaded());
+    }
     ImGui::Separator();
     
-    ImGui::TextColored(ImVec4(0.4f, 0.8f, 1.0f, 1.0f), "Simulation Settings");
+    if (m_Replay) {
+        ImGui::TextColored(ImVec4(0.4f, 0.8f, 1.0f, 1.0f), "Replay");
+        if (ImGui::Button(m_Replay->IsPlaying() ? "Pause" : "Play")) {
+            // Playing again after reaching an end starts over
+            if (!m_Replay->IsPlaying()) {
+                if (m_Replay->GetSpeed() > 0.0f && m_Replay->GetTime() >= m_Replay->GetEndTime()) {
+                    m_Replay->Seek(m_Replay->GetStartTime());
+                } else if (m_Replay->GetSpeed() < 0.0f && m_Replay->GetTime() <= m_Replay->GetStartTime()) {
+                    m_Replay->Seek(m_Replay->GetEndTime());
+                }
+            }
+            m_Replay->SetPlaying(!m_Replay->IsPlaying());
+        }
+        
+        float time = (float)m_Replay->GetTime();
+        if (ImGui::SliderFloat("Time (s)", &time, (float)m_Replay->GetStartTime(), (float)m_Replay->GetEndTime(), "%.2f")) {
+            m_Replay->Seek(time);
+        }
+        
+        float speed = m_Replay->GetSpeed();
+        if (ImGui::SliderFloat("Speed", &speed, -16.0f, 16.0f, "%.2fx")) {
+            m_Replay->SetSpeed(speed);
+        }
+    } else {
+        ImGui::TextColored(ImVec4(0.4f, 0.8f, 1.0f, 1.0f), "Simulation Settings");
+        
+        // Settings show what the last snapshot reported; changes are applied by the
+        // simulation thread before its next tick
+        const RenderSnapshot& snapshot = m_SimulationThread->GetSnapshot();
+        ImGui::Text("Sim Time: %.1f s | %.0f ticks/s", snapshot.simulationTime, snapshot.ticksPerSecond);
+    
+        bool trafficLightsEnabled = snapshot.trafficLightsEnabled;
+        if (ImGui::Checkbox("Enable Traffic Lights", &trafficLightsEnabled)) {
+            m_SimulationThread->Post([trafficLightsEnabled](TransportSimulation& simulation) {
+                simulation.SetTrafficLightsEnabled(trafficLightsEnabled);
+            });
+        }
+    
+        int threadCount = snapshot.threadCount;
+        if (ImGui::SliderInt("Sim Threads (Tiles)", &threadCount, 1, 16)) {
+            m_SimulationThread->Post([threadCount](TransportSimulation& simulation) {
+                simulation.SetThreadCount(threadCount);
+            });
+        }
     
-    bool trafficLightsEnabled = m_Simulation->AreTrafficLightsEnabled();
-    if (ImGui::Checkbox("Enable Traffic Lights", &trafficLightsEnabled)) {
-        m_Simulation->SetTrafficLightsEnabled(trafficLightsEnabled);
+        if (ImGui::Button(snapshot.recording ? "Stop Recording" : "Record Trajectories")) {
+            std::string path = m_RecordingFile;
+            m_SimulationThread->Post([path](TransportSimulation& simulation) {
+                if (simulation.IsRecording()) {
+                    simulation.StopRecording();
+                } else {
+                    simulation.StartRecording(path);
+                }
+            });
+        }
+    
+        if (ImGui::Button("Save Checkpoint")) {
+            std::string path = m_CheckpointFile;
+            m_SimulationThread->Post([path](TransportSimulation& simulation) { simulation.SaveCheckpoint(path); });
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Load Checkpoint")) {
+            std::string path = m_CheckpointFile;
+            m_SimulationThread->Post([path](TransportSimulation& simulation) { simulation.LoadCheckpoint(path); });
+        }
     }
     
     ImGui::Separator();
     
     ImGui::TextColored(ImVec4(0.8f, 0.8f, 0.4f, 1.0f), "Vehicles");
-    const auto& vehicles = m_Simulation->GetVehicles();
-    ImGui::Text("Active: %zu", vehicles.size());
-    
-    int moving = 0, stopped = 0;
-    for (const auto& v : vehicles) {
-        if (glm::length(v->GetVelocity()) > 0.1f) moving++; else stopped++;
+    size_t active = 0, stopped = 0;
+    if (m_Replay) {
+        active = m_Replay->GetVehicles().size();
+        stopped = m_Replay->GetStoppedCount();
+    } else {
+        active = stats.active;
+        stopped = stats.halted;
+    }
+    ImGui::Text("Active: %zu", active);
+    
+    ImGui::Text("  Moving: %zu | Stopped: %zu", active - stopped, stopped);
+    if (!m_Replay) {
+        ImGui::Text("Arrived: %llu (%.1f/s) | Signal Changes: %llu", (unsigned long long)stats.arrived,
+                    stats.arrivalsPerSecond, (unsigned long long)stats.signalChanges);
+        ImGui::Text("Mean Edge Delay: %.2f s", stats.meanEdgeDelay);
+        const std::vector<float>& halted = m_SimulationThread->GetSnapshot().haltedSeries;
+        ImGui::PlotLines("Stopped", halted.data(), (int)halted.size(), 0, nullptr, 0.0f, 3.4e38f, ImVec2(0, 40));
     }
-    
-    ImGui::Text("  Moving: %d | Stopped: %d", moving, stopped);
     ImGui::Separator();
     
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
     ImGui::Text("Frame Time: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+    const RenderQueue::Stats& renderStats = m_RenderQueue->GetStats();
+    ImGui::Text("Draw Calls: %zu (%zu shader / %zu VAO changes)", renderStats.drawCalls,
+                renderStats.shaderChanges, renderStats.vaoChanges);
+    
+#if TS_ENABLE_PROFILER
+    Profiler::Collect();
+    if (ImGui::CollapsingHeader("Profiler")) {
+        for (int i = 0; i < (int)ProfilePhase::Count; i++) {
+            ProfilePhase phase = (ProfilePhase)i;
+            const Profiler::PhaseStats& stats = Profiler::GetStats(phase);
+            
+            ImGui::Text("%-15s p50 %6.3f ms | p99 %6.3f ms", Profiler::GetPhaseName(phase), stats.p50, stats.p99);
+            ImGui::PushID(i);
+            ImGui::PlotHistogram("##history", stats.history, (int)stats.count, 0, nullptr, 0.0f, std::numeric_limits<float>::max(), ImVec2(0.0f, 30.0f));
+            ImGui::PopID();
+        }
+        if (Profiler::GetDroppedEvents() > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.3f, 1.0f), "Dropped events: %llu", (unsigned long long)Profiler::GetDroppedEvents());
+        }
+    }
+#endif
     
     ImGui::End();
     
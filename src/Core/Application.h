@@ -1,13 +1,25 @@
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
 
+struct CommandLineArgs;
 class Camera;
 class TransportSimulation;
-class Shader;
+class RenderQueue;
+class ReplayPlayer;
+class SimulationThread;
+class VehicleRenderer;
+class TrafficLightRenderer;
+class NetworkRenderer;
+class Framebuffer;
+class FrameCapture;
+class ImageSequenceWriter;
 
 class Application {
 public:
-    Application();
+    Application(const CommandLineArgs& args);
     ~Application();
 
     void Run();
@@ -23,31 +35,37 @@ private:
     
     std::shared_ptr<Camera> m_Camera;
     std::shared_ptr<TransportSimulation> m_Simulation;
-    std::shared_ptr<Shader> m_Shader;
+    std::shared_ptr<SimulationThread> m_SimulationThread;  // Steps m_Simulation; not created in replay mode
+    std::shared_ptr<RenderQueue> m_RenderQueue;
+    std::shared_ptr<ReplayPlayer> m_Replay;  // Set in replay mode: the simulation is not stepped
+    std::shared_ptr<VehicleRenderer> m_VehicleRenderer;
+    std::shared_ptr<TrafficLightRenderer> m_TrafficLightRenderer;
+    std::shared_ptr<NetworkRenderer> m_NetworkRenderer;
+    
+    // Offscreen mode (--offscreen): no window, draws into m_Framebuffer and
+    // advances simulated time by a fixed m_FrameTime per frame
+    bool m_Offscreen = false;
+    int m_OffscreenFrames = 0;
+    float m_FrameTime = 1.0f / 30.0f;
+    std::shared_ptr<Framebuffer> m_Framebuffer;
+    // Frame capture (--capture), windowed or offscreen
+    std::shared_ptr<ImageSequenceWriter> m_ImageWriter;
+    std::shared_ptr<FrameCapture> m_FrameCapture;
     
     unsigned int m_CubeVAO = 0;
     unsigned int m_CubeVBO = 0;
-    unsigned int m_LineVAO = 0;
-    unsigned int m_LineVBO = 0;
-    
-    // Batch Rendering Members
-    unsigned int m_BatchNodesVAO = 0;
-    unsigned int m_BatchNodesVBO = 0;
-    int m_BatchNodesCount = 0;
-    
-    unsigned int m_BatchOneWayVAO = 0;
-    unsigned int m_BatchOneWayVBO = 0;
-    int m_BatchOneWayCount = 0;
-    
-    unsigned int m_BatchTwoWayVAO = 0;
-    unsigned int m_BatchTwoWayVBO = 0;
-    int m_BatchTwoWayCount = 0;
-    
-    unsigned int m_BatchLightsVAO = 0;
-    unsigned int m_BatchLightsVBO = 0;
     
     void BuildGridMesh();
-    void RenderGridBatched();
     
     float m_LastFrameTime = 0.0f;
+    
+    // Auto camera orbit, framed around the loaded network
+    glm::vec3 m_OrbitCenter = glm::vec3(55.0f, 0.0f, 55.0f);
+    float m_OrbitRadius = 120.0f;
+    float m_OrbitHeight = 65.0f;
+    
+    std::string m_CheckpointFile = "checkpoint.tscp";
+    std::string m_RecordingFile = "trajectories.tstraj";
+    std::string m_TraceFile = "trace.json";
+    float m_TraceSeconds = 5.0f;
 };
@@ -24,17 +24,11 @@ void Application::RenderUI() {
     int oneWayEdges = 0;
     int twoWayEdges = 0;
     
-    for (const auto& [id, node] : graph->GetNodes()) {
-        for (const auto& edge : node->edges) {
+    for (int id = 0; id < (int)graph->GetNodeCount(); id++) {
+        for (int edgeId : graph->GetOutgoingEdges(id)) {
             totalEdges++;
             
-            bool isBidirectional = false;
-            for (const auto& reverseEdge : edge->to->edges) {
-                if (reverseEdge->to->id == node->id) {
-                    isBidirectional = true;
-                    break;
-                }
-            }
+            bool isBidirectional = graph->FindEdge(graph->GetEdgeTarget(edgeId), id) >= 0;
             
             if (isBidirectional) {
                 twoWayEdges++;
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Appends raw little-endian values to a memory buffer.
+// Used for checkpoints: everything is memcpy'd, so writing runs at memory speed.
+class BinaryWriter {
+public:
+    template<typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryWriter only writes plain data");
+        Append(&value, sizeof(T));
+    }
+    
+    // Element count followed by the raw elements
+    template<typename T>
+    void WriteArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryWriter only writes plain data");
+        Write<uint64_t>(values.size());
+        Append(values.data(), values.size() * sizeof(T));
+    }
+    
+    void WriteString(const std::string& value) {
+        Write<uint64_t>(value.size());
+        Append(value.data(), value.size());
+    }
+    
+    void Append(const void* data, size_t size) {
+        if (size == 0) return;
+        size_t offset = m_Data.size();
+        m_Data.resize(offset + size);
+        std::memcpy(m_Data.data() + offset, data, size);
+    }
+    
+    void Reserve(size_t size) { m_Data.reserve(size); }
+    std::vector<uint8_t>& GetData() { return m_Data; }
+    const std::vector<uint8_t>& GetData() const { return m_Data; }
+    
+private:
+    std::vector<uint8_t> m_Data;
+};
+
+// Reads values written by BinaryWriter. Every read is bounds checked; after the
+// first failure all reads fail and IsOk() returns false.
+class BinaryReader {
+public:
+    BinaryReader(const uint8_t* data, size_t size) : m_Data(data), m_Size(size) {}
+    
+    template<typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryReader only reads plain data");
+        return Copy(&value, sizeof(T));
+    }
+    
+    template<typename T>
+    bool ReadArray(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "BinaryReader only reads plain data");
+        uint64_t count = 0;
+        if (!Read(count) || count > (m_Size - m_Offset) / (sizeof(T) > 0 ? sizeof(T) : 1)) {
+            m_Ok = false;
+            return false;
+        }
+        values.resize((size_t)count);
+        return Copy(values.data(), (size_t)count * sizeof(T));
+    }
+    
+    bool ReadString(std::string& value) {
+        uint64_t length = 0;
+        if (!Read(length) || length > m_Size - m_Offset) {
+            m_Ok = false;
+            return false;
+        }
+        value.assign((const char*)m_Data + m_Offset, (size_t)length);
+        m_Offset += (size_t)length;
+        return true;
+    }
+    
+    bool IsOk() const { return m_Ok; }
+    bool IsAtEnd() const { return m_Offset == m_Size; }
+    
+private:
+    bool Copy(void* out, size_t size) {
+        if (!m_Ok || size > m_Size - m_Offset) {
+            m_Ok = false;
+            return false;
+        }
+        if (size > 0) std::memcpy(out, m_Data + m_Offset, size);
+        m_Offset += size;
+        return true;
+    }
+    
+    const uint8_t* m_Data;
+    size_t m_Size;
+    size_t m_Offset = 0;
+    bool m_Ok = true;
+};
@@ -0,0 +1,127 @@
+#include "CommandLine.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]" << std::endl;
+    std::cout << "  --scenario <file>  Grid size, street mix, signal density, fleet size and seed (key = value lines)" << std::endl;
+    std::cout << "  --network <file>   Load roads from a .tsnet file or an OpenStreetMap extract (.osm or .osm.pbf)" << std::endl;
+    std::cout << "  --export-network <file.tsnet>  Save the loaded network in the binary format for fast startup" << std::endl;
+    std::cout << "  --threads <n>      Number of simulation threads (spatial tiles)" << std::endl;
+    std::cout << "  --checkpoint <file.tscp>  Restore a saved checkpoint (same network required)" << std::endl;
+    std::cout << "  --record <file.tstraj>  Record vehicle trajectories" << std::endl;
+    std::cout << "  --replay <file.tstraj>  Play back a recording (load the network it was recorded on)" << std::endl;
+    std::cout << "  --seed <n>         Seed the random spawn and signal streams" << std::endl;
+    std::cout << "  --trace <file.json>  Capture a timeline for chrome://tracing or Perfetto (F9 in the window)" << std::endl;
+    std::cout << "  --trace-seconds <s>  Length of the trace capture (default 5)" << std::endl;
+    std::cout << "  --headless <s>     Simulate <s> seconds at 60 ticks/s without opening a window" << std::endl;
+    std::cout << "  --ensemble <n>     Run <n> seeds of the scenario on one shared network (--threads runs at once," << std::endl;
+    std::cout << "                     --headless seconds each, default 60) and report mean, spread and 95% CI" << std::endl;
+    std::cout << "  --offscreen <n>    Render <n> frames without a window or GPU (EGL, falling back to OSMesa)" << std::endl;
+    std::cout << "  --fps <n>          Offscreen frames per simulated second (default 30)" << std::endl;
+    std::cout << "  --resolution <WxH> Window or offscreen frame size (default 1280x720)" << std::endl;
+    std::cout << "  --capture <dir>    Save every rendered frame to <dir> as frame_00000.tga, ..." << std::endl;
+}
+
+CommandLineArgs ParseCommandLine(int argc, char** argv) {
+    CommandLineArgs args;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        
+        if (arg == "--scenario" && hasValue) {
+            args.scenarioFile = argv[++i];
+        } else if (arg == "--network" && hasValue) {
+            args.networkFile = argv[++i];
+        } else if (arg == "--export-network" && hasValue) {
+            args.exportNetworkFile = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            try {
+                args.threads = std::max(std::stoi(argv[++i]), 1);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid thread count: " << argv[i] << std::endl;
+            }
+        } else if (arg == "--checkpoint" && hasValue) {
+            args.checkpointFile = argv[++i];
+        } else if (arg == "--record" && hasValue) {
+            args.recordFile = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            args.replayFile = argv[++i];
+        } else if (arg == "--seed" && hasValue) {
+            try {
+                args.seed = (unsigned int)std::stoul(argv[++i]);
+                args.hasSeed = true;
+            } catch (const std::exception&) {
+                std::cerr << "Invalid seed: " << argv[i] << std::endl;
+            }
+        } else if (arg == "--trace" && hasValue) {
+            args.traceFile = argv[++i];
+        } else if (arg == "--trace-seconds" && hasValue) {
+            try {
+                args.traceSeconds = std::max(std::stof(argv[++i]), 0.0f);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid trace length: " << argv[i] << std::endl;
+            }
+        } else if (arg == "--headless" && hasValue) {
+            try {
+                args.headlessSeconds = std::max(std::stof(argv[++i]), 0.0f);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid headless duration: " << argv[i] << std::endl;
+            }
+        } else if (arg == "--ensemble" && hasValue) {
+            try {
+                args.ensembleRuns = std::max(std::stoi(argv[++i]), 0);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid ensemble run count: " << argv[i] << std::endl;
+            }
+        } else if (arg == "--offscreen" && hasValue) {
+            try {
+                args.offscreenFrames = std::max(std::stoi(argv[++i]), 0);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid offscreen frame count: " << argv[i] << std::endl;
+            }
+        } else if (arg == "--fps" && hasValue) {
+            try {
+                float frameRate = std::stof(argv[++i]);
+                if (frameRate > 0.0f) args.frameRate = frameRate;
+            } catch (const std::exception&) {
+                std::cerr << "Invalid frame rate: " << argv[i] << std::endl;
+            }
+        } else if (arg == "--resolution" && hasValue) {
+            int width = 0, height = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                args.width = width;
+                args.height = height;
+            } else {
+                std::cerr << "Invalid resolution (expected WxH): " << argv[i] << std::endl;
+            }
+        } else if (arg == "--capture" && hasValue) {
+            args.captureDir = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+        }
+    }
+    
+    return args;
+}
+
+Scenario LoadScenario(const CommandLineArgs& args) {
+    Scenario scenario;
+    if (!args.scenarioFile.empty() && !Scenario::Load(args.scenarioFile, scenario)) {
+        std::cerr << "Scenario " << args.scenarioFile << " has errors; using defaults for the invalid settings" << std::endl;
+    }
+    if (!args.networkFile.empty()) {
+        scenario.network = args.networkFile;
+    }
+    if (args.hasSeed) {
+        scenario.hasSeed = true;
+        scenario.seed = args.seed;
+    }
+    return scenario;
+}
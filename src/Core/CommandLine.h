@@ -0,0 +1,31 @@
+#pragma once
+#include "../Simulation/Scenario.h"
+#include <string>
+
+// Options passed on the command line
+struct CommandLineArgs {
+    std::string scenarioFile;  // --scenario <file>: network size, topology, signals, fleet and seed
+    std::string networkFile;   // --network <file.tsnet|file.osm|file.osm.pbf>
+    std::string exportNetworkFile;  // --export-network <file.tsnet>
+    int threads = 1;           // --threads <n>
+    std::string checkpointFile;  // --checkpoint <file.tscp>: restore on startup
+    std::string recordFile;    // --record <file.tstraj>: record trajectories from the start
+    std::string replayFile;    // --replay <file.tstraj>: play back a recording instead of simulating
+    bool hasSeed = false;      // --seed <n>: reproducible runs
+    unsigned int seed = 0;
+    std::string traceFile;     // --trace <file.json>: capture a Chrome trace from the start
+    float traceSeconds = 5.0f; // --trace-seconds <s>
+    float headlessSeconds = 0.0f;  // --headless <s>: simulate without a window, 0 = windowed
+    int ensembleRuns = 0;      // --ensemble <n>: n seeded runs on one shared network, --threads at once
+    int offscreenFrames = 0;   // --offscreen <n>: render n frames without a window (EGL, else OSMesa)
+    float frameRate = 30.0f;   // --fps <n>: offscreen frames per simulated second
+    int width = 1280;          // --resolution <WxH>
+    int height = 720;
+    std::string captureDir;    // --capture <dir>: save every rendered frame as a TGA image
+};
+
+// Parses argv. Unknown flags are reported and ignored.
+CommandLineArgs ParseCommandLine(int argc, char** argv);
+
+// The --scenario file, with --network and --seed taking precedence over it
+Scenario LoadScenario(const CommandLineArgs& args);
@@ -0,0 +1,445 @@
+#include "Compression.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+    constexpr int FastBits = 9;
+
+    // Canonical Huffman decoding table (count of codes per length + symbols sorted by code).
+    // Codes up to FastBits long are also resolved with a single table lookup.
+    struct Huffman {
+        uint16_t counts[16];
+        uint16_t symbols[320];
+        uint16_t fast[1 << FastBits];  // (length << 9) | symbol, 0 = use slow path
+    };
+
+    struct BitReader {
+        const uint8_t* data;
+        size_t size;
+        size_t pos = 0;
+        uint32_t bitBuffer = 0;
+        int bitCount = 0;
+        bool overrun = false;
+
+        int Bits(int need) {
+            uint32_t value = bitBuffer;
+            while (bitCount < need) {
+                if (pos >= size) {
+                    overrun = true;
+                    return 0;
+                }
+                value |= (uint32_t)data[pos++] << bitCount;
+                bitCount += 8;
+            }
+            bitBuffer = value >> need;
+            bitCount -= need;
+            return (int)(value & ((1u << need) - 1));
+        }
+
+        // Tops up the bit buffer without consuming anything
+        void Refill() {
+            while (bitCount <= 24 && pos < size) {
+                bitBuffer |= (uint32_t)data[pos++] << bitCount;
+                bitCount += 8;
+            }
+        }
+
+        void AlignToByte() {
+            pos -= bitCount / 8;  // Hand back whole bytes that were only prefetched
+            bitBuffer = 0;
+            bitCount = 0;
+        }
+    };
+
+    bool BuildHuffman(Huffman& h, const uint8_t* lengths, int n) {
+        std::memset(h.counts, 0, sizeof(h.counts));
+        std::memset(h.fast, 0, sizeof(h.fast));
+        for (int i = 0; i < n; i++) h.counts[lengths[i]]++;
+        if (h.counts[0] == n) return true;  // No codes (allowed for distance trees)
+
+        // Reject over-subscribed code sets
+        int left = 1;
+        for (int len = 1; len < 16; len++) {
+            left <<= 1;
+            left -= h.counts[len];
+            if (left < 0) return false;
+        }
+
+        uint16_t offsets[16];
+        offsets[1] = 0;
+        for (int len = 1; len < 15; len++) offsets[len + 1] = offsets[len] + h.counts[len];
+        for (int i = 0; i < n; i++) {
+            if (lengths[i] != 0) h.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+        }
+
+        // Fill the lookup table; deflate sends codes LSB-first, so index by the reversed code
+        int code = 0, index = 0;
+        for (int len = 1; len <= FastBits; len++) {
+            for (int k = 0; k < h.counts[len]; k++, code++, index++) {
+                int reversed = 0;
+                for (int b = 0; b < len; b++) reversed |= ((code >> b) & 1) << (len - 1 - b);
+                for (int fill = reversed; fill < (1 << FastBits); fill += 1 << len) {
+                    h.fast[fill] = (uint16_t)((len << 9) | h.symbols[index]);
+                }
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    int Decode(BitReader& in, const Huffman& h) {
+        in.Refill();
+        uint16_t entry = h.fast[in.bitBuffer & ((1 << FastBits) - 1)];
+        int len = entry >> 9;
+        if (entry != 0 && len <= in.bitCount) {
+            in.bitBuffer >>= len;
+            in.bitCount -= len;
+            return entry & 0x1FF;
+        }
+
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; len++) {
+            code |= in.Bits(1);
+            int count = h.counts[len];
+            if (code - count < first) return h.symbols[index + (code - first)];
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+            if (in.overrun) return -1;
+        }
+        return -1;
+    }
+
+    const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                       35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const uint16_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                     257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                     8193, 12289, 16385, 24577 };
+    const uint16_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                      7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    bool InflateCodes(BitReader& in, std::vector<uint8_t>& out, size_t outStart, const Huffman& lit, const Huffman& dist) {
+        while (true) {
+            int symbol = Decode(in, lit);
+            if (symbol < 0) return false;
+            if (symbol < 256) {
+                out.push_back((uint8_t)symbol);
+                continue;
+            }
+            if (symbol == 256) return true;
+
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            size_t length = kLengthBase[symbol] + in.Bits(kLengthExtra[symbol]);
+
+            int distSymbol = Decode(in, dist);
+            if (distSymbol < 0 || distSymbol >= 30) return false;
+            size_t distance = kDistBase[distSymbol] + in.Bits(kDistExtra[distSymbol]);
+            if (in.overrun || distance > out.size() - outStart) return false;
+
+            size_t from = out.size() - distance;
+            for (size_t i = 0; i < length; i++) {
+                out.push_back(out[from + i]);
+            }
+        }
+    }
+
+    bool InflateStored(BitReader& in, std::vector<uint8_t>& out) {
+        in.AlignToByte();
+        if (in.pos + 4 > in.size) return false;
+        uint16_t len = (uint16_t)(in.data[in.pos] | (in.data[in.pos + 1] << 8));
+        uint16_t nlen = (uint16_t)(in.data[in.pos + 2] | (in.data[in.pos + 3] << 8));
+        in.pos += 4;
+        if (len != (uint16_t)~nlen || in.pos + len > in.size) return false;
+        out.insert(out.end(), in.data + in.pos, in.data + in.pos + len);
+        in.pos += len;
+        return true;
+    }
+
+    bool InflateFixed(BitReader& in, std::vector<uint8_t>& out, size_t outStart) {
+        static Huffman lit, dist;
+        static bool built = [] {
+            uint8_t lengths[288];
+            int i = 0;
+            for (; i < 144; i++) lengths[i] = 8;
+            for (; i < 256; i++) lengths[i] = 9;
+            for (; i < 280; i++) lengths[i] = 7;
+            for (; i < 288; i++) lengths[i] = 8;
+            BuildHuffman(lit, lengths, 288);
+            for (i = 0; i < 30; i++) lengths[i] = 5;
+            BuildHuffman(dist, lengths, 30);
+            return true;
+        }();
+        (void)built;
+        return InflateCodes(in, out, outStart, lit, dist);
+    }
+
+    bool InflateDynamic(BitReader& in, std::vector<uint8_t>& out, size_t outStart) {
+        static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        int nlen = in.Bits(5) + 257;
+        int ndist = in.Bits(5) + 1;
+        int ncode = in.Bits(4) + 4;
+        if (nlen > 286 || ndist > 30) return false;
+
+        uint8_t lengths[320] = {};
+        for (int i = 0; i < ncode; i++) lengths[order[i]] = (uint8_t)in.Bits(3);
+
+        Huffman codeLengths;
+        if (!BuildHuffman(codeLengths, lengths, 19)) return false;
+
+        int index = 0;
+        while (index < nlen + ndist) {
+            int symbol = Decode(in, codeLengths);
+            if (symbol < 0) return false;
+            if (symbol < 16) {
+                lengths[index++] = (uint8_t)symbol;
+                continue;
+            }
+
+            uint8_t value = 0;
+            int repeat = 0;
+            if (symbol == 16) {
+                if (index == 0) return false;
+                value = lengths[index - 1];
+                repeat = 3 + in.Bits(2);
+            } else if (symbol == 17) {
+                repeat = 3 + in.Bits(3);
+            } else {
+                repeat = 11 + in.Bits(7);
+            }
+            if (index + repeat > nlen + ndist) return false;
+            while (repeat--) lengths[index++] = value;
+        }
+        if (lengths[256] == 0) return false;  // Block must be able to end
+
+        Huffman lit, dist;
+        if (!BuildHuffman(lit, lengths, nlen)) return false;
+        if (!BuildHuffman(dist, lengths + nlen, ndist)) return false;
+        return InflateCodes(in, out, outStart, lit, dist);
+    }
+
+
+    // ---- Compression ----
+
+    struct BitWriter {
+        std::vector<uint8_t>& out;
+        uint64_t bitBuffer = 0;
+        int bitCount = 0;
+
+        void Put(uint32_t bits, int count) {
+            bitBuffer |= (uint64_t)bits << bitCount;
+            bitCount += count;
+            while (bitCount >= 8) {
+                out.push_back((uint8_t)bitBuffer);
+                bitBuffer >>= 8;
+                bitCount -= 8;
+            }
+        }
+
+        void Flush() {
+            if (bitCount > 0) out.push_back((uint8_t)bitBuffer);
+            bitBuffer = 0;
+            bitCount = 0;
+        }
+    };
+
+    uint32_t ReverseBits(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+        return reversed;
+    }
+
+    // Fixed Huffman code tables (RFC 1951 3.2.6), bit-reversed for LSB-first output
+    struct FixedCodes {
+        uint16_t litCode[288];
+        uint8_t litLength[288];
+        uint8_t lengthSymbol[259];  // Match length -> length code index (0..28)
+        uint8_t distSymbolSmall[512];  // (distance - 1) < 256 -> code, else (distance - 1) >> 7
+
+        FixedCodes() {
+            for (int i = 0; i < 288; i++) {
+                uint32_t code;
+                int length;
+                if (i < 144) { code = 0x30 + i; length = 8; }
+                else if (i < 256) { code = 0x190 + (i - 144); length = 9; }
+                else if (i < 280) { code = i - 256; length = 7; }
+                else { code = 0xC0 + (i - 280); length = 8; }
+                litCode[i] = (uint16_t)ReverseBits(code, length);
+                litLength[i] = (uint8_t)length;
+            }
+            for (int symbol = 0; symbol < 29; symbol++) {
+                int last = symbol == 28 ? 258 : kLengthBase[symbol] + (1 << kLengthExtra[symbol]) - 1;
+                for (int length = kLengthBase[symbol]; length <= last && length <= 258; length++) {
+                    lengthSymbol[length] = (uint8_t)symbol;
+                }
+            }
+            lengthSymbol[258] = 28;
+            for (int symbol = 0; symbol < 30; symbol++) {
+                int first = kDistBase[symbol] - 1;
+                int last = first + (1 << kDistExtra[symbol]) - 1;
+                for (int d = first; d <= last; d++) {
+                    if (d < 256) distSymbolSmall[d] = (uint8_t)symbol;
+                    else distSymbolSmall[256 + (d >> 7)] = (uint8_t)symbol;
+                }
+            }
+        }
+
+        int DistanceSymbol(int distance) const {
+            int d = distance - 1;
+            return d < 256 ? distSymbolSmall[d] : distSymbolSmall[256 + (d >> 7)];
+        }
+    };
+
+    const FixedCodes& GetFixedCodes() {
+        static const FixedCodes codes;
+        return codes;
+    }
+
+    constexpr int WindowSize = 32768;
+    constexpr int HashBits = 15;
+    constexpr int MaxChain = 16;
+    constexpr int MinMatch = 3;
+    constexpr int MaxMatch = 258;
+
+    void DeflateFixed(const uint8_t* data, size_t size, BitWriter& writer) {
+        const FixedCodes& codes = GetFixedCodes();
+        writer.Put(1, 1);  // Final block
+        writer.Put(1, 2);  // Fixed Huffman
+
+        auto putLiteral = [&](int symbol) {
+            writer.Put(codes.litCode[symbol], codes.litLength[symbol]);
+        };
+
+        std::vector<int32_t> head(1 << HashBits, -1);
+        std::vector<int32_t> prev(WindowSize, -1);
+        auto hashAt = [&](size_t pos) {
+            uint32_t v = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16);
+            return (v * 2654435761u) >> (32 - HashBits);
+        };
+        auto insert = [&](size_t pos) {
+            uint32_t h = hashAt(pos);
+            prev[pos & (WindowSize - 1)] = head[h];
+            head[h] = (int32_t)pos;
+        };
+
+        size_t pos = 0;
+        while (pos < size) {
+            int bestLength = 0;
+            int bestDistance = 0;
+
+            if (pos + MinMatch <= size) {
+                int32_t candidate = head[hashAt(pos)];
+                int maxLength = (int)std::min<size_t>(MaxMatch, size - pos);
+                for (int chain = 0; chain < MaxChain && candidate >= 0; chain++) {
+                    int distance = (int)(pos - candidate);
+                    if (distance > WindowSize) break;
+
+                    const uint8_t* a = data + pos;
+                    const uint8_t* b = data + candidate;
+                    if (b[bestLength] == a[bestLength]) {
+                        int length = 0;
+                        while (length < maxLength && a[length] == b[length]) length++;
+                        if (length > bestLength) {
+                            bestLength = length;
+                            bestDistance = distance;
+                            if (length == maxLength) break;
+                        }
+                    }
+                    int32_t next = prev[candidate & (WindowSize - 1)];
+                    if (next >= candidate) break;  // Slot was overwritten by a newer position
+                    candidate = next;
+                }
+                insert(pos);
+            }
+
+            if (bestLength >= MinMatch) {
+                int lengthSymbol = codes.lengthSymbol[bestLength];
+                putLiteral(257 + lengthSymbol);
+                writer.Put(bestLength - kLengthBase[lengthSymbol], kLengthExtra[lengthSymbol]);
+
+                int distSymbol = codes.DistanceSymbol(bestDistance);
+                writer.Put(ReverseBits(distSymbol, 5), 5);
+                writer.Put(bestDistance - kDistBase[distSymbol], kDistExtra[distSymbol]);
+
+                // Index the skipped positions so later matches can find them
+                size_t end = pos + bestLength;
+                for (pos++; pos < end; pos++) {
+                    if (pos + MinMatch <= size) insert(pos);
+                }
+            } else {
+                putLiteral(data[pos]);
+                pos++;
+            }
+        }
+
+        putLiteral(256);  // End of block
+        writer.Flush();
+    }
+
+}
+
+namespace Compression {
+
+    uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler) {
+        uint32_t a = adler & 0xFFFF;
+        uint32_t b = adler >> 16;
+        while (size > 0) {
+            size_t block = size < 5552 ? size : 5552;  // Largest run without overflow
+            size -= block;
+            while (block--) {
+                a += *data++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        out.push_back(0x78);  // Deflate, 32K window
+        out.push_back(0x01);  // Fastest compression level, check bits
+        
+        BitWriter writer{ out };
+        DeflateFixed(data, size, writer);
+        
+        uint32_t adler = Adler32(data, size);
+        out.push_back((uint8_t)(adler >> 24));
+        out.push_back((uint8_t)(adler >> 16));
+        out.push_back((uint8_t)(adler >> 8));
+        out.push_back((uint8_t)adler);
+    }
+
+    bool ZlibDecompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t sizeHint) {
+        if (size < 6) return false;
+
+        // zlib header: deflate method, no preset dictionary, valid check bits
+        uint8_t cmf = data[0], flg = data[1];
+        if ((cmf & 0x0F) != 8 || (flg & 0x20) || ((cmf << 8) | flg) % 31 != 0) return false;
+
+        size_t outStart = out.size();
+        out.reserve(outStart + sizeHint);
+
+        BitReader in{ data + 2, size - 6 };
+        int last = 0;
+        while (!last) {
+            last = in.Bits(1);
+            int type = in.Bits(2);
+            bool ok = false;
+            if (type == 0) ok = InflateStored(in, out);
+            else if (type == 1) ok = InflateFixed(in, out, outStart);
+            else if (type == 2) ok = InflateDynamic(in, out, outStart);
+            if (!ok || in.overrun) return false;
+        }
+
+        const uint8_t* trailer = data + size - 4;
+        uint32_t expected = ((uint32_t)trailer[0] << 24) | ((uint32_t)trailer[1] << 16) | ((uint32_t)trailer[2] << 8) | trailer[3];
+        return Adler32(out.data() + outStart, out.size() - outStart) == expected;
+    }
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Self-contained zlib (RFC 1950 / RFC 1951) support, so file formats that use
+// zlib streams can be read and written without pulling in an external dependency.
+namespace Compression {
+
+    // Decompresses a zlib stream and appends the result to 'out'.
+    // 'sizeHint' pre-sizes the output when the caller knows the raw size.
+    // Returns false on corrupt input or checksum mismatch.
+    bool ZlibDecompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t sizeHint = 0);
+
+    // Compresses data into a zlib stream appended to 'out'. Greedy LZ77 with the
+    // fixed Huffman code: fast, and effective on delta-encoded data where long
+    // runs of small values dominate.
+    void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+    
+    // Adler-32 checksum used by zlib streams
+    uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+
+}
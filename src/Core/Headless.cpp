@@ -0,0 +1,95 @@
+#include "Headless.h"
+#include "CommandLine.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "../Simulation/EnsembleRunner.h"
+#include "../Simulation/TransportSimulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+
+int RunHeadless(const CommandLineArgs& args) {
+    TS_PROFILE_THREAD_NAME("Main");
+    
+    auto simulation = std::make_shared<TransportSimulation>();
+    simulation->SetScenario(LoadScenario(args));
+    simulation->SetThreadCount(args.threads);
+    simulation->Initialize();
+    if (!args.exportNetworkFile.empty()) {
+        simulation->ExportNetwork(args.exportNetworkFile);
+    }
+    if (!args.checkpointFile.empty()) {
+        simulation->LoadCheckpoint(args.checkpointFile);
+    }
+    if (!args.recordFile.empty()) {
+        simulation->StartRecording(args.recordFile);
+    }
+    if (!args.traceFile.empty()) {
+        Profiler::StartTrace(args.traceFile, args.traceSeconds);
+    }
+    
+    const float deltaTime = 1.0f / 60.0f;
+    int ticks = (int)std::ceil(args.headlessSeconds / deltaTime);
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) {
+        simulation->Update(deltaTime);
+        Profiler::Collect();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    Profiler::StopTrace();
+    simulation->StopRecording();
+    
+    std::cout << "Simulated " << ticks << " ticks in " << elapsed << "s ("
+              << (elapsed > 0.0 ? ticks / elapsed : 0.0) << " ticks/s)" << std::endl;
+    
+    const TrafficStatistics::Snapshot& stats = simulation->GetStatistics().GetSnapshot();
+    std::cout << "Vehicles: " << stats.active << " active, " << stats.spawned << " spawned, " << stats.arrived
+              << " arrived | Mean edge delay: " << stats.meanEdgeDelay << "s | Signal changes: "
+              << stats.signalChanges << std::endl;
+    return 0;
+}
+
+int RunEnsemble(const CommandLineArgs& args) {
+    TS_PROFILE_THREAD_NAME("Main");
+    
+    Scenario scenario = LoadScenario(args);
+    EnsembleRunner::Options options;
+    options.runs = args.ensembleRuns;
+    options.threads = args.threads;
+    options.seconds = args.headlessSeconds > 0.0f ? args.headlessSeconds : 60.0f;
+    options.baseSeed = scenario.hasSeed ? scenario.seed : std::random_device()();
+    
+    EnsembleRunner ensemble(scenario, options);
+    ensemble.SetRunCallback([](const EnsembleRunner::RunResult& result) {
+        using Metric = EnsembleRunner::Metric;
+        std::printf("Run %d (seed %u): %.0f arrived | Mean edge delay: %.3fs | Halted: %.1f%% | %.0f ticks/s\n",
+                    result.run, result.seed, result.values[(size_t)Metric::Arrived],
+                    result.values[(size_t)Metric::MeanEdgeDelay], result.values[(size_t)Metric::HaltedShare] * 100.0,
+                    result.values[(size_t)Metric::TicksPerSecond]);
+    });
+    
+    // Every run logs its fleet each second; only warnings are worth seeing here
+    LogLevel logLevel = Log::GetLevel();
+    Log::SetLevel(LogLevel::Warning);
+    auto start = std::chrono::steady_clock::now();
+    ensemble.Run();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Log::SetLevel(logLevel);
+    
+    std::printf("%d runs of %.0fs in %.2fs, %d at a time, base seed %u\n", ensemble.GetCompletedRuns(),
+                options.seconds, elapsed, std::min(options.threads, std::max(options.runs, 1)), options.baseSeed);
+    std::printf("%-22s %12s %12s %12s %12s %12s\n", "", "mean", "stddev", "95% CI +/-", "min", "max");
+    for (size_t metric = 0; metric < (size_t)EnsembleRunner::Metric::Count; metric++) {
+        const RunningStatistics& stats = ensemble.GetStatistics((EnsembleRunner::Metric)metric);
+        std::printf("%-22s %12.4g %12.4g %12.4g %12.4g %12.4g\n",
+                    EnsembleRunner::GetMetricName((EnsembleRunner::Metric)metric),
+                    stats.mean, stats.GetStandardDeviation(), stats.GetConfidenceHalfWidth(), stats.min, stats.max);
+    }
+    return 0;
+}
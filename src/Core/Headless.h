@@ -0,0 +1,14 @@
+#pragma once
+
+struct CommandLineArgs;
+
+// Runs the simulation without a window at a fixed 60 ticks per second of
+// simulated time, as fast as the machine allows. Honours the same network,
+// seed, thread, checkpoint, recording and trace options as the windowed app.
+int RunHeadless(const CommandLineArgs& args);
+
+// Runs --ensemble independent seeds of the scenario on one shared copy of the
+// network, --threads of them at a time, for --headless seconds each (60 if
+// unset). Prints one line per run and the mean, spread and 95% confidence
+// interval of each figure.
+int RunEnsemble(const CommandLineArgs& args);
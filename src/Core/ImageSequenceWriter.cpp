@@ -0,0 +1,127 @@
+#include "ImageSequenceWriter.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+ImageSequenceWriter::~ImageSequenceWriter() {
+    Stop();
+}
+
+bool ImageSequenceWriter::Start(const std::string& directory) {
+    Stop();
+    
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create capture directory " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+    
+    m_Directory = directory;
+    m_Queue.clear();
+    m_Stop = false;
+    m_WrittenFrames = 0;
+    m_ProducerWaits = 0;
+    m_WriteFailed = false;
+    m_Worker = std::thread(&ImageSequenceWriter::WriterLoop, this);
+    
+    std::cout << "Capturing frames to " << directory << std::endl;
+    return true;
+}
+
+void ImageSequenceWriter::Stop() {
+    if (!m_Worker.joinable()) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_QueueChanged.notify_all();
+    m_Worker.join();
+    
+    std::cout << "Captured " << m_WrittenFrames << " frames to " << m_Directory;
+    if (m_ProducerWaits > 0) {
+        std::cout << " (renderer waited " << m_ProducerWaits << " times for the disk)";
+    }
+    std::cout << std::endl;
+}
+
+ImageSequenceWriter::Image ImageSequenceWriter::AcquireImage(int width, int height) {
+    Image image;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        if (m_Queue.size() >= MaxQueuedImages) {
+            m_ProducerWaits++;
+            m_QueueChanged.wait(lock, [this] { return m_Queue.size() < MaxQueuedImages; });
+        }
+        if (!m_Free.empty()) {
+            image = std::move(m_Free.back());
+            m_Free.pop_back();
+        }
+    }
+    image.width = width;
+    image.height = height;
+    image.pixels.resize((size_t)width * height * 4);
+    return image;
+}
+
+void ImageSequenceWriter::Submit(Image image) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queue.push_back(std::move(image));
+    }
+    m_QueueChanged.notify_all();
+}
+
+void ImageSequenceWriter::WriterLoop() {
+    uint64_t frame = 0;
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        m_QueueChanged.wait(lock, [this] { return m_Stop || !m_Queue.empty(); });
+        if (m_Queue.empty()) break;  // Stopping, and everything is written
+        
+        Image image = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        lock.unlock();
+        m_QueueChanged.notify_all();
+        
+        bool written = !m_WriteFailed && WriteImage(image, frame);
+        frame++;
+        
+        lock.lock();
+        if (written) m_WrittenFrames++;
+        m_Free.push_back(std::move(image));
+    }
+}
+
+bool ImageSequenceWriter::WriteImage(const Image& image, uint64_t frame) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05llu.tga", (unsigned long long)frame);
+    std::string path = (std::filesystem::path(m_Directory) / name).string();
+    
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to write " << path << "; capture stopped" << std::endl;
+        m_WriteFailed = true;
+        return false;
+    }
+    
+    // Uncompressed true-colour, 8 alpha bits, origin bottom-left
+    uint8_t header[18] = {};
+    header[2] = 2;
+    header[12] = (uint8_t)(image.width & 0xFF);
+    header[13] = (uint8_t)(image.width >> 8);
+    header[14] = (uint8_t)(image.height & 0xFF);
+    header[15] = (uint8_t)(image.height >> 8);
+    header[16] = 32;
+    header[17] = 8;
+    
+    bool ok = std::fwrite(header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(image.pixels.data(), 1, image.pixels.size(), file) == image.pixels.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write " << path << "; capture stopped" << std::endl;
+        m_WriteFailed = true;
+    }
+    return ok;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes captured frames as numbered 32-bit TGA files (frame_00000.tga, ...)
+// on a worker thread. TGA keeps BGRA rows bottom-up, which is exactly what
+// glReadPixels returns, so encoding is just an 18-byte header and the file
+// write. "ffmpeg -framerate 30 -i frame_%05d.tga out.mp4" makes a video.
+class ImageSequenceWriter {
+public:
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;  // BGRA, bottom row first
+    };
+    
+    // Images handed over but not yet written. Beyond this the producer waits:
+    // a video with dropped frames is worse than a slower capture.
+    static constexpr size_t MaxQueuedImages = 8;
+    
+    ImageSequenceWriter() = default;
+    ~ImageSequenceWriter();
+    
+    // Creates the directory if needed
+    bool Start(const std::string& directory);
+    // Writes everything still queued, then stops the worker
+    void Stop();
+    bool IsRunning() const { return m_Worker.joinable(); }
+    
+    // Producer: an image to fill, reusing a written one's storage when possible
+    Image AcquireImage(int width, int height);
+    void Submit(Image image);
+    
+    uint64_t GetWrittenFrames() const { return m_WrittenFrames; }
+    uint64_t GetProducerWaits() const { return m_ProducerWaits; }
+    
+private:
+    void WriterLoop();
+    bool WriteImage(const Image& image, uint64_t frame);
+    
+    std::string m_Directory;
+    std::thread m_Worker;
+    std::mutex m_Mutex;
+    std::condition_variable m_QueueChanged;
+    std::deque<Image> m_Queue;
+    std::vector<Image> m_Free;  // Written, storage kept for reuse
+    bool m_Stop = false;
+    
+    std::atomic<uint64_t> m_WrittenFrames{ 0 };
+    std::atomic<uint64_t> m_ProducerWaits{ 0 };
+    bool m_WriteFailed = false;    // Worker only
+};
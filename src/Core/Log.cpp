@@ -0,0 +1,237 @@
+#include "Log.h"
+#include "SpscRing.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    struct LogRecord {
+        uint64_t time;        // Nanoseconds since the logger started
+        uint32_t suppressed;  // Messages from the same call site dropped by the rate limit before this one
+        LogLevel level;
+        LogCategory category;
+        char message[Log::MessageLength];
+    };
+
+    struct ThreadBuffer {
+        SpscRing<LogRecord> records{ Log::RingCapacity };
+        std::atomic<bool> retired{ false };  // Owning thread has exited
+    };
+
+    constexpr uint64_t RateWindowNs = 1000000000ull;
+    constexpr auto SinkInterval = std::chrono::milliseconds(10);
+
+    struct LogState {
+        std::mutex registryMutex;  // Only taken when a thread logs for the first time, and by the sink
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::atomic<LogLevel> level{ LogLevel::Debug };
+        std::atomic<uint64_t> dropped{ 0 };
+
+        std::thread sink;
+        std::mutex sinkMutex;
+        std::condition_variable wake;
+        bool stopping = false;  // Guarded by sinkMutex
+        bool stopped = false;
+
+        // Sink thread only
+        std::vector<LogRecord> batch;
+        uint64_t reportedDrops = 0;
+
+        ~LogState() { Log::Shutdown(); }
+    };
+
+    const std::chrono::steady_clock::time_point s_Epoch = std::chrono::steady_clock::now();
+
+    uint64_t Now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count();
+    }
+
+    LogState& GetState() {
+        static LogState state;
+        return state;
+    }
+
+    void WriteRecord(const LogRecord& record) {
+        std::ostream& out = record.level >= LogLevel::Warning ? std::cerr : std::cout;
+        char prefix[64];
+        std::snprintf(prefix, sizeof(prefix), "[%9.3f] %-7s %-10s ", record.time / 1.0e9,
+                      Log::GetLevelName(record.level), Log::GetCategoryName(record.category));
+        out << prefix << record.message;
+        if (record.suppressed > 0) {
+            out << " (" << record.suppressed << " similar messages suppressed)";
+        }
+        out << '\n';
+    }
+
+    // Moves every queued record to the console, oldest first. Returns how many were written.
+    size_t Drain(LogState& state) {
+        state.batch.clear();
+        {
+            std::lock_guard<std::mutex> lock(state.registryMutex);
+            // As in the profiler: read the retired flag before draining so a
+            // thread's last messages are written before its ring is released
+            auto retiredIt = std::remove_if(state.buffers.begin(), state.buffers.end(),
+                [&](const std::shared_ptr<ThreadBuffer>& buffer) {
+                    bool retired = buffer->retired;
+                    LogRecord record;
+                    while (buffer->records.TryPop(record)) {
+                        state.batch.push_back(record);
+                    }
+                    return retired;
+                });
+            state.buffers.erase(retiredIt, state.buffers.end());
+        }
+
+        std::stable_sort(state.batch.begin(), state.batch.end(),
+            [](const LogRecord& a, const LogRecord& b) { return a.time < b.time; });
+        for (const auto& record : state.batch) {
+            WriteRecord(record);
+        }
+
+        uint64_t dropped = state.dropped.load(std::memory_order_relaxed);
+        if (dropped != state.reportedDrops) {
+            std::cerr << "[Log] " << dropped - state.reportedDrops << " messages dropped, queue full" << '\n';
+            state.reportedDrops = dropped;
+        }
+        if (!state.batch.empty()) {
+            std::cout.flush();
+            std::cerr.flush();
+        }
+        return state.batch.size();
+    }
+
+    void RunSink(LogState& state) {
+        std::unique_lock<std::mutex> lock(state.sinkMutex);
+        while (true) {
+            bool stopping = state.stopping;
+            lock.unlock();
+            Drain(state);
+            lock.lock();
+            if (stopping) break;
+            state.wake.wait_for(lock, SinkInterval, [&] { return state.stopping; });
+        }
+    }
+
+    // Registers the calling thread's ring on first use and retires it on thread exit
+    struct ThreadSlot {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~ThreadSlot() {
+            if (buffer) buffer->retired = true;
+        }
+
+        ThreadBuffer& Get() {
+            if (!buffer) {
+                buffer = std::make_shared<ThreadBuffer>();
+                LogState& state = GetState();
+                {
+                    std::lock_guard<std::mutex> lock(state.registryMutex);
+                    state.buffers.push_back(buffer);
+                }
+                std::lock_guard<std::mutex> lock(state.sinkMutex);
+                if (!state.sink.joinable() && !state.stopped) {
+                    state.sink = std::thread(RunSink, std::ref(state));
+                }
+            }
+            return *buffer;
+        }
+    };
+
+    thread_local ThreadSlot t_Slot;
+
+    // Lets RateLimit messages through per window and counts the rest.
+    // Returns false to drop; 'suppressed' receives the count from the previous window.
+    bool PassRateLimit(LogSite& site, uint64_t now, uint32_t& suppressed) {
+        suppressed = 0;
+        uint64_t windowStart = site.windowStart.load(std::memory_order_relaxed);
+        if (now - windowStart >= RateWindowNs &&
+            site.windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+            suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+            site.count.store(0, std::memory_order_relaxed);
+        }
+        if (site.count.fetch_add(1, std::memory_order_relaxed) >= Log::RateLimit) {
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+}
+
+void Log::SetLevel(LogLevel level) {
+    GetState().level.store(level, std::memory_order_relaxed);
+}
+
+LogLevel Log::GetLevel() {
+    return GetState().level.load(std::memory_order_relaxed);
+}
+
+void Log::Write(LogLevel level, LogCategory category, LogSite& site, const char* format, ...) {
+    LogState& state = GetState();
+    if (level < state.level.load(std::memory_order_relaxed)) return;
+
+    LogRecord record;
+    record.time = Now();
+    if (!PassRateLimit(site, record.time, record.suppressed)) return;
+    record.level = level;
+    record.category = category;
+
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(record.message, sizeof(record.message), format, args);
+    va_end(args);
+
+    if (!t_Slot.Get().records.TryPush(record)) {
+        state.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Log::Shutdown() {
+    LogState& state = GetState();
+    std::thread sink;
+    {
+        std::lock_guard<std::mutex> lock(state.sinkMutex);
+        if (state.stopped) return;
+        state.stopping = true;
+        state.stopped = true;
+        sink = std::move(state.sink);
+    }
+    state.wake.notify_all();
+    if (sink.joinable()) {
+        sink.join();
+    }
+    Drain(state);  // Anything logged after the sink's last pass
+}
+
+uint64_t Log::GetDroppedMessages() {
+    return GetState().dropped.load(std::memory_order_relaxed);
+}
+
+const char* Log::GetLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "Debug";
+        case LogLevel::Info: return "Info";
+        case LogLevel::Warning: return "Warning";
+        case LogLevel::Error: return "Error";
+        default: return "Off";
+    }
+}
+
+const char* Log::GetCategoryName(LogCategory category) {
+    switch (category) {
+        case LogCategory::General: return "General";
+        case LogCategory::Simulation: return "Simulation";
+        case LogCategory::Routing: return "Routing";
+        case LogCategory::Network: return "Network";
+        case LogCategory::Render: return "Render";
+        default: return "Unknown";
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+enum class LogCategory : uint8_t {
+    General = 0,
+    Simulation,
+    Routing,
+    Network,
+    Render,
+    Count
+};
+
+// Compile-time filters. Calls below TS_LOG_LEVEL, or in a category whose bit is
+// clear in TS_LOG_CATEGORIES, expand to nothing.
+#ifndef TS_LOG_LEVEL
+#ifdef NDEBUG
+#define TS_LOG_LEVEL 1  // Info
+#else
+#define TS_LOG_LEVEL 0  // Debug
+#endif
+#endif
+
+#ifndef TS_LOG_CATEGORIES
+#define TS_LOG_CATEGORIES 0xFFFFFFFFu
+#endif
+
+// Per call site state for rate limiting, one per TS_LOG statement
+struct LogSite {
+    std::atomic<uint64_t> windowStart{ 0 };
+    std::atomic<uint32_t> count{ 0 };
+    std::atomic<uint32_t> suppressed{ 0 };
+};
+
+// Asynchronous logger. Each thread formats its messages into its own
+// lock-free ring; a background sink thread drains the rings, orders the
+// messages by time and writes them to the console. Logging never blocks or
+// touches I/O on the calling thread: a message is dropped when its thread's
+// ring is full, and a call site logging more than RateLimit messages per
+// second has the excess counted and reported with its next message.
+class Log {
+public:
+    static constexpr uint32_t RateLimit = 10;       // Messages per call site per second
+    static constexpr size_t RingCapacity = 1024;    // Messages buffered per thread
+    static constexpr size_t MessageLength = 224;    // Longer messages are truncated
+
+    static constexpr bool IsCompiledIn(LogLevel level, LogCategory category) {
+        return level >= (LogLevel)TS_LOG_LEVEL && level != LogLevel::Off &&
+               ((TS_LOG_CATEGORIES >> (unsigned)category) & 1u) != 0;
+    }
+
+    // Runtime threshold on top of the compile-time one
+    static void SetLevel(LogLevel level);
+    static LogLevel GetLevel();
+
+    // printf-style; any thread. Use the TS_LOG macros rather than calling this directly.
+    static void Write(LogLevel level, LogCategory category, LogSite& site, const char* format, ...);
+
+    // Writes everything logged so far and stops the sink. Call before exiting.
+    static void Shutdown();
+
+    static uint64_t GetDroppedMessages();
+    static const char* GetLevelName(LogLevel level);
+    static const char* GetCategoryName(LogCategory category);
+};
+
+#define TS_LOG(level, category, ...)                                  \
+    do {                                                              \
+        if constexpr (Log::IsCompiledIn(level, category)) {           \
+            static LogSite tsLogSite;                                 \
+            Log::Write(level, category, tsLogSite, __VA_ARGS__);      \
+        }                                                             \
+    } while (0)
+
+#define TS_LOG_DEBUG(category, ...) TS_LOG(LogLevel::Debug, LogCategory::category, __VA_ARGS__)
+#define TS_LOG_INFO(category, ...) TS_LOG(LogLevel::Info, LogCategory::category, __VA_ARGS__)
+#define TS_LOG_WARNING(category, ...) TS_LOG(LogLevel::Warning, LogCategory::category, __VA_ARGS__)
+#define TS_LOG_ERROR(category, ...) TS_LOG(LogLevel::Error, LogCategory::category, __VA_ARGS__)
@@ -0,0 +1,269 @@
+#include "Profiler.h"
+#include "SpscRing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+    struct ThreadBuffer {
+        SpscRing<ProfileEvent> events{ Profiler::RingCapacity };
+        std::atomic<bool> retired{ false };  // Owning thread has exited
+        uint32_t threadId = 0;               // Sequential, used as the trace tid
+        std::string name;                    // Guarded by the registry mutex
+    };
+
+    struct TraceEvent {
+        ProfileEvent event;
+        uint32_t threadId;
+    };
+
+    struct PhaseWindow {
+        float samples[Profiler::HistoryLength] = {};
+        size_t next = 0;
+        size_t count = 0;
+    };
+
+    struct ProfilerState {
+        std::mutex registryMutex;  // Only taken when a thread records its first event, and by Collect
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::atomic<uint64_t> dropped{ 0 };
+
+        // Consumer only
+        PhaseWindow windows[(size_t)ProfilePhase::Count];
+        Profiler::PhaseStats stats[(size_t)ProfilePhase::Count];
+        std::vector<ProfileEvent> drained;
+        std::vector<float> sorted;
+        uint32_t nextThreadId = 1;
+
+        // Trace capture
+        bool tracing = false;
+        std::string tracePath;
+        uint64_t traceStart = 0;
+        uint64_t traceEnd = 0;
+        std::vector<TraceEvent> traceEvents;
+        std::map<uint32_t, std::string> traceThreads;
+    };
+
+    const std::chrono::steady_clock::time_point s_Epoch = std::chrono::steady_clock::now();
+
+    ProfilerState& GetState() {
+        static ProfilerState state;
+        return state;
+    }
+
+    // Registers the calling thread's ring on first use and retires it on thread exit
+    struct ThreadSlot {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~ThreadSlot() {
+            if (buffer) buffer->retired = true;
+        }
+
+        ThreadBuffer& Get() {
+            if (!buffer) {
+                buffer = std::make_shared<ThreadBuffer>();
+                ProfilerState& state = GetState();
+                std::lock_guard<std::mutex> lock(state.registryMutex);
+                buffer->threadId = state.nextThreadId++;
+                state.buffers.push_back(buffer);
+            }
+            return *buffer;
+        }
+    };
+
+    thread_local ThreadSlot t_Slot;
+
+    const char* GetPhaseCategory(ProfilePhase phase) {
+        if (phase == ProfilePhase::Routing) return "routing";
+        if (phase >= ProfilePhase::Render) return "render";
+        return "sim";
+    }
+
+    // Chrome trace event format: complete ("X") events, timestamps in microseconds
+    void WriteTrace(ProfilerState& state) {
+        FILE* file = std::fopen(state.tracePath.c_str(), "w");
+        if (!file) {
+            std::cerr << "Failed to create trace file: " << state.tracePath << std::endl;
+            return;
+        }
+
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Transport-Sim\"}}");
+        for (const auto& [threadId, name] : state.traceThreads) {
+            std::string label = name.empty() ? "Thread " + std::to_string(threadId) : name;
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         threadId, label.c_str());
+        }
+        for (const auto& trace : state.traceEvents) {
+            const ProfileEvent& event = trace.event;
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+                         Profiler::GetPhaseName(event.phase), GetPhaseCategory(event.phase),
+                         (event.start - state.traceStart) / 1000.0, event.duration / 1000.0, trace.threadId);
+            if (event.arg >= 0) {
+                std::fprintf(file, ",\"args\":{\"tile\":%d}", event.arg);
+            }
+            std::fprintf(file, "}");
+        }
+        std::fprintf(file, "\n]}\n");
+
+        if (std::fclose(file) != 0) {
+            std::cerr << "Failed to write trace file: " << state.tracePath << std::endl;
+        } else {
+            std::cout << "Wrote " << state.traceEvents.size() << " trace events to " << state.tracePath << std::endl;
+        }
+    }
+
+}
+
+uint64_t Profiler::Now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count();
+}
+
+const char* Profiler::GetPhaseName(ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::SimUpdate: return "Update";
+        case ProfilePhase::SimSignals: return "Signals";
+        case ProfilePhase::SimVehicleMove: return "Vehicle Move";
+        case ProfilePhase::SimCollision: return "Collision";
+        case ProfilePhase::SimLifecycle: return "Lifecycle";
+        case ProfilePhase::SimSpawnQueue: return "Spawn Queue";
+        case ProfilePhase::SimTransit: return "Transit";
+        case ProfilePhase::SimTile: return "Tile";
+        case ProfilePhase::SimBarrier: return "Barrier Wait";
+        case ProfilePhase::Routing: return "Routing";
+        case ProfilePhase::Render: return "Render";
+        case ProfilePhase::RenderGrid: return "RenderGrid";
+        case ProfilePhase::RenderVehicles: return "RenderVehicles";
+        case ProfilePhase::RenderFlush: return "RenderFlush";
+        case ProfilePhase::RenderUI: return "RenderUI";
+        default: return "Unknown";
+    }
+}
+
+void Profiler::Record(ProfilePhase phase, uint64_t start, uint64_t end, int32_t arg) {
+    ProfileEvent event = { start, end - start, phase, arg };
+    if (!t_Slot.Get().events.TryPush(event)) {
+        GetState().dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+    ThreadBuffer& buffer = t_Slot.Get();
+    std::lock_guard<std::mutex> lock(GetState().registryMutex);
+    buffer.name = name;
+}
+
+void Profiler::Collect() {
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.registryMutex);
+
+    bool updated[(size_t)ProfilePhase::Count] = {};
+    state.drained.resize(RingCapacity);
+    auto drain = [&](ThreadBuffer& buffer) {
+        size_t count = buffer.events.TryPop(state.drained.data(), state.drained.size());
+        if (state.tracing && count > 0) {
+            state.traceThreads[buffer.threadId] = buffer.name;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const ProfileEvent& event = state.drained[i];
+            if (state.tracing && event.start >= state.traceStart && event.start < state.traceEnd) {
+                state.traceEvents.push_back({ event, buffer.threadId });
+            }
+            size_t phase = (size_t)event.phase;
+            if (phase >= (size_t)ProfilePhase::Count) continue;
+
+            PhaseWindow& window = state.windows[phase];
+            window.samples[window.next] = (float)(event.duration / 1.0e6);
+            window.next = (window.next + 1) % HistoryLength;
+            window.count = std::min(window.count + 1, HistoryLength);
+            updated[phase] = true;
+        }
+    };
+
+    // A retired thread pushes nothing after setting the flag, so reading the flag
+    // before draining guarantees its last events are collected before it is dropped
+    auto retiredIt = std::remove_if(state.buffers.begin(), state.buffers.end(),
+        [&](const std::shared_ptr<ThreadBuffer>& buffer) {
+            bool retired = buffer->retired;
+            drain(*buffer);
+            return retired;
+        });
+    state.buffers.erase(retiredIt, state.buffers.end());
+
+    for (size_t phase = 0; phase < (size_t)ProfilePhase::Count; phase++) {
+        if (!updated[phase]) continue;
+
+        const PhaseWindow& window = state.windows[phase];
+        PhaseStats& stats = state.stats[phase];
+        size_t oldest = (window.next + HistoryLength - window.count) % HistoryLength;
+        for (size_t i = 0; i < window.count; i++) {
+            stats.history[i] = window.samples[(oldest + i) % HistoryLength];
+        }
+        stats.count = window.count;
+
+        state.sorted.assign(stats.history, stats.history + stats.count);
+        std::sort(state.sorted.begin(), state.sorted.end());
+        stats.p50 = state.sorted[(state.sorted.size() - 1) / 2];
+        stats.p99 = state.sorted[(state.sorted.size() - 1) * 99 / 100];
+    }
+
+    if (state.tracing && Now() >= state.traceEnd) {
+        WriteTrace(state);
+        state.tracing = false;
+        state.traceEvents.clear();
+        state.traceThreads.clear();
+    }
+}
+
+const Profiler::PhaseStats& Profiler::GetStats(ProfilePhase phase) {
+    return GetState().stats[std::min((size_t)phase, (size_t)ProfilePhase::Count - 1)];
+}
+
+uint64_t Profiler::GetDroppedEvents() {
+    return GetState().dropped.load(std::memory_order_relaxed);
+}
+
+bool Profiler::StartTrace([[maybe_unused]] const std::string& path, [[maybe_unused]] double seconds) {
+#if !TS_ENABLE_PROFILER
+    std::cerr << "Tracing unavailable: built without the profiler" << std::endl;
+    return false;
+#else
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.registryMutex);
+    if (state.tracing) return false;
+
+    state.tracing = true;
+    state.tracePath = path;
+    state.traceStart = Now();
+    state.traceEnd = state.traceStart + (uint64_t)(seconds * 1.0e9);
+    state.traceEvents.clear();
+    state.traceThreads.clear();
+    std::cout << "Tracing for " << seconds << "s to " << path << std::endl;
+    return true;
+#endif
+}
+
+void Profiler::StopTrace() {
+    ProfilerState& state = GetState();
+    if (!IsTracing()) return;
+
+    // Pick up events still in the rings, then end the capture now
+    {
+        std::lock_guard<std::mutex> lock(state.registryMutex);
+        state.traceEnd = std::min(state.traceEnd, Now());
+    }
+    Collect();
+}
+
+bool Profiler::IsTracing() {
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.registryMutex);
+    return state.tracing;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Set TS_ENABLE_PROFILER=0 (premake --no-profiler) to compile all
+// instrumentation out; TS_PROFILE_SCOPE then expands to nothing.
+#ifndef TS_ENABLE_PROFILER
+#define TS_ENABLE_PROFILER 1
+#endif
+
+// Instrumented phases of a simulation tick and a rendered frame
+enum class ProfilePhase : uint8_t {
+    SimUpdate = 0,
+    SimSignals,
+    SimVehicleMove,
+    SimCollision,
+    SimLifecycle,
+    SimSpawnQueue,
+    SimTransit,      // Transit departures, boarding and passenger journeys
+    SimTile,         // One tile's share of the tick on its worker
+    SimBarrier,      // Tile waiting for the other tiles
+    Routing,
+    Render,
+    RenderGrid,
+    RenderVehicles,
+    RenderFlush,     // Submitting the sorted render queue
+    RenderUI,
+    Count
+};
+
+struct ProfileEvent {
+    uint64_t start;     // Nanoseconds since the profiler started
+    uint64_t duration;  // Nanoseconds
+    ProfilePhase phase;
+    int32_t arg;        // Phase-specific detail (tile index), -1 if none
+};
+
+// Per-phase scoped timers. Each thread writes its events into its own
+// lock-free ring; the UI thread drains all rings in Collect and keeps a
+// rolling window of durations per phase. While a trace is being captured the
+// drained events are also kept and written as a Chrome trace (.json) that
+// chrome://tracing and ui.perfetto.dev can open.
+class Profiler {
+public:
+    static constexpr size_t HistoryLength = 240;  // Samples kept per phase
+    static constexpr size_t RingCapacity = 8192;  // Events buffered per thread between Collects
+
+    struct PhaseStats {
+        float history[HistoryLength] = {};  // Milliseconds, oldest first after Collect
+        size_t count = 0;                   // Valid entries in history
+        float p50 = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    static uint64_t Now();
+    static const char* GetPhaseName(ProfilePhase phase);
+
+    // Any thread; never blocks. The event is dropped if the thread's ring is full.
+    static void Record(ProfilePhase phase, uint64_t start, uint64_t end, int32_t arg = -1);
+
+    // Labels the calling thread in traces
+    static void SetThreadName(const std::string& name);
+
+    // Single consumer: drains every thread's ring into the per-phase statistics
+    static void Collect();
+
+    static const PhaseStats& GetStats(ProfilePhase phase);
+    static uint64_t GetDroppedEvents();
+
+    // Captures every event for 'seconds' of wall-clock time, then writes the trace.
+    // Collect must keep being called meanwhile. Same thread as Collect.
+    static bool StartTrace(const std::string& path, double seconds);
+    static void StopTrace();  // Writes what was captured so far
+    static bool IsTracing();
+};
+
+// Times the enclosing scope
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase, int32_t arg = -1) : m_Phase(phase), m_Arg(arg), m_Start(Profiler::Now()) {}
+    ~ProfileScope() { Profiler::Record(m_Phase, m_Start, Profiler::Now(), m_Arg); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfilePhase m_Phase;
+    int32_t m_Arg;
+    uint64_t m_Start;
+};
+
+#if TS_ENABLE_PROFILER
+#define TS_PROFILE_CONCAT_INNER(a, b) a##b
+#define TS_PROFILE_CONCAT(a, b) TS_PROFILE_CONCAT_INNER(a, b)
+#define TS_PROFILE_SCOPE(phase) ProfileScope TS_PROFILE_CONCAT(profileScope, __LINE__)(phase)
+#define TS_PROFILE_SCOPE_ARG(phase, arg) ProfileScope TS_PROFILE_CONCAT(profileScope, __LINE__)(phase, arg)
+#define TS_PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#else
+#define TS_PROFILE_SCOPE(phase)
+#define TS_PROFILE_SCOPE_ARG(phase, arg)
+#define TS_PROFILE_THREAD_NAME(name)
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// The producer never blocks: pushes fail when the ring is full.
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        m_Buffer.resize(size);
+        m_Mask = size - 1;
+    }
+    
+    size_t GetCapacity() const { return m_Buffer.size(); }
+    
+    // Producer side
+    bool TryPush(const T& value) {
+        return TryPush(&value, 1);
+    }
+    
+    // All or nothing
+    bool TryPush(const T* values, size_t count) {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+        size_t tail = m_Tail.load(std::memory_order_acquire);
+        if (m_Buffer.size() - (head - tail) < count) return false;
+        
+        size_t start = head & m_Mask;
+        size_t first = std::min(count, m_Buffer.size() - start);
+        std::copy(values, values + first, m_Buffer.begin() + start);
+        std::copy(values + first, values + count, m_Buffer.begin());
+        
+        m_Head.store(head + count, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side
+    bool TryPop(T& value) {
+        return TryPop(&value, 1) == 1;
+    }
+    
+    // Pops up to maxCount values, returns how many were popped
+    size_t TryPop(T* out, size_t maxCount) {
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+        size_t head = m_Head.load(std::memory_order_acquire);
+        size_t count = std::min(maxCount, head - tail);
+        if (count == 0) return 0;
+        
+        size_t start = tail & m_Mask;
+        size_t first = std::min(count, m_Buffer.size() - start);
+        std::copy(m_Buffer.begin() + start, m_Buffer.begin() + start + first, out);
+        std::copy(m_Buffer.begin(), m_Buffer.begin() + (count - first), out + first);
+        
+        m_Tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+    
+    // Approximate when called concurrently
+    size_t GetSize() const {
+        return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire);
+    }
+    
+private:
+    std::vector<T> m_Buffer;
+    size_t m_Mask = 0;
+    
+    // Separate cache lines so producer and consumer do not false-share
+    alignas(64) std::atomic<size_t> m_Head{ 0 };  // Next slot to write
+    alignas(64) std::atomic<size_t> m_Tail{ 0 };  // Next slot to read
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of the latest value from one producer thread to one
+// consumer thread. The producer fills the back buffer and publishes it; the
+// consumer swaps in the newest published buffer whenever it likes. Neither
+// side ever waits, intermediate values the consumer was too slow for are
+// skipped, and buffers are reused so their allocations carry over.
+template<typename T>
+class TripleBuffer {
+public:
+    // Producer side
+    T& GetWriteBuffer() { return m_Buffers[m_Write]; }
+    
+    void Publish() {
+        uint8_t previous = m_Middle.exchange((uint8_t)(m_Write | FreshBit), std::memory_order_acq_rel);
+        m_Write = previous & IndexMask;
+    }
+    
+    // Consumer side: returns false (and keeps the current buffer) if nothing new was published
+    bool Acquire() {
+        if (!(m_Middle.load(std::memory_order_relaxed) & FreshBit)) return false;
+        uint8_t previous = m_Middle.exchange(m_Read, std::memory_order_acq_rel);
+        m_Read = previous & IndexMask;
+        return true;
+    }
+    
+    const T& GetReadBuffer() const { return m_Buffers[m_Read]; }
+    
+private:
+    static constexpr uint8_t IndexMask = 0x3;
+    static constexpr uint8_t FreshBit = 0x4;  // Middle buffer was published and not yet acquired
+    
+    T m_Buffers[3];
+    uint8_t m_Write = 0;  // Owned by the producer
+    uint8_t m_Read = 2;   // Owned by the consumer
+    alignas(64) std::atomic<uint8_t> m_Middle{ 1 };
+};
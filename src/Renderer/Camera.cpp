@@ -61,3 +61,9 @@ void Camera::SetAspectRatio(float aspectRatio) {
     m_AspectRatio = aspectRatio;
     m_ProjectionMatrix = glm::perspective(glm::radians(m_Fov), m_AspectRatio, m_NearClip, m_FarClip);
 }
+
+void Camera::SetClipPlanes(float nearClip, float farClip) {
+    m_NearClip = nearClip;
+    m_FarClip = farClip;
+    m_ProjectionMatrix = glm::perspective(glm::radians(m_Fov), m_AspectRatio, m_NearClip, m_FarClip);
+}
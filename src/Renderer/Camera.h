@@ -1,4 +1,5 @@
 #pragma once
+#include "Frustum.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -12,10 +13,12 @@ public:
     const glm::mat4& GetViewMatrix() const { return m_ViewMatrix; }
     const glm::mat4& GetProjectionMatrix() const { return m_ProjectionMatrix; }
     const glm::vec3& GetPosition() const { return m_Position; }
+    Frustum GetFrustum() const { return Frustum(m_ProjectionMatrix * m_ViewMatrix); }
     
     void SetPosition(const glm::vec3& position);
     void SetRotation(float pitch, float yaw);
     void SetAspectRatio(float aspectRatio);
+    void SetClipPlanes(float nearClip, float farClip);
     
     // Camera movement
     void MoveForward(float amount);
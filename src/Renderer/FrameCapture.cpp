@@ -0,0 +1,79 @@
+#include "FrameCapture.h"
+#include <glad/glad.h>
+#include <cstring>
+
+FrameCapture::FrameCapture(std::shared_ptr<ImageSequenceWriter> writer)
+    : m_Writer(std::move(writer)) {
+    for (Slot& slot : m_Slots) {
+        glGenBuffers(1, &slot.pbo);
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    for (Slot& slot : m_Slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.pbo);
+    }
+}
+
+void FrameCapture::Capture(int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    if (width != m_Width || height != m_Height) {
+        Resize(width, height);
+    }
+
+    // The oldest frame's copy was queued RingSize - 1 frames ago
+    Slot& slot = m_Slots[m_Next];
+    if (slot.fence) Retire(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, m_Width, m_Height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_Next = (m_Next + 1) % RingSize;
+}
+
+void FrameCapture::Finish() {
+    // Oldest first, so frames reach the writer in order
+    for (int i = 0; i < RingSize; i++) {
+        Slot& slot = m_Slots[(m_Next + i) % RingSize];
+        if (slot.fence) Retire(slot);
+    }
+    m_Next = 0;
+}
+
+void FrameCapture::Resize(int width, int height) {
+    Finish();
+    m_Width = width;
+    m_Height = height;
+    for (Slot& slot : m_Slots) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::Retire(Slot& slot) {
+    // Normally signalled long ago; only a GPU several frames behind waits here
+    GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    size_t size = (size_t)m_Width * m_Height * 4;
+    ImageSequenceWriter::Image image = m_Writer->AcquireImage(m_Width, m_Height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+    if (pixels) {
+        std::memcpy(image.pixels.data(), pixels, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!pixels) return;
+
+    m_Writer->Submit(std::move(image));
+    m_CapturedFrames++;
+}
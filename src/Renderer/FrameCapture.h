@@ -0,0 +1,44 @@
+#pragma once
+#include "../Core/ImageSequenceWriter.h"
+#include <cstdint>
+#include <memory>
+
+// Reads rendered frames back without waiting on the GPU. Each frame is copied
+// into the next pixel buffer object of a ring (glReadPixels into a bound pack
+// buffer only queues the copy) and fenced. A buffer is mapped when its slot
+// comes round again, RingSize - 1 frames later, by which time the copy has
+// long finished; its pixels go to the writer's thread for encoding.
+class FrameCapture {
+public:
+    static constexpr int RingSize = 3;
+
+    explicit FrameCapture(std::shared_ptr<ImageSequenceWriter> writer);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Queues a readback of the bound read framebuffer. A size change first
+    // finishes the frames in flight.
+    void Capture(int width, int height);
+    // Hands every frame still in flight to the writer (end of capture)
+    void Finish();
+
+    uint64_t GetCapturedFrames() const { return m_CapturedFrames; }
+
+private:
+    struct Slot {
+        unsigned int pbo = 0;
+        struct __GLsync* fence = nullptr;  // Set while a readback is in flight
+    };
+
+    void Resize(int width, int height);
+    void Retire(Slot& slot);
+
+    std::shared_ptr<ImageSequenceWriter> m_Writer;
+    Slot m_Slots[RingSize];
+    int m_Next = 0;  // Slot for the next frame, also the oldest in flight
+    int m_Width = 0;
+    int m_Height = 0;
+    uint64_t m_CapturedFrames = 0;
+};
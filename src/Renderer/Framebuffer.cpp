@@ -0,0 +1,35 @@
+#include "Framebuffer.h"
+#include "../Core/Log.h"
+#include <glad/glad.h>
+
+Framebuffer::Framebuffer(int width, int height)
+    : m_Width(width), m_Height(height) {
+    glGenRenderbuffers(1, &m_ColorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_ColorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &m_DepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorRBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_DepthRBO);
+    m_Complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!m_Complete) {
+        TS_LOG_ERROR(Render, "Offscreen framebuffer %dx%d is incomplete", width, height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+Framebuffer::~Framebuffer() {
+    glDeleteFramebuffers(1, &m_FBO);
+    glDeleteRenderbuffers(1, &m_DepthRBO);
+    glDeleteRenderbuffers(1, &m_ColorRBO);
+}
+
+void Framebuffer::Bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+}
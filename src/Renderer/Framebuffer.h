@@ -0,0 +1,26 @@
+#pragma once
+
+// Colour (RGBA8) and depth render target for drawing without a window.
+// Bind makes it both the draw and the read framebuffer.
+class Framebuffer {
+public:
+    Framebuffer(int width, int height);
+    ~Framebuffer();
+
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+
+    void Bind() const;
+    bool IsComplete() const { return m_Complete; }
+
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+
+private:
+    unsigned int m_FBO = 0;
+    unsigned int m_ColorRBO = 0;
+    unsigned int m_DepthRBO = 0;
+    int m_Width = 0;
+    int m_Height = 0;
+    bool m_Complete = false;
+};
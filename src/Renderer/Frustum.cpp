@@ -0,0 +1,27 @@
+#include "Frustum.h"
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    // Gribb-Hartmann: each plane is the last row of the matrix plus or minus one of the others
+    auto row = [&](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+    glm::vec4 w = row(3);
+    for (int axis = 0; axis < 3; axis++) {
+        glm::vec4 r = row(axis);
+        m_Planes[axis * 2] = w + r;
+        m_Planes[axis * 2 + 1] = w - r;
+    }
+}
+
+bool Frustum::Intersects(const glm::vec3& min, const glm::vec3& max) const {
+    for (const glm::vec4& plane : m_Planes) {
+        // The corner furthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x,
+                         plane.y >= 0.0f ? max.y : min.y,
+                         plane.z >= 0.0f ? max.z : min.z);
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
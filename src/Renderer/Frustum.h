@@ -0,0 +1,16 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// The six clip planes of a view-projection matrix, in world space. Used to
+// skip geometry whose bounding box lies entirely outside the view.
+class Frustum {
+public:
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    // Conservative: boxes crossing a corner outside the view may still pass
+    bool Intersects(const glm::vec3& min, const glm::vec3& max) const;
+
+private:
+    glm::vec4 m_Planes[6];  // xyz = inward normal, w = distance
+};
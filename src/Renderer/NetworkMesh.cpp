@@ -0,0 +1,251 @@
+#include "NetworkMesh.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+    struct Segment {
+        int from;
+        int to;
+        glm::vec3 a;
+        glm::vec3 b;
+        uint32_t edgeId;
+    };
+
+    struct TileBuilder {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+        std::vector<float> layers[NetworkMesh::LodCount][NetworkMesh::LayerCount];
+        std::vector<uint32_t> edgeIds[NetworkMesh::LodCount][NetworkMesh::LayerCount];
+        std::vector<Segment> coarseRoads[NetworkMesh::LayerCount];  // OneWay and TwoWay only
+
+        void Append(NetworkMesh::Lod lod, NetworkMesh::Layer layer, std::initializer_list<glm::vec3> points,
+                    uint32_t edgeId = NetworkMesh::NoEdge) {
+            std::vector<float>& out = layers[lod][layer];
+            for (const glm::vec3& point : points) {
+                out.insert(out.end(), { point.x, point.y, point.z });
+                edgeIds[lod][layer].push_back(edgeId);
+                min = glm::min(min, point);
+                max = glm::max(max, point);
+            }
+        }
+    };
+
+    // Follows segments that continue straight on from 'node', marking them used,
+    // and returns where the run ends
+    glm::vec3 ExtendRun(const std::vector<Segment>& segments,
+                        const std::unordered_map<int, std::vector<uint32_t>>& atNode,
+                        std::vector<uint8_t>& used, int node, glm::vec3 position, const glm::vec3& direction) {
+        bool extended = true;
+        while (extended) {
+            extended = false;
+            auto it = atNode.find(node);
+            if (it == atNode.end()) break;
+            for (uint32_t index : it->second) {
+                if (used[index]) continue;
+                const Segment& segment = segments[index];
+                bool forward = segment.from == node;
+                glm::vec3 next = forward ? segment.b : segment.a;
+                if (glm::dot(glm::normalize(next - position), direction) > 0.9999f) {
+                    used[index] = 1;
+                    node = forward ? segment.to : segment.from;
+                    position = next;
+                    extended = true;
+                    break;
+                }
+            }
+        }
+        return position;
+    }
+
+    // A straight street crossing the tile becomes one line instead of one per block
+    void MergeStraightRuns(TileBuilder& tile, NetworkMesh::Layer layer) {
+        const std::vector<Segment>& segments = tile.coarseRoads[layer];
+        std::unordered_map<int, std::vector<uint32_t>> atNode;
+        for (uint32_t i = 0; i < segments.size(); i++) {
+            atNode[segments[i].from].push_back(i);
+            atNode[segments[i].to].push_back(i);
+        }
+
+        std::vector<uint8_t> used(segments.size(), 0);
+        for (uint32_t i = 0; i < segments.size(); i++) {
+            if (used[i]) continue;
+            used[i] = 1;
+            const Segment& segment = segments[i];
+            glm::vec3 direction = glm::normalize(segment.b - segment.a);
+            glm::vec3 end = ExtendRun(segments, atNode, used, segment.to, segment.b, direction);
+            glm::vec3 start = ExtendRun(segments, atNode, used, segment.from, segment.a, -direction);
+            tile.Append(NetworkMesh::Coarse, layer, { start, end }, segment.edgeId);
+        }
+    }
+
+}
+
+NetworkMesh NetworkMesh::Build(const Graph& graph, float tileSize) {
+    NetworkMesh mesh;
+    mesh.tileSize = tileSize;
+
+    // Everything belonging to a node or leaving it goes into the node's tile
+    std::vector<TileBuilder> builders;
+    std::unordered_map<uint64_t, uint32_t> tileIndex;
+    auto tileOf = [&](const glm::vec3& position) -> TileBuilder& {
+        uint32_t x = (uint32_t)(int32_t)std::floor(position.x / tileSize);
+        uint32_t z = (uint32_t)(int32_t)std::floor(position.z / tileSize);
+        auto [it, inserted] = tileIndex.try_emplace((uint64_t)x << 32 | z, (uint32_t)builders.size());
+        if (inserted) builders.emplace_back();
+        return builders[it->second];
+    };
+    
+    // 1. Build Node Mesh (Pentagons)
+    int nodeCount = (int)graph.GetNodeCount();
+    for (int id = 0; id < nodeCount; id++) {
+        const glm::vec3& position = graph.GetPosition(id);
+        TileBuilder& tile = tileOf(position);
+        float rotation = 0.0f;
+        EdgeRange edges = graph.GetOutgoingEdges(id);
+        if (!edges.empty()) {
+            glm::vec3 dir = glm::normalize(graph.GetPosition(graph.GetEdgeTarget(edges[0])) - position);
+            rotation = atan2(dir.x, dir.z);
+        }
+        
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, position + glm::vec3(0.0f, 0.1f, 0.0f));
+        model = glm::rotate(model, rotation, glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::scale(model, glm::vec3(0.8f, 1.0f, 0.8f));
+        
+        // Pentagon vertices (local space)
+        float localVerts[] = {
+             0.0f,  0.5f, 0.0f, 
+            -0.48f, 0.15f, 0.0f, 
+            -0.29f, -0.4f, 0.0f,
+            0.29f, -0.4f, 0.0f, 
+             0.48f,  0.15f, 0.0f
+        };
+        
+        glm::vec3 v0 = glm::vec3(model * glm::vec4(localVerts[0], localVerts[1], localVerts[2], 1.0f));
+        glm::vec3 v1 = glm::vec3(model * glm::vec4(localVerts[3], localVerts[4], localVerts[5], 1.0f));
+        glm::vec3 v2 = glm::vec3(model * glm::vec4(localVerts[6], localVerts[7], localVerts[8], 1.0f));
+        glm::vec3 v3 = glm::vec3(model * glm::vec4(localVerts[9], localVerts[10], localVerts[11], 1.0f));
+        glm::vec3 v4 = glm::vec3(model * glm::vec4(localVerts[12], localVerts[13], localVerts[14], 1.0f));
+        
+        // Triangle 1
+        tile.Append(Detail, Nodes, {v0, v1, v2});
+        // Triangle 2
+        tile.Append(Detail, Nodes, {v0, v2, v3});
+        // Triangle 3
+        tile.Append(Detail, Nodes, {v0, v3, v4});
+
+        tile.Append(Coarse, Nodes, {position + glm::vec3(0.0f, 0.1f, 0.0f)});
+    }
+    // 2. Build Road Meshes
+    for (int id = 0; id < nodeCount; id++) {
+        const glm::vec3& position = graph.GetPosition(id);
+        TileBuilder& tile = tileOf(position);
+        for (int edge : graph.GetOutgoingEdges(id)) {
+            uint32_t edgeId = (uint32_t)edge;
+            int toId = graph.GetEdgeTarget(edge);
+            const glm::vec3& toPosition = graph.GetPosition(toId);
+            int reverse = graph.FindEdge(toId, id);
+            uint32_t reverseId = reverse >= 0 ? (uint32_t)reverse : NoEdge;
+            bool isBidirectional = reverse >= 0;
+            
+            if (isBidirectional) {
+                // Two-way: Parallel lines
+                if (id < toId) {
+                    glm::vec3 roadDir = glm::normalize(toPosition - position);
+                    glm::vec3 perp = glm::normalize(glm::cross(roadDir, glm::vec3(0.0f, 1.0f, 0.0f)));
+                    float offset = 0.2f;
+                    
+                    glm::vec3 p1 = position + perp * offset;
+                    glm::vec3 p2 = toPosition + perp * offset;
+                    glm::vec3 p3 = position - perp * offset;
+                    glm::vec3 p4 = toPosition - perp * offset;
+                    
+                    // Vehicles keep right, so the lane on this side carries node -> to
+                    tile.Append(Detail, TwoWay, {p1, p2}, edgeId);
+                    tile.Append(Detail, TwoWay, {p3, p4}, reverseId);
+                    tile.coarseRoads[TwoWay].push_back({id, toId, position, toPosition, edgeId});
+
+                    // Add arrows for two-way roads (drawn in the one-way layer)
+                    // Lane 1: Node -> Edge->To (Right side)
+                    {
+                        glm::vec3 mid = (position + toPosition) * 0.5f;
+                        glm::vec3 dir = glm::normalize(toPosition - position);
+                        glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
+                        float size = 0.5f;
+                        glm::vec3 arrowPos = mid + right * 0.2f; // Offset to right lane
+
+                        glm::vec3 tip = arrowPos + dir * size;
+                        glm::vec3 left = arrowPos - dir * size + right * size;
+                        glm::vec3 rightP = arrowPos - dir * size - right * size;
+
+                        tile.Append(Detail, OneWay, {tip, left}, edgeId);
+                        tile.Append(Detail, OneWay, {tip, rightP}, edgeId);
+                    }
+
+                    // Lane 2: Edge->To -> Node (Right side relative to return direction)
+                    {
+                        glm::vec3 mid = (position + toPosition) * 0.5f;
+                        glm::vec3 dir = glm::normalize(position - toPosition); // Reverse direction
+                        glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
+                        float size = 0.5f;
+                        glm::vec3 arrowPos = mid + right * 0.2f; // Offset to right lane (which is left from original perspective)
+
+                        glm::vec3 tip = arrowPos + dir * size;
+                        glm::vec3 left = arrowPos - dir * size + right * size;
+                        glm::vec3 rightP = arrowPos - dir * size - right * size;
+
+                        tile.Append(Detail, OneWay, {tip, left}, reverseId);
+                        tile.Append(Detail, OneWay, {tip, rightP}, reverseId);
+                    }
+                }
+            } else {
+                // One-way: Single line + Arrow
+                tile.Append(Detail, OneWay, {position, toPosition}, edgeId);
+                tile.coarseRoads[OneWay].push_back({id, toId, position, toPosition, edgeId});
+                
+                // Arrow
+                glm::vec3 mid = (position + toPosition) * 0.5f;
+                glm::vec3 dir = glm::normalize(toPosition - position);
+                glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
+                float size = 0.5f;
+                
+                glm::vec3 tip = mid + dir * size;
+                glm::vec3 left = mid - dir * size + right * size;
+                glm::vec3 rightP = mid - dir * size - right * size;
+                
+                tile.Append(Detail, OneWay, {tip, left}, edgeId);
+                tile.Append(Detail, OneWay, {tip, rightP}, edgeId);
+            }
+        }
+    }
+    
+    // 3. Coarse roads, then lay every layer out tile by tile
+    for (TileBuilder& tile : builders) {
+        MergeStraightRuns(tile, OneWay);
+        MergeStraightRuns(tile, TwoWay);
+    }
+
+    mesh.tiles.resize(builders.size());
+    for (size_t t = 0; t < builders.size(); t++) {
+        mesh.tiles[t].min = builders[t].min;
+        mesh.tiles[t].max = builders[t].max;
+    }
+    for (int lod = 0; lod < LodCount; lod++) {
+        for (int layer = 0; layer < LayerCount; layer++) {
+            for (size_t t = 0; t < builders.size(); t++) {
+                const std::vector<float>& source = builders[t].layers[lod][layer];
+                const std::vector<uint32_t>& sourceEdges = builders[t].edgeIds[lod][layer];
+                Range& range = mesh.tiles[t].ranges[lod][layer];
+                range.first = (uint32_t)(mesh.vertices[lod].size() / 3);
+                range.count = (uint32_t)(source.size() / 3);
+                mesh.vertices[lod].insert(mesh.vertices[lod].end(), source.begin(), source.end());
+                mesh.edgeIds[lod].insert(mesh.edgeIds[lod].end(), sourceEdges.begin(), sourceEdges.end());
+            }
+        }
+    }
+    
+    return mesh;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "../Simulation/Graph.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// CPU-side geometry of the road network (packed xyz floats), built once per
+// network and uploaded by the renderer. Kept free of GL so it can be
+// generated and measured without a context.
+//
+// The network is bucketed into square tiles on the ground plane, each with a
+// bounding box, so the renderer can skip tiles outside the view. Every tile is
+// built at two levels of detail:
+//   Detail: intersection pentagons (triangles), both lanes of two-way roads
+//           and direction arrows (lines)
+//   Coarse: intersections as points, one centreline per road with no arrows,
+//           straight runs of road inside the tile merged into one segment
+// Every vertex also carries the id of the edge it draws, so per-edge values
+// (the congestion overlay) can be looked up on the GPU without touching the
+// geometry. Merged coarse segments carry the edge the run starts with.
+struct NetworkMesh {
+    enum Layer { Nodes, OneWay, TwoWay, LayerCount };
+    enum Lod { Detail, Coarse, LodCount };
+    static constexpr uint32_t NoEdge = 0xFFFFFFFFu;  // Intersections
+
+    struct Range {
+        uint32_t first = 0;  // In vertices
+        uint32_t count = 0;
+    };
+
+    struct Tile {
+        glm::vec3 min;
+        glm::vec3 max;
+        Range ranges[LodCount][LayerCount];
+    };
+
+    // Per LOD, the three layers back to back, each sorted by tile
+    std::vector<float> vertices[LodCount];
+    std::vector<uint32_t> edgeIds[LodCount];  // One per vertex
+    std::vector<Tile> tiles;
+    float tileSize = 0.0f;
+
+    static NetworkMesh Build(const Graph& graph, float tileSize = 100.0f);
+
+    size_t GetVertexCount(Lod lod) const { return vertices[lod].size() / 3; }
+};
@@ -0,0 +1,211 @@
+#include "NetworkRenderer.h"
+#include "Camera.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "../Simulation/RenderSnapshot.h"
+#include <glad/glad.h>
+#include <algorithm>
+
+static const char* networkVertexShaderSource = R"(
+    #version 460 core
+    layout (location = 0) in vec3 aPos;
+    layout (std140, binding = 0) uniform Camera {
+        mat4 u_View;
+        mat4 u_Projection;
+    };
+    void main() {
+        gl_Position = u_Projection * u_View * vec4(aPos, 1.0);
+    }
+)";
+
+static const char* networkFragmentShaderSource = R"(
+    #version 460 core
+    out vec4 FragColor;
+    uniform vec4 u_Color;
+    void main() {
+        FragColor = u_Color;
+    }
+)";
+
+// Roads only; intersections (no edge) keep the material colour
+static const char* heatmapVertexShaderSource = R"(
+    #version 460 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in uint aEdge;
+    layout (std140, binding = 0) uniform Camera {
+        mat4 u_View;
+        mat4 u_Projection;
+    };
+    layout (binding = 1) uniform samplerBuffer u_EdgeLoads;
+    uniform vec4 u_Color;
+    flat out vec4 vColor;
+    void main() {
+        if (aEdge == 0xFFFFFFFFu) {
+            vColor = u_Color;
+        } else {
+            // Free (green) through half full (yellow) to jammed (red)
+            float load = texelFetch(u_EdgeLoads, int(aEdge)).r;
+            vec3 color = load < 0.5 ? mix(vec3(0.2, 0.8, 0.2), vec3(0.95, 0.85, 0.1), load * 2.0)
+                                    : mix(vec3(0.95, 0.85, 0.1), vec3(0.9, 0.1, 0.1), load * 2.0 - 1.0);
+            vColor = vec4(color, 1.0);
+        }
+        gl_Position = u_Projection * u_View * vec4(aPos, 1.0);
+    }
+)";
+
+static const char* heatmapFragmentShaderSource = R"(
+    #version 460 core
+    flat in vec4 vColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vColor;
+    }
+)";
+
+static const unsigned int EdgeTextureUnit = 1;
+
+NetworkRenderer::NetworkRenderer(const NetworkMesh& mesh, RenderQueue& queue)
+    : m_Tiles(mesh.tiles) {
+    m_Shader = std::make_unique<Shader>(networkVertexShaderSource, networkFragmentShaderSource);
+    m_HeatmapShader = std::make_unique<Shader>(heatmapVertexShaderSource, heatmapFragmentShaderSource);
+    m_Materials[NetworkMesh::Nodes] = queue.AddMaterial({ glm::vec4(0.9f, 0.9f, 0.95f, 1.0f) });
+    m_Materials[NetworkMesh::OneWay] = queue.AddMaterial({ glm::vec4(0.8f, 0.2f, 0.2f, 1.0f) });
+    m_Materials[NetworkMesh::TwoWay] = queue.AddMaterial({ glm::vec4(0.4f, 0.5f, 0.4f, 1.0f) });
+
+    for (int lod = 0; lod < NetworkMesh::LodCount; lod++) {
+        glGenVertexArrays(1, &m_VAO[lod]);
+        glGenBuffers(1, &m_VBO[lod]);
+        glBindVertexArray(m_VAO[lod]);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO[lod]);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices[lod].size() * sizeof(float), mesh.vertices[lod].data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // Only read by the heatmap shader
+        glGenBuffers(1, &m_EdgeVBO[lod]);
+        glBindBuffer(GL_ARRAY_BUFFER, m_EdgeVBO[lod]);
+        glBufferData(GL_ARRAY_BUFFER, mesh.edgeIds[lod].size() * sizeof(uint32_t), mesh.edgeIds[lod].data(), GL_STATIC_DRAW);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+        glEnableVertexAttribArray(1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Sized on the first heatmap update, once the edge count is known
+    glGenBuffers(1, &m_EdgeBuffer);
+    glGenTextures(1, &m_EdgeTexture);
+
+    // Coarse intersections are drawn as points
+    glPointSize(2.0f);
+}
+
+NetworkRenderer::~NetworkRenderer() {
+    glDeleteTextures(1, &m_EdgeTexture);
+    glDeleteBuffers(1, &m_EdgeBuffer);
+    glDeleteBuffers(NetworkMesh::LodCount, m_EdgeVBO);
+    glDeleteBuffers(NetworkMesh::LodCount, m_VBO);
+    glDeleteVertexArrays(NetworkMesh::LodCount, m_VAO);
+}
+
+void NetworkRenderer::Submit(RenderQueue& queue, const Camera& camera) {
+    for (int lod = 0; lod < NetworkMesh::LodCount; lod++) {
+        for (int layer = 0; layer < NetworkMesh::LayerCount; layer++) {
+            m_Firsts[lod][layer].clear();
+            m_Counts[lod][layer].clear();
+        }
+    }
+    m_VisibleTiles = 0;
+    m_CoarseTiles = 0;
+
+    Frustum frustum = camera.GetFrustum();
+    const glm::vec3& eye = camera.GetPosition();
+    for (const NetworkMesh::Tile& tile : m_Tiles) {
+        if (!frustum.Intersects(tile.min, tile.max)) continue;
+        m_VisibleTiles++;
+
+        glm::vec3 closest = glm::max(tile.min, glm::min(eye, tile.max));
+        int lod = glm::length(eye - closest) > m_LodDistance ? NetworkMesh::Coarse : NetworkMesh::Detail;
+        if (lod == NetworkMesh::Coarse) m_CoarseTiles++;
+
+        for (int layer = 0; layer < NetworkMesh::LayerCount; layer++) {
+            const NetworkMesh::Range& range = tile.ranges[lod][layer];
+            if (range.count == 0) continue;
+
+            // Neighbouring tiles are usually adjacent in the buffer too
+            std::vector<int>& firsts = m_Firsts[lod][layer];
+            std::vector<int>& counts = m_Counts[lod][layer];
+            if (!firsts.empty() && (uint32_t)(firsts.back() + counts.back()) == range.first) {
+                counts.back() += (int)range.count;
+            } else {
+                firsts.push_back((int)range.first);
+                counts.push_back((int)range.count);
+            }
+        }
+    }
+
+    static const unsigned int modes[NetworkMesh::LodCount][NetworkMesh::LayerCount] = {
+        { GL_TRIANGLES, GL_LINES, GL_LINES },
+        { GL_POINTS, GL_LINES, GL_LINES }
+    };
+
+    bool heatmap = m_HeatmapEnabled && m_EdgeCount > 0;
+    if (heatmap) {
+        glActiveTexture(GL_TEXTURE0 + EdgeTextureUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_EdgeTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    for (int lod = 0; lod < NetworkMesh::LodCount; lod++) {
+        for (int layer = 0; layer < NetworkMesh::LayerCount; layer++) {
+            if (m_Firsts[lod][layer].empty()) continue;
+
+            RenderQueue::Packet packet;
+            packet.shader = heatmap && layer != NetworkMesh::Nodes ? m_HeatmapShader.get() : m_Shader.get();
+            packet.vao = m_VAO[lod];
+            packet.material = m_Materials[layer];
+            packet.mode = modes[lod][layer];
+            packet.type = RenderQueue::DrawType::MultiArrays;
+            packet.firsts = m_Firsts[lod][layer].data();
+            packet.counts = m_Counts[lod][layer].data();
+            packet.drawCount = (int)m_Firsts[lod][layer].size();
+            queue.Submit(packet);
+        }
+    }
+}
+
+void NetworkRenderer::UpdateHeatmap(const RenderSnapshot& snapshot) {
+    m_HeatmapBytesUploaded = 0;
+    size_t edgeCount = snapshot.edgeLoads.size();
+    if (!m_HeatmapEnabled || edgeCount == 0 || snapshot.version == m_HeatmapVersion) return;
+
+    if (m_EdgeCount != edgeCount) {
+        m_EdgeCount = edgeCount;
+        glBindBuffer(GL_TEXTURE_BUFFER, m_EdgeBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, edgeCount, snapshot.edgeLoads.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, m_EdgeTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R8, m_EdgeBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        m_HeatmapVersion = snapshot.version;
+        m_HeatmapBytesUploaded = edgeCount;
+        return;
+    }
+
+    // Runs of pages stamped since the last upload go out as one call each
+    const std::vector<uint64_t>& versions = snapshot.edgePageVersions;
+    glBindBuffer(GL_TEXTURE_BUFFER, m_EdgeBuffer);
+    size_t page = 0;
+    while (page < versions.size()) {
+        if (versions[page] <= m_HeatmapVersion) { page++; continue; }
+        size_t end = page;
+        while (end < versions.size() && versions[end] > m_HeatmapVersion) end++;
+
+        size_t first = page * RenderSnapshot::EdgePageSize;
+        size_t size = std::min(end * RenderSnapshot::EdgePageSize, edgeCount) - first;
+        glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)first, (GLsizeiptr)size, snapshot.edgeLoads.data() + first);
+        m_HeatmapBytesUploaded += size;
+        page = end;
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    m_HeatmapVersion = snapshot.version;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "NetworkMesh.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Camera;
+class RenderQueue;
+class Shader;
+struct RenderSnapshot;
+
+// Draws the static road network tile by tile. Both levels of detail are
+// uploaded once; each frame the tiles outside the camera frustum are skipped,
+// far tiles use the coarse mesh, and the ranges that remain are queued as
+// one multi-draw per layer and level.
+//
+// With the congestion heatmap on, roads are coloured by their edge's load.
+// Loads live in a texture buffer of one byte per edge which the vertex shader
+// reads through each vertex's edge id, so the geometry is never touched;
+// only the snapshot pages stamped since the last upload are re-sent.
+class NetworkRenderer {
+public:
+    NetworkRenderer(const NetworkMesh& mesh, RenderQueue& queue);
+    ~NetworkRenderer();
+
+    NetworkRenderer(const NetworkRenderer&) = delete;
+    NetworkRenderer& operator=(const NetworkRenderer&) = delete;
+
+    // The queued draws read the visible ranges in place until the queue is flushed
+    void Submit(RenderQueue& queue, const Camera& camera);
+
+    // Uploads the edge loads that changed since the last snapshot uploaded.
+    // Nothing is sent while the heatmap is off; turning it on catches up.
+    void UpdateHeatmap(const RenderSnapshot& snapshot);
+    void SetHeatmapEnabled(bool enabled) { m_HeatmapEnabled = enabled; }
+    bool IsHeatmapEnabled() const { return m_HeatmapEnabled; }
+
+    // Tiles further than this from the camera switch to the coarse mesh
+    void SetLodDistance(float distance) { m_LodDistance = distance; }
+
+    size_t GetTileCount() const { return m_Tiles.size(); }
+    size_t GetVisibleTileCount() const { return m_VisibleTiles; }
+    size_t GetCoarseTileCount() const { return m_CoarseTiles; }
+    size_t GetHeatmapBytesUploaded() const { return m_HeatmapBytesUploaded; }  // Last update
+
+private:
+    std::unique_ptr<Shader> m_Shader;
+    std::unique_ptr<Shader> m_HeatmapShader;
+    uint32_t m_Materials[NetworkMesh::LayerCount] = {};
+    unsigned int m_VAO[NetworkMesh::LodCount] = {};
+    unsigned int m_VBO[NetworkMesh::LodCount] = {};
+    unsigned int m_EdgeVBO[NetworkMesh::LodCount] = {};
+    std::vector<NetworkMesh::Tile> m_Tiles;
+
+    // Roughly where the 0.4 unit gap between two lanes shrinks below a pixel at 720p
+    float m_LodDistance = 300.0f;
+
+    // Visible ranges gathered each frame for glMultiDrawArrays
+    std::vector<int> m_Firsts[NetworkMesh::LodCount][NetworkMesh::LayerCount];
+    std::vector<int> m_Counts[NetworkMesh::LodCount][NetworkMesh::LayerCount];
+    size_t m_VisibleTiles = 0;
+    size_t m_CoarseTiles = 0;
+
+    bool m_HeatmapEnabled = false;
+    unsigned int m_EdgeBuffer = 0;
+    unsigned int m_EdgeTexture = 0;
+    size_t m_EdgeCount = 0;         // Allocated in m_EdgeBuffer
+    uint64_t m_HeatmapVersion = 0;  // Snapshot the GPU copy matches
+    size_t m_HeatmapBytesUploaded = 0;
+};
@@ -0,0 +1,92 @@
+#include "RenderQueue.h"
+#include "Shader.h"
+#include <glad/glad.h>
+#include <algorithm>
+
+RenderQueue::RenderQueue() {
+    m_Materials.push_back({ glm::vec4(1.0f) });  // NoMaterial
+
+    glGenBuffers(1, &m_CameraUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_CameraUBO);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CameraBinding, m_CameraUBO);
+}
+
+RenderQueue::~RenderQueue() {
+    glDeleteBuffers(1, &m_CameraUBO);
+}
+
+uint32_t RenderQueue::AddMaterial(const Material& material) {
+    for (uint32_t id = 1; id < m_Materials.size(); id++) {
+        if (m_Materials[id].color == material.color) return id;
+    }
+    m_Materials.push_back(material);
+    return (uint32_t)m_Materials.size() - 1;
+}
+
+void RenderQueue::BeginFrame(const glm::mat4& view, const glm::mat4& projection) {
+    glm::mat4 camera[2] = { view, projection };
+    glBindBuffer(GL_UNIFORM_BUFFER, m_CameraUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera), camera);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void RenderQueue::Submit(const Packet& packet) {
+    // Shader in the top bits so program changes are rarest, then VAO, then material.
+    // Ties keep submission order through the packet index.
+    uint64_t key = (uint64_t)(packet.shader->GetID() & 0xFFFFF) << 40 |
+                   (uint64_t)(packet.vao & 0xFFFFF) << 20 |
+                   (uint64_t)(packet.material & 0xFFFFF);
+    m_Order.emplace_back(key, (uint32_t)m_Packets.size());
+    m_Packets.push_back(packet);
+}
+
+void RenderQueue::Flush() {
+    m_Stats = Stats();
+    std::sort(m_Order.begin(), m_Order.end());
+
+    const Shader* shader = nullptr;
+    unsigned int vao = 0;
+    uint32_t material = NoMaterial;
+    int colorLocation = -1;
+    for (const auto& [key, index] : m_Order) {
+        const Packet& packet = m_Packets[index];
+        if (packet.shader != shader) {
+            shader = packet.shader;
+            shader->Bind();
+            colorLocation = shader->GetUniformLocation("u_Color");
+            material = NoMaterial;
+            m_Stats.shaderChanges++;
+        }
+        if (packet.vao != vao) {
+            vao = packet.vao;
+            glBindVertexArray(vao);
+            m_Stats.vaoChanges++;
+        }
+        if (packet.material != NoMaterial && packet.material != material) {
+            material = packet.material;
+            packet.shader->SetFloat4(colorLocation, m_Materials[material].color);
+            m_Stats.materialChanges++;
+        }
+
+        switch (packet.type) {
+            case DrawType::Arrays:
+                glDrawArrays(packet.mode, packet.first, packet.count);
+                break;
+            case DrawType::MultiArrays:
+                glMultiDrawArrays(packet.mode, packet.firsts, packet.counts, packet.drawCount);
+                break;
+            case DrawType::Instanced:
+                glDrawArraysInstancedBaseInstance(packet.mode, packet.first, packet.count,
+                                                  packet.instanceCount, packet.baseInstance);
+                break;
+        }
+        m_Stats.drawCalls++;
+    }
+
+    glBindVertexArray(0);
+    if (shader) shader->Unbind();
+    m_Packets.clear();
+    m_Order.clear();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class Shader;
+
+// Draw packets collected over a frame and submitted in one pass. Packets are
+// sorted by shader, vertex array and material, so each program, VAO and
+// colour is bound once per frame however many renderers add draws.
+// View and projection live in a uniform buffer written once per frame; every
+// shader reads them from the block
+//     layout (std140, binding = 0) uniform Camera { mat4 u_View; mat4 u_Projection; };
+class RenderQueue {
+public:
+    static constexpr unsigned int CameraBinding = 0;
+    static constexpr uint32_t NoMaterial = 0;  // Leaves u_Color alone
+
+    struct Material {
+        glm::vec4 color;  // Written to the shader's u_Color
+    };
+
+    enum class DrawType : uint8_t {
+        Arrays,       // glDrawArrays(mode, first, count)
+        MultiArrays,  // glMultiDrawArrays(mode, firsts, counts, drawCount)
+        Instanced     // glDrawArraysInstancedBaseInstance(mode, first, count, instanceCount, baseInstance)
+    };
+
+    struct Packet {
+        Shader* shader = nullptr;
+        unsigned int vao = 0;
+        uint32_t material = NoMaterial;
+        unsigned int mode = 0;  // GL primitive type
+        DrawType type = DrawType::Arrays;
+        int first = 0;
+        int count = 0;
+        int instanceCount = 0;
+        unsigned int baseInstance = 0;
+        const int* firsts = nullptr;  // Owned by the submitter, must stay valid until Flush
+        const int* counts = nullptr;
+        int drawCount = 0;
+    };
+
+    struct Stats {
+        size_t drawCalls = 0;
+        size_t shaderChanges = 0;
+        size_t vaoChanges = 0;
+        size_t materialChanges = 0;
+    };
+
+    RenderQueue();
+    ~RenderQueue();
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    // Materials are registered once at setup; equal colours share an id
+    uint32_t AddMaterial(const Material& material);
+
+    void BeginFrame(const glm::mat4& view, const glm::mat4& projection);
+    void Submit(const Packet& packet);
+    void Flush();
+
+    // Counts from the last Flush
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    unsigned int m_CameraUBO = 0;
+    std::vector<Material> m_Materials;
+    std::vector<Packet> m_Packets;
+    std::vector<std::pair<uint64_t, uint32_t>> m_Order;  // Sort key, packet index
+    Stats m_Stats;
+};
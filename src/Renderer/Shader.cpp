@@ -39,6 +39,23 @@ Shader::Shader(const std::string& vertexSrc, const std::string& fragmentSrc) {
         std::cerr << "Shader linking failed:\n" << infoLog << std::endl;
     }
     
+    // Cache every uniform of the default block; those in uniform blocks have no location
+    int uniformCount = 0;
+    glGetProgramiv(m_ProgramID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    for (int i = 0; i < uniformCount; i++) {
+        char name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_ProgramID, (GLuint)i, sizeof(name), &length, &size, &type, name);
+        int location = glGetUniformLocation(m_ProgramID, name);
+        if (location < 0) continue;
+        
+        std::string uniform(name, length);
+        if (uniform.ends_with("[0]")) uniform.resize(uniform.size() - 3);  // Arrays are set from their first element
+        m_UniformLocations[uniform] = location;
+    }
+    
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 }
@@ -55,26 +72,47 @@ void Shader::Unbind() const {
     glUseProgram(0);
 }
 
-int Shader::GetUniformLocation(const std::string& name) {
-    return glGetUniformLocation(m_ProgramID, name.c_str());
+int Shader::GetUniformLocation(const std::string& name) const {
+    auto it = m_UniformLocations.find(name);
+    return it != m_UniformLocations.end() ? it->second : -1;
 }
 
 void Shader::SetInt(const std::string& name, int value) {
-    glUniform1i(GetUniformLocation(name), value);
+    SetInt(GetUniformLocation(name), value);
 }
 
 void Shader::SetFloat(const std::string& name, float value) {
-    glUniform1f(GetUniformLocation(name), value);
+    SetFloat(GetUniformLocation(name), value);
 }
 
 void Shader::SetFloat3(const std::string& name, const glm::vec3& value) {
-    glUniform3f(GetUniformLocation(name), value.x, value.y, value.z);
+    SetFloat3(GetUniformLocation(name), value);
 }
 
 void Shader::SetFloat4(const std::string& name, const glm::vec4& value) {
-    glUniform4f(GetUniformLocation(name), value.x, value.y, value.z, value.w);
+    SetFloat4(GetUniformLocation(name), value);
 }
 
 void Shader::SetMat4(const std::string& name, const glm::mat4& value) {
-    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+    SetMat4(GetUniformLocation(name), value);
+}
+
+void Shader::SetInt(int location, int value) {
+    glUniform1i(location, value);
+}
+
+void Shader::SetFloat(int location, float value) {
+    glUniform1f(location, value);
+}
+
+void Shader::SetFloat3(int location, const glm::vec3& value) {
+    glUniform3f(location, value.x, value.y, value.z);
+}
+
+void Shader::SetFloat4(int location, const glm::vec4& value) {
+    glUniform4f(location, value.x, value.y, value.z, value.w);
+}
+
+void Shader::SetMat4(int location, const glm::mat4& value) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
 class Shader {
@@ -10,6 +11,12 @@ public:
     void Bind() const;
     void Unbind() const;
     
+    unsigned int GetID() const { return m_ProgramID; }
+    
+    // Locations are looked up once at link time; -1 if the program has no such uniform.
+    // Resolve a location once and use the int setters in per-draw code.
+    int GetUniformLocation(const std::string& name) const;
+    
     // Uniform setters
     void SetInt(const std::string& name, int value);
     void SetFloat(const std::string& name, float value);
@@ -17,7 +24,13 @@ public:
     void SetFloat4(const std::string& name, const glm::vec4& value);
     void SetMat4(const std::string& name, const glm::mat4& value);
     
+    void SetInt(int location, int value);
+    void SetFloat(int location, float value);
+    void SetFloat3(int location, const glm::vec3& value);
+    void SetFloat4(int location, const glm::vec4& value);
+    void SetMat4(int location, const glm::mat4& value);
+    
 private:
     unsigned int m_ProgramID;
-    int GetUniformLocation(const std::string& name);
+    std::unordered_map<std::string, int> m_UniformLocations;
 };
@@ -0,0 +1,139 @@
+#include "TrafficLightRenderer.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "../Simulation/RenderSnapshot.h"
+#include <glad/glad.h>
+#include <algorithm>
+
+static const char* lightVertexShaderSource = R"(
+    #version 460 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aOffset;
+    layout (location = 2) in uint aState;  // TrafficLightState: RED, YELLOW, GREEN, OFF
+    layout (std140, binding = 0) uniform Camera {
+        mat4 u_View;
+        mat4 u_Projection;
+    };
+    flat out vec4 vColor;
+    void main() {
+        if (aState > 2u) {
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);  // Degenerate, outside the clip volume
+            return;
+        }
+        const vec4 colors[3] = vec4[3](vec4(1.0, 0.0, 0.0, 1.0), vec4(1.0, 1.0, 0.0, 1.0), vec4(0.0, 1.0, 0.0, 1.0));
+        vColor = colors[aState];
+        gl_Position = u_Projection * u_View * vec4(aPos * 0.6 + aOffset, 1.0);
+    }
+)";
+
+static const char* lightFragmentShaderSource = R"(
+    #version 460 core
+    flat in vec4 vColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vColor;
+    }
+)";
+
+TrafficLightRenderer::TrafficLightRenderer(const Graph& graph, const SignalTable& signals) {
+    m_Shader = std::make_unique<Shader>(lightVertexShaderSource, lightFragmentShaderSource);
+
+    // Placement as before: on the incoming road, up and to its right-hand side.
+    // Initial states are the simulation's; later ones arrive through Update.
+    m_EdgeCount = graph.GetEdgeCount();
+    std::vector<glm::vec3> positions;
+    for (int edgeId = 0; edgeId < (int)m_EdgeCount; edgeId++) {
+        int nodeId = graph.GetEdgeTarget(edgeId);
+        if (graph.GetIncomingEdges(nodeId).size() < 2) continue;
+
+        const glm::vec3& position = graph.GetPosition(nodeId);
+        glm::vec3 dir = glm::normalize(graph.GetPosition(graph.GetEdgeSource(edgeId)) - position);
+        glm::vec3 right = glm::normalize(glm::cross(dir, glm::vec3(0.0f, 1.0f, 0.0f)));
+        positions.push_back(position + dir * 2.5f + glm::vec3(0.0f, 3.0f, 0.0f) + right * 1.5f);
+        m_Approaches.push_back((uint32_t)edgeId);
+        m_States.push_back(edgeId < (int)signals.lights.size() ? (uint8_t)signals.lights[edgeId] : (uint8_t)TrafficLightState::OFF);
+    }
+
+    float cube[] = {
+        -0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f, -0.5f,
+        -0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f, -0.5f,  0.5f,
+        -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f,
+        -0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f, -0.5f,  0.5f, -0.5f, -0.5f, -0.5f,
+        -0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f,  0.5f, -0.5f,  0.5f,  0.5f, -0.5f,  0.5f, -0.5f
+    };
+
+    glGenVertexArrays(1, &m_VAO);
+    glBindVertexArray(m_VAO);
+
+    glGenBuffers(1, &m_CubeVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_CubeVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cube), cube, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &m_PositionVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_PositionVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glGenBuffers(1, &m_StateVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_StateVBO);
+    glBufferData(GL_ARRAY_BUFFER, m_States.size(), m_States.data(), GL_DYNAMIC_DRAW);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, 1, (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glBindVertexArray(0);
+}
+
+TrafficLightRenderer::~TrafficLightRenderer() {
+    glDeleteBuffers(1, &m_StateVBO);
+    glDeleteBuffers(1, &m_PositionVBO);
+    glDeleteBuffers(1, &m_CubeVBO);
+    glDeleteVertexArrays(1, &m_VAO);
+}
+
+void TrafficLightRenderer::Update(const RenderSnapshot& snapshot) {
+    if (snapshot.version <= m_UploadedVersion || snapshot.signalStates.size() != m_EdgeCount) return;
+
+    // Signals switch a handful of approaches per tick; the instances in each
+    // run of pages stamped since the last upload go out as one call
+    const std::vector<uint64_t>& versions = snapshot.signalPageVersions;
+    glBindBuffer(GL_ARRAY_BUFFER, m_StateVBO);
+    size_t page = 0;
+    while (page < versions.size()) {
+        if (versions[page] <= m_UploadedVersion) { page++; continue; }
+        size_t end = page;
+        while (end < versions.size() && versions[end] > m_UploadedVersion) end++;
+
+        size_t first = std::lower_bound(m_Approaches.begin(), m_Approaches.end(),
+                                        (uint32_t)(page * RenderSnapshot::EdgePageSize)) - m_Approaches.begin();
+        size_t last = std::lower_bound(m_Approaches.begin() + first, m_Approaches.end(),
+                                       (uint32_t)std::min(end * RenderSnapshot::EdgePageSize, m_EdgeCount)) - m_Approaches.begin();
+        for (size_t i = first; i < last; i++) {
+            m_States[i] = snapshot.signalStates[m_Approaches[i]];
+        }
+        if (last > first) {
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)first, (GLsizeiptr)(last - first), m_States.data() + first);
+        }
+        page = end;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_UploadedVersion = snapshot.version;
+}
+
+void TrafficLightRenderer::Submit(RenderQueue& queue) {
+    if (m_Approaches.empty()) return;
+
+    RenderQueue::Packet packet;
+    packet.shader = m_Shader.get();
+    packet.vao = m_VAO;
+    packet.mode = GL_TRIANGLES;
+    packet.type = RenderQueue::DrawType::Instanced;
+    packet.count = 36;
+    packet.instanceCount = (int)m_Approaches.size();
+    queue.Submit(packet);
+}
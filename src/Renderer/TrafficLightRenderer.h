@@ -0,0 +1,46 @@
+#pragma once
+#include "../Simulation/Graph.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class RenderQueue;
+class Shader;
+struct RenderSnapshot;
+
+// Draws one light per signal approach (an incoming road of a node that can
+// carry signals) as an instanced cube. Positions never change, so they are
+// uploaded once; each frame only the approaches in snapshot pages stamped
+// since the last upload are sent. Instances are in edge ID order.
+// Approaches that are OFF are collapsed in the vertex shader, so all three
+// colours go out in a single draw.
+class TrafficLightRenderer {
+public:
+    // Every incoming road of a node with more than one, the only nodes the
+    // simulation signalises, gets an instance, lit or not, so signals toggled
+    // or restored later need no rebuild
+    TrafficLightRenderer(const Graph& graph, const SignalTable& signals);
+    ~TrafficLightRenderer();
+
+    TrafficLightRenderer(const TrafficLightRenderer&) = delete;
+    TrafficLightRenderer& operator=(const TrafficLightRenderer&) = delete;
+
+    // Uploads the pages of signal states the snapshot stamped since the last call
+    void Update(const RenderSnapshot& snapshot);
+    void Submit(RenderQueue& queue);
+
+    size_t GetApproachCount() const { return m_Approaches.size(); }
+
+private:
+    std::unique_ptr<Shader> m_Shader;
+    unsigned int m_VAO = 0;
+    unsigned int m_CubeVBO = 0;
+    unsigned int m_PositionVBO = 0;
+    unsigned int m_StateVBO = 0;
+
+    size_t m_EdgeCount = 0;
+    std::vector<uint32_t> m_Approaches;  // Edge ID per instance, ascending
+    std::vector<uint8_t> m_States;       // Per instance, as last uploaded
+    uint64_t m_UploadedVersion = 0;  // Snapshot version the GPU states match
+};
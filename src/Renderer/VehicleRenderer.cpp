@@ -0,0 +1,167 @@
+#include "VehicleRenderer.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+static const char* vehicleVertexShaderSource = R"(
+    #version 460 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec4 aInstance;  // xyz = position, w = heading
+    layout (location = 2) in vec4 aColor;
+    layout (std140, binding = 0) uniform Camera {
+        mat4 u_View;
+        mat4 u_Projection;
+    };
+    out vec4 vColor;
+    void main() {
+        float s = sin(aInstance.w);
+        float c = cos(aInstance.w);
+        vec3 rotated = vec3(c * aPos.x + s * aPos.z, aPos.y, c * aPos.z - s * aPos.x);
+        gl_Position = u_Projection * u_View * vec4(rotated + aInstance.xyz, 1.0);
+        vColor = aColor;
+    }
+)";
+
+static const char* vehicleFragmentShaderSource = R"(
+    #version 460 core
+    in vec4 vColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vColor;
+    }
+)";
+
+VehicleRenderer::VehicleRenderer() {
+    m_Shader = std::make_unique<Shader>(vehicleVertexShaderSource, vehicleFragmentShaderSource);
+
+    // Arrow-head triangle pointing along +z
+    float triangleVertices[] = {
+         0.0f,  0.5f,  1.0f,
+        -0.5f,  0.5f, -0.5f,
+         0.5f,  0.5f, -0.5f
+    };
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_MeshVBO);
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_MeshVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    Reserve(4096);
+}
+
+VehicleRenderer::~VehicleRenderer() {
+    for (int region = 0; region < RegionCount; region++) {
+        if (m_Fences[region]) glDeleteSync(m_Fences[region]);
+    }
+    if (m_InstanceVBO) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glDeleteBuffers(1, &m_InstanceVBO);
+    }
+    glDeleteBuffers(1, &m_MeshVBO);
+    glDeleteVertexArrays(1, &m_VAO);
+}
+
+void VehicleRenderer::WaitForRegion(int region) {
+    if (!m_Fences[region]) return;
+
+    GLenum result = glClientWaitSync(m_Fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(m_Fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+    }
+    glDeleteSync(m_Fences[region]);
+    m_Fences[region] = nullptr;
+}
+
+void VehicleRenderer::Reserve(size_t capacity) {
+    // The old storage may still be read by queued draws
+    for (int region = 0; region < RegionCount; region++) {
+        WaitForRegion(region);
+    }
+    if (m_InstanceVBO) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glDeleteBuffers(1, &m_InstanceVBO);
+    }
+
+    m_Capacity = capacity;
+    GLsizeiptr size = (GLsizeiptr)(m_Capacity * RegionCount * sizeof(Instance));
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &m_InstanceVBO);
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+    m_Mapped = (Instance*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance), (void*)offsetof(Instance, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+}
+
+VehicleRenderer::Instance* VehicleRenderer::Begin(size_t count) {
+    // Last frame's queue has been flushed, so its draw is ahead of this fence
+    if (m_Submitted) {
+        m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_Submitted = false;
+    }
+    if (count > m_Capacity) {
+        Reserve(std::max(count, m_Capacity * 2));
+    }
+    m_Region = (m_Region + 1) % RegionCount;
+    WaitForRegion(m_Region);
+    return m_Mapped + m_Region * m_Capacity;
+}
+
+void VehicleRenderer::Submit(RenderQueue& queue, size_t count) {
+    m_Submitted = true;
+    if (count == 0) return;
+
+    RenderQueue::Packet packet;
+    packet.shader = m_Shader.get();
+    packet.vao = m_VAO;
+    packet.mode = GL_TRIANGLES;
+    packet.type = RenderQueue::DrawType::Instanced;
+    packet.count = 3;
+    packet.instanceCount = (int)count;
+    // The region is selected by offsetting the instance index, so the attribute bindings never change
+    packet.baseInstance = (unsigned int)(m_Region * m_Capacity);
+    queue.Submit(packet);
+}
+
+uint32_t VehicleRenderer::GetColor(size_t index) {
+    // Hue steps of 60 degrees, so the palette repeats every six vehicles
+    static const std::array<uint32_t, 6> palette = [] {
+        std::array<uint32_t, 6> colors;
+        for (int i = 0; i < 6; i++) {
+            float hue = (i * 60.0f) / 360.0f;
+            glm::vec3 color(
+                0.5f + 0.5f * std::sin(hue * 6.28f),
+                0.5f + 0.5f * std::sin((hue + 0.33f) * 6.28f),
+                0.5f + 0.5f * std::sin((hue + 0.67f) * 6.28f)
+            );
+            colors[i] = (uint32_t)(color.x * 255.0f + 0.5f) |
+                        (uint32_t)(color.y * 255.0f + 0.5f) << 8 |
+                        (uint32_t)(color.z * 255.0f + 0.5f) << 16 |
+                        0xFFu << 24;
+        }
+        return colors;
+    }();
+    return palette[index % 6];
+}
+
+float VehicleRenderer::GetHeading(const glm::vec3& direction) {
+    if (glm::length(direction) <= 0.01f) return 0.0f;
+    return std::atan2(direction.x, direction.z);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class RenderQueue;
+class Shader;
+
+// Draws every vehicle with one instanced call. Per-instance data is written
+// straight into a persistently mapped buffer split into three regions: the
+// CPU fills one region while the GPU may still be reading the previous two,
+// and a fence per region keeps it from overwriting data still in flight.
+// The fence for a region goes in at the next Begin, after the queue that
+// held its draw has been flushed.
+class VehicleRenderer {
+public:
+    struct Instance {
+        glm::vec3 position;
+        float heading;   // Radians about +y, 0 = facing +z
+        uint32_t color;  // RGBA8
+    };
+
+    VehicleRenderer();
+    ~VehicleRenderer();
+
+    VehicleRenderer(const VehicleRenderer&) = delete;
+    VehicleRenderer& operator=(const VehicleRenderer&) = delete;
+
+    // Returns room for 'count' instances in the next region. Write all of
+    // them, then call Submit with the same count before the next Begin.
+    Instance* Begin(size_t count);
+    void Submit(RenderQueue& queue, size_t count);
+
+    // The colour vehicle 'index' has always been drawn in
+    static uint32_t GetColor(size_t index);
+    static float GetHeading(const glm::vec3& direction);
+
+private:
+    static constexpr int RegionCount = 3;
+
+    void Reserve(size_t capacity);
+    void WaitForRegion(int region);
+
+    std::unique_ptr<Shader> m_Shader;
+    unsigned int m_VAO = 0;
+    unsigned int m_MeshVBO = 0;
+    unsigned int m_InstanceVBO = 0;
+
+    Instance* m_Mapped = nullptr;
+    size_t m_Capacity = 0;  // Instances per region
+    int m_Region = 0;       // Region written this frame
+    bool m_Submitted = false;  // m_Region was queued and still needs its fence
+    struct __GLsync* m_Fences[RegionCount] = {};
+};
@@ -0,0 +1,125 @@
+#include "EnsembleRunner.h"
+#include "TransportSimulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+void RunningStatistics::Add(double value) {
+    count++;
+    double delta = value - mean;
+    mean += delta / (double)count;
+    m2 += delta * (value - mean);
+    min = count == 1 ? value : std::min(min, value);
+    max = count == 1 ? value : std::max(max, value);
+}
+
+double RunningStatistics::GetStandardDeviation() const {
+    return std::sqrt(GetVariance());
+}
+
+double RunningStatistics::GetConfidenceHalfWidth() const {
+    return count > 1 ? 1.96 * GetStandardDeviation() / std::sqrt((double)count) : 0.0;
+}
+
+EnsembleRunner::EnsembleRunner(const Scenario& scenario, const Options& options)
+    : m_Scenario(scenario), m_Options(options) {
+    m_Options.runs = std::max(m_Options.runs, 0);
+    m_Options.threads = std::clamp(m_Options.threads, 1, std::max(m_Options.runs, 1));
+}
+
+const char* EnsembleRunner::GetMetricName(Metric metric) {
+    switch (metric) {
+        case Metric::Arrived: return "Arrivals";
+        case Metric::MeanEdgeDelay: return "Mean edge delay (s)";
+        case Metric::HaltedShare: return "Halted share";
+        case Metric::SignalChanges: return "Signal changes";
+        case Metric::TicksPerSecond: return "Ticks/s";
+        default: return "";
+    }
+}
+
+void EnsembleRunner::Run() {
+    // Load (or generate) the network once, with the base seed and no fleet
+    Scenario networkScenario = m_Scenario;
+    networkScenario.initialVehicles = 0;
+    networkScenario.hasSeed = true;
+    networkScenario.seed = m_Options.baseSeed;
+    {
+        TransportSimulation network;
+        network.SetScenario(networkScenario);
+        network.Initialize();
+        m_Graph = network.GetGraph();
+        m_Signals = network.GetSignals();
+        m_NextHops = network.GetNextHopTable();
+        m_RouteOverlay = network.GetRouteOverlay();
+    }
+
+    m_NextRun = 0;
+    m_CompletedRuns = 0;
+    m_Statistics = {};
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < m_Options.threads; i++) {
+        workers.emplace_back(&EnsembleRunner::RunWorker, this);
+    }
+    RunWorker();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void EnsembleRunner::RunWorker() {
+    for (;;) {
+        int run = m_NextRun.fetch_add(1, std::memory_order_relaxed);
+        if (run >= m_Options.runs) return;
+
+        RunResult result = RunMember(run);
+
+        std::lock_guard<std::mutex> lock(m_ResultMutex);
+        for (size_t metric = 0; metric < (size_t)Metric::Count; metric++) {
+            m_Statistics[metric].Add(result.values[metric]);
+        }
+        m_CompletedRuns++;
+        if (m_RunCallback) m_RunCallback(result);
+    }
+}
+
+EnsembleRunner::RunResult EnsembleRunner::RunMember(int run) {
+    Scenario scenario = m_Scenario;
+    scenario.hasSeed = true;
+    scenario.seed = m_Options.baseSeed + (uint32_t)run;
+    if (m_ScenarioOverride) m_ScenarioOverride(run, scenario);
+
+    RunResult result;
+    result.run = run;
+    result.seed = scenario.seed;
+
+    // Own vehicles, signals and statistics on top of the shared network
+    TransportSimulation simulation;
+    simulation.SetScenario(scenario);
+    simulation.SetNextHopTable(m_NextHops);
+    simulation.SetRouteOverlay(m_RouteOverlay);
+    simulation.Initialize(m_Graph, m_Signals);
+
+    const float deltaTime = 1.0f / 60.0f;
+    int ticks = (int)std::ceil(m_Options.seconds / deltaTime);
+    double haltedShare = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) {
+        simulation.Update(deltaTime);
+        const TrafficStatistics::Snapshot& stats = simulation.GetStatistics().GetSnapshot();
+        if (stats.active > 0) haltedShare += (double)stats.halted / (double)stats.active;
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const TrafficStatistics::Snapshot& stats = simulation.GetStatistics().GetSnapshot();
+    result.values[(size_t)Metric::Arrived] = (double)stats.arrived;
+    result.values[(size_t)Metric::MeanEdgeDelay] = stats.meanEdgeDelay;
+    result.values[(size_t)Metric::HaltedShare] = ticks > 0 ? haltedShare / ticks : 0.0;
+    result.values[(size_t)Metric::SignalChanges] = (double)stats.signalChanges;
+    result.values[(size_t)Metric::TicksPerSecond] = result.wallSeconds > 0.0 ? ticks / result.wallSeconds : 0.0;
+    return result;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "Graph.h"
+#include "NextHopTable.h"
+#include "RouteOverlay.h"
+#include "Scenario.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Mean and variance updated one value at a time (Welford), plus the range.
+// Nothing is kept per value, so it costs the same for ten runs or ten thousand.
+struct RunningStatistics {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;   // Sum of squared deviations from the mean
+    double min = 0.0;
+    double max = 0.0;
+
+    void Add(double value);
+    double GetVariance() const { return count > 1 ? m2 / (double)(count - 1) : 0.0; }  // Sample variance
+    double GetStandardDeviation() const;
+    // Half-width of the normal-approximation 95% confidence interval of the mean
+    double GetConfidenceHalfWidth() const;
+};
+
+// Runs many independent simulations of one scenario side by side. The road
+// network, its initial signal layout and any next-hop table are loaded once and
+// shared read-only; each run owns only its vehicles, signal states and
+// statistics, so memory grows with the fleet rather than with the network
+// times the run count.
+//
+// Run i is seeded with baseSeed + i. Runs are handed out to a pool of threads,
+// each driving one single-tile simulation at a time at 60 ticks per simulated
+// second, and every run's end-of-run figures are folded into running
+// statistics as it finishes.
+class EnsembleRunner {
+public:
+    enum class Metric { Arrived, MeanEdgeDelay, HaltedShare, SignalChanges, TicksPerSecond, Count };
+
+    struct Options {
+        int runs = 16;
+        int threads = 1;        // Runs in flight at once
+        float seconds = 60.0f;  // Simulated time per run
+        uint32_t baseSeed = 0;
+    };
+
+    struct RunResult {
+        int run = 0;
+        uint32_t seed = 0;
+        double wallSeconds = 0.0;
+        std::array<double, (size_t)Metric::Count> values = {};
+    };
+
+    // Adjusts a run's scenario before it starts (fleet size). The network and
+    // signal layout are shared, so settings for those are ignored. Any thread.
+    using ScenarioOverride = std::function<void(int run, Scenario& scenario)>;
+    // Called once per finished run, in completion order, never concurrently
+    using RunCallback = std::function<void(const RunResult& result)>;
+
+    EnsembleRunner(const Scenario& scenario, const Options& options);
+
+    void SetScenarioOverride(ScenarioOverride scenarioOverride) { m_ScenarioOverride = std::move(scenarioOverride); }
+    void SetRunCallback(RunCallback callback) { m_RunCallback = std::move(callback); }
+
+    // Loads the network, then blocks until every run has finished
+    void Run();
+
+    const RunningStatistics& GetStatistics(Metric metric) const { return m_Statistics[(size_t)metric]; }
+    int GetCompletedRuns() const { return m_CompletedRuns; }
+    static const char* GetMetricName(Metric metric);
+
+private:
+    void RunWorker();
+    RunResult RunMember(int run);
+
+    Scenario m_Scenario;
+    Options m_Options;
+    ScenarioOverride m_ScenarioOverride;
+    RunCallback m_RunCallback;
+
+    // Shared by every run, read-only once Run has loaded it
+    std::shared_ptr<Graph> m_Graph;
+    SignalTable m_Signals;
+    std::shared_ptr<const NextHopTable> m_NextHops;  // Null unless the scenario routes by table
+    std::shared_ptr<const RouteOverlay> m_RouteOverlay;  // Null unless the scenario routes hierarchically
+
+    std::atomic<int> m_NextRun{ 0 };
+    std::mutex m_ResultMutex;
+    std::array<RunningStatistics, (size_t)Metric::Count> m_Statistics;
+    int m_CompletedRuns = 0;
+};
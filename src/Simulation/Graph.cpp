@@ -1,34 +1,115 @@
 #include "Graph.h"
 #include <stdexcept>
 
-int Graph::AddNode(const glm::vec3& position) {
-    int id = m_NextNodeId++;
-    auto node = std::make_shared<Node>(id, position);
-    m_Nodes[id] = node;
-    return id;
+namespace {
+    // Arrays of a graph built in memory
+    struct OwnedArrays {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> targets;
+        std::vector<float> weights;
+        std::vector<uint32_t> sources;
+        std::vector<uint32_t> incomingOffsets;
+        std::vector<uint32_t> incomingEdges;
+    };
 }
 
-void Graph::AddEdge(int fromId, int toId, float weight) {
-    auto fromNode = GetNode(fromId);
-    auto toNode = GetNode(toId);
-    
-    if (!fromNode || !toNode) {
-        throw std::runtime_error("Invalid node ID in AddEdge");
+void Graph::Build(const std::vector<glm::vec3>& positions, const std::vector<EdgeDescription>& edges) {
+    int nodeCount = (int)positions.size();
+
+    // Counting sort into CSR order (stable, so each node keeps its edge order)
+    std::vector<uint32_t> offsets(nodeCount + 1, 0);
+    for (const auto& e : edges) {
+        if (e.from < 0 || e.from >= nodeCount || e.to < 0 || e.to >= nodeCount) {
+            throw std::runtime_error("Invalid node ID in Graph::Build");
+        }
+        offsets[e.from + 1]++;
+    }
+    for (int id = 0; id < nodeCount; id++) {
+        offsets[id + 1] += offsets[id];
+    }
+
+    std::vector<uint32_t> targets(edges.size());
+    std::vector<float> weights(edges.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& e : edges) {
+        uint32_t slot = fill[e.from]++;
+        targets[slot] = (uint32_t)e.to;
+        weights[slot] = e.weight;
+    }
+
+    Build(positions, std::move(offsets), std::move(targets), std::move(weights));
+}
+
+void Graph::Build(std::vector<glm::vec3> positions, std::vector<uint32_t> offsets,
+                  std::vector<uint32_t> targets, std::vector<float> weights) {
+    if (m_Arrays.nodeCount != 0) {
+        throw std::runtime_error("Graph::Build requires an empty graph");
+    }
+
+    size_t nodeCount = positions.size();
+    if (offsets.size() != nodeCount + 1 || offsets[0] != 0 || offsets[nodeCount] != targets.size() ||
+        weights.size() != targets.size()) {
+        throw std::runtime_error("Inconsistent adjacency in Graph::Build");
+    }
+
+    auto arrays = std::make_shared<OwnedArrays>();
+    arrays->positions = std::move(positions);
+    arrays->offsets = std::move(offsets);
+    arrays->targets = std::move(targets);
+    arrays->weights = std::move(weights);
+
+    // Reverse adjacency: start node of every edge, and the edges into every node
+    size_t edgeCount = arrays->targets.size();
+    arrays->sources.resize(edgeCount);
+    arrays->incomingOffsets.assign(nodeCount + 1, 0);
+    for (size_t id = 0; id < nodeCount; id++) {
+        if (arrays->offsets[id + 1] < arrays->offsets[id]) {
+            throw std::runtime_error("Inconsistent adjacency in Graph::Build");
+        }
+        for (uint32_t e = arrays->offsets[id]; e < arrays->offsets[id + 1]; e++) {
+            if (arrays->targets[e] >= nodeCount) {
+                throw std::runtime_error("Invalid node ID in Graph::Build");
+            }
+            arrays->sources[e] = (uint32_t)id;
+            arrays->incomingOffsets[arrays->targets[e] + 1]++;
+        }
+    }
+    for (size_t id = 0; id < nodeCount; id++) {
+        arrays->incomingOffsets[id + 1] += arrays->incomingOffsets[id];
     }
-    
-    auto edge = std::make_shared<Edge>(fromNode, toNode, weight);
-    fromNode->edges.push_back(edge);
+    arrays->incomingEdges.resize(edgeCount);
+    std::vector<uint32_t> fill(arrays->incomingOffsets.begin(), arrays->incomingOffsets.end() - 1);
+    for (size_t e = 0; e < edgeCount; e++) {
+        arrays->incomingEdges[fill[arrays->targets[e]]++] = (uint32_t)e;
+    }
+
+    GraphArrays view;
+    view.nodeCount = (int)nodeCount;
+    view.edgeCount = (int)edgeCount;
+    view.positions = arrays->positions.data();
+    view.edgeOffsets = arrays->offsets.data();
+    view.edgeTargets = arrays->targets.data();
+    view.edgeWeights = arrays->weights.data();
+    view.edgeSources = arrays->sources.data();
+    view.incomingOffsets = arrays->incomingOffsets.data();
+    view.incomingEdges = arrays->incomingEdges.data();
+    Attach(view, std::move(arrays));
 }
 
-void Graph::AddBidirectionalEdge(int fromId, int toId, float weight) {
-    AddEdge(fromId, toId, weight);
-    AddEdge(toId, fromId, weight);
+void Graph::Attach(const GraphArrays& arrays, std::shared_ptr<const void> storage) {
+    if (m_Arrays.nodeCount != 0) {
+        throw std::runtime_error("Graph::Attach requires an empty graph");
+    }
+    m_Arrays = arrays;
+    m_Storage = std::move(storage);
 }
 
-std::shared_ptr<Node> Graph::GetNode(int id) {
-    auto it = m_Nodes.find(id);
-    if (it != m_Nodes.end()) {
-        return it->second;
+int Graph::FindEdge(int fromId, int toId) const {
+    if (!HasNode(fromId)) return -1;
+
+    for (int edgeId : GetOutgoingEdges(fromId)) {
+        if (GetEdgeTarget(edgeId) == toId) return edgeId;
     }
-    return nullptr;
+    return -1;
 }
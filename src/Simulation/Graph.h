@@ -1,73 +1,129 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <vector>
-#include <unordered_map>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <vector>
 
-// Forward declarations
-struct Edge;
-struct Node;
-
-enum class TrafficLightState {
+enum class TrafficLightState : uint8_t {
     RED,
     YELLOW,
     GREEN,
     OFF
 };
 
-// Node represents an intersection in the road network
-struct Node {
-    int id;
-    glm::vec3 position;  // 3D position
-    std::vector<std::shared_ptr<Edge>> edges;  // Outgoing edges
-    
-    // Traffic Light Data (Per-Path)
-    // Key: Neighbor ID (where the car is coming FROM), Value: Light State
-    std::unordered_map<int, TrafficLightState> incomingLights;
-    
-    int currentGreenNodeId = -1; // ID of the neighbor that currently has GREEN
+// Signal state of one intersection. Every road into it has its own light,
+// held per edge in SignalTable::lights.
+struct IntersectionSignals {
+    int32_t greenEdge = -1;  // Incoming edge that has GREEN (or YELLOW), -1 if none
     float lightTimer = 0.0f;
     float minGreenDuration = 3.0f;
     float maxGreenDuration = 10.0f;
-    
-    Node(int id, const glm::vec3& pos) : id(id), position(pos) {}
 };
 
-// Edge represents a road connecting two nodes
-struct Edge {
-    std::shared_ptr<Node> from;
-    std::shared_ptr<Node> to;
-    float weight;  // Can represent distance, traffic, etc.
-    
-    Edge(std::shared_ptr<Node> f, std::shared_ptr<Node> t, float w)
-        : from(f), to(t), weight(w) {}
+// Traffic lights of a whole network, in flat arrays. Kept out of the graph,
+// owned by each simulation, so the graph stays read-only once built and
+// several simulations can run on one copy of it.
+struct SignalTable {
+    std::vector<TrafficLightState> lights;           // By edge ID: the light where the edge enters its end node
+    std::vector<IntersectionSignals> intersections;  // By node ID
+};
+
+// Directed edge description used for bulk construction
+struct EdgeDescription {
+    int from;
+    int to;
+    float weight;
+};
+
+// Consecutive edge IDs: the outgoing roads of a node
+class EdgeRange {
+public:
+    class Iterator {
+    public:
+        explicit Iterator(uint32_t id) : m_Id(id) {}
+        int operator*() const { return (int)m_Id; }
+        Iterator& operator++() { m_Id++; return *this; }
+        bool operator!=(const Iterator& other) const { return m_Id != other.m_Id; }
+    private:
+        uint32_t m_Id;
+    };
+
+    EdgeRange(uint32_t first, uint32_t last) : m_First(first), m_Last(last) {}
+    Iterator begin() const { return Iterator(m_First); }
+    Iterator end() const { return Iterator(m_Last); }
+    size_t size() const { return m_Last - m_First; }
+    bool empty() const { return m_First == m_Last; }
+    int operator[](size_t index) const { return (int)(m_First + index); }
+
+private:
+    uint32_t m_First;
+    uint32_t m_Last;
+};
+
+// The arrays a graph is made of. Nodes and edges have dense IDs; edges are
+// numbered in order of their start node (compressed sparse rows).
+struct GraphArrays {
+    int nodeCount = 0;
+    int edgeCount = 0;
+    const glm::vec3* positions = nullptr;        // Per node
+    const uint32_t* edgeOffsets = nullptr;       // Per node + 1: node i's outgoing edges are [offsets[i], offsets[i + 1])
+    const uint32_t* edgeTargets = nullptr;       // Per edge: end node
+    const float* edgeWeights = nullptr;          // Per edge: routing cost
+    const uint32_t* edgeSources = nullptr;       // Per edge: start node
+    const uint32_t* incomingOffsets = nullptr;   // Per node + 1: node i's incoming edges are
+    const uint32_t* incomingEdges = nullptr;     // incomingEdges[incomingOffsets[i] .. incomingOffsets[i + 1]), by start node
 };
 
-// Graph Data Structure - Adjacency List representation
+// Road network as flat arrays: node positions and compressed sparse row
+// adjacency in both directions. Read-only once built, so any number of
+// simulations and threads can share it. The arrays are either owned (Build)
+// or someone else's, e.g. a mapped network file (Attach).
 class Graph {
 public:
     Graph() = default;
-    ~Graph() = default;
-    
-    // Add a node to the graph
-    int AddNode(const glm::vec3& position);
-    
-    // Add a directed edge from node 'from' to node 'to' with given weight
-    void AddEdge(int fromId, int toId, float weight);
-    
-    // Add a bidirectional edge (creates two directed edges)
-    void AddBidirectionalEdge(int fromId, int toId, float weight);
-    
-    // Get node by ID
-    std::shared_ptr<Node> GetNode(int id);
-    
-    // Get all nodes
-    const std::unordered_map<int, std::shared_ptr<Node>>& GetNodes() const { return m_Nodes; }
-    
-    // Get number of nodes
-    size_t GetNodeCount() const { return m_Nodes.size(); }
-    
+
+    // Bulk construction from an edge list. Node i gets ID i; edges keep their
+    // order per start node. The graph must be empty.
+    void Build(const std::vector<glm::vec3>& positions, const std::vector<EdgeDescription>& edges);
+
+    // Same, from compressed sparse row adjacency, taking over the arrays: the
+    // outgoing edges of node i are [offsets[i], offsets[i + 1]) in 'targets' / 'weights'
+    void Build(std::vector<glm::vec3> positions, std::vector<uint32_t> offsets,
+               std::vector<uint32_t> targets, std::vector<float> weights);
+
+    // Uses complete arrays in place. 'storage' keeps them alive for as long as
+    // the graph (or a copy of it) exists.
+    void Attach(const GraphArrays& arrays, std::shared_ptr<const void> storage);
+
+    size_t GetNodeCount() const { return (size_t)m_Arrays.nodeCount; }
+    size_t GetEdgeCount() const { return (size_t)m_Arrays.edgeCount; }
+    bool HasNode(int id) const { return id >= 0 && id < m_Arrays.nodeCount; }
+    bool HasEdge(int id) const { return id >= 0 && id < m_Arrays.edgeCount; }
+
+    const glm::vec3& GetPosition(int nodeId) const { return m_Arrays.positions[nodeId]; }
+    EdgeRange GetOutgoingEdges(int nodeId) const {
+        return EdgeRange(m_Arrays.edgeOffsets[nodeId], m_Arrays.edgeOffsets[nodeId + 1]);
+    }
+    std::span<const uint32_t> GetIncomingEdges(int nodeId) const {
+        return std::span<const uint32_t>(m_Arrays.incomingEdges + m_Arrays.incomingOffsets[nodeId],
+                                         m_Arrays.incomingEdges + m_Arrays.incomingOffsets[nodeId + 1]);
+    }
+
+    int GetEdgeSource(int edgeId) const { return (int)m_Arrays.edgeSources[edgeId]; }
+    int GetEdgeTarget(int edgeId) const { return (int)m_Arrays.edgeTargets[edgeId]; }
+    float GetEdgeWeight(int edgeId) const { return m_Arrays.edgeWeights[edgeId]; }
+    // Distance between the end nodes; vehicles drive offsets 0..length
+    float GetEdgeLength(int edgeId) const {
+        return glm::length(GetPosition(GetEdgeTarget(edgeId)) - GetPosition(GetEdgeSource(edgeId)));
+    }
+
+    // Directed edge between two nodes, -1 if there is none
+    int FindEdge(int fromId, int toId) const;
+
+    const GraphArrays& GetArrays() const { return m_Arrays; }
+
 private:
-    std::unordered_map<int, std::shared_ptr<Node>> m_Nodes;
-    int m_NextNodeId = 0;
+    GraphArrays m_Arrays;
+    std::shared_ptr<const void> m_Storage;
 };
@@ -0,0 +1,155 @@
+#include "GridGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+    uint64_t SplitMix64(uint64_t value) {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    // Independent random value per (seed, node, stream), whichever thread asks
+    uint64_t NodeRandom(uint32_t seed, int nodeId, uint32_t stream) {
+        return SplitMix64(((uint64_t)seed << 32 | stream) ^ SplitMix64((uint64_t)nodeId));
+    }
+
+    struct GridLayout {
+        int width;
+        int height;
+        float spacing;
+        float diagonalLength;
+        int diagonalInterval;
+        std::vector<uint8_t> rowOneWay;     // Per z: the road along x only runs towards +x
+        std::vector<uint8_t> columnOneWay;  // Per x: the road along z only runs towards +z
+
+        int GetId(int x, int z) const { return x * height + z; }
+
+        // Blocks whose corners are joined by a pair of diagonal shortcuts
+        bool HasDiagonals(int blockX, int blockZ) const {
+            return diagonalInterval > 0 && blockX >= 0 && blockZ >= 0 &&
+                   blockX < width - 1 && blockZ < height - 1 &&
+                   blockX % diagonalInterval == 0 && blockZ % diagonalInterval == 0;
+        }
+
+        // Diagonals are two-way, so these are both the outgoing and incoming ones
+        template<typename Visit>
+        void ForEachDiagonal(int x, int z, Visit&& visit) const {
+            if (HasDiagonals(x, z)) visit(x + 1, z + 1, diagonalLength);
+            if (HasDiagonals(x - 1, z - 1)) visit(x - 1, z - 1, diagonalLength);
+            if (HasDiagonals(x - 1, z)) visit(x - 1, z + 1, diagonalLength);
+            if (HasDiagonals(x, z - 1)) visit(x + 1, z - 1, diagonalLength);
+        }
+
+        template<typename Visit>
+        void ForEachOutgoing(int x, int z, Visit&& visit) const {
+            if (x < width - 1) visit(x + 1, z, spacing);
+            if (x > 0 && !rowOneWay[z]) visit(x - 1, z, spacing);
+            if (z < height - 1) visit(x, z + 1, spacing);
+            if (z > 0 && !columnOneWay[x]) visit(x, z - 1, spacing);
+            ForEachDiagonal(x, z, visit);
+        }
+
+        template<typename Visit>
+        void ForEachIncoming(int x, int z, Visit&& visit) const {
+            if (x > 0) visit(x - 1, z, spacing);
+            if (x < width - 1 && !rowOneWay[z]) visit(x + 1, z, spacing);
+            if (z > 0) visit(x, z - 1, spacing);
+            if (z < height - 1 && !columnOneWay[x]) visit(x, z + 1, spacing);
+            ForEachDiagonal(x, z, visit);
+        }
+    };
+
+    // Spreads the one-way streets evenly: street i is one-way when the running
+    // count of one-way streets steps up at i. A fraction of 0.5 makes every odd street one-way.
+    std::vector<uint8_t> SpreadOneWayStreets(int count, float fraction) {
+        std::vector<uint8_t> oneWay(count);
+        for (int i = 0; i < count; i++) {
+            oneWay[i] = std::floor((i + 1) * (double)fraction) > std::floor(i * (double)fraction);
+        }
+        return oneWay;
+    }
+
+    // Runs body(xBegin, xEnd) over bands of grid columns, one band per thread
+    template<typename Body>
+    void ForEachBand(int width, int threadCount, Body&& body) {
+        int bands = std::clamp(threadCount, 1, width);
+        int bandWidth = (width + bands - 1) / bands;
+        std::vector<std::thread> workers;
+        for (int band = 1; band < bands; band++) {
+            int begin = band * bandWidth;
+            int end = std::min(begin + bandWidth, width);
+            if (begin < end) workers.emplace_back([&body, begin, end] { body(begin, end); });
+        }
+        body(0, std::min(bandWidth, width));
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+}
+
+void GridGenerator::Generate(const Scenario& scenario, uint32_t seed, int threadCount, GeneratedNetwork& network) {
+    GridLayout layout;
+    layout.width = std::max(scenario.gridWidth, 2);
+    layout.height = std::max(scenario.gridHeight, 2);
+    layout.spacing = scenario.spacing;
+    layout.diagonalLength = scenario.spacing * std::sqrt(2.0f);
+    layout.diagonalInterval = scenario.diagonalInterval;
+    layout.rowOneWay = SpreadOneWayStreets(layout.height, scenario.oneWayFraction);
+    layout.columnOneWay = SpreadOneWayStreets(layout.width, scenario.oneWayFraction);
+
+    size_t nodeCount = (size_t)layout.width * layout.height;
+    network.positions.resize(nodeCount);
+    network.offsets.assign(nodeCount + 1, 0);
+    network.signalLayout.resize(nodeCount);
+
+    // Pass 1: out-degree of every node
+    ForEachBand(layout.width, threadCount, [&](int xBegin, int xEnd) {
+        for (int x = xBegin; x < xEnd; x++) {
+            for (int z = 0; z < layout.height; z++) {
+                uint32_t degree = 0;
+                layout.ForEachOutgoing(x, z, [&](int, int, float) { degree++; });
+                network.offsets[layout.GetId(x, z) + 1] = degree;
+            }
+        }
+    });
+
+    for (size_t i = 0; i < nodeCount; i++) {
+        network.offsets[i + 1] += network.offsets[i];
+    }
+    network.targets.resize(network.offsets[nodeCount]);
+    network.weights.resize(network.offsets[nodeCount]);
+
+    // Pass 2: positions, edges and signals, each node writing only its own slots
+    uint32_t signalThreshold = (uint32_t)std::min((double)scenario.signalDensity * 4294967296.0, 4294967295.0);
+    ForEachBand(layout.width, threadCount, [&](int xBegin, int xEnd) {
+        int incoming[8];
+        for (int x = xBegin; x < xEnd; x++) {
+            for (int z = 0; z < layout.height; z++) {
+                int id = layout.GetId(x, z);
+                network.positions[id] = glm::vec3(x * layout.spacing, 0.0f, z * layout.spacing);
+
+                uint32_t edge = network.offsets[id];
+                layout.ForEachOutgoing(x, z, [&](int toX, int toZ, float weight) {
+                    network.targets[edge] = (uint32_t)layout.GetId(toX, toZ);
+                    network.weights[edge] = weight;
+                    edge++;
+                });
+
+                // Signals only where more than one road comes in
+                int incomingCount = 0;
+                layout.ForEachIncoming(x, z, [&](int fromX, int fromZ, float) {
+                    incoming[incomingCount++] = layout.GetId(fromX, fromZ);
+                });
+                network.signalLayout[id] = -1;
+                if (incomingCount > 1 && (uint32_t)NodeRandom(seed, id, 0) < signalThreshold) {
+                    network.signalLayout[id] = incoming[NodeRandom(seed, id, 1) % incomingCount];
+                }
+            }
+        }
+    });
+}
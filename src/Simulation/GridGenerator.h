@@ -0,0 +1,25 @@
+#pragma once
+#include "Scenario.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Procedural grid network in compressed sparse row form, ready for Graph::Build
+struct GeneratedNetwork {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> offsets;      // Outgoing edges of node i are [offsets[i], offsets[i + 1])
+    std::vector<uint32_t> targets;
+    std::vector<float> weights;
+    std::vector<int32_t> signalLayout;  // Neighbour that starts green, -1 = no signal
+
+    int GetNodeCount() const { return (int)positions.size(); }
+};
+
+// Generates the grid a scenario describes. Node (x, z) gets ID x * gridHeight + z.
+// Every node's roads and signal are a pure function of its coordinates and the
+// seed, so the grid is generated in parallel bands and comes out identical for
+// any thread count.
+class GridGenerator {
+public:
+    static void Generate(const Scenario& scenario, uint32_t seed, int threadCount, GeneratedNetwork& network);
+};
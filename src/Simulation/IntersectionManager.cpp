@@ -0,0 +1,120 @@
+#include "IntersectionManager.h"
+#include "Vehicle.h"
+#include <algorithm>
+
+namespace {
+
+    float Cross(const glm::vec2& a, const glm::vec2& b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    bool SegmentsCross(const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& q1, const glm::vec2& q2) {
+        float d1 = Cross(p2 - p1, q1 - p1);
+        float d2 = Cross(p2 - p1, q2 - p1);
+        float d3 = Cross(q2 - q1, p1 - q1);
+        float d4 = Cross(q2 - q1, p2 - q1);
+        return ((d1 > 0.0f) != (d2 > 0.0f)) && ((d3 > 0.0f) != (d4 > 0.0f));
+    }
+
+    // Unit direction of a road on the ground plane (x, z)
+    glm::vec2 GetGroundDirection(const glm::vec3& from, const glm::vec3& to) {
+        glm::vec2 direction(to.x - from.x, to.z - from.z);
+        float length = glm::length(direction);
+        return length > 0.0f ? direction / length : glm::vec2(0.0f, 1.0f);
+    }
+
+    // Right of the direction of travel, as Vehicle places its lanes
+    glm::vec2 GetRight(const glm::vec2& direction) {
+        return glm::vec2(-direction.y, direction.x);
+    }
+
+}
+
+bool IntersectionManager::Request(const Graph& graph, const Movement& movement, int vehicleId,
+                                  double entryTime, double exitTime) {
+    if (!graph.HasNode(movement.fromNodeId) || !graph.HasNode(movement.nodeId) || !graph.HasNode(movement.toNodeId)) {
+        return true;
+    }
+    const glm::vec3& from = graph.GetPosition(movement.fromNodeId);
+    const glm::vec3& node = graph.GetPosition(movement.nodeId);
+    const glm::vec3& to = graph.GetPosition(movement.toNodeId);
+
+    // Lane centre where the movement enters and leaves the box
+    const float laneOffset = Vehicle::LaneWidth * 0.5f;
+    glm::vec2 centre(node.x, node.z);
+    glm::vec2 in = GetGroundDirection(from, node);
+    glm::vec2 out = GetGroundDirection(node, to);
+
+    Reservation request;
+    request.nodeId = movement.nodeId;
+    request.fromNodeId = movement.fromNodeId;
+    request.toNodeId = movement.toNodeId;
+    request.vehicleId = vehicleId;
+    request.entryTime = entryTime;
+    request.exitTime = exitTime;
+    request.entry = centre - in * JunctionRadius + GetRight(in) * laneOffset;
+    request.exit = centre + out * JunctionRadius + GetRight(out) * laneOffset;
+
+    auto it = m_Nodes.find(movement.nodeId);
+    if (it != m_Nodes.end()) {
+        for (const auto& slot : it->second) {
+            bool overlaps = slot.entryTime - SlotMargin < exitTime && entryTime < slot.exitTime + SlotMargin;
+            if (overlaps && Conflicts(slot, request)) return false;
+        }
+        it->second.push_back(request);
+    } else {
+        m_Nodes[movement.nodeId].push_back(request);
+    }
+    return true;
+}
+
+double IntersectionManager::FindSlot(int nodeId, int vehicleId) const {
+    auto it = m_Nodes.find(nodeId);
+    if (it == m_Nodes.end()) return -1.0;
+    for (const auto& slot : it->second) {
+        if (slot.vehicleId == vehicleId) return slot.entryTime;
+    }
+    return -1.0;
+}
+
+void IntersectionManager::Cancel(int nodeId, int vehicleId) {
+    auto it = m_Nodes.find(nodeId);
+    if (it == m_Nodes.end()) return;
+    auto& slots = it->second;
+    slots.erase(std::remove_if(slots.begin(), slots.end(),
+        [vehicleId](const Reservation& slot) { return slot.vehicleId == vehicleId; }), slots.end());
+    if (slots.empty()) m_Nodes.erase(it);
+}
+
+void IntersectionManager::Expire(double time) {
+    for (auto it = m_Nodes.begin(); it != m_Nodes.end();) {
+        auto& slots = it->second;
+        slots.erase(std::remove_if(slots.begin(), slots.end(),
+            [time](const Reservation& slot) { return slot.exitTime + SlotMargin < time; }), slots.end());
+        it = slots.empty() ? m_Nodes.erase(it) : std::next(it);
+    }
+}
+
+size_t IntersectionManager::GetReservationCount() const {
+    size_t count = 0;
+    for (const auto& [nodeId, slots] : m_Nodes) {
+        count += slots.size();
+    }
+    return count;
+}
+
+void IntersectionManager::GetReservations(std::vector<Reservation>& reservations) const {
+    for (const auto& [nodeId, slots] : m_Nodes) {
+        reservations.insert(reservations.end(), slots.begin(), slots.end());
+    }
+}
+
+void IntersectionManager::Restore(const Reservation& reservation) {
+    m_Nodes[reservation.nodeId].push_back(reservation);
+}
+
+bool IntersectionManager::Conflicts(const Reservation& a, const Reservation& b) {
+    if (a.fromNodeId == b.fromNodeId) return false;  // Same road: lane order
+    if (a.toNodeId == b.toNodeId) return true;       // Merging
+    return SegmentsCross(a.entry, a.exit, b.entry, b.exit);
+}
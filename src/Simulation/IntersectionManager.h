@@ -0,0 +1,65 @@
+#pragma once
+#include "Graph.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Reservation-based control of unsignalised intersections. A vehicle nearing
+// one asks for the time slot in which its turning movement (incoming road ->
+// outgoing road) occupies the junction box, assuming it keeps cruising. The
+// slot is granted unless it overlaps a granted slot of a conflicting movement;
+// otherwise the vehicle holds at the box and asks again next tick.
+//
+// Movements conflict when they merge into the same road or their paths through
+// the box cross. Movements from the same road never conflict: the vehicles on
+// it already follow each other in lane order. A request checks the handful of
+// slots booked at its node, so it costs O(movements) there, never a scan of
+// the vehicles around.
+//
+// Each RegionPartition tile has its own manager for the nodes it owns, and
+// only that tile's thread touches it.
+class IntersectionManager {
+public:
+    static constexpr float JunctionRadius = 2.0f;     // The box extends this far along every road
+    static constexpr float ApproachDistance = 15.0f;  // Vehicles start asking this far from the node
+    static constexpr float HoldDistance = 1.0f;       // Without a slot, vehicles stop this far before the box
+    static constexpr float SlotMargin = 0.25f;        // Seconds of clearance around every slot
+
+    struct Movement {
+        int fromNodeId;
+        int nodeId;
+        int toNodeId;
+    };
+
+    struct Reservation {
+        int32_t nodeId;
+        int32_t fromNodeId;
+        int32_t toNodeId;
+        int32_t vehicleId;
+        double entryTime;
+        double exitTime;
+        glm::vec2 entry;  // Path through the box on the ground plane, in lane
+        glm::vec2 exit;
+    };
+
+    // Books [entryTime, exitTime] (simulation seconds) for the vehicle's movement
+    // if no conflicting slot overlaps it. Returns whether it was granted.
+    bool Request(const Graph& graph, const Movement& movement, int vehicleId, double entryTime, double exitTime);
+    // Entry time of the vehicle's slot at the node, or a negative value if it holds none
+    double FindSlot(int nodeId, int vehicleId) const;
+    void Cancel(int nodeId, int vehicleId);
+    // Drops every slot that ended before 'time'
+    void Expire(double time);
+
+    size_t GetReservationCount() const;
+
+    // Checkpointing: every booked slot, and booking one again as it was
+    void GetReservations(std::vector<Reservation>& reservations) const;
+    void Restore(const Reservation& reservation);
+
+private:
+    static bool Conflicts(const Reservation& a, const Reservation& b);
+
+    std::unordered_map<int, std::vector<Reservation>> m_Nodes;  // Only nodes with booked slots
+};
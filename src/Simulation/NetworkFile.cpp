@@ -0,0 +1,231 @@
+#include "NetworkFile.h"
+#include "../Core/Compression.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+    const char kMagic[4] = { 'T', 'S', 'N', 'W' };
+    constexpr size_t kAlignment = 64;
+
+    // All fields little-endian
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t sectionCount;
+        uint64_t fileSize;
+        uint32_t nodeCount;
+        uint32_t edgeCount;
+        uint32_t checksum;  // Adler-32 of everything after the header
+        uint32_t reserved;
+    };
+
+    struct SectionEntry {
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(FileHeader) == 40, "FileHeader layout");
+    static_assert(sizeof(SectionEntry) == 24, "SectionEntry layout");
+    static_assert(sizeof(glm::vec3) == 12, "Positions are stored as packed float triples");
+
+    size_t AlignUp(size_t value) {
+        return (value + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    struct PendingSection {
+        uint32_t type;
+        const void* data;
+        size_t size;
+    };
+
+}
+
+bool NetworkFile::Write(const std::string& path, const Graph& graph, const SignalTable& signals,
+                        const std::vector<ExtraSection>& extraSections) {
+    int nodeCount = (int)graph.GetNodeCount();
+    int edgeCount = (int)graph.GetEdgeCount();
+    const GraphArrays& arrays = graph.GetArrays();
+    
+    std::vector<int32_t> signalLayout(nodeCount, -1);
+    for (int id = 0; id < nodeCount && id < (int)signals.intersections.size(); id++) {
+        int greenEdge = signals.intersections[id].greenEdge;
+        if (greenEdge < 0 || greenEdge >= (int)signals.lights.size()) continue;
+        for (uint32_t edgeId : graph.GetIncomingEdges(id)) {
+            if (signals.lights[edgeId] != TrafficLightState::OFF) {
+                signalLayout[id] = graph.GetEdgeSource(greenEdge);
+                break;
+            }
+        }
+    }
+    
+    std::vector<PendingSection> sections = {
+        { (uint32_t)NetworkSection::Positions, arrays.positions, nodeCount * sizeof(glm::vec3) },
+        { (uint32_t)NetworkSection::EdgeOffsets, arrays.edgeOffsets, (nodeCount + 1) * sizeof(uint32_t) },
+        { (uint32_t)NetworkSection::EdgeTargets, arrays.edgeTargets, edgeCount * sizeof(uint32_t) },
+        { (uint32_t)NetworkSection::EdgeWeights, arrays.edgeWeights, edgeCount * sizeof(float) },
+        { (uint32_t)NetworkSection::SignalLayout, signalLayout.data(), signalLayout.size() * sizeof(int32_t) },
+        { (uint32_t)NetworkSection::EdgeSources, arrays.edgeSources, edgeCount * sizeof(uint32_t) },
+        { (uint32_t)NetworkSection::IncomingOffsets, arrays.incomingOffsets, (nodeCount + 1) * sizeof(uint32_t) },
+        { (uint32_t)NetworkSection::IncomingEdges, arrays.incomingEdges, edgeCount * sizeof(uint32_t) },
+    };
+    for (const auto& extra : extraSections) {
+        sections.push_back({ extra.type, extra.data.data(), extra.data.size() });
+    }
+    
+    // Assemble the file image: header, section table, aligned payloads
+    size_t tableEnd = sizeof(FileHeader) + sections.size() * sizeof(SectionEntry);
+    std::vector<SectionEntry> table;
+    size_t offset = AlignUp(tableEnd);
+    for (const auto& section : sections) {
+        table.push_back({ section.type, 0, offset, section.size });
+        offset = AlignUp(offset + section.size);
+    }
+    
+    std::vector<uint8_t> image(offset, 0);
+    std::memcpy(image.data() + sizeof(FileHeader), table.data(), table.size() * sizeof(SectionEntry));
+    for (size_t i = 0; i < sections.size(); i++) {
+        if (sections[i].size > 0) {
+            std::memcpy(image.data() + table[i].offset, sections[i].data, sections[i].size);
+        }
+    }
+    
+    FileHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = Version;
+    header.headerSize = sizeof(FileHeader);
+    header.sectionCount = (uint32_t)sections.size();
+    header.fileSize = image.size();
+    header.nodeCount = (uint32_t)nodeCount;
+    header.edgeCount = (uint32_t)edgeCount;
+    header.checksum = Compression::Adler32(image.data() + sizeof(FileHeader), image.size() - sizeof(FileHeader));
+    std::memcpy(image.data(), &header, sizeof(header));
+    
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create network file: " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write network file: " << path << std::endl;
+        return false;
+    }
+    
+    std::cout << "Exported network (" << nodeCount << " nodes, " << edgeCount << " edges) to " << path << std::endl;
+    return true;
+}
+
+bool NetworkFile::Open(const std::string& path, bool verify) {
+    m_File = std::make_shared<MappedFile>();
+    m_Arrays = GraphArrays();
+    m_SignalLayout = nullptr;
+    if (!m_File->Open(path)) return false;
+    
+    const uint8_t* data = m_File->GetData();
+    size_t size = m_File->GetSize();
+    
+    FileHeader header;
+    if (size < sizeof(FileHeader)) {
+        std::cerr << "Not a network file: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << "Not a network file: " << path << std::endl;
+        return false;
+    }
+    if (header.version != Version) {
+        std::cerr << "Unsupported network file version " << header.version << " (expected " << Version << ")" << std::endl;
+        return false;
+    }
+    if (header.headerSize != sizeof(FileHeader) || header.fileSize != size ||
+        sizeof(FileHeader) + (uint64_t)header.sectionCount * sizeof(SectionEntry) > size) {
+        std::cerr << "Network file is truncated or corrupt: " << path << std::endl;
+        return false;
+    }
+    if (verify && Compression::Adler32(data + sizeof(FileHeader), size - sizeof(FileHeader)) != header.checksum) {
+        std::cerr << "Network file checksum mismatch: " << path << std::endl;
+        return false;
+    }
+    
+    size_t nodeCount = header.nodeCount;
+    size_t edgeCount = header.edgeCount;
+    auto require = [&](NetworkSection type, size_t expectedSize) -> const uint8_t* {
+        size_t sectionSize = 0;
+        const uint8_t* section = FindSection((uint32_t)type, sectionSize);
+        return (section && sectionSize == expectedSize) ? section : nullptr;
+    };
+    
+    GraphArrays arrays;
+    arrays.nodeCount = (int)nodeCount;
+    arrays.edgeCount = (int)edgeCount;
+    arrays.positions = (const glm::vec3*)require(NetworkSection::Positions, nodeCount * sizeof(glm::vec3));
+    arrays.edgeOffsets = (const uint32_t*)require(NetworkSection::EdgeOffsets, (nodeCount + 1) * sizeof(uint32_t));
+    arrays.edgeTargets = (const uint32_t*)require(NetworkSection::EdgeTargets, edgeCount * sizeof(uint32_t));
+    arrays.edgeWeights = (const float*)require(NetworkSection::EdgeWeights, edgeCount * sizeof(float));
+    arrays.edgeSources = (const uint32_t*)require(NetworkSection::EdgeSources, edgeCount * sizeof(uint32_t));
+    arrays.incomingOffsets = (const uint32_t*)require(NetworkSection::IncomingOffsets, (nodeCount + 1) * sizeof(uint32_t));
+    arrays.incomingEdges = (const uint32_t*)require(NetworkSection::IncomingEdges, edgeCount * sizeof(uint32_t));
+    
+    if (!arrays.positions || !arrays.edgeOffsets || !arrays.edgeTargets || !arrays.edgeWeights ||
+        !arrays.edgeSources || !arrays.incomingOffsets || !arrays.incomingEdges) {
+        std::cerr << "Network file is missing required sections: " << path << std::endl;
+        return false;
+    }
+    
+    // The checksum guards against corruption, not against a buggy writer, so
+    // verifying also walks the whole adjacency; otherwise only its ends are checked
+    bool valid = arrays.edgeOffsets[0] == 0 && arrays.edgeOffsets[nodeCount] == edgeCount &&
+                 arrays.incomingOffsets[0] == 0 && arrays.incomingOffsets[nodeCount] == edgeCount;
+    for (size_t id = 0; verify && valid && id < nodeCount; id++) {
+        valid = arrays.edgeOffsets[id] <= arrays.edgeOffsets[id + 1] &&
+                arrays.incomingOffsets[id] <= arrays.incomingOffsets[id + 1];
+        for (uint32_t e = arrays.edgeOffsets[id]; valid && e < arrays.edgeOffsets[id + 1]; e++) {
+            valid = arrays.edgeTargets[e] < nodeCount && arrays.edgeSources[e] == id;
+        }
+        for (uint32_t i = arrays.incomingOffsets[id]; valid && i < arrays.incomingOffsets[id + 1]; i++) {
+            valid = arrays.incomingEdges[i] < edgeCount && arrays.edgeTargets[arrays.incomingEdges[i]] == id;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Network file has invalid adjacency: " << path << std::endl;
+        return false;
+    }
+    
+    m_Arrays = arrays;
+    m_SignalLayout = (const int32_t*)require(NetworkSection::SignalLayout, nodeCount * sizeof(int32_t));
+    return true;
+}
+
+const uint8_t* NetworkFile::FindSection(uint32_t type, size_t& size) const {
+    if (!m_File || !m_File->IsOpen()) return nullptr;
+    
+    const uint8_t* data = m_File->GetData();
+    uint32_t sectionCount;
+    std::memcpy(&sectionCount, data + offsetof(FileHeader, sectionCount), sizeof(sectionCount));
+    
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        SectionEntry entry;
+        std::memcpy(&entry, data + sizeof(FileHeader) + i * sizeof(SectionEntry), sizeof(entry));
+        if (entry.type != type) continue;
+        
+        if (entry.offset % kAlignment != 0 || entry.offset > m_File->GetSize() ||
+            entry.size > m_File->GetSize() - entry.offset) {
+            return nullptr;
+        }
+        size = (size_t)entry.size;
+        return data + entry.offset;
+    }
+    return nullptr;
+}
+
+void NetworkFile::BuildGraph(Graph& graph) const {
+    graph.Attach(m_Arrays, m_File);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "Graph.h"
+#include "../Core/MappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Section types stored in a .tsnet file
+enum class NetworkSection : uint32_t {
+    Positions = 1,       // glm::vec3 per node
+    EdgeOffsets = 2,     // uint32 per node + 1: outgoing edges of node i are [offsets[i], offsets[i+1])
+    EdgeTargets = 3,     // uint32 target node per edge
+    EdgeWeights = 4,     // float per edge
+    SignalLayout = 5,    // int32 per node: neighbour that starts green, -1 = no signal
+    EdgeSources = 6,     // uint32 start node per edge
+    IncomingOffsets = 7, // uint32 per node + 1: incoming edges of node i are [offsets[i], offsets[i+1])
+    IncomingEdges = 8,   // uint32 edge ID, grouped by end node
+    RoutingData = 0x100, // First ID reserved for optional routing preprocessing
+    NextHops = 0x100     // NextHopTable::Serialize
+};
+
+// Binary road network format (.tsnet).
+// Layout: header, section table, then 64-byte aligned section payloads holding
+// the Graph's arrays as they are in memory. Opening a file maps it and checks
+// the header and section sizes; the graph then uses the mapped arrays in place,
+// so only the pages the simulation touches are ever read.
+class NetworkFile {
+public:
+    static constexpr uint32_t Version = 2;
+    
+    struct ExtraSection {
+        uint32_t type;
+        std::vector<uint8_t> data;
+    };
+    
+    // The signal layout is taken from 'signals' (empty = no signals).
+    static bool Write(const std::string& path, const Graph& graph, const SignalTable& signals,
+                      const std::vector<ExtraSection>& extraSections = {});
+    
+    // 'verify' also checks the checksum and every adjacency entry, which reads
+    // the whole file. Without it a damaged file can crash the simulation later.
+    bool Open(const std::string& path, bool verify = false);
+    
+    // Attaches the mapped arrays to an empty graph; the mapping stays alive as
+    // long as the graph does
+    void BuildGraph(Graph& graph) const;
+    
+    int GetNodeCount() const { return m_Arrays.nodeCount; }
+    int GetEdgeCount() const { return m_Arrays.edgeCount; }
+    const GraphArrays& GetArrays() const { return m_Arrays; }
+    const int32_t* GetSignalLayout() const { return m_SignalLayout; }  // nullptr if absent
+    
+    // Raw access to any section, e.g. routing data. Returns nullptr if absent.
+    const uint8_t* FindSection(uint32_t type, size_t& size) const;
+    
+private:
+    std::shared_ptr<MappedFile> m_File;
+    GraphArrays m_Arrays;
+    const int32_t* m_SignalLayout = nullptr;
+};
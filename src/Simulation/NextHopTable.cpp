@@ -0,0 +1,166 @@
+#include "NextHopTable.h"
+#include "../Core/Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+
+namespace {
+
+    // Section payload: header, row offsets, runs
+    struct SectionHeader {
+        uint32_t nodeCount;
+        uint32_t runCount;
+    };
+
+}
+
+bool NextHopTable::Build(const Graph& graph, int threadCount) {
+    TS_PROFILE_SCOPE(ProfilePhase::Routing);
+    m_RowOffsets.clear();
+    m_Runs.clear();
+
+    size_t nodeCount = graph.GetNodeCount();
+    if (nodeCount == 0 || nodeCount > MaxNodeCount) return false;
+
+    // The graph's own adjacency: a hop is an index into the node's outgoing edges
+    const GraphArrays& arrays = graph.GetArrays();
+    const uint32_t* offsets = arrays.edgeOffsets;
+    const uint32_t* targets = arrays.edgeTargets;
+    const float* weights = arrays.edgeWeights;
+    for (size_t id = 0; id < nodeCount; id++) {
+        if (offsets[id + 1] - offsets[id] >= NoHop) return false;
+    }
+
+    // One Dijkstra per source. The first hop is inherited down the shortest-path
+    // tree, so the whole row falls out of a single search.
+    std::vector<std::vector<Run>> rows(nodeCount);
+    std::atomic<size_t> nextSource{ 0 };
+    auto worker = [&] {
+        using Entry = std::pair<float, uint32_t>;
+        std::vector<float> distances(nodeCount);
+        std::vector<uint16_t> firstHops(nodeCount);
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> openSet;
+
+        for (;;) {
+            size_t source = nextSource.fetch_add(1, std::memory_order_relaxed);
+            if (source >= nodeCount) return;
+
+            std::fill(distances.begin(), distances.end(), std::numeric_limits<float>::max());
+            std::fill(firstHops.begin(), firstHops.end(), NoHop);
+            distances[source] = 0.0f;
+            openSet.push({ 0.0f, (uint32_t)source });
+            while (!openSet.empty()) {
+                auto [distance, node] = openSet.top();
+                openSet.pop();
+                if (distance > distances[node]) continue;
+                for (uint32_t edge = offsets[node]; edge < offsets[node + 1]; edge++) {
+                    uint32_t next = targets[edge];
+                    float candidate = distance + weights[edge];
+                    if (candidate < distances[next]) {
+                        distances[next] = candidate;
+                        firstHops[next] = node == source ? (uint16_t)(edge - offsets[node]) : firstHops[node];
+                        openSet.push({ candidate, next });
+                    }
+                }
+            }
+
+            std::vector<Run>& row = rows[source];
+            for (size_t target = 0; target < nodeCount; target++) {
+                uint16_t hop = target == source ? NoHop : firstHops[target];
+                if (row.empty() || row.back().hop != hop) {
+                    row.push_back({ (uint16_t)target, hop });
+                }
+            }
+            row.shrink_to_fit();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < std::min<int>(std::max(threadCount, 1), (int)nodeCount); i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    m_RowOffsets.assign(nodeCount + 1, 0);
+    for (size_t source = 0; source < nodeCount; source++) {
+        m_RowOffsets[source + 1] = m_RowOffsets[source] + (uint32_t)rows[source].size();
+    }
+    m_Runs.reserve(m_RowOffsets.back());
+    for (auto& row : rows) {
+        m_Runs.insert(m_Runs.end(), row.begin(), row.end());
+        std::vector<Run>().swap(row);
+    }
+    return true;
+}
+
+std::vector<uint8_t> NextHopTable::Serialize() const {
+    SectionHeader header = { (uint32_t)GetNodeCount(), (uint32_t)m_Runs.size() };
+    size_t offsetBytes = m_RowOffsets.size() * sizeof(uint32_t);
+    size_t runBytes = m_Runs.size() * sizeof(Run);
+
+    std::vector<uint8_t> data(sizeof(header) + offsetBytes + runBytes);
+    std::memcpy(data.data(), &header, sizeof(header));
+    if (offsetBytes > 0) std::memcpy(data.data() + sizeof(header), m_RowOffsets.data(), offsetBytes);
+    if (runBytes > 0) std::memcpy(data.data() + sizeof(header) + offsetBytes, m_Runs.data(), runBytes);
+    return data;
+}
+
+bool NextHopTable::Deserialize(const uint8_t* data, size_t size, size_t nodeCount) {
+    SectionHeader header;
+    if (!data || size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    size_t offsetBytes = ((size_t)header.nodeCount + 1) * sizeof(uint32_t);
+    size_t runBytes = (size_t)header.runCount * sizeof(Run);
+    if (header.nodeCount != nodeCount || nodeCount == 0 || size != sizeof(header) + offsetBytes + runBytes) return false;
+
+    std::vector<uint32_t> rowOffsets(header.nodeCount + 1);
+    std::vector<Run> runs(header.runCount);
+    std::memcpy(rowOffsets.data(), data + sizeof(header), offsetBytes);
+    if (runBytes > 0) std::memcpy(runs.data(), data + sizeof(header) + offsetBytes, runBytes);
+
+    // Every row must be a non-empty, in-range slice of the runs
+    if (rowOffsets.front() != 0 || rowOffsets.back() != header.runCount) return false;
+    for (size_t source = 0; source < nodeCount; source++) {
+        if (rowOffsets[source + 1] <= rowOffsets[source]) return false;
+    }
+
+    m_RowOffsets = std::move(rowOffsets);
+    m_Runs = std::move(runs);
+    return true;
+}
+
+uint16_t NextHopTable::GetNextHop(int sourceId, int targetId) const {
+    size_t nodeCount = GetNodeCount();
+    if (sourceId < 0 || targetId < 0 || (size_t)sourceId >= nodeCount || (size_t)targetId >= nodeCount) return NoHop;
+
+    // Last run starting at or before the target
+    const Run* begin = m_Runs.data() + m_RowOffsets[sourceId];
+    const Run* end = m_Runs.data() + m_RowOffsets[sourceId + 1];
+    const Run* run = std::upper_bound(begin, end, (uint16_t)targetId,
+        [](uint16_t target, const Run& candidate) { return target < candidate.firstTarget; });
+    return run == begin ? NoHop : (run - 1)->hop;
+}
+
+std::vector<int> NextHopTable::FindPath(const Graph& graph, int startId, int goalId) const {
+    TS_PROFILE_SCOPE(ProfilePhase::Routing);
+
+    std::vector<int> path = { startId };
+    int nodeId = startId;
+    while (nodeId != goalId) {
+        uint16_t hop = GetNextHop(nodeId, goalId);
+        // Unreachable, or a table that does not match the graph (loops included)
+        if (hop == NoHop || !graph.HasNode(nodeId) || hop >= graph.GetOutgoingEdges(nodeId).size() ||
+            path.size() > GetNodeCount()) return {};
+        nodeId = graph.GetEdgeTarget(graph.GetOutgoingEdges(nodeId)[hop]);
+        path.push_back(nodeId);
+    }
+    return path;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Graph.h"
+#include <cstdint>
+#include <vector>
+
+// Precomputed all-pairs routing for small and medium networks. For every
+// source and target node the table holds the first road of a shortest path
+// between them, as an index into the source node's edges. A route is then a
+// walk: take the hop, look up the next one from the node it leads to, with no
+// search at all.
+//
+// Each source's row is stored as runs of consecutive target IDs sharing a hop.
+// Nearby targets mostly share one, so the rows compress to a small fraction of
+// the N x N uint16 matrix. Node IDs and edge indices must fit in 16 bits.
+//
+// Read-only once built; may be shared by several simulations on one graph.
+class NextHopTable {
+public:
+    static constexpr size_t AutoNodeThreshold = 10000;  // RoutingMode::Auto builds a table up to this size
+    static constexpr size_t MaxNodeCount = 0xFFFF;
+    static constexpr uint16_t NoHop = 0xFFFF;
+
+    // One shortest-path tree per source, spread over 'threadCount' threads.
+    // Returns false, leaving the table empty, if the graph is too large.
+    bool Build(const Graph& graph, int threadCount);
+
+    // Payload of the .tsnet routing section, and reading one back. Data built
+    // for a different node count is rejected.
+    std::vector<uint8_t> Serialize() const;
+    bool Deserialize(const uint8_t* data, size_t size, size_t nodeCount);
+
+    // Index into the source node's edges of the first road towards the target,
+    // NoHop if the target is unreachable (or is the source)
+    uint16_t GetNextHop(int sourceId, int targetId) const;
+    // Node path from start to goal by following the table; empty if unreachable
+    std::vector<int> FindPath(const Graph& graph, int startId, int goalId) const;
+
+    bool IsEmpty() const { return m_RowOffsets.empty(); }
+    size_t GetNodeCount() const { return m_RowOffsets.empty() ? 0 : m_RowOffsets.size() - 1; }
+    size_t GetRunCount() const { return m_Runs.size(); }
+    size_t GetMemoryBytes() const { return m_RowOffsets.size() * sizeof(uint32_t) + m_Runs.size() * sizeof(Run); }
+
+private:
+    struct Run {
+        uint16_t firstTarget;  // The run covers targets from here up to the next run's first
+        uint16_t hop;
+    };
+
+    // Runs of source s: m_Runs[m_RowOffsets[s] .. m_RowOffsets[s + 1])
+    std::vector<uint32_t> m_RowOffsets;
+    std::vector<Run> m_Runs;
+};
@@ -0,0 +1,858 @@
+#include "OsmImporter.h"
+#include "../Core/Compression.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+    // Node coordinates in 1e-7 degrees; lat == NoCoordinate until the node pass finds it
+    struct OsmCoordinates {
+        int32_t lat;
+        int32_t lon;
+    };
+    constexpr int32_t NoCoordinate = std::numeric_limits<int32_t>::min();
+
+    struct WayTags {
+        std::string highway;
+        std::string oneway;
+        std::string maxspeed;
+        std::string junction;
+
+        void Set(std::string_view key, std::string_view value) {
+            if (key == "highway") highway = value;
+            else if (key == "oneway") oneway = value;
+            else if (key == "maxspeed") maxspeed = value;
+            else if (key == "junction") junction = value;
+        }
+
+        void Clear() {
+            highway.clear();
+            oneway.clear();
+            maxspeed.clear();
+            junction.clear();
+        }
+    };
+
+    // Referenced nodes are kept as a sorted ID array with parallel compact
+    // arrays, looked up by binary search. Way node lists are never stored:
+    // the last pass re-reads the ways and emits edges directly.
+    struct ImportState {
+        OsmImporter::Options options;
+        bool emitEdges = false;             // Set for the final way pass
+        size_t wayCount = 0;
+        float maxSpeed = 1.0f;
+
+        std::vector<int64_t> nodeIds;       // Sorted and unique once the first pass is done
+        std::vector<uint8_t> useCounts;     // Way references, saturating at 2 (endpoints count twice)
+        std::vector<OsmCoordinates> coordinates;
+        std::vector<int> graphIds;
+        size_t resolvedNodes = 0;
+
+        // Projection around the centre of the referenced area
+        double lat0 = 0.0, lon0 = 0.0;
+        double scaleX = 0.0, scaleZ = 0.0;
+
+        std::vector<glm::vec3> positions;
+        std::vector<EdgeDescription> edges;
+    };
+
+    // ---- Tag interpretation ------------------------------------------------
+
+    // Typical urban speeds (km/h) for drivable highway classes; 0 = not drivable
+    float DefaultSpeed(std::string_view highway, bool includeService) {
+        struct Entry { const char* name; float speed; };
+        static const Entry table[] = {
+            { "motorway", 110.0f }, { "motorway_link", 60.0f },
+            { "trunk", 90.0f },     { "trunk_link", 50.0f },
+            { "primary", 65.0f },   { "primary_link", 40.0f },
+            { "secondary", 55.0f }, { "secondary_link", 40.0f },
+            { "tertiary", 45.0f },  { "tertiary_link", 35.0f },
+            { "unclassified", 40.0f }, { "residential", 30.0f },
+            { "living_street", 10.0f }, { "road", 40.0f },
+        };
+        for (const auto& entry : table) {
+            if (highway == entry.name) return entry.speed;
+        }
+        if (includeService && highway == "service") return 20.0f;
+        return 0.0f;
+    }
+
+    // "50", "30 mph", "10 knots"; anything non-numeric ("none", "walk", "DE:urban") is ignored
+    float ParseMaxSpeed(std::string_view value) {
+        float speed = 0.0f;
+        auto result = std::from_chars(value.data(), value.data() + value.size(), speed);
+        if (result.ec != std::errc() || speed <= 0.0f) return 0.0f;
+
+        std::string_view unit(result.ptr, value.data() + value.size() - result.ptr);
+        if (unit.find("mph") != std::string_view::npos) speed *= 1.609f;
+        else if (unit.find("knots") != std::string_view::npos) speed *= 1.852f;
+        return speed;
+    }
+
+    int ParseDirection(const WayTags& tags) {
+        const std::string& oneway = tags.oneway;
+        if (oneway == "yes" || oneway == "true" || oneway == "1") return 1;
+        if (oneway == "-1" || oneway == "reverse") return -1;
+        if (oneway == "no" || oneway == "false" || oneway == "0") return 0;
+
+        // Implied one-way roads
+        if (tags.highway == "motorway") return 1;
+        if (tags.junction == "roundabout" || tags.junction == "circular") return 1;
+        return 0;
+    }
+
+    // Sorts the IDs and keeps at most two copies of each, which is all the use count needs
+    void CompactNodeIds(std::vector<int64_t>& ids) {
+        std::sort(ids.begin(), ids.end());
+        size_t kept = 0;
+        for (int64_t id : ids) {
+            if (kept >= 2 && ids[kept - 2] == id) continue;
+            ids[kept++] = id;
+        }
+        ids.resize(kept);
+    }
+
+    void AddNodeReference(ImportState& state, int64_t id) {
+        std::vector<int64_t>& ids = state.nodeIds;
+        if (ids.size() == ids.capacity() && ids.size() >= (1 << 20)) {
+            // Compact instead of growing while most of the buffer is duplicates
+            CompactNodeIds(ids);
+            if (ids.size() > ids.capacity() / 2) ids.reserve(ids.capacity() * 2);
+        }
+        ids.push_back(id);
+    }
+
+    // Turns the collected references into unique IDs with their use counts
+    void FinishNodeIds(ImportState& state) {
+        std::vector<int64_t>& ids = state.nodeIds;
+        CompactNodeIds(ids);
+        size_t unique = 0;
+        for (int64_t id : ids) {
+            if (unique > 0 && ids[unique - 1] == id) {
+                state.useCounts[unique - 1] = 2;
+                continue;
+            }
+            ids[unique++] = id;
+            state.useCounts.push_back(1);
+        }
+        ids.resize(unique);
+        ids.shrink_to_fit();
+        state.useCounts.shrink_to_fit();
+        state.coordinates.assign(unique, { NoCoordinate, 0 });
+    }
+
+    // Index into ImportState::nodeIds, or -1 if the node is not referenced by a road
+    ptrdiff_t FindNode(const ImportState& state, int64_t id) {
+        auto it = std::lower_bound(state.nodeIds.begin(), state.nodeIds.end(), id);
+        if (it == state.nodeIds.end() || *it != id) return -1;
+        return it - state.nodeIds.begin();
+    }
+
+    glm::vec3 Project(const ImportState& state, const OsmCoordinates& node) {
+        return glm::vec3(
+            (float)((node.lon * 1e-7 - state.lon0) * state.scaleX),
+            0.0f,
+            (float)(-(node.lat * 1e-7 - state.lat0) * state.scaleZ));  // North points towards -Z
+    }
+
+    // Graph nodes are intersections and way endpoints; shape points only add length
+    void AddWayEdges(ImportState& state, const std::vector<int64_t>& wayRefs, int direction, float speed) {
+        // Weight = travel time scaled to distance units at the network's top speed,
+        // so the Euclidean A* heuristic stays admissible
+        float weightScale = state.maxSpeed / speed;
+
+        int previousId = -1;
+        float length = 0.0f;
+        glm::vec3 previousPos(0.0f);
+
+        for (size_t i = 0; i < wayRefs.size(); i++) {
+            ptrdiff_t index = FindNode(state, wayRefs[i]);
+            if (index == -1 || state.coordinates[index].lat == NoCoordinate) {
+                previousId = -1;  // Node outside the extract: split the way here
+                continue;
+            }
+
+            glm::vec3 pos = Project(state, state.coordinates[index]);
+            if (previousId != -1) length += glm::length(pos - previousPos);
+            previousPos = pos;
+
+            bool isGraphNode = previousId == -1 || state.useCounts[index] >= 2 || i + 1 == wayRefs.size();
+            if (!isGraphNode) continue;
+
+            int& id = state.graphIds[index];
+            if (id == -1) {
+                id = (int)state.positions.size();
+                state.positions.push_back(pos);
+            }
+            if (previousId != -1 && id != previousId && length > 0.0f) {
+                float weight = length * weightScale;
+                if (direction >= 0) state.edges.push_back({ previousId, id, weight });
+                if (direction <= 0) state.edges.push_back({ id, previousId, weight });
+            }
+            previousId = id;
+            length = 0.0f;
+        }
+    }
+
+    void AddWay(ImportState& state, const std::vector<int64_t>& wayRefs, const WayTags& tags) {
+        if (wayRefs.size() < 2) return;
+
+        float speed = DefaultSpeed(tags.highway, state.options.includeServiceRoads);
+        if (speed <= 0.0f) return;
+
+        float tagged = ParseMaxSpeed(tags.maxspeed);
+        if (tagged > 0.0f) speed = tagged;
+
+        if (state.emitEdges) {
+            AddWayEdges(state, wayRefs, ParseDirection(tags), speed);
+            return;
+        }
+
+        state.wayCount++;
+        state.maxSpeed = std::max(state.maxSpeed, speed);
+        for (int64_t ref : wayRefs) {
+            AddNodeReference(state, ref);
+        }
+        // Endpoints always become graph nodes
+        AddNodeReference(state, wayRefs.front());
+        AddNodeReference(state, wayRefs.back());
+    }
+
+    void SetNodeCoordinates(ImportState& state, int64_t id, int32_t lat, int32_t lon) {
+        ptrdiff_t index = FindNode(state, id);
+        if (index == -1 || state.coordinates[index].lat != NoCoordinate) return;
+        state.coordinates[index] = { lat, lon };
+        state.resolvedNodes++;
+    }
+
+    // ---- XML -----------------------------------------------------------------
+
+    // Pull parser for the flat element structure of .osm files.
+    // Reads the file in fixed-size chunks; only the current element is kept in memory.
+    class XmlReader {
+    public:
+        struct Attribute {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        explicit XmlReader(FILE* file) : m_File(file), m_Buffer(1 << 20) {}
+
+        // Returns false at end of input. Views stay valid until the next call.
+        bool Next(std::string_view& name, std::vector<Attribute>& attributes, bool& isClosing, bool& isSelfClosing) {
+            while (true) {
+                const char* begin = m_Buffer.data() + m_Begin;
+                const char* open = (const char*)std::memchr(begin, '<', m_End - m_Begin);
+                if (!open) {
+                    m_Begin = m_End;
+                    if (!Fill()) return false;
+                    continue;
+                }
+                m_Begin = open - m_Buffer.data();
+
+                size_t end = FindElementEnd();
+                if (end == std::string_view::npos) {
+                    if (!Fill()) return false;
+                    continue;
+                }
+
+                const char* p = m_Buffer.data() + m_Begin;
+                const char* last = m_Buffer.data() + end;  // Points at '>'
+                m_Begin = end + 1;
+
+                if (p[1] == '?' || p[1] == '!') continue;  // Declarations and comments
+
+                isClosing = p[1] == '/';
+                isSelfClosing = last[-1] == '/';
+                p += isClosing ? 2 : 1;
+
+                const char* nameStart = p;
+                while (p < last && !IsSpace(*p) && *p != '/') p++;
+                name = std::string_view(nameStart, p - nameStart);
+
+                attributes.clear();
+                while (true) {
+                    while (p < last && IsSpace(*p)) p++;
+                    if (p >= last || *p == '/') break;
+
+                    const char* keyStart = p;
+                    while (p < last && *p != '=' && !IsSpace(*p)) p++;
+                    std::string_view key(keyStart, p - keyStart);
+                    while (p < last && *p != '"' && *p != '\'') p++;
+                    if (p >= last) break;
+
+                    char quote = *p++;
+                    const char* valueStart = p;
+                    while (p < last && *p != quote) p++;
+                    attributes.push_back({ key, std::string_view(valueStart, p - valueStart) });
+                    if (p < last) p++;
+                }
+                return true;
+            }
+        }
+
+    private:
+        static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+        // Index of the '>' closing the element at m_Begin, or npos if it is not buffered yet
+        size_t FindElementEnd() const {
+            const char* data = m_Buffer.data();
+            if (m_End - m_Begin >= 4 && std::memcmp(data + m_Begin, "<!--", 4) == 0) {
+                for (size_t i = m_Begin + 4; i + 2 < m_End; i++) {
+                    if (data[i] == '-' && data[i + 1] == '-' && data[i + 2] == '>') return i + 2;
+                }
+                return std::string_view::npos;
+            }
+
+            char quote = 0;
+            for (size_t i = m_Begin + 1; i < m_End; i++) {
+                char c = data[i];
+                if (quote) {
+                    if (c == quote) quote = 0;
+                } else if (c == '"' || c == '\'') {
+                    quote = c;
+                } else if (c == '>') {
+                    return i;
+                }
+            }
+            return std::string_view::npos;
+        }
+
+        // Moves unread bytes to the front and reads the next chunk
+        bool Fill() {
+            if (m_Begin > 0) {
+                std::memmove(m_Buffer.data(), m_Buffer.data() + m_Begin, m_End - m_Begin);
+                m_End -= m_Begin;
+                m_Begin = 0;
+            }
+            if (m_End == m_Buffer.size()) {
+                m_Buffer.resize(m_Buffer.size() * 2);  // Single element larger than the buffer
+            }
+            size_t read = std::fread(m_Buffer.data() + m_End, 1, m_Buffer.size() - m_End, m_File);
+            m_End += read;
+            return read > 0;
+        }
+
+        FILE* m_File;
+        std::vector<char> m_Buffer;
+        size_t m_Begin = 0;
+        size_t m_End = 0;
+    };
+
+    std::string_view FindAttribute(const std::vector<XmlReader::Attribute>& attributes, std::string_view name) {
+        for (const auto& attribute : attributes) {
+            if (attribute.name == name) return attribute.value;
+        }
+        return {};
+    }
+
+    int64_t ParseId(std::string_view value) {
+        int64_t id = 0;
+        std::from_chars(value.data(), value.data() + value.size(), id);
+        return id;
+    }
+
+    // Decimal degrees -> fixed point 1e-7 degrees, without going through floating point
+    int32_t ParseFixed7(std::string_view value) {
+        const char* p = value.data();
+        const char* end = p + value.size();
+        bool negative = p < end && *p == '-';
+        if (negative) p++;
+
+        int64_t result = 0;
+        while (p < end && *p >= '0' && *p <= '9') result = result * 10 + (*p++ - '0');
+
+        int digits = 0;
+        if (p < end && *p == '.') {
+            p++;
+            while (p < end && *p >= '0' && *p <= '9' && digits < 7) {
+                result = result * 10 + (*p++ - '0');
+                digits++;
+            }
+        }
+        while (digits++ < 7) result *= 10;
+        return (int32_t)(negative ? -result : result);
+    }
+
+    bool ReadXml(FILE* file, ImportState& state, bool readWays) {
+        XmlReader reader(file);
+        std::string_view name;
+        std::vector<XmlReader::Attribute> attributes;
+        bool isClosing = false, isSelfClosing = false;
+
+        bool inWay = false;
+        std::vector<int64_t> wayRefs;
+        WayTags tags;
+
+        while (reader.Next(name, attributes, isClosing, isSelfClosing)) {
+            if (readWays) {
+                if (name == "way") {
+                    if (!isClosing) {
+                        inWay = true;
+                        wayRefs.clear();
+                        tags.Clear();
+                    }
+                    if (isClosing || isSelfClosing) {
+                        if (inWay) AddWay(state, wayRefs, tags);
+                        inWay = false;
+                    }
+                } else if (inWay && name == "nd") {
+                    wayRefs.push_back(ParseId(FindAttribute(attributes, "ref")));
+                } else if (inWay && name == "tag") {
+                    tags.Set(FindAttribute(attributes, "k"), FindAttribute(attributes, "v"));
+                }
+            } else {
+                if (name == "node" && !isClosing) {
+                    int64_t id = ParseId(FindAttribute(attributes, "id"));
+                    SetNodeCoordinates(state, id,
+                        ParseFixed7(FindAttribute(attributes, "lat")),
+                        ParseFixed7(FindAttribute(attributes, "lon")));
+                } else if (name == "way" && state.resolvedNodes == state.nodeIds.size()) {
+                    break;  // Sorted extract: all nodes we need come before the ways
+                }
+            }
+        }
+        return true;
+    }
+
+    // ---- PBF -----------------------------------------------------------------
+
+    // Reader for the protobuf wire format
+    struct ProtoReader {
+        const uint8_t* p = nullptr;
+        const uint8_t* end = nullptr;
+
+        bool Next(uint32_t& field, uint32_t& wireType) {
+            if (p >= end) return false;
+            uint64_t key = Varint();
+            field = (uint32_t)(key >> 3);
+            wireType = (uint32_t)(key & 7);
+            return true;
+        }
+
+        uint64_t Varint() {
+            uint64_t value = 0;
+            for (int shift = 0; p < end && shift < 64; shift += 7) {
+                uint8_t byte = *p++;
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+            p = end;  // Truncated
+            return value;
+        }
+
+        int64_t SignedVarint() {
+            uint64_t value = Varint();
+            return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+        }
+
+        ProtoReader Bytes() {
+            uint64_t length = Varint();
+            ProtoReader sub;
+            sub.p = p;
+            sub.end = (length <= (uint64_t)(end - p)) ? p + length : end;
+            p = sub.end;
+            return sub;
+        }
+
+        std::string_view String() {
+            ProtoReader sub = Bytes();
+            return std::string_view((const char*)sub.p, sub.end - sub.p);
+        }
+
+        void Skip(uint32_t wireType) {
+            switch (wireType) {
+                case 0: Varint(); break;
+                case 1: p = std::min(p + 8, end); break;
+                case 2: Bytes(); break;
+                case 5: p = std::min(p + 4, end); break;
+                default: p = end; break;
+            }
+        }
+    };
+
+    struct BlockInfo {
+        std::vector<std::string_view> strings;
+        int64_t granularity = 100;
+        int64_t latOffset = 0;
+        int64_t lonOffset = 0;
+
+        // Raw coordinate -> 1e-7 degrees
+        int32_t Lat(int64_t raw) const { return (int32_t)((latOffset + granularity * raw) / 100); }
+        int32_t Lon(int64_t raw) const { return (int32_t)((lonOffset + granularity * raw) / 100); }
+    };
+
+    void ReadPbfWay(ProtoReader way, const BlockInfo& block, ImportState& state, std::vector<int64_t>& wayRefs, WayTags& tags) {
+        ProtoReader keys, values, refs;
+        uint32_t field, wireType;
+        while (way.Next(field, wireType)) {
+            if (field == 2 && wireType == 2) keys = way.Bytes();
+            else if (field == 3 && wireType == 2) values = way.Bytes();
+            else if (field == 8 && wireType == 2) refs = way.Bytes();
+            else way.Skip(wireType);
+        }
+
+        tags.Clear();
+        while (keys.p < keys.end && values.p < values.end) {
+            uint64_t k = keys.Varint();
+            uint64_t v = values.Varint();
+            if (k < block.strings.size() && v < block.strings.size()) {
+                tags.Set(block.strings[k], block.strings[v]);
+            }
+        }
+        if (tags.highway.empty()) return;
+
+        wayRefs.clear();
+        int64_t ref = 0;
+        while (refs.p < refs.end) {
+            ref += refs.SignedVarint();
+            wayRefs.push_back(ref);
+        }
+        AddWay(state, wayRefs, tags);
+    }
+
+    void ReadPbfDenseNodes(ProtoReader dense, const BlockInfo& block, ImportState& state) {
+        ProtoReader ids, lats, lons;
+        uint32_t field, wireType;
+        while (dense.Next(field, wireType)) {
+            if (field == 1 && wireType == 2) ids = dense.Bytes();
+            else if (field == 8 && wireType == 2) lats = dense.Bytes();
+            else if (field == 9 && wireType == 2) lons = dense.Bytes();
+            else dense.Skip(wireType);
+        }
+
+        int64_t id = 0, lat = 0, lon = 0;
+        while (ids.p < ids.end && lats.p < lats.end && lons.p < lons.end) {
+            id += ids.SignedVarint();
+            lat += lats.SignedVarint();
+            lon += lons.SignedVarint();
+            SetNodeCoordinates(state, id, block.Lat(lat), block.Lon(lon));
+        }
+    }
+
+    void ReadPbfNode(ProtoReader node, const BlockInfo& block, ImportState& state) {
+        int64_t id = 0, lat = 0, lon = 0;
+        uint32_t field, wireType;
+        while (node.Next(field, wireType)) {
+            if (field == 1 && wireType == 0) id = node.SignedVarint();
+            else if (field == 8 && wireType == 0) lat = node.SignedVarint();
+            else if (field == 9 && wireType == 0) lon = node.SignedVarint();
+            else node.Skip(wireType);
+        }
+        SetNodeCoordinates(state, id, block.Lat(lat), block.Lon(lon));
+    }
+
+    void ReadPrimitiveBlock(ProtoReader reader, ImportState& state, bool readWays) {
+        BlockInfo block;
+        std::vector<ProtoReader> groups;
+
+        // Groups are encoded before granularity/offsets, so collect them first
+        uint32_t field, wireType;
+        while (reader.Next(field, wireType)) {
+            if (field == 1 && wireType == 2) {
+                ProtoReader table = reader.Bytes();
+                while (table.Next(field, wireType)) {
+                    if (field == 1 && wireType == 2) block.strings.push_back(table.String());
+                    else table.Skip(wireType);
+                }
+            } else if (field == 2 && wireType == 2) {
+                groups.push_back(reader.Bytes());
+            } else if (field == 17 && wireType == 0) {
+                block.granularity = (int64_t)reader.Varint();
+            } else if (field == 19 && wireType == 0) {
+                block.latOffset = (int64_t)reader.Varint();
+            } else if (field == 20 && wireType == 0) {
+                block.lonOffset = (int64_t)reader.Varint();
+            } else {
+                reader.Skip(wireType);
+            }
+        }
+
+        std::vector<int64_t> wayRefs;
+        WayTags tags;
+        for (ProtoReader group : groups) {
+            while (group.Next(field, wireType)) {
+                if (wireType != 2) {
+                    group.Skip(wireType);
+                    continue;
+                }
+                ProtoReader message = group.Bytes();
+                if (readWays && field == 3) ReadPbfWay(message, block, state, wayRefs, tags);
+                else if (!readWays && field == 2) ReadPbfDenseNodes(message, block, state);
+                else if (!readWays && field == 1) ReadPbfNode(message, block, state);
+            }
+        }
+    }
+
+    bool ReadExact(FILE* file, std::vector<uint8_t>& buffer, size_t size) {
+        buffer.resize(size);
+        return size == 0 || std::fread(buffer.data(), 1, size, file) == size;
+    }
+
+    bool ReadPbf(FILE* file, ImportState& state, bool readWays) {
+        std::vector<uint8_t> header, blob, inflated;
+
+        while (true) {
+            uint8_t lengthBytes[4];
+            if (std::fread(lengthBytes, 1, 4, file) != 4) break;  // End of file
+            uint32_t headerLength = ((uint32_t)lengthBytes[0] << 24) | ((uint32_t)lengthBytes[1] << 16) |
+                                    ((uint32_t)lengthBytes[2] << 8) | lengthBytes[3];
+            if (headerLength > 64 * 1024 || !ReadExact(file, header, headerLength)) {
+                std::cerr << "OSM PBF: corrupt blob header" << std::endl;
+                return false;
+            }
+
+            std::string_view type;
+            uint64_t dataSize = 0;
+            ProtoReader reader{ header.data(), header.data() + header.size() };
+            uint32_t field, wireType;
+            while (reader.Next(field, wireType)) {
+                if (field == 1 && wireType == 2) type = reader.String();
+                else if (field == 3 && wireType == 0) dataSize = reader.Varint();
+                else reader.Skip(wireType);
+            }
+            std::string blobType(type);
+
+            if (dataSize > 64 * 1024 * 1024 || !ReadExact(file, blob, (size_t)dataSize)) {
+                std::cerr << "OSM PBF: corrupt blob" << std::endl;
+                return false;
+            }
+            if (blobType != "OSMData") continue;  // OSMHeader carries nothing we need
+
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            uint64_t rawSize = 0;
+            reader = ProtoReader{ blob.data(), blob.data() + blob.size() };
+            while (reader.Next(field, wireType)) {
+                if (field == 1 && wireType == 2) {
+                    ProtoReader raw = reader.Bytes();
+                    data = raw.p;
+                    size = raw.end - raw.p;
+                } else if (field == 2 && wireType == 0) {
+                    rawSize = reader.Varint();
+                } else if (field == 3 && wireType == 2) {
+                    ProtoReader compressed = reader.Bytes();
+                    inflated.clear();
+                    if (!Compression::ZlibDecompress(compressed.p, compressed.end - compressed.p, inflated, (size_t)rawSize)) {
+                        std::cerr << "OSM PBF: failed to decompress block" << std::endl;
+                        return false;
+                    }
+                    data = inflated.data();
+                    size = inflated.size();
+                } else if (wireType == 2 && field >= 4) {
+                    std::cerr << "OSM PBF: unsupported block compression (only raw and zlib are supported)" << std::endl;
+                    return false;
+                } else {
+                    reader.Skip(wireType);
+                }
+            }
+
+            if (data) {
+                ReadPrimitiveBlock(ProtoReader{ data, data + size }, state, readWays);
+            }
+        }
+        return true;
+    }
+
+    // ---- Graph construction ----------------------------------------------------
+
+    // Keeps only the largest strongly connected component, so every spawn can be routed.
+    // Returns old node index -> new node index (-1 = dropped).
+    std::vector<int> LargestStronglyConnectedComponent(int nodeCount, const std::vector<EdgeDescription>& edges) {
+        // Forward and reverse CSR adjacency
+        std::vector<int> fwdStart(nodeCount + 1, 0), revStart(nodeCount + 1, 0);
+        for (const auto& e : edges) {
+            fwdStart[e.from + 1]++;
+            revStart[e.to + 1]++;
+        }
+        for (int i = 0; i < nodeCount; i++) {
+            fwdStart[i + 1] += fwdStart[i];
+            revStart[i + 1] += revStart[i];
+        }
+        std::vector<int> fwd(edges.size()), rev(edges.size());
+        {
+            std::vector<int> fwdFill(fwdStart.begin(), fwdStart.end() - 1);
+            std::vector<int> revFill(revStart.begin(), revStart.end() - 1);
+            for (const auto& e : edges) {
+                fwd[fwdFill[e.from]++] = e.to;
+                rev[revFill[e.to]++] = e.from;
+            }
+        }
+
+        // Kosaraju pass 1: iterative DFS for finish order
+        std::vector<int> order;
+        order.reserve(nodeCount);
+        std::vector<char> visited(nodeCount, 0);
+        std::vector<std::pair<int, int>> stack;
+        for (int root = 0; root < nodeCount; root++) {
+            if (visited[root]) continue;
+            visited[root] = 1;
+            stack.push_back({ root, fwdStart[root] });
+            while (!stack.empty()) {
+                auto& [node, next] = stack.back();
+                if (next < fwdStart[node + 1]) {
+                    int to = fwd[next++];
+                    if (!visited[to]) {
+                        visited[to] = 1;
+                        stack.push_back({ to, fwdStart[to] });
+                    }
+                } else {
+                    order.push_back(node);
+                    stack.pop_back();
+                }
+            }
+        }
+
+        // Pass 2: components on the reverse graph in reverse finish order
+        std::vector<int> component(nodeCount, -1);
+        std::vector<int> componentSize;
+        std::vector<int> work;
+        for (int i = nodeCount - 1; i >= 0; i--) {
+            int root = order[i];
+            if (component[root] != -1) continue;
+            int id = (int)componentSize.size();
+            componentSize.push_back(0);
+            component[root] = id;
+            work.push_back(root);
+            while (!work.empty()) {
+                int node = work.back();
+                work.pop_back();
+                componentSize[id]++;
+                for (int j = revStart[node]; j < revStart[node + 1]; j++) {
+                    if (component[rev[j]] == -1) {
+                        component[rev[j]] = id;
+                        work.push_back(rev[j]);
+                    }
+                }
+            }
+        }
+
+        int largest = (int)(std::max_element(componentSize.begin(), componentSize.end()) - componentSize.begin());
+        std::vector<int> remap(nodeCount, -1);
+        int next = 0;
+        for (int i = 0; i < nodeCount; i++) {
+            if (component[i] == largest) remap[i] = next++;
+        }
+        return remap;
+    }
+
+    // Sets up the projection once the node pass has resolved the coordinates
+    bool PrepareProjection(ImportState& state) {
+        // Project around the centre of the referenced area (equirectangular is
+        // accurate to well under a percent at city scale)
+        int64_t minLat = INT64_MAX, maxLat = INT64_MIN, minLon = INT64_MAX, maxLon = INT64_MIN;
+        for (const auto& node : state.coordinates) {
+            if (node.lat == NoCoordinate) continue;
+            minLat = std::min<int64_t>(minLat, node.lat);
+            maxLat = std::max<int64_t>(maxLat, node.lat);
+            minLon = std::min<int64_t>(minLon, node.lon);
+            maxLon = std::max<int64_t>(maxLon, node.lon);
+        }
+        if (minLat > maxLat) {
+            std::cerr << "OSM import: no road nodes with coordinates found" << std::endl;
+            return false;
+        }
+
+        const double degToRad = 3.14159265358979323846 / 180.0;
+        const double earthRadius = 6371008.8;
+        state.lat0 = (minLat + maxLat) * 0.5e-7;
+        state.lon0 = (minLon + maxLon) * 0.5e-7;
+        state.scaleZ = earthRadius * degToRad * state.options.unitsPerMeter;
+        state.scaleX = state.scaleZ * std::cos(state.lat0 * degToRad);
+        state.graphIds.assign(state.nodeIds.size(), -1);
+        return true;
+    }
+
+    void BuildGraph(ImportState& state, Graph& graph) {
+        // The OSM-side data is no longer needed; release it before building the graph
+        std::vector<int64_t>().swap(state.nodeIds);
+        std::vector<uint8_t>().swap(state.useCounts);
+        std::vector<OsmCoordinates>().swap(state.coordinates);
+        std::vector<int>().swap(state.graphIds);
+
+        std::vector<glm::vec3>& positions = state.positions;
+        std::vector<EdgeDescription>& edges = state.edges;
+
+        std::vector<int> remap = LargestStronglyConnectedComponent((int)positions.size(), edges);
+        std::vector<glm::vec3> keptPositions;
+        glm::vec3 keptMin(std::numeric_limits<float>::max()), keptMax(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < positions.size(); i++) {
+            if (remap[i] == -1) continue;
+            keptPositions.push_back(positions[i]);
+            keptMin = glm::min(keptMin, positions[i]);
+            keptMax = glm::max(keptMax, positions[i]);
+        }
+        // Centre the kept network on the origin (dropped fragments may have skewed the bbox)
+        glm::vec3 centre = (keptMin + keptMax) * 0.5f;
+        for (auto& position : keptPositions) {
+            position -= glm::vec3(centre.x, 0.0f, centre.z);
+        }
+        size_t keptEdges = 0;
+        for (const auto& e : edges) {
+            if (remap[e.from] != -1 && remap[e.to] != -1) {
+                edges[keptEdges++] = { remap[e.from], remap[e.to], e.weight };
+            }
+        }
+        edges.resize(keptEdges);
+
+        std::cout << "OSM import: " << state.wayCount << " roads, kept " << keptPositions.size() << " of "
+                  << positions.size() << " intersections (largest connected component)" << std::endl;
+
+        std::vector<glm::vec3>().swap(positions);
+        graph.Build(keptPositions, edges);
+    }
+
+    bool EndsWith(const std::string& value, const char* suffix) {
+        size_t length = std::strlen(suffix);
+        return value.size() >= length && value.compare(value.size() - length, length, suffix) == 0;
+    }
+
+}
+
+bool OsmImporter::Import(const std::string& path, Graph& graph, const Options& options) {
+    auto startTime = std::chrono::steady_clock::now();
+    bool isPbf = EndsWith(path, ".pbf");
+
+    ImportState state;
+    state.options = options;
+
+    // Pass 0 collects the nodes of road ways, pass 1 their coordinates and
+    // pass 2 reads the ways again to emit the edges
+    for (int pass = 0; pass < 3; pass++) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            std::cerr << "Failed to open OSM file: " << path << std::endl;
+            return false;
+        }
+
+        bool readWays = pass != 1;
+        state.emitEdges = pass == 2;
+        bool ok = isPbf ? ReadPbf(file, state, readWays) : ReadXml(file, state, readWays);
+        std::fclose(file);
+        if (!ok) return false;
+
+        if (pass == 0) {
+            if (state.wayCount == 0) {
+                std::cerr << "OSM import: no drivable roads in " << path << std::endl;
+                return false;
+            }
+            FinishNodeIds(state);
+        } else if (pass == 1 && !PrepareProjection(state)) {
+            return false;
+        }
+    }
+
+    BuildGraph(state, graph);
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Imported " << path << " in " << seconds << "s" << std::endl;
+    return true;
+}
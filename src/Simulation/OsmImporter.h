@@ -0,0 +1,21 @@
+#pragma once
+#include "Graph.h"
+#include <string>
+
+// Imports the drivable road network from an OpenStreetMap extract.
+// Supports .osm (XML) and .osm.pbf files. The file is streamed three times:
+// the first pass keeps only the node IDs of highway ways, the second only the
+// coordinates of those nodes, and the third walks the ways again to sum each
+// segment's length. Way node lists are never stored, so peak memory is about
+// 21 bytes per referenced node plus the graph being built.
+class OsmImporter {
+public:
+    struct Options {
+        float unitsPerMeter = 1.0f;     // Scale of the projected sim plane
+        bool includeServiceRoads = true;
+    };
+
+    // Builds the network into an empty graph. Returns false on I/O or format errors.
+    static bool Import(const std::string& path, Graph& graph, const Options& options);
+    static bool Import(const std::string& path, Graph& graph) { return Import(path, graph, Options()); }
+};
@@ -1,5 +1,6 @@
 #include "Pathfinding.h"
-#include <iostream>
+#include "../Core/Log.h"
+#include "../Core/Profiler.h"
 
 float Pathfinding::Heuristic(const glm::vec3& a, const glm::vec3& b) {
     return glm::length(b - a);  // Euclidean distance
@@ -10,6 +11,8 @@ std::vector<int> Pathfinding::AStar(
     int startId,
     int goalId
 ) {
+    TS_PROFILE_SCOPE(ProfilePhase::Routing);
+    
     // Priority queue (min-heap) - stores nodes to explore
     std::priority_queue<AStarNode, std::vector<AStarNode>, std::greater<AStarNode>> openSet;
     
@@ -22,16 +25,14 @@ std::vector<int> Pathfinding::AStar(
     // Track parent nodes for path reconstruction
     std::unordered_map<int, int> cameFrom;
     
-    auto startNode = graph->GetNode(startId);
-    auto goalNode = graph->GetNode(goalId);
-    
-    if (!startNode || !goalNode) {
-        std::cerr << "Invalid start or goal node" << std::endl;
+    if (!graph->HasNode(startId) || !graph->HasNode(goalId)) {
+        TS_LOG_WARNING(Routing, "Invalid start or goal node (%d -> %d)", startId, goalId);
         return {};
     }
     
     // Initialize start node
-    float hCost = Heuristic(startNode->position, goalNode->position);
+    const glm::vec3& goalPosition = graph->GetPosition(goalId);
+    float hCost = Heuristic(graph->GetPosition(startId), goalPosition);
     openSet.push(AStarNode(startId, 0.0f, hCost, -1));
     gCosts[startId] = 0.0f;
     
@@ -63,9 +64,8 @@ std::vector<int> Pathfinding::AStar(
         }
         
         // Explore neighbors
-        auto currentNode = graph->GetNode(current.nodeId);
-        for (const auto& edge : currentNode->edges) {
-            int neighborId = edge->to->id;
+        for (int edgeId : graph->GetOutgoingEdges(current.nodeId)) {
+            int neighborId = graph->GetEdgeTarget(edgeId);
             
             // Skip if already processed
             if (closedSet.count(neighborId)) {
@@ -73,7 +73,7 @@ std::vector<int> Pathfinding::AStar(
             }
             
             // Calculate tentative gCost
-            float tentativeGCost = current.gCost + edge->weight;
+            float tentativeGCost = current.gCost + graph->GetEdgeWeight(edgeId);
             
             // Check if this path to neighbor is better
             auto it = gCosts.find(neighborId);
@@ -82,13 +82,13 @@ std::vector<int> Pathfinding::AStar(
                 gCosts[neighborId] = tentativeGCost;
                 cameFrom[neighborId] = current.nodeId;
                 
-                float hCost = Heuristic(edge->to->position, goalNode->position);
+                float hCost = Heuristic(graph->GetPosition(neighborId), goalPosition);
                 openSet.push(AStarNode(neighborId, tentativeGCost, hCost, current.nodeId));
             }
         }
     }
     
     // No path found
-    std::cerr << "No path found from " << startId << " to " << goalId << std::endl;
+    TS_LOG_WARNING(Routing, "No path found from %d to %d", startId, goalId);
     return {};
 }
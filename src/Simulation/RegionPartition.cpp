@@ -0,0 +1,303 @@
+#include "RegionPartition.h"
+#include "TransportSimulation.h"
+#include "../Core/Profiler.h"
+#include <algorithm>
+#include <limits>
+#include <string>
+
+RegionPartition::RegionPartition(TransportSimulation& simulation, int threadCount)
+    : m_Simulation(simulation) {
+    BuildTiles(std::max(threadCount, 1));
+
+    // Tile 0 is simulated by the calling thread, every other tile gets a worker
+    int tileCount = (int)m_Tiles.size();
+    m_Barrier = std::make_unique<std::barrier<>>(tileCount);
+    for (int i = 1; i < tileCount; i++) {
+        m_Workers.emplace_back(&RegionPartition::WorkerLoop, this, i);
+    }
+}
+
+RegionPartition::~RegionPartition() {
+    if (!m_Workers.empty()) {
+        m_Stop = true;
+        m_Barrier->arrive_and_wait();
+        for (auto& worker : m_Workers) {
+            worker.join();
+        }
+    }
+}
+
+void RegionPartition::BuildTiles(int threadCount) {
+    // Pick the most square tile layout for the requested thread count
+    int tilesX = 1;
+    for (int i = 1; i * i <= threadCount; i++) {
+        if (threadCount % i == 0) tilesX = i;
+    }
+    int tilesZ = threadCount / tilesX;
+
+    auto graph = m_Simulation.GetGraph();
+    glm::vec3 minBounds(std::numeric_limits<float>::max());
+    glm::vec3 maxBounds(std::numeric_limits<float>::lowest());
+    int nodeCount = (int)graph->GetNodeCount();
+    for (int id = 0; id < nodeCount; id++) {
+        minBounds = glm::min(minBounds, graph->GetPosition(id));
+        maxBounds = glm::max(maxBounds, graph->GetPosition(id));
+    }
+    if (nodeCount == 0) {
+        minBounds = maxBounds = glm::vec3(0.0f);
+    }
+
+    float tileWidth = std::max((maxBounds.x - minBounds.x) / tilesX, 1e-3f);
+    float tileDepth = std::max((maxBounds.z - minBounds.z) / tilesZ, 1e-3f);
+
+    for (int tz = 0; tz < tilesZ; tz++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            auto tile = std::make_unique<Tile>();
+            tile->ghostsOut.resize(threadCount);
+            tile->outbox.resize(threadCount);
+            m_Tiles.push_back(std::move(tile));
+        }
+    }
+
+    // Assign every intersection to the tile it lies in
+    m_NodeTile.assign(nodeCount, 0);
+    for (int id = 0; id < nodeCount; id++) {
+        const glm::vec3& position = graph->GetPosition(id);
+        int tx = std::clamp((int)((position.x - minBounds.x) / tileWidth), 0, tilesX - 1);
+        int tz = std::clamp((int)((position.z - minBounds.z) / tileDepth), 0, tilesZ - 1);
+        int tileIndex = tz * tilesX + tx;
+        m_NodeTile[id] = tileIndex;
+        m_Tiles[tileIndex]->nodes.push_back(id);
+    }
+}
+
+void RegionPartition::Insert(Vehicle* vehicle) {
+    // Vehicles are created in ID order, so this is nearly always an append
+    auto& residents = m_Tiles[GetOwnerTile(*vehicle)]->residents;
+    residents.insert(std::upper_bound(residents.begin(), residents.end(), vehicle, IsLowerId), vehicle);
+}
+
+std::vector<IntersectionManager::Reservation> RegionPartition::GetReservations() const {
+    std::vector<IntersectionManager::Reservation> reservations;
+    for (const auto& tile : m_Tiles) {
+        tile->intersections.GetReservations(reservations);
+    }
+    return reservations;
+}
+
+void RegionPartition::RestoreReservation(const IntersectionManager::Reservation& reservation) {
+    m_Tiles[GetTileOfNode(reservation.nodeId)]->intersections.Restore(reservation);
+}
+
+void RegionPartition::Step(float deltaTime) {
+    m_DeltaTime = deltaTime;
+    if (m_Workers.empty()) {
+        RunTile(0);
+    } else {
+        m_Barrier->arrive_and_wait();  // Release the workers
+        RunTile(0);
+    }
+
+    // Every tile has passed the last barrier, so their counters are settled
+    for (auto& tile : m_Tiles) {
+        m_Simulation.m_Statistics.Merge(tile->statistics);
+        for (int nodeId : tile->changedSignals) {
+            m_Simulation.MarkSignalsChanged(nodeId);
+        }
+        tile->changedSignals.clear();
+    }
+}
+
+void RegionPartition::WorkerLoop(int tileIndex) {
+    TS_PROFILE_THREAD_NAME("Tile " + std::to_string(tileIndex));
+    while (true) {
+        m_Barrier->arrive_and_wait();  // Wait for the next Step
+        if (m_Stop) break;
+        RunTile(tileIndex);
+    }
+}
+
+void RegionPartition::RunTile(int tileIndex) {
+    TS_PROFILE_SCOPE_ARG(ProfilePhase::SimTile, tileIndex);
+    Tile& tile = *m_Tiles[tileIndex];
+    bool parallel = !m_Workers.empty();
+
+    UpdateSignalsAndMove(tile);
+    if (parallel) WaitForTiles(tileIndex);
+
+    PublishGhosts(tileIndex);
+    if (parallel) WaitForTiles(tileIndex);
+
+    ResolveAndMigrate(tileIndex);
+    if (parallel) WaitForTiles(tileIndex);
+
+    ReceiveMigrants(tileIndex);
+    if (parallel) WaitForTiles(tileIndex);
+}
+
+void RegionPartition::WaitForTiles([[maybe_unused]] int tileIndex) {
+    TS_PROFILE_SCOPE_ARG(ProfilePhase::SimBarrier, tileIndex);
+    m_Barrier->arrive_and_wait();
+}
+
+void RegionPartition::UpdateSignalsAndMove(Tile& tile) {
+    // Every vehicle approaching one of our intersections is a resident, so the
+    // signal sensors only need to look at local vehicles
+    if (m_Simulation.AreTrafficLightsEnabled()) {
+        TS_PROFILE_SCOPE(ProfilePhase::SimSignals);
+        tile.proxies.Clear();
+        for (Vehicle* vehicle : tile.residents) {
+            if (!vehicle->IsDestinationReached()) {
+                tile.proxies.Add(MakeProxy(*vehicle));
+            }
+        }
+        tile.proxies.Sort();
+
+        for (int nodeId : tile.nodes) {
+            if (m_Simulation.UpdateTrafficLight(nodeId, tile.proxies, m_DeltaTime)) {
+                tile.statistics.signalChanges++;
+                tile.changedSignals.push_back(nodeId);
+            }
+        }
+    }
+
+    TS_PROFILE_SCOPE(ProfilePhase::SimVehicleMove);
+    const Graph& graph = *m_Simulation.m_Graph;
+    const SignalTable& signals = m_Simulation.m_Signals;
+    TrafficStatistics& statistics = m_Simulation.m_Statistics;
+    for (Vehicle* vehicle : tile.residents) {
+        // Hierarchical routes are refined here, by the tile's own worker
+        if (!vehicle->IsPathComplete() && vehicle->GetNodesAhead() < RouteOverlay::RefineNodesAhead) {
+            m_Simulation.RefineRoute(*vehicle);
+        }
+        int edgeId = vehicle->GetCurrentEdgeId();
+        vehicle->Update(m_DeltaTime, graph, signals);
+        if (vehicle->GetCurrentEdgeId() != edgeId) {
+            statistics.OnEdgeChange(*vehicle, edgeId, tile.statistics);
+        }
+    }
+}
+
+void RegionPartition::PublishGhosts(int tileIndex) {
+    Tile& tile = *m_Tiles[tileIndex];
+    int tileCount = (int)m_Tiles.size();
+
+    for (auto& ghosts : tile.ghostsOut) {
+        ghosts.clear();
+    }
+
+    tile.proxies.Clear();
+    for (Vehicle* vehicle : tile.residents) {
+        if (vehicle->IsDestinationReached()) continue;
+
+        VehicleProxy proxy = MakeProxy(*vehicle);
+        tile.proxies.Add(proxy);
+
+        if (tileCount == 1) continue;
+
+        // Only the tile owning the start of our edge looks at us from outside:
+        // its vehicles queue onto the edge and check it for gridlock
+        int fromTile = proxy.fromNodeId >= 0 ? GetTileOfNode(proxy.fromNodeId) : tileIndex;
+        if (fromTile != tileIndex) {
+            tile.ghostsOut[fromTile].push_back(proxy);
+        }
+    }
+}
+
+void RegionPartition::ResolveAndMigrate(int tileIndex) {
+    TS_PROFILE_SCOPE(ProfilePhase::SimCollision);
+    Tile& tile = *m_Tiles[tileIndex];
+
+    // Neighbour set = residents + ghosts mirrored to us by the other tiles
+    for (int other = 0; other < (int)m_Tiles.size(); other++) {
+        if (other == tileIndex) continue;
+        tile.proxies.Add(m_Tiles[other]->ghostsOut[tileIndex]);
+    }
+    tile.proxies.Sort();
+
+    tile.intersections.Expire(m_Simulation.GetSimulationTime());
+    for (Vehicle* vehicle : tile.residents) {
+        // A vehicle that has just turned towards another tile's node is handed over
+        // below; only that tile books slots there
+        IntersectionManager* intersections = GetOwnerTile(*vehicle) == tileIndex ? &tile.intersections : nullptr;
+        m_Simulation.ResolveVehicle(*vehicle, tile.proxies, intersections, m_DeltaTime);
+        m_Simulation.m_Statistics.OnVehicleResolved(*vehicle, tile.statistics);
+    }
+
+    // Drop arrived vehicles (the simulation destroys them) and hand over the ones
+    // now driving towards an intersection owned by another tile
+    auto keepIt = std::remove_if(tile.residents.begin(), tile.residents.end(),
+        [&](Vehicle* vehicle) {
+            if (vehicle->IsDestinationReached()) return true;
+
+            int owner = GetOwnerTile(*vehicle);
+            if (owner != tileIndex) {
+                tile.outbox[owner].push_back(vehicle);
+                return true;
+            }
+            return false;
+        });
+    tile.residents.erase(keepIt, tile.residents.end());
+}
+
+void RegionPartition::ReceiveMigrants(int tileIndex) {
+    Tile& tile = *m_Tiles[tileIndex];
+    size_t settled = tile.residents.size();
+    for (int other = 0; other < (int)m_Tiles.size(); other++) {
+        if (other == tileIndex) continue;
+        auto& inbox = m_Tiles[other]->outbox[tileIndex];
+        tile.residents.insert(tile.residents.end(), inbox.begin(), inbox.end());
+        inbox.clear();
+    }
+
+    // Keep residents in ID order: intersection slots go to whoever asks first,
+    // and a restored checkpoint must ask in the same order
+    auto migrants = tile.residents.begin() + settled;
+    std::sort(migrants, tile.residents.end(), IsLowerId);
+    std::inplace_merge(tile.residents.begin(), migrants, tile.residents.end(), IsLowerId);
+}
+
+int RegionPartition::GetTileOfNode(int nodeId) const {
+    if (nodeId < 0 || nodeId >= (int)m_NodeTile.size()) return 0;
+    return m_NodeTile[nodeId];
+}
+
+int RegionPartition::GetOwnerTile(const Vehicle& vehicle) const {
+    int targetNodeId = vehicle.GetTargetNodeId();
+    return targetNodeId >= 0 ? GetTileOfNode(targetNodeId) : 0;
+}
+
+bool RegionPartition::IsLowerId(const Vehicle* a, const Vehicle* b) {
+    return a->GetId() < b->GetId();
+}
+
+VehicleProxy RegionPartition::MakeProxy(const Vehicle& vehicle) {
+    VehicleProxy proxy;
+    proxy.id = vehicle.GetId();
+    proxy.edgeId = vehicle.GetCurrentEdgeId();
+    proxy.offset = vehicle.GetOffset();
+    proxy.fromNodeId = vehicle.GetFromNodeId();
+    proxy.targetNodeId = vehicle.GetTargetNodeId();
+    proxy.lane = vehicle.GetLane();
+    return proxy;
+}
+
+void EdgeBuckets::Add(const std::vector<VehicleProxy>& proxies) {
+    m_Proxies.insert(m_Proxies.end(), proxies.begin(), proxies.end());
+}
+
+void EdgeBuckets::Sort() {
+    std::sort(m_Proxies.begin(), m_Proxies.end(), [](const VehicleProxy& a, const VehicleProxy& b) {
+        if (a.edgeId != b.edgeId) return a.edgeId < b.edgeId;
+        if (a.offset != b.offset) return a.offset < b.offset;
+        return a.id < b.id;
+    });
+}
+
+std::span<const VehicleProxy> EdgeBuckets::GetVehicles(int edgeId) const {
+    auto first = std::lower_bound(m_Proxies.begin(), m_Proxies.end(), edgeId,
+        [](const VehicleProxy& proxy, int id) { return proxy.edgeId < id; });
+    auto last = std::upper_bound(first, m_Proxies.end(), edgeId,
+        [](int id, const VehicleProxy& proxy) { return id < proxy.edgeId; });
+    return std::span<const VehicleProxy>(first, last);
+}
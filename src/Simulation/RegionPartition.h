@@ -0,0 +1,114 @@
+#pragma once
+#include "Graph.h"
+#include "IntersectionManager.h"
+#include "TrafficStatistics.h"
+#include "Vehicle.h"
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+class TransportSimulation;
+
+// Read-only copy of the vehicle state that neighbour lookups need.
+// Tiles query their own residents and ghosts from other tiles through this.
+struct VehicleProxy {
+    int32_t id;
+    int32_t edgeId;        // -1 if not on an edge
+    float offset;          // Distance driven along the edge
+    int32_t fromNodeId;    // Start node of the edge (-1 if none)
+    int32_t targetNodeId;  // Node the vehicle is driving towards (-1 if none)
+    uint8_t lane;
+};
+
+// Vehicle proxies grouped by edge, each edge's vehicles in driving order.
+// Rebuilt by every tile once per phase, so finding the vehicle ahead or
+// counting an edge's vehicles is a binary search, not a scan of the fleet.
+class EdgeBuckets {
+public:
+    void Clear() { m_Proxies.clear(); }
+    void Add(const VehicleProxy& proxy) { m_Proxies.push_back(proxy); }
+    void Add(const std::vector<VehicleProxy>& proxies);
+    // Groups the added proxies; call before any lookup
+    void Sort();
+
+    // Vehicles on an edge, by offset (ties by ID)
+    std::span<const VehicleProxy> GetVehicles(int edgeId) const;
+    int GetCount(int edgeId) const { return (int)GetVehicles(edgeId).size(); }
+    size_t GetSize() const { return m_Proxies.size(); }
+
+private:
+    std::vector<VehicleProxy> m_Proxies;
+};
+
+// Spatial decomposition of the simulation.
+// The network is split into a grid of tiles, each owned by one thread. A vehicle
+// belongs to the tile containing the node it is driving towards, so the signals
+// it reads and the vehicles it queues behind are all local to that thread.
+// A vehicle on a road that starts in another tile is published to that tile as
+// a read-only ghost (vehicles queueing onto the road and the gridlock check
+// there need it), and vehicles crossing into another tile are handed over
+// through per-tile mailboxes between phases.
+class RegionPartition {
+public:
+    RegionPartition(TransportSimulation& simulation, int threadCount);
+    ~RegionPartition();
+
+    RegionPartition(const RegionPartition&) = delete;
+    RegionPartition& operator=(const RegionPartition&) = delete;
+
+    // Runs signals, vehicle movement and collision avoidance for one tick,
+    // then merges the tiles' event counts and changed lights into the simulation
+    void Step(float deltaTime);
+
+    // Hands a newly spawned vehicle to the tile that owns it
+    void Insert(Vehicle* vehicle);
+
+    // Intersection slots of every tile, for checkpointing. Restoring hands each
+    // slot to the tile that owns its node, whatever the tile layout was.
+    std::vector<IntersectionManager::Reservation> GetReservations() const;
+    void RestoreReservation(const IntersectionManager::Reservation& reservation);
+
+    int GetTileCount() const { return (int)m_Tiles.size(); }
+    int GetThreadCount() const { return (int)m_Tiles.size(); }
+
+private:
+    struct Tile {
+        std::vector<int32_t> nodes;                 // Intersections owned by this tile
+        std::vector<Vehicle*> residents;            // Vehicles owned by this tile, in ID order
+        EdgeBuckets proxies;                        // Residents (plus ghosts when resolving), rebuilt each phase
+        std::vector<std::vector<VehicleProxy>> ghostsOut;  // Ghosts published to each tile
+        std::vector<std::vector<Vehicle*>> outbox;          // Vehicles migrating to each tile
+        TrafficStatistics::Counters statistics;             // Merged after every Step
+        std::vector<int32_t> changedSignals;                // Intersections whose lights changed, merged likewise
+        IntersectionManager intersections;                  // Slots at the unsignalised nodes we own
+    };
+
+    void BuildTiles(int threadCount);
+    void WorkerLoop(int tileIndex);
+    void RunTile(int tileIndex);
+    void WaitForTiles(int tileIndex);  // Barrier between phases, timed as a stall
+
+    // Phases executed by each tile, separated by barriers
+    void UpdateSignalsAndMove(Tile& tile);
+    void PublishGhosts(int tileIndex);
+    void ResolveAndMigrate(int tileIndex);
+    void ReceiveMigrants(int tileIndex);
+
+    int GetTileOfNode(int nodeId) const;
+    int GetOwnerTile(const Vehicle& vehicle) const;
+    static VehicleProxy MakeProxy(const Vehicle& vehicle);
+    static bool IsLowerId(const Vehicle* a, const Vehicle* b);
+
+    TransportSimulation& m_Simulation;
+    std::vector<std::unique_ptr<Tile>> m_Tiles;
+    std::vector<int> m_NodeTile;  // Node ID -> owning tile
+
+    std::vector<std::thread> m_Workers;
+    std::unique_ptr<std::barrier<>> m_Barrier;
+    std::atomic<bool> m_Stop = false;
+    float m_DeltaTime = 0.0f;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include "TrafficStatistics.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What the renderer and UI read from the simulation, copied out after a tick
+// so the main thread never touches live simulation state. Published by
+// SimulationThread and left untouched until it is recycled.
+struct RenderSnapshot {
+    static constexpr size_t EdgePageSize = 4096;  // Edges (or signal approaches) per version stamp
+
+    struct VehicleState {
+        glm::vec3 position;
+        glm::vec3 direction;
+    };
+
+    uint64_t version = 0;  // Publish count, 0 = never published
+    double simulationTime = 0.0;
+    float ticksPerSecond = 0.0f;  // Wall clock, over the last second
+
+    std::vector<VehicleState> vehicles;
+    // TrafficLightState per signal approach (SignalTable::lights, by edge ID),
+    // paged and stamped like edgeLoads below
+    std::vector<uint8_t> signalStates;
+    std::vector<uint64_t> signalPageVersions;
+
+    // Load per edge, 0 (empty) to 255 (full). Each page of EdgePageSize edges
+    // is stamped with the version in which it last changed, so a reader that
+    // has seen version v only needs the pages stamped after v.
+    std::vector<uint8_t> edgeLoads;
+    std::vector<uint64_t> edgePageVersions;
+
+    TrafficStatistics::Snapshot statistics;
+    std::vector<float> haltedSeries;  // Oldest first
+
+    // Settings as the simulation currently has them
+    bool trafficLightsEnabled = true;
+    int threadCount = 1;
+    bool recording = false;
+};
@@ -0,0 +1,288 @@
+#include "ReplayPlayer.h"
+#include "Vehicle.h"
+#include "../Core/Compression.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+    bool IsSortedById(const TrajectorySample* samples, uint32_t count) {
+        for (uint32_t i = 1; i < count; i++) {
+            if (samples[i].vehicleId <= samples[i - 1].vehicleId) return false;
+        }
+        return true;
+    }
+
+}
+
+bool ReplayPlayer::Open(const std::string& path) {
+    Close();
+
+    if (!m_File.Open(path)) {
+        std::cerr << "Failed to open trajectory file: " << path << std::endl;
+        return false;
+    }
+
+    const uint8_t* data = m_File.GetData();
+    size_t size = m_File.GetSize();
+    if (size >= sizeof(m_Header)) {
+        std::memcpy(&m_Header, data, sizeof(m_Header));
+    }
+    if (size < sizeof(m_Header) ||
+        std::memcmp(m_Header.magic, TrajectoryFormat::FileMagic, sizeof(m_Header.magic)) != 0 ||
+        m_Header.version != TrajectoryFormat::Version ||
+        m_Header.geometrySize > size - sizeof(m_Header)) {
+        std::cerr << "Not a supported trajectory file: " << path << std::endl;
+        Close();
+        return false;
+    }
+
+    std::vector<uint8_t> geometry;
+    size_t geometryBytes = (size_t)m_Header.edgeCount * 6 * sizeof(float);
+    if (!Compression::ZlibDecompress(data + sizeof(m_Header), m_Header.geometrySize, geometry, geometryBytes) ||
+        geometry.size() != geometryBytes) {
+        std::cerr << "Corrupt edge geometry in trajectory file: " << path << std::endl;
+        Close();
+        return false;
+    }
+
+    m_Edges.resize(m_Header.edgeCount);
+    for (size_t i = 0; i < m_Edges.size(); i++) {
+        glm::vec3 from, to;
+        std::memcpy(&from, geometry.data() + i * 6 * sizeof(float), sizeof(glm::vec3));
+        std::memcpy(&to, geometry.data() + (i * 6 + 3) * sizeof(float), sizeof(glm::vec3));
+
+        glm::vec3 along = to - from;
+        float length = glm::length(along);
+        glm::vec3 direction = length > 0.0f ? along / length : glm::vec3(0.0f);
+        glm::vec3 right = glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f));
+        float rightLength = glm::length(right);
+        right = rightLength > 0.01f ? right / rightLength : glm::vec3(0.0f);
+        m_Edges[i] = { from, direction, right };
+    }
+
+    if (!ReadIndex()) {
+        std::cerr << "No recorded frames in trajectory file: " << path << std::endl;
+        Close();
+        return false;
+    }
+
+    m_Time = GetStartTime();
+    m_Dirty = true;
+    std::cout << "Replaying " << path << ": " << m_Index.size() << " chunks, "
+              << GetStartTime() << "s - " << GetEndTime() << "s" << std::endl;
+    return true;
+}
+
+void ReplayPlayer::Close() {
+    m_File.Close();
+    m_Header = {};
+    m_Edges.clear();
+    m_Index.clear();
+    for (auto& chunk : m_Cache) {
+        chunk = Chunk();
+    }
+    m_Vehicles.clear();
+    m_Time = 0.0;
+    m_Dirty = true;
+}
+
+bool ReplayPlayer::ReadIndex() {
+    const uint8_t* data = m_File.GetData();
+    size_t size = m_File.GetSize();
+    size_t firstChunk = sizeof(m_Header) + m_Header.geometrySize;
+
+    if (size >= firstChunk + sizeof(TrajectoryIndexFooter)) {
+        TrajectoryIndexFooter footer;
+        std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+        size_t indexBytes = (size_t)footer.chunkCount * sizeof(TrajectoryIndexEntry);
+        if (std::memcmp(footer.magic, TrajectoryFormat::IndexMagic, sizeof(footer.magic)) == 0 &&
+            footer.indexOffset >= firstChunk &&
+            footer.indexOffset + indexBytes + sizeof(footer) == size) {
+            m_Index.resize(footer.chunkCount);
+            if (indexBytes > 0) {
+                std::memcpy(m_Index.data(), data + footer.indexOffset, indexBytes);
+            }
+            return !m_Index.empty();
+        }
+    }
+
+    // Interrupted recording: walk the chunk headers instead
+    size_t offset = firstChunk;
+    while (offset + sizeof(TrajectoryChunkHeader) <= size) {
+        TrajectoryChunkHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        size_t chunkSize = TrajectoryFormat::GetChunkSize(header);
+        if (chunkSize == 0 || chunkSize > size - offset) break;
+
+        m_Index.push_back({ header.startTime, header.endTime, offset });
+        offset += chunkSize;
+    }
+    if (!m_Index.empty()) {
+        std::cout << "Trajectory index missing (interrupted recording?), recovered " << m_Index.size() << " chunks" << std::endl;
+    }
+    return !m_Index.empty();
+}
+
+const ReplayPlayer::Chunk* ReplayPlayer::GetChunk(size_t index) {
+    Chunk* slot = &m_Cache[0];
+    for (auto& chunk : m_Cache) {
+        if (chunk.index == index) {
+            chunk.lastUse = ++m_UseCounter;
+            return &chunk;
+        }
+        if (chunk.lastUse < slot->lastUse) slot = &chunk;
+    }
+
+    uint64_t offset = m_Index[index].offset;
+    slot->index = SIZE_MAX;
+    if (offset >= m_File.GetSize() ||
+        !TrajectoryFormat::DecodeChunk(m_File.GetData() + offset, m_File.GetSize() - offset,
+                                       m_Header.offsetQuantum, m_Header.speedQuantum, slot->frames, slot->samples)) {
+        std::cerr << "Corrupt trajectory chunk " << index << std::endl;
+        return nullptr;
+    }
+    for (const auto& sample : slot->samples) {
+        if (sample.edgeId < 0 || sample.edgeId >= (int32_t)m_Edges.size()) {
+            std::cerr << "Trajectory chunk " << index << " references unknown edge " << sample.edgeId << std::endl;
+            return nullptr;
+        }
+    }
+
+    slot->frameStart.resize(slot->frames.size());
+    uint32_t start = 0;
+    for (size_t i = 0; i < slot->frames.size(); i++) {
+        slot->frameStart[i] = start;
+        start += slot->frames[i].sampleCount;
+    }
+
+    slot->index = index;
+    slot->lastUse = ++m_UseCounter;
+    return slot;
+}
+
+void ReplayPlayer::Update(float deltaTime) {
+    if (m_Playing && !m_Index.empty()) {
+        double time = m_Time + (double)deltaTime * m_Speed;
+        if (time >= GetEndTime() && m_Speed > 0.0f) {
+            time = GetEndTime();
+            m_Playing = false;
+        } else if (time <= GetStartTime() && m_Speed < 0.0f) {
+            time = GetStartTime();
+            m_Playing = false;
+        }
+        if (time != m_Time) {
+            m_Time = time;
+            m_Dirty = true;
+        }
+    }
+
+    if (m_Dirty) {
+        Evaluate();
+    }
+}
+
+void ReplayPlayer::Seek(double time) {
+    time = std::clamp(time, GetStartTime(), GetEndTime());
+    if (time != m_Time) {
+        m_Time = time;
+        m_Dirty = true;
+    }
+}
+
+glm::vec3 ReplayPlayer::GetPosition(const TrajectorySample& sample) const {
+    const EdgeGeometry& edge = m_Edges[sample.edgeId];
+    // Lane centre as in Vehicle::GetPosition
+    return edge.from + edge.direction * sample.offset + edge.right * ((sample.lane + 0.5f) * Vehicle::LaneWidth);
+}
+
+void ReplayPlayer::Evaluate() {
+    m_Dirty = false;
+    m_Vehicles.clear();
+    m_StoppedCount = 0;
+    if (m_Index.empty()) return;
+
+    // Last chunk, then last frame, starting at or before the playback time
+    auto chunkIt = std::upper_bound(m_Index.begin(), m_Index.end(), m_Time,
+        [](double time, const TrajectoryIndexEntry& entry) { return time < entry.startTime; });
+    size_t chunkIndex = chunkIt == m_Index.begin() ? 0 : (size_t)(chunkIt - m_Index.begin()) - 1;
+    const Chunk* chunk = GetChunk(chunkIndex);
+    if (!chunk || chunk->frames.empty()) return;
+
+    auto frameIt = std::upper_bound(chunk->frames.begin(), chunk->frames.end(), m_Time,
+        [](double time, const TrajectoryFrame& frame) { return time < frame.time; });
+    size_t frame = frameIt == chunk->frames.begin() ? 0 : (size_t)(frameIt - chunk->frames.begin()) - 1;
+
+    // The tick after it may be the first of the next chunk
+    const Chunk* nextChunk = chunk;
+    size_t nextFrame = frame + 1;
+    if (nextFrame >= chunk->frames.size()) {
+        nextChunk = chunkIndex + 1 < m_Index.size() ? GetChunk(chunkIndex + 1) : nullptr;
+        nextFrame = 0;
+        if (nextChunk && nextChunk->frames.empty()) nextChunk = nullptr;
+    }
+
+    const TrajectorySample* current = chunk->samples.data() + chunk->frameStart[frame];
+    uint32_t currentCount = chunk->frames[frame].sampleCount;
+    const TrajectorySample* next = nullptr;
+    uint32_t nextCount = 0;
+    float alpha = 0.0f;
+    if (nextChunk) {
+        next = nextChunk->samples.data() + nextChunk->frameStart[nextFrame];
+        nextCount = nextChunk->frames[nextFrame].sampleCount;
+        double t0 = chunk->frames[frame].time;
+        double t1 = nextChunk->frames[nextFrame].time;
+        alpha = t1 > t0 ? (float)std::clamp((m_Time - t0) / (t1 - t0), 0.0, 1.0) : 0.0f;
+    }
+
+    m_Vehicles.resize(currentCount);
+    auto interpolate = [&](const TrajectorySample& a, const TrajectorySample* b, VehicleState& state) {
+        state.id = a.vehicleId;
+        state.position = GetPosition(a);
+        state.direction = m_Edges[a.edgeId].direction;
+        state.speed = a.speed;
+        if (b) {
+            if (b->edgeId == a.edgeId) {
+                TrajectorySample between = a;
+                between.offset = a.offset + (b->offset - a.offset) * alpha;
+                state.position = GetPosition(between);
+            } else {
+                // Turned onto the next edge between the two ticks
+                state.position = glm::mix(state.position, GetPosition(*b), alpha);
+                if (alpha >= 0.5f) state.direction = m_Edges[b->edgeId].direction;
+            }
+            state.speed = a.speed + (b->speed - a.speed) * alpha;
+        }
+        if (state.speed <= 0.1f) m_StoppedCount++;
+    };
+
+    if (!next) {
+        for (uint32_t i = 0; i < currentCount; i++) {
+            interpolate(current[i], nullptr, m_Vehicles[i]);
+        }
+    } else if (IsSortedById(current, currentCount) && IsSortedById(next, nextCount)) {
+        // Merge join on vehicle id
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < currentCount; i++) {
+            while (j < nextCount && next[j].vehicleId < current[i].vehicleId) j++;
+            bool found = j < nextCount && next[j].vehicleId == current[i].vehicleId;
+            interpolate(current[i], found ? &next[j] : nullptr, m_Vehicles[i]);
+        }
+    } else {
+        for (uint32_t j = 0; j < nextCount; j++) {
+            int32_t id = next[j].vehicleId;
+            if (id < 0) continue;
+            if (id >= (int32_t)m_NextLookup.size()) m_NextLookup.resize((size_t)id + 1, -1);
+            m_NextLookup[id] = (int32_t)j;
+        }
+        for (uint32_t i = 0; i < currentCount; i++) {
+            int32_t id = current[i].vehicleId;
+            int32_t match = id >= 0 && id < (int32_t)m_NextLookup.size() ? m_NextLookup[id] : -1;
+            interpolate(current[i], match >= 0 ? &next[match] : nullptr, m_Vehicles[i]);
+        }
+        for (uint32_t j = 0; j < nextCount; j++) {
+            if (next[j].vehicleId >= 0) m_NextLookup[next[j].vehicleId] = -1;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "TrajectoryFormat.h"
+#include "../Core/MappedFile.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Plays back a .tstraj recording. The file is memory-mapped and chunks are
+// located by time through the chunk index, so seeking anywhere in the
+// recording, forwards or backwards, decodes at most two chunks.
+class ReplayPlayer {
+public:
+    struct VehicleState {
+        int id;
+        glm::vec3 position;
+        glm::vec3 direction;
+        float speed;
+    };
+
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return m_File.IsOpen(); }
+
+    // Advances playback by deltaTime * speed. Pauses at either end of the recording.
+    void Update(float deltaTime);
+    void Seek(double time);
+
+    void SetSpeed(float speed) { m_Speed = speed; }  // Negative plays backwards
+    float GetSpeed() const { return m_Speed; }
+    void SetPlaying(bool playing) { m_Playing = playing; }
+    bool IsPlaying() const { return m_Playing; }
+
+    double GetTime() const { return m_Time; }
+    double GetStartTime() const { return m_Index.empty() ? 0.0 : m_Index.front().startTime; }
+    double GetEndTime() const { return m_Index.empty() ? 0.0 : m_Index.back().endTime; }
+    size_t GetEdgeCount() const { return m_Edges.size(); }
+    size_t GetChunkCount() const { return m_Index.size(); }
+
+    // Vehicles at the current time, interpolated between the recorded ticks around it
+    const std::vector<VehicleState>& GetVehicles() const { return m_Vehicles; }
+    size_t GetStoppedCount() const { return m_StoppedCount; }  // Of those, how many are standing still
+
+private:
+    struct EdgeGeometry {
+        glm::vec3 from;
+        glm::vec3 direction;  // Unit length
+        glm::vec3 right;      // Unit length; lanes are to the right of the centreline
+    };
+
+    struct Chunk {
+        size_t index = SIZE_MAX;
+        uint64_t lastUse = 0;
+        std::vector<TrajectoryFrame> frames;
+        std::vector<TrajectorySample> samples;
+        std::vector<uint32_t> frameStart;  // First sample of each frame
+    };
+
+    bool ReadIndex();
+    const Chunk* GetChunk(size_t index);
+    void Evaluate();
+    glm::vec3 GetPosition(const TrajectorySample& sample) const;
+
+    MappedFile m_File;
+    TrajectoryFileHeader m_Header = {};
+    std::vector<EdgeGeometry> m_Edges;
+    std::vector<TrajectoryIndexEntry> m_Index;
+
+    // Decoded chunks, least recently used evicted. Three covers the chunk being
+    // shown, its successor for interpolation, and the one scrubbing left behind.
+    Chunk m_Cache[3];
+    uint64_t m_UseCounter = 0;
+
+    double m_Time = 0.0;
+    float m_Speed = 1.0f;
+    bool m_Playing = true;
+    bool m_Dirty = true;
+
+    std::vector<VehicleState> m_Vehicles;
+    size_t m_StoppedCount = 0;
+    std::vector<int32_t> m_NextLookup;  // Vehicle id -> sample in the next frame, when ids are unsorted
+};
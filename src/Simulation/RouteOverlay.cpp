@@ -0,0 +1,194 @@
+#include "RouteOverlay.h"
+#include "../Core/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+    // Open-set entry for both searches, ordered by estimated total cost
+    struct OpenEntry {
+        float fCost;
+        float gCost;
+        int32_t id;
+
+        bool operator>(const OpenEntry& other) const {
+            return fCost > other.fCost;
+        }
+    };
+
+    using OpenSet = std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>>;
+
+}
+
+RouteOverlay::RouteOverlay(const Graph& graph) {
+    int nodeCount = (int)graph.GetNodeCount();
+    if (nodeCount == 0) return;
+
+    // Bounds of the network on the ground plane
+    glm::vec2 minimum(std::numeric_limits<float>::max());
+    glm::vec2 maximum(std::numeric_limits<float>::lowest());
+    for (int id = 0; id < nodeCount; id++) {
+        const glm::vec3& position = graph.GetPosition(id);
+        minimum.x = std::min(minimum.x, position.x);
+        minimum.y = std::min(minimum.y, position.z);
+        maximum.x = std::max(maximum.x, position.x);
+        maximum.y = std::max(maximum.y, position.z);
+    }
+
+    // Square cells sized for NodesPerCell at the network's mean density
+    glm::vec2 extent = maximum - minimum;
+    float area = std::max(extent.x, 1.0f) * std::max(extent.y, 1.0f);
+    m_CellSize = std::max(std::sqrt(area * NodesPerCell / nodeCount), 1.0f);
+    m_Origin = minimum;
+    m_Columns = (int)(extent.x / m_CellSize) + 1;
+    m_Rows = (int)(extent.y / m_CellSize) + 1;
+    size_t cellCount = (size_t)m_Columns * m_Rows;
+
+    m_NodeCell.assign(nodeCount, 0);
+    m_CellCentres.assign(cellCount, glm::vec2(0.0f));
+    std::vector<uint32_t> cellNodes(cellCount, 0);
+    for (int id = 0; id < nodeCount; id++) {
+        const glm::vec3& position = graph.GetPosition(id);
+        int column = std::min((int)((position.x - m_Origin.x) / m_CellSize), m_Columns - 1);
+        int row = std::min((int)((position.z - m_Origin.y) / m_CellSize), m_Rows - 1);
+        int cell = row * m_Columns + column;
+        m_NodeCell[id] = cell;
+        m_CellCentres[cell] = m_CellCentres[cell] + glm::vec2(position.x, position.z);
+        cellNodes[cell]++;
+    }
+    for (size_t cell = 0; cell < cellCount; cell++) {
+        if (cellNodes[cell] > 0) m_CellCentres[cell] = m_CellCentres[cell] * (1.0f / cellNodes[cell]);
+    }
+
+    // One arc per pair of cells joined by at least one road, as compressed sparse rows
+    std::vector<uint64_t> arcs;
+    for (int id = 0; id < nodeCount; id++) {
+        for (int edge : graph.GetOutgoingEdges(id)) {
+            uint32_t from = (uint32_t)m_NodeCell[id];
+            uint32_t to = (uint32_t)m_NodeCell[graph.GetEdgeTarget(edge)];
+            if (from != to) arcs.push_back((uint64_t)from << 32 | to);
+        }
+    }
+    std::sort(arcs.begin(), arcs.end());
+    arcs.erase(std::unique(arcs.begin(), arcs.end()), arcs.end());
+
+    m_ArcOffsets.assign(cellCount + 1, 0);
+    m_ArcTargets.resize(arcs.size());
+    for (size_t i = 0; i < arcs.size(); i++) {
+        m_ArcOffsets[(arcs[i] >> 32) + 1]++;
+        m_ArcTargets[i] = (int32_t)(arcs[i] & 0xFFFFFFFFu);
+    }
+    for (size_t cell = 1; cell <= cellCount; cell++) {
+        m_ArcOffsets[cell] += m_ArcOffsets[cell - 1];
+    }
+}
+
+int RouteOverlay::GetCellOfNode(int nodeId) const {
+    return nodeId >= 0 && nodeId < (int)m_NodeCell.size() ? m_NodeCell[nodeId] : -1;
+}
+
+std::vector<int32_t> RouteOverlay::FindCorridor(int startNodeId, int goalNodeId) const {
+    TS_PROFILE_SCOPE(ProfilePhase::Routing);
+
+    int startCell = GetCellOfNode(startNodeId);
+    int goalCell = GetCellOfNode(goalNodeId);
+    if (startCell < 0 || goalCell < 0) return {};
+
+    // A* over cells, arcs costing the distance between cell centres
+    std::vector<float> gCosts(m_CellCentres.size(), std::numeric_limits<float>::max());
+    std::vector<int32_t> cameFrom(m_CellCentres.size(), -1);
+    std::vector<uint8_t> closed(m_CellCentres.size(), 0);
+    const glm::vec2& goalCentre = m_CellCentres[goalCell];
+
+    OpenSet openSet;
+    gCosts[startCell] = 0.0f;
+    openSet.push({ glm::length(goalCentre - m_CellCentres[startCell]), 0.0f, startCell });
+    while (!openSet.empty()) {
+        OpenEntry current = openSet.top();
+        openSet.pop();
+        if (closed[current.id]) continue;
+        closed[current.id] = 1;
+
+        if (current.id == goalCell) {
+            std::vector<int32_t> corridor;
+            for (int32_t cell = goalCell; cell != -1; cell = cameFrom[cell]) {
+                corridor.push_back(cell);
+            }
+            std::reverse(corridor.begin(), corridor.end());
+            return corridor;
+        }
+
+        for (uint32_t arc = m_ArcOffsets[current.id]; arc < m_ArcOffsets[current.id + 1]; arc++) {
+            int32_t next = m_ArcTargets[arc];
+            if (closed[next]) continue;
+            float gCost = current.gCost + glm::length(m_CellCentres[next] - m_CellCentres[current.id]);
+            if (gCost < gCosts[next]) {
+                gCosts[next] = gCost;
+                cameFrom[next] = current.id;
+                openSet.push({ gCost + glm::length(goalCentre - m_CellCentres[next]), gCost, next });
+            }
+        }
+    }
+    return {};
+}
+
+std::vector<int> RouteOverlay::Refine(const Graph& graph, int startNodeId, int goalNodeId,
+                                      const std::vector<int32_t>& corridor, size_t first, size_t& reachedIndex) const {
+    TS_PROFILE_SCOPE(ProfilePhase::Routing);
+
+    if (!graph.HasNode(goalNodeId) || first >= corridor.size() || GetCellOfNode(startNodeId) != corridor[first]) return {};
+
+    // The search stays inside the window of corridor cells
+    size_t last = std::min(first + Lookahead, corridor.size() - 1);
+    bool goalInWindow = last == corridor.size() - 1;
+    auto windowIndex = [&](int nodeId) -> size_t {
+        int cell = GetCellOfNode(nodeId);
+        for (size_t i = first; i <= last; i++) {
+            if (corridor[i] == cell) return i;
+        }
+        return corridor.size();
+    };
+
+    std::unordered_map<int, float> gCosts;
+    std::unordered_map<int, int> cameFrom;
+    std::unordered_set<int> closedSet;
+
+    OpenSet openSet;
+    gCosts[startNodeId] = 0.0f;
+    openSet.push({ 0.0f, 0.0f, startNodeId });
+    while (!openSet.empty()) {
+        OpenEntry current = openSet.top();
+        openSet.pop();
+        if (!closedSet.insert(current.id).second) continue;
+
+        bool reached = goalInWindow ? current.id == goalNodeId :
+            current.id != startNodeId && windowIndex(current.id) == last;
+        if (reached) {
+            std::vector<int> path;
+            for (int nodeId = current.id; nodeId != startNodeId; nodeId = cameFrom[nodeId]) {
+                path.push_back(nodeId);
+            }
+            path.push_back(startNodeId);
+            std::reverse(path.begin(), path.end());
+            reachedIndex = last;
+            return path;
+        }
+
+        for (int edge : graph.GetOutgoingEdges(current.id)) {
+            int next = graph.GetEdgeTarget(edge);
+            if (closedSet.count(next) || windowIndex(next) > last) continue;
+            float gCost = current.gCost + graph.GetEdgeWeight(edge);
+            auto it = gCosts.find(next);
+            if (it == gCosts.end() || gCost < it->second) {
+                gCosts[next] = gCost;
+                cameFrom[next] = current.id;
+                openSet.push({ gCost + glm::length(graph.GetPosition(goalNodeId) - graph.GetPosition(next)), gCost, next });
+            }
+        }
+    }
+    return {};
+}
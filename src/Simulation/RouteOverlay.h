@@ -0,0 +1,54 @@
+#pragma once
+#include "Graph.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Coarse routing layer for large networks. The network is covered by a grid of
+// square cells holding about NodesPerCell intersections each; the overlay has
+// one vertex per cell and an arc wherever a road leaves one cell for another.
+//
+// Trips are planned on two levels: a corridor of cells found over the overlay,
+// a graph a few hundred times smaller than the network, and a detailed node
+// path through only the next few cells of that corridor. The vehicle's tile
+// worker refines the next stretch as the vehicle drives, so a spawn costs two
+// small searches and no vehicle holds more than a few cells of path.
+//
+// Read-only once built.
+class RouteOverlay {
+public:
+    static constexpr int NodesPerCell = 256;
+    static constexpr size_t Lookahead = 2;           // Corridor cells each refinement covers past its first
+    static constexpr size_t RefineNodesAhead = 8;    // Refine once the planned path ends this close ahead
+    static constexpr size_t AutoNodeThreshold = 50000;  // RoutingMode::Auto plans hierarchically from this size
+
+    explicit RouteOverlay(const Graph& graph);
+
+    int GetCellOfNode(int nodeId) const;
+    size_t GetNodeCount() const { return m_NodeCell.size(); }
+    size_t GetCellCount() const { return m_CellCentres.size(); }
+    size_t GetArcCount() const { return m_ArcTargets.size(); }
+
+    // Cells from the start node's to the goal node's, empty if the overlay has no way there
+    std::vector<int32_t> FindCorridor(int startNodeId, int goalNodeId) const;
+
+    // Node path from startNodeId, which lies in corridor[first], through the cells
+    // corridor[first .. first + Lookahead]. It ends at the goal if the goal's cell is
+    // among them, otherwise at the first node reached in the last one; 'reachedIndex'
+    // receives the corridor index of the cell it ends in. Empty if there is no way
+    // through those cells.
+    std::vector<int> Refine(const Graph& graph, int startNodeId, int goalNodeId,
+                            const std::vector<int32_t>& corridor, size_t first, size_t& reachedIndex) const;
+
+private:
+    glm::vec2 m_Origin = glm::vec2(0.0f);
+    float m_CellSize = 1.0f;
+    int m_Columns = 1;
+    int m_Rows = 1;
+
+    std::vector<int32_t> m_NodeCell;         // Node ID -> cell
+    std::vector<glm::vec2> m_CellCentres;    // Mean position of each cell's nodes (x, z)
+    // Arcs leaving cell c: m_ArcTargets[m_ArcOffsets[c] .. m_ArcOffsets[c + 1])
+    std::vector<uint32_t> m_ArcOffsets;
+    std::vector<int32_t> m_ArcTargets;
+};
@@ -0,0 +1,127 @@
+#include "Scenario.h"
+#include "../Core/Log.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+    std::string Trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return "";
+        size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    // "<bus|tram> <headway> <stop> <stop> ..."
+    TransitLineSpec ParseLine(const std::string& value) {
+        std::istringstream stream(value);
+        std::string mode;
+        TransitLineSpec line;
+        stream >> mode >> line.headway;
+        if (mode == "bus") line.mode = TransitMode::Bus;
+        else if (mode == "tram") line.mode = TransitMode::Tram;
+        else throw std::invalid_argument(mode);
+        if (!stream || line.headway < 1.0f) throw std::invalid_argument(value);
+
+        int32_t stop;
+        while (stream >> stop) {
+            line.stops.push_back(stop);
+        }
+        if (!stream.eof() || line.stops.size() < 2) throw std::invalid_argument(value);
+        return line;
+    }
+
+}
+
+bool Scenario::Load(const std::string& path, Scenario& scenario) {
+    std::ifstream file(path);
+    if (!file) {
+        TS_LOG_ERROR(General, "Failed to open scenario file: %s", path.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = Trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            TS_LOG_ERROR(General, "%s:%d: expected 'key = value'", path.c_str(), lineNumber);
+            ok = false;
+            continue;
+        }
+        std::string key = Trim(line.substr(0, equals));
+        std::string value = Trim(line.substr(equals + 1));
+
+        try {
+            if (key == "network") {
+                std::filesystem::path networkPath(value);
+                if (!value.empty() && networkPath.is_relative()) {
+                    networkPath = std::filesystem::path(path).parent_path() / networkPath;
+                }
+                scenario.network = value.empty() ? "" : networkPath.string();
+            } else if (key == "verify_network") {
+                if (value == "true" || value == "1") scenario.verifyNetwork = true;
+                else if (value == "false" || value == "0") scenario.verifyNetwork = false;
+                else throw std::invalid_argument(value);
+            } else if (key == "grid_size") {
+                scenario.gridWidth = scenario.gridHeight = std::max(std::stoi(value), 2);
+            } else if (key == "grid_width") {
+                scenario.gridWidth = std::max(std::stoi(value), 2);
+            } else if (key == "grid_height") {
+                scenario.gridHeight = std::max(std::stoi(value), 2);
+            } else if (key == "spacing") {
+                scenario.spacing = std::max(std::stof(value), 1.0f);
+            } else if (key == "one_way_fraction") {
+                scenario.oneWayFraction = std::clamp(std::stof(value), 0.0f, 1.0f);
+            } else if (key == "diagonal_interval") {
+                scenario.diagonalInterval = std::max(std::stoi(value), 0);
+            } else if (key == "signal_density") {
+                scenario.signalDensity = std::clamp(std::stof(value), 0.0f, 1.0f);
+            } else if (key == "vehicles") {
+                scenario.initialVehicles = scenario.maxVehicles = std::max(std::stoi(value), 0);
+            } else if (key == "initial_vehicles") {
+                scenario.initialVehicles = std::max(std::stoi(value), 0);
+            } else if (key == "max_vehicles") {
+                scenario.maxVehicles = std::max(std::stoi(value), 0);
+            } else if (key == "seed") {
+                scenario.seed = (uint32_t)std::stoul(value);
+                scenario.hasSeed = true;
+            } else if (key == "routing") {
+                if (value == "auto") scenario.routing = RoutingMode::Auto;
+                else if (value == "astar") scenario.routing = RoutingMode::AStar;
+                else if (value == "table") scenario.routing = RoutingMode::Table;
+                else if (value == "hierarchical") scenario.routing = RoutingMode::Hierarchical;
+                else throw std::invalid_argument(value);
+            } else if (key == "line") {
+                scenario.lines.push_back(ParseLine(value));
+            } else if (key == "transit_lines") {
+                scenario.transitLines = std::max(std::stoi(value), 0);
+            } else if (key == "transit_headway") {
+                scenario.transitHeadway = std::max(std::stof(value), 1.0f);
+            } else if (key == "transit_service_hours") {
+                scenario.transitServiceHours = std::max(std::stof(value), 0.0f);
+            } else if (key == "transit_demand") {
+                scenario.transitDemand = std::max(std::stof(value), 0.0f);
+            } else {
+                TS_LOG_WARNING(General, "%s:%d: unknown setting '%s'", path.c_str(), lineNumber, key.c_str());
+            }
+        } catch (const std::exception&) {
+            TS_LOG_ERROR(General, "%s:%d: invalid value for %s: %s", path.c_str(), lineNumber, key.c_str(), value.c_str());
+            ok = false;
+        }
+    }
+
+    if ((int64_t)scenario.gridWidth * scenario.gridHeight > INT32_MAX) {
+        TS_LOG_ERROR(General, "%s: grid of %dx%d exceeds the node ID range", path.c_str(), scenario.gridWidth, scenario.gridHeight);
+        return false;
+    }
+    return ok;
+}
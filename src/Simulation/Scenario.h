@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Settings for one simulation run. Defaults reproduce the built-in 20x20 city.
+//
+// Scenario files are plain text, one 'key = value' per line, '#' starts a comment:
+//   grid_size = 3163            # or grid_width / grid_height
+//   one_way_fraction = 0.5
+//   signal_density = 0.25
+//   vehicles = 100000
+//   seed = 42
+//   routing = hierarchical      # auto, astar, table or hierarchical
+//   verify_network = true       # read and check all of a .tsnet file up front
+//   transit_lines = 6           # generated bus/tram lines, each run both ways
+//   line = tram 90 0 47 1210    # or explicit ones: mode, headway (s), stop node IDs
+
+// How spawned vehicles plan their routes
+enum class RoutingMode {
+    Auto,          // Table on small networks (NextHopTable::AutoNodeThreshold), hierarchical on
+                   // large ones (RouteOverlay::AutoNodeThreshold), A* in between
+    AStar,         // Full node path searched at spawn
+    Table,         // Full node path walked from precomputed all-pairs next hops
+    Hierarchical   // Cell corridor at spawn, node path refined a few cells ahead while driving
+};
+
+enum class TransitMode {
+    Bus,
+    Tram
+};
+
+// A transit line given in the scenario, running from its first stop to its last
+struct TransitLineSpec {
+    TransitMode mode = TransitMode::Bus;
+    float headway = 120.0f;          // Seconds between trips
+    std::vector<int32_t> stops;      // Node IDs, in driving order
+};
+
+struct Scenario {
+    std::string network;          // Road network file (.tsnet / .osm / .osm.pbf); empty = generate a grid
+    bool verifyNetwork = false;   // Checksum and validate a whole .tsnet file before using it
+
+    // Procedural grid
+    int gridWidth = 20;           // Intersections along x
+    int gridHeight = 20;          // Intersections along z
+    float spacing = 10.0f;        // Block length
+    float oneWayFraction = 0.5f;  // Share of streets that are one-way, spread evenly across the grid
+    int diagonalInterval = 4;     // Diagonal shortcuts in every Nth block along both axes, 0 = none
+    float signalDensity = 0.25f;  // Share of intersections with traffic lights
+
+    // Fleet
+    int initialVehicles = 150;
+    int maxVehicles = 200;        // Respawning keeps the fleet (plus queued spawns) at this size
+
+    RoutingMode routing = RoutingMode::Auto;
+
+    // Public transit
+    std::vector<TransitLineSpec> lines;
+    int transitLines = 0;             // Lines generated between random far-apart nodes, plus their returns
+    float transitHeadway = 120.0f;    // Seconds between trips on generated lines
+    float transitServiceHours = 4.0f; // Timetabled trips leave until then
+    float transitDemand = 30.0f;      // Passenger journeys requested per minute
+
+    bool hasSeed = false;
+    uint32_t seed = 0;
+
+    // Reads a scenario file over the current values. Unknown keys are reported
+    // and skipped; a relative network path is resolved against the file's directory.
+    static bool Load(const std::string& path, Scenario& scenario);
+};
@@ -0,0 +1,182 @@
+#include "SimulationThread.h"
+#include "TransportSimulation.h"
+#include "../Core/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+SimulationThread::SimulationThread(std::shared_ptr<TransportSimulation> simulation, float timeStep)
+    : m_Simulation(std::move(simulation)), m_TimeStep(timeStep) {
+}
+
+SimulationThread::~SimulationThread() {
+    Stop();
+}
+
+void SimulationThread::Start() {
+    if (m_Running.load(std::memory_order_relaxed)) return;
+    
+    Publish();
+    m_Snapshots.Acquire();
+    m_Running.store(true, std::memory_order_relaxed);
+    m_Thread = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop() {
+    if (!m_Running.exchange(false)) return;
+    m_Thread.join();
+    RunCommands();
+}
+
+void SimulationThread::Step(float seconds) {
+    if (m_Running.load(std::memory_order_relaxed)) return;
+    
+    RunCommands();
+    // The tolerance keeps e.g. 1/30 s frames at exactly two 1/60 s ticks each
+    m_StepPending += seconds;
+    while (m_StepPending >= m_TimeStep - 1e-6) {
+        m_Simulation->Update(m_TimeStep);
+        m_StepPending -= m_TimeStep;
+    }
+    Publish();
+}
+
+void SimulationThread::Post(Command command) {
+    std::lock_guard<std::mutex> lock(m_CommandMutex);
+    m_Commands.push_back(std::move(command));
+}
+
+void SimulationThread::RunCommands() {
+    {
+        std::lock_guard<std::mutex> lock(m_CommandMutex);
+        if (m_Commands.empty()) return;
+        std::swap(m_Commands, m_CommandBatch);
+    }
+    for (Command& command : m_CommandBatch) {
+        command(*m_Simulation);
+    }
+    m_CommandBatch.clear();
+}
+
+void SimulationThread::Run() {
+    TS_PROFILE_THREAD_NAME("Simulation");
+    using Clock = std::chrono::steady_clock;
+    
+    Clock::time_point previous = Clock::now();
+    double pending = 0.0;  // Wall-clock seconds not yet simulated
+    double rateTimer = 0.0;
+    int rateTicks = 0;
+    while (m_Running.load(std::memory_order_relaxed)) {
+        Clock::time_point now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - previous).count();
+        previous = now;
+        pending = std::min(pending + elapsed, (double)m_TimeStep * MaxCatchUpTicks);
+        
+        rateTimer += elapsed;
+        if (rateTimer >= 1.0) {
+            m_TicksPerSecond = (float)(rateTicks / rateTimer);
+            rateTimer = 0.0;
+            rateTicks = 0;
+        }
+        
+        if (pending < m_TimeStep) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(m_TimeStep - pending));
+            continue;
+        }
+        
+        RunCommands();
+        while (pending >= m_TimeStep) {
+            m_Simulation->Update(m_TimeStep);
+            pending -= m_TimeStep;
+            rateTicks++;
+        }
+        Publish();
+    }
+}
+
+void SimulationThread::Publish() {
+    RenderSnapshot& snapshot = m_Snapshots.GetWriteBuffer();
+    uint64_t version = ++m_Version;
+    
+    // World positions are only derived here, from each vehicle's edge and offset
+    const Graph& graph = *m_Simulation->GetGraph();
+    const auto& vehicles = m_Simulation->GetVehicles();
+    snapshot.vehicles.resize(vehicles.size());
+    for (size_t i = 0; i < vehicles.size(); i++) {
+        snapshot.vehicles[i] = { vehicles[i]->GetPosition(graph), vehicles[i]->GetDirection(graph) };
+    }
+    
+    // Signal states: stamp the pages of the lights that changed, then copy the
+    // pages this buffer has not seen yet, as for the edge loads below
+    const auto& lights = m_Simulation->GetSignals().lights;
+    size_t signalPageCount = (lights.size() + RenderSnapshot::EdgePageSize - 1) / RenderSnapshot::EdgePageSize;
+    if (m_SignalPageVersions.size() != signalPageCount) {
+        m_SignalPageVersions.assign(signalPageCount, version);
+    }
+    m_ChangedSignals.clear();
+    m_Simulation->TakeChangedSignals(m_ChangedSignals);
+    for (uint32_t edgeId : m_ChangedSignals) {
+        m_SignalPageVersions[edgeId / RenderSnapshot::EdgePageSize] = version;
+    }
+    if (snapshot.signalStates.size() != lights.size()) {
+        snapshot.signalStates.resize(lights.size());
+        std::memcpy(snapshot.signalStates.data(), lights.data(), lights.size());
+        snapshot.signalPageVersions = m_SignalPageVersions;
+    } else {
+        for (size_t page = 0; page < signalPageCount; page++) {
+            if (snapshot.signalPageVersions[page] == m_SignalPageVersions[page]) continue;
+            size_t first = page * RenderSnapshot::EdgePageSize;
+            size_t size = std::min(first + RenderSnapshot::EdgePageSize, lights.size()) - first;
+            std::memcpy(snapshot.signalStates.data() + first, lights.data() + first, size);
+            snapshot.signalPageVersions[page] = m_SignalPageVersions[page];
+        }
+    }
+    
+    // Edge loads: apply what changed since the last publish, stamping the pages it falls in
+    TrafficStatistics& statistics = m_Simulation->GetStatistics();
+    size_t edgeCount = statistics.GetEdgeCount();
+    size_t pageCount = (edgeCount + RenderSnapshot::EdgePageSize - 1) / RenderSnapshot::EdgePageSize;
+    if (m_EdgeLoads.size() != edgeCount) {
+        m_EdgeLoads.assign(edgeCount, 0);
+        m_EdgePageVersions.assign(pageCount, version);
+    }
+    m_ChangedEdges.clear();
+    statistics.TakeChangedEdges(m_ChangedEdges);
+    for (uint32_t edgeId : m_ChangedEdges) {
+        uint8_t load = (uint8_t)(std::min(statistics.GetEdgeLoad((int)edgeId), 1.0f) * 255.0f + 0.5f);
+        if (load == m_EdgeLoads[edgeId]) continue;
+        m_EdgeLoads[edgeId] = load;
+        m_EdgePageVersions[edgeId / RenderSnapshot::EdgePageSize] = version;
+    }
+    
+    // This buffer was last written two publishes or more ago; copy the pages stamped since
+    if (snapshot.edgeLoads.size() != edgeCount) {
+        snapshot.edgeLoads = m_EdgeLoads;
+        snapshot.edgePageVersions = m_EdgePageVersions;
+    } else {
+        for (size_t page = 0; page < pageCount; page++) {
+            if (snapshot.edgePageVersions[page] == m_EdgePageVersions[page]) continue;
+            size_t first = page * RenderSnapshot::EdgePageSize;
+            size_t size = std::min(first + RenderSnapshot::EdgePageSize, edgeCount) - first;
+            std::memcpy(snapshot.edgeLoads.data() + first, m_EdgeLoads.data() + first, size);
+            snapshot.edgePageVersions[page] = m_EdgePageVersions[page];
+        }
+    }
+    
+    snapshot.statistics = statistics.GetSnapshot();
+    const float* series = statistics.GetSeries(TrafficStatistics::Series::Halted);
+    int count = statistics.GetSeriesCount();
+    int offset = statistics.GetSeriesOffset();
+    snapshot.haltedSeries.resize(count);
+    for (int i = 0; i < count; i++) {
+        snapshot.haltedSeries[i] = series[(offset + i) % TrafficStatistics::SeriesLength];
+    }
+    
+    snapshot.version = version;
+    snapshot.simulationTime = m_Simulation->GetSimulationTime();
+    snapshot.ticksPerSecond = m_TicksPerSecond;
+    snapshot.trafficLightsEnabled = m_Simulation->AreTrafficLightsEnabled();
+    snapshot.threadCount = m_Simulation->GetThreadCount();
+    snapshot.recording = m_Simulation->IsRecording();
+    m_Snapshots.Publish();
+}
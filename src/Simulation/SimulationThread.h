@@ -0,0 +1,80 @@
+#pragma once
+#include "Graph.h"
+#include "RenderSnapshot.h"
+#include "../Core/TripleBuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TransportSimulation;
+
+// Steps a TransportSimulation on its own thread at a fixed time step, paced to
+// wall-clock time, so frame rate and vsync no longer set the simulation rate
+// and a slow tick no longer drops frames. After every batch of ticks a
+// RenderSnapshot goes out through a triple buffer; the main thread reads only
+// snapshots. Changes from the UI are posted as commands and run on the
+// simulation thread between ticks.
+//
+// Before Start and after Stop the simulation may be used directly, or driven
+// from the calling thread with Step (offscreen capture, where every frame
+// must advance simulated time by the same amount).
+class SimulationThread {
+public:
+    using Command = std::function<void(TransportSimulation&)>;
+    
+    static constexpr float DefaultTimeStep = 1.0f / 60.0f;
+    static constexpr int MaxCatchUpTicks = 5;  // Beyond this, fall behind real time instead
+    
+    explicit SimulationThread(std::shared_ptr<TransportSimulation> simulation, float timeStep = DefaultTimeStep);
+    ~SimulationThread();
+    
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+    
+    // Publishes a first snapshot, so one is available at once, then starts ticking
+    void Start();
+    // Waits for the current tick, then runs any commands still queued
+    void Stop();
+    bool IsRunning() const { return m_Running.load(std::memory_order_relaxed); }
+    
+    // Not running: runs the queued commands, advances simulated time by 'seconds'
+    // in whole ticks on the calling thread and publishes a snapshot
+    void Step(float seconds);
+    
+    // Any thread. Commands run in the order they were posted.
+    void Post(Command command);
+    
+    // Consumer (main thread): switches to the newest snapshot if there is one
+    bool AcquireSnapshot() { return m_Snapshots.Acquire(); }
+    const RenderSnapshot& GetSnapshot() const { return m_Snapshots.GetReadBuffer(); }
+    
+private:
+    void Run();
+    void RunCommands();
+    void Publish();
+    
+    std::shared_ptr<TransportSimulation> m_Simulation;
+    float m_TimeStep;
+    std::thread m_Thread;
+    std::atomic<bool> m_Running{ false };
+    
+    std::mutex m_CommandMutex;
+    std::vector<Command> m_Commands;
+    std::vector<Command> m_CommandBatch;  // Being run, swapped with m_Commands
+    
+    TripleBuffer<RenderSnapshot> m_Snapshots;
+    
+    // Simulation thread only
+    std::vector<uint8_t> m_EdgeLoads;
+    std::vector<uint64_t> m_EdgePageVersions;
+    std::vector<uint32_t> m_ChangedEdges;
+    std::vector<uint64_t> m_SignalPageVersions;
+    std::vector<uint32_t> m_ChangedSignals;
+    uint64_t m_Version = 0;
+    double m_StepPending = 0.0;  // Step time not yet simulated
+    float m_TicksPerSecond = 0.0f;
+};
@@ -0,0 +1,171 @@
+#include "TrafficStatistics.h"
+#include "Vehicle.h"
+#include <algorithm>
+#include <cmath>
+
+void TrafficStatistics::Reset(const Graph& graph) {
+    m_Snapshot = Snapshot();
+    m_Edges.assign(graph.GetEdgeCount(), EdgeCounters());
+    m_FreeFlowTime.assign(graph.GetEdgeCount(), 0.0f);
+    m_Capacity.assign(graph.GetEdgeCount(), 1.0f);
+
+    // The only full pass over the network, done once when it is loaded
+    size_t twoWayEdges = 0;
+    for (int id = 0; id < (int)graph.GetNodeCount(); id++) {
+        for (int edge : graph.GetOutgoingEdges(id)) {
+            m_Snapshot.roads++;
+            bool isTwoWay = graph.FindEdge(graph.GetEdgeTarget(edge), id) >= 0;
+            if (isTwoWay) twoWayEdges++; else m_Snapshot.oneWayRoads++;
+
+            float length = graph.GetEdgeLength(edge);
+            m_FreeFlowTime[edge] = length / FreeFlowSpeed;
+            m_Capacity[edge] = std::max(std::floor(length / VehicleSpacing), 1.0f);
+        }
+    }
+    m_Snapshot.twoWayRoads = twoWayEdges / 2;
+
+    ClearTraffic();
+}
+
+void TrafficStatistics::ClearTraffic() {
+    std::fill(m_Edges.begin(), m_Edges.end(), EdgeCounters());
+
+    // Every edge's figures start over, so all of them count as changed
+    m_EdgeChanged.assign(m_Edges.size(), 1);
+    m_ChangedEdges.resize(m_Edges.size());
+    for (size_t i = 0; i < m_ChangedEdges.size(); i++) {
+        m_ChangedEdges[i] = (uint32_t)i;
+    }
+    m_Snapshot.active = 0;
+    m_Snapshot.halted = 0;
+    m_Snapshot.spawned = 0;
+    m_Snapshot.arrived = 0;
+    m_Snapshot.signalChanges = 0;
+    m_Snapshot.meanEdgeDelay = 0.0;
+    m_Snapshot.arrivalsPerSecond = 0.0f;
+    m_TotalDelay = 0.0;
+    m_TotalExits = 0;
+
+    m_IntervalTime = 0.0f;
+    m_IntervalArrivals = 0;
+    m_IntervalExits = 0;
+    m_IntervalDelay = 0.0;
+    m_SeriesHead = 0;
+    m_SeriesCount = 0;
+}
+
+void TrafficStatistics::Rebuild(const std::vector<std::shared_ptr<Vehicle>>& vehicles) {
+    ClearTraffic();
+    for (const auto& vehicle : vehicles) {
+        OnSpawn(*vehicle);
+    }
+}
+
+void TrafficStatistics::OnSpawn(Vehicle& vehicle) {
+    m_Snapshot.active++;
+    m_Snapshot.spawned++;
+
+    bool halted = vehicle.IsHalted();
+    vehicle.SetCountedHalted(halted);
+    if (halted) m_Snapshot.halted++;
+
+    vehicle.ResetEdgeTime();
+    int edgeId = vehicle.GetCurrentEdgeId();
+    if (edgeId >= 0 && edgeId < (int)m_Edges.size()) {
+        m_Edges[edgeId].entered++;
+        MarkChanged((uint32_t)edgeId);
+    }
+}
+
+void TrafficStatistics::OnArrival(const Vehicle& vehicle) {
+    m_Snapshot.active--;
+    m_Snapshot.arrived++;
+    m_IntervalArrivals++;
+    if (vehicle.IsCountedHalted()) m_Snapshot.halted--;
+}
+
+void TrafficStatistics::OnEdgeChange(Vehicle& vehicle, int previousEdgeId, Counters& counters) {
+    if (previousEdgeId >= 0 && previousEdgeId < (int)m_Edges.size()) {
+        float travelTime = vehicle.GetEdgeTime();
+        float delay = std::max(travelTime - m_FreeFlowTime[previousEdgeId], 0.0f);
+
+        EdgeCounters& edge = m_Edges[previousEdgeId];
+        edge.exited++;
+        edge.travelTime += travelTime;
+        edge.delay += delay;
+        counters.edgeExits++;
+        counters.edgeDelay += delay;
+        counters.changedEdges.push_back((uint32_t)previousEdgeId);
+    }
+
+    vehicle.ResetEdgeTime();
+    int edgeId = vehicle.GetCurrentEdgeId();
+    if (edgeId >= 0 && edgeId < (int)m_Edges.size()) {
+        m_Edges[edgeId].entered++;
+        counters.changedEdges.push_back((uint32_t)edgeId);
+    }
+}
+
+void TrafficStatistics::OnVehicleResolved(Vehicle& vehicle, Counters& counters) {
+    bool halted = vehicle.IsHalted();
+    if (halted != vehicle.IsCountedHalted()) {
+        vehicle.SetCountedHalted(halted);
+        counters.halted += halted ? 1 : -1;
+    }
+}
+
+void TrafficStatistics::Merge(Counters& counters) {
+    m_Snapshot.halted = (size_t)((int64_t)m_Snapshot.halted + counters.halted);
+    m_Snapshot.signalChanges += counters.signalChanges;
+
+    m_TotalExits += counters.edgeExits;
+    m_TotalDelay += counters.edgeDelay;
+    m_IntervalExits += counters.edgeExits;
+    m_IntervalDelay += counters.edgeDelay;
+    m_Snapshot.meanEdgeDelay = m_TotalExits > 0 ? m_TotalDelay / m_TotalExits : 0.0;
+
+    for (uint32_t edgeId : counters.changedEdges) {
+        MarkChanged(edgeId);
+    }
+    counters.halted = 0;
+    counters.signalChanges = 0;
+    counters.edgeExits = 0;
+    counters.edgeDelay = 0.0;
+    counters.changedEdges.clear();  // Capacity kept for the next tick
+}
+
+void TrafficStatistics::MarkChanged(uint32_t edgeId) {
+    if (m_EdgeChanged[edgeId]) return;
+    m_EdgeChanged[edgeId] = 1;
+    m_ChangedEdges.push_back(edgeId);
+}
+
+void TrafficStatistics::TakeChangedEdges(std::vector<uint32_t>& edges) {
+    for (uint32_t edgeId : m_ChangedEdges) {
+        m_EdgeChanged[edgeId] = 0;
+    }
+    edges.insert(edges.end(), m_ChangedEdges.begin(), m_ChangedEdges.end());
+    m_ChangedEdges.clear();
+}
+
+void TrafficStatistics::Advance(float deltaTime) {
+    m_IntervalTime += deltaTime;
+    if (m_IntervalTime < 1.0f) return;
+
+    m_Snapshot.arrivalsPerSecond = (float)(m_IntervalArrivals / m_IntervalTime);
+    float samples[(size_t)Series::Count];
+    samples[(size_t)Series::Active] = (float)m_Snapshot.active;
+    samples[(size_t)Series::Halted] = (float)m_Snapshot.halted;
+    samples[(size_t)Series::Arrivals] = m_Snapshot.arrivalsPerSecond;
+    samples[(size_t)Series::EdgeDelay] = m_IntervalExits > 0 ? (float)(m_IntervalDelay / m_IntervalExits) : 0.0f;
+    for (size_t series = 0; series < (size_t)Series::Count; series++) {
+        m_Series[series][m_SeriesHead] = samples[series];
+    }
+    m_SeriesHead = (m_SeriesHead + 1) % SeriesLength;
+    m_SeriesCount = std::min(m_SeriesCount + 1, SeriesLength);
+
+    m_IntervalTime = 0.0f;
+    m_IntervalArrivals = 0;
+    m_IntervalExits = 0;
+    m_IntervalDelay = 0.0;
+}
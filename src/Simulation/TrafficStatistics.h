@@ -0,0 +1,119 @@
+#pragma once
+#include "Graph.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Vehicle;
+
+// Network and traffic figures kept up to date from simulation events instead
+// of being recomputed from the whole fleet. Fleet counters change on spawns,
+// arrivals, stops and restarts; per-edge counters on edge entry and exit; the
+// signal counter on phase changes. Once per simulated second a sample goes
+// into rolling time series. Every read is O(1).
+//
+// Tile workers report fleet-wide events into their own Counters, which the
+// partition merges after each tick. Per-edge counters are written directly:
+// vehicles only enter an edge in the tile owning its start node and only
+// leave it in the tile owning its end node.
+class TrafficStatistics {
+public:
+    static constexpr float FreeFlowSpeed = 5.0f;  // Cruise speed set by collision avoidance
+    static constexpr int SeriesLength = 300;      // One sample per simulated second
+    static constexpr float VehicleSpacing = 8.0f; // Road length per queued vehicle, gap included
+
+    // Events counted by one tile worker during a tick
+    struct Counters {
+        int64_t halted = 0;          // Net change in vehicles held at lights or by traffic
+        uint64_t signalChanges = 0;
+        uint64_t edgeExits = 0;
+        double edgeDelay = 0.0;      // Seconds beyond free flow, summed over the exits
+        std::vector<uint32_t> changedEdges;  // Entered or left, may repeat
+    };
+
+    struct EdgeCounters {
+        uint64_t entered = 0;
+        uint64_t exited = 0;         // Throughput
+        double travelTime = 0.0;     // Seconds, summed over exits
+        double delay = 0.0;          // Seconds beyond free flow, summed over exits
+
+        uint32_t GetOccupancy() const { return (uint32_t)(entered - exited); }
+    };
+
+    struct Snapshot {
+        // Network, fixed once loaded. Two-way roads are counted once per pair.
+        size_t roads = 0;
+        size_t oneWayRoads = 0;
+        size_t twoWayRoads = 0;
+
+        size_t active = 0;
+        size_t halted = 0;
+        uint64_t spawned = 0;
+        uint64_t arrived = 0;
+        uint64_t signalChanges = 0;
+        double meanEdgeDelay = 0.0;  // Seconds, over every edge exit so far
+        float arrivalsPerSecond = 0.0f;  // Over the last sample interval
+    };
+
+    enum class Series { Active, Halted, Arrivals, EdgeDelay, Count };
+
+    // Counts the roads and sizes the per-edge counters; clears everything else
+    void Reset(const Graph& graph);
+    // Clears the traffic figures and counts the given fleet as just spawned
+    // (after a checkpoint restore)
+    void Rebuild(const std::vector<std::shared_ptr<Vehicle>>& vehicles);
+
+    // Main thread, between ticks
+    void OnSpawn(Vehicle& vehicle);
+    void OnArrival(const Vehicle& vehicle);
+
+    // Tile workers, on vehicles they own
+    void OnEdgeChange(Vehicle& vehicle, int previousEdgeId, Counters& counters);
+    void OnVehicleResolved(Vehicle& vehicle, Counters& counters);
+
+    // Folds a tile's counters in and clears them for the next tick
+    void Merge(Counters& counters);
+    // Advances simulated time, taking a sample whenever a second has passed
+    void Advance(float deltaTime);
+
+    const Snapshot& GetSnapshot() const { return m_Snapshot; }
+    const EdgeCounters& GetEdge(int edgeId) const { return m_Edges[edgeId]; }
+    size_t GetEdgeCount() const { return m_Edges.size(); }
+    // Vehicles on the edge relative to how many fit end to end (1 = full)
+    float GetEdgeLoad(int edgeId) const { return m_Edges[edgeId].GetOccupancy() / m_Capacity[edgeId]; }
+
+    // Appends the edges whose occupancy changed since the last call, each once.
+    // Meant for a single consumer (SimulationThread, feeding the congestion overlay).
+    void TakeChangedEdges(std::vector<uint32_t>& edges);
+
+    // Ring of the last GetSeriesCount() samples, oldest at GetSeriesOffset()
+    // (the layout ImGui::PlotLines takes)
+    const float* GetSeries(Series series) const { return m_Series[(size_t)series].data(); }
+    int GetSeriesCount() const { return m_SeriesCount; }
+    int GetSeriesOffset() const { return m_SeriesCount < SeriesLength ? 0 : m_SeriesHead; }
+
+private:
+    void ClearTraffic();
+    void MarkChanged(uint32_t edgeId);
+
+    Snapshot m_Snapshot;
+    std::vector<EdgeCounters> m_Edges;
+    std::vector<float> m_FreeFlowTime;  // Per edge, seconds
+    std::vector<float> m_Capacity;      // Per edge, vehicles (at least 1)
+    std::vector<uint32_t> m_ChangedEdges;
+    std::vector<uint8_t> m_EdgeChanged;  // Already in m_ChangedEdges
+    double m_TotalDelay = 0.0;
+    uint64_t m_TotalExits = 0;
+
+    // Current sample interval
+    float m_IntervalTime = 0.0f;
+    uint64_t m_IntervalArrivals = 0;
+    uint64_t m_IntervalExits = 0;
+    double m_IntervalDelay = 0.0;
+
+    std::array<std::array<float, SeriesLength>, (size_t)Series::Count> m_Series = {};
+    int m_SeriesHead = 0;   // Next slot to write
+    int m_SeriesCount = 0;
+};
@@ -0,0 +1,192 @@
+#include "TrajectoryFormat.h"
+#include "../Core/Compression.h"
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+    // Last sample of a vehicle within the current chunk (quantised)
+    struct Previous {
+        int32_t edgeId = 0;
+        int32_t offset = 0;
+        int32_t speed = 0;
+    };
+
+    void PutVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    void PutSigned(std::vector<uint8_t>& out, int32_t value) {
+        PutVarint(out, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));  // Zigzag
+    }
+
+    int32_t Quantise(float value, float quantum) {
+        return (int32_t)std::lround(value / quantum);
+    }
+    
+    // Reads a varint at 'cursor'; returns false if the column ends first
+    bool GetVarint(const uint8_t*& cursor, const uint8_t* end, uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (cursor == end) return false;
+            uint8_t byte = *cursor++;
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+    
+    bool GetSigned(const uint8_t*& cursor, const uint8_t* end, int32_t& value) {
+        uint32_t zigzag;
+        if (!GetVarint(cursor, end, zigzag)) return false;
+        value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        return true;
+    }
+
+}
+
+namespace TrajectoryFormat {
+
+    const char FileMagic[4] = { 'T', 'S', 'T', 'R' };
+    const char ChunkMagic[4] = { 'T', 'S', 'C', 'H' };
+    const char IndexMagic[4] = { 'T', 'S', 'I', 'X' };
+
+    void EncodeChunk(const std::vector<TrajectoryFrame>& frames, const std::vector<TrajectorySample>& samples,
+                     float offsetQuantum, float speedQuantum, std::vector<uint8_t>& out) {
+        std::vector<uint8_t> columns[TrajectoryColumnCount];
+        columns[TrajectoryColumnFrames].resize(frames.size() * sizeof(TrajectoryFrame));
+        if (!frames.empty()) {
+            std::memcpy(columns[TrajectoryColumnFrames].data(), frames.data(), columns[TrajectoryColumnFrames].size());
+        }
+        
+        std::unordered_map<int32_t, Previous> previous;
+        size_t sampleIndex = 0;
+        for (const auto& frame : frames) {
+            int32_t previousId = -1;
+            for (uint32_t i = 0; i < frame.sampleCount; i++, sampleIndex++) {
+                const TrajectorySample& sample = samples[sampleIndex];
+                auto [it, isNew] = previous.try_emplace(sample.vehicleId);
+                Previous& last = it->second;
+                
+                int32_t offset = Quantise(sample.offset, offsetQuantum);
+                int32_t speed = Quantise(sample.speed, speedQuantum);
+                bool sameEdge = !isNew && last.edgeId == sample.edgeId;
+                
+                PutSigned(columns[TrajectoryColumnIds], sample.vehicleId - previousId);
+                PutSigned(columns[TrajectoryColumnEdges], sample.edgeId - last.edgeId);
+                PutSigned(columns[TrajectoryColumnOffsets], sameEdge ? offset - last.offset : offset);
+                PutSigned(columns[TrajectoryColumnSpeeds], speed - last.speed);
+                PutVarint(columns[TrajectoryColumnLanes], sample.lane);
+                
+                previousId = sample.vehicleId;
+                last.edgeId = sample.edgeId;
+                last.offset = offset;
+                last.speed = speed;
+            }
+        }
+        
+        TrajectoryChunkHeader header = {};
+        std::memcpy(header.magic, ChunkMagic, sizeof(ChunkMagic));
+        header.frameCount = (uint32_t)frames.size();
+        header.sampleCount = (uint32_t)sampleIndex;
+        header.startTime = frames.empty() ? 0.0 : frames.front().time;
+        header.endTime = frames.empty() ? 0.0 : frames.back().time;
+        
+        size_t headerOffset = out.size();
+        out.resize(headerOffset + sizeof(header));
+        for (int column = 0; column < TrajectoryColumnCount; column++) {
+            size_t before = out.size();
+            Compression::ZlibCompress(columns[column].data(), columns[column].size(), out);
+            header.rawSize[column] = (uint32_t)columns[column].size();
+            header.compressedSize[column] = (uint32_t)(out.size() - before);
+        }
+        std::memcpy(out.data() + headerOffset, &header, sizeof(header));
+    }
+
+    size_t GetChunkSize(const TrajectoryChunkHeader& header) {
+        if (std::memcmp(header.magic, ChunkMagic, sizeof(ChunkMagic)) != 0) return 0;
+        
+        size_t size = sizeof(TrajectoryChunkHeader);
+        for (int column = 0; column < TrajectoryColumnCount; column++) {
+            size += header.compressedSize[column];
+        }
+        return size;
+    }
+
+    bool DecodeChunk(const uint8_t* data, size_t size, float offsetQuantum, float speedQuantum,
+                     std::vector<TrajectoryFrame>& frames, std::vector<TrajectorySample>& samples) {
+        frames.clear();
+        samples.clear();
+        if (size < sizeof(TrajectoryChunkHeader)) return false;
+        
+        TrajectoryChunkHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        size_t chunkSize = GetChunkSize(header);
+        if (chunkSize == 0 || chunkSize > size) return false;
+        if (header.rawSize[TrajectoryColumnFrames] != (size_t)header.frameCount * sizeof(TrajectoryFrame)) return false;
+        
+        std::vector<uint8_t> columns[TrajectoryColumnCount];
+        const uint8_t* cursor = data + sizeof(header);
+        for (int column = 0; column < TrajectoryColumnCount; column++) {
+            if (!Compression::ZlibDecompress(cursor, header.compressedSize[column], columns[column], header.rawSize[column]) ||
+                columns[column].size() != header.rawSize[column]) {
+                return false;
+            }
+            cursor += header.compressedSize[column];
+        }
+        
+        frames.resize(header.frameCount);
+        if (!frames.empty()) {
+            std::memcpy(frames.data(), columns[TrajectoryColumnFrames].data(), columns[TrajectoryColumnFrames].size());
+        }
+        
+        const uint8_t* read[TrajectoryColumnCount];
+        const uint8_t* end[TrajectoryColumnCount];
+        for (int column = 0; column < TrajectoryColumnCount; column++) {
+            read[column] = columns[column].data();
+            end[column] = read[column] + columns[column].size();
+        }
+        
+        std::unordered_map<int32_t, Previous> previous;
+        samples.resize(header.sampleCount);
+        size_t sampleIndex = 0;
+        for (const auto& frame : frames) {
+            if (frame.sampleCount > header.sampleCount - sampleIndex) return false;
+            
+            int32_t previousId = -1;
+            for (uint32_t i = 0; i < frame.sampleCount; i++, sampleIndex++) {
+                int32_t idDelta, edgeDelta, offset, speedDelta;
+                uint32_t lane;
+                if (!GetSigned(read[TrajectoryColumnIds], end[TrajectoryColumnIds], idDelta) ||
+                    !GetSigned(read[TrajectoryColumnEdges], end[TrajectoryColumnEdges], edgeDelta) ||
+                    !GetSigned(read[TrajectoryColumnOffsets], end[TrajectoryColumnOffsets], offset) ||
+                    !GetSigned(read[TrajectoryColumnSpeeds], end[TrajectoryColumnSpeeds], speedDelta) ||
+                    !GetVarint(read[TrajectoryColumnLanes], end[TrajectoryColumnLanes], lane) || lane > UINT8_MAX) {
+                    return false;
+                }
+                
+                int32_t vehicleId = previousId + idDelta;
+                auto [it, isNew] = previous.try_emplace(vehicleId);
+                Previous& last = it->second;
+                
+                int32_t edgeId = last.edgeId + edgeDelta;
+                if (!isNew && last.edgeId == edgeId) offset += last.offset;
+                int32_t speed = last.speed + speedDelta;
+                
+                samples[sampleIndex] = { vehicleId, edgeId, offset * offsetQuantum, speed * speedQuantum, (uint8_t)lane };
+                
+                previousId = vehicleId;
+                last.edgeId = edgeId;
+                last.offset = offset;
+                last.speed = speed;
+            }
+        }
+        return sampleIndex == header.sampleCount;
+    }
+
+}
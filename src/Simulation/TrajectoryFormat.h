@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Trajectory recording file (.tstraj)
+//
+//   TrajectoryFileHeader
+//   zlib-compressed edge geometry (float[6] per edge: from xyz, to xyz)
+//   chunks: TrajectoryChunkHeader + one zlib stream per column
+//   index:  TrajectoryIndexEntry per chunk + TrajectoryIndexFooter (absent if
+//           the recording was interrupted; chunks can then be found by scanning)
+//
+// Each chunk is self-contained. Within a chunk, ids are delta-encoded against the
+// previous sample of the frame, and edge / offset / speed against the same
+// vehicle's previous sample in the chunk. Offsets and speeds are quantised;
+// lanes are stored as they are.
+
+// Per vehicle, per recorded tick
+struct TrajectorySample {
+    int32_t vehicleId;
+    int32_t edgeId;
+    float offset;  // Distance travelled along the edge
+    float speed;
+    uint8_t lane;  // As Vehicle::GetLane
+};
+
+struct TrajectoryFrame {
+    double time;
+    uint32_t sampleCount;
+};
+
+enum TrajectoryColumn {
+    TrajectoryColumnFrames = 0,
+    TrajectoryColumnIds,
+    TrajectoryColumnEdges,
+    TrajectoryColumnOffsets,
+    TrajectoryColumnSpeeds,
+    TrajectoryColumnLanes,
+    TrajectoryColumnCount
+};
+
+struct TrajectoryFileHeader {
+    char magic[4];  // "TSTR"
+    uint32_t version;
+    uint32_t edgeCount;
+    uint32_t geometrySize;  // Compressed bytes following the header
+    float offsetQuantum;    // Distance units per quantisation step
+    float speedQuantum;
+};
+
+struct TrajectoryChunkHeader {
+    char magic[4];  // "TSCH"
+    uint32_t frameCount;
+    uint32_t sampleCount;
+    uint32_t reserved;
+    double startTime;
+    double endTime;
+    uint32_t rawSize[TrajectoryColumnCount];
+    uint32_t compressedSize[TrajectoryColumnCount];
+};
+
+struct TrajectoryIndexEntry {
+    double startTime;
+    double endTime;
+    uint64_t offset;  // File offset of the chunk header
+};
+
+struct TrajectoryIndexFooter {
+    uint64_t indexOffset;
+    uint32_t chunkCount;
+    char magic[4];  // "TSIX"
+};
+
+namespace TrajectoryFormat {
+
+    constexpr uint32_t Version = 2;
+    extern const char FileMagic[4];
+    extern const char ChunkMagic[4];
+    extern const char IndexMagic[4];
+
+    // Delta-encodes, quantises and compresses one chunk; appends header + columns to 'out'
+    void EncodeChunk(const std::vector<TrajectoryFrame>& frames, const std::vector<TrajectorySample>& samples,
+                     float offsetQuantum, float speedQuantum, std::vector<uint8_t>& out);
+
+    // Inverse of EncodeChunk. 'data' points at a chunk header with 'size' bytes available.
+    // Replaces the contents of 'frames' and 'samples'. Returns false on a truncated or corrupt chunk.
+    bool DecodeChunk(const uint8_t* data, size_t size, float offsetQuantum, float speedQuantum,
+                     std::vector<TrajectoryFrame>& frames, std::vector<TrajectorySample>& samples);
+
+    // Header plus compressed columns, or 0 if the header is invalid
+    size_t GetChunkSize(const TrajectoryChunkHeader& header);
+
+}
@@ -0,0 +1,158 @@
+#include "TrajectoryRecorder.h"
+#include "../Core/Compression.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    Stop();
+}
+
+bool TrajectoryRecorder::Start(const std::string& path, Graph& graph, const Options& options) {
+    Stop();
+    
+    m_File = std::fopen(path.c_str(), "wb");
+    if (!m_File) {
+        std::cerr << "Failed to create trajectory file: " << path << std::endl;
+        return false;
+    }
+    
+    // Store the edge geometry so recordings can be replayed without the network
+    std::vector<float> geometry(graph.GetEdgeCount() * 6, 0.0f);
+    for (int edge = 0; edge < (int)graph.GetEdgeCount(); edge++) {
+        float* out = &geometry[(size_t)edge * 6];
+        std::memcpy(out, &graph.GetPosition(graph.GetEdgeSource(edge)), sizeof(glm::vec3));
+        std::memcpy(out + 3, &graph.GetPosition(graph.GetEdgeTarget(edge)), sizeof(glm::vec3));
+    }
+    m_EdgeCount = graph.GetEdgeCount();
+    std::vector<uint8_t> compressed;
+    Compression::ZlibCompress((const uint8_t*)geometry.data(), geometry.size() * sizeof(float), compressed);
+    
+    TrajectoryFileHeader header = {};
+    std::memcpy(header.magic, TrajectoryFormat::FileMagic, sizeof(header.magic));
+    header.version = TrajectoryFormat::Version;
+    header.edgeCount = (uint32_t)graph.GetEdgeCount();
+    header.geometrySize = (uint32_t)compressed.size();
+    header.offsetQuantum = options.offsetQuantum;
+    header.speedQuantum = options.speedQuantum;
+    
+    if (std::fwrite(&header, sizeof(header), 1, m_File) != 1 ||
+        std::fwrite(compressed.data(), 1, compressed.size(), m_File) != compressed.size()) {
+        std::cerr << "Failed to write trajectory file: " << path << std::endl;
+        std::fclose(m_File);
+        m_File = nullptr;
+        return false;
+    }
+    m_FileOffset = sizeof(header) + compressed.size();
+    
+    m_Path = path;
+    m_Options = options;
+    m_Samples = std::make_unique<SpscRing<TrajectorySample>>(options.ringCapacity);
+    m_Frames = std::make_unique<SpscRing<TrajectoryFrame>>(4096);
+    m_ChunkFrames.clear();
+    m_ChunkSamples.clear();
+    m_Index.clear();
+    m_WriteFailed = false;
+    m_RecordedFrames = 0;
+    m_DroppedFrames = 0;
+    m_Stop = false;
+    m_Writer = std::thread(&TrajectoryRecorder::WriterLoop, this);
+    
+    std::cout << "Recording trajectories to " << path << std::endl;
+    return true;
+}
+
+void TrajectoryRecorder::Stop() {
+    if (!m_Writer.joinable()) return;
+    
+    m_Stop = true;
+    m_Writer.join();
+    
+    std::cout << "Recorded " << m_RecordedFrames << " frames to " << m_Path;
+    if (m_DroppedFrames > 0) {
+        std::cout << " (" << m_DroppedFrames << " dropped: writer could not keep up)";
+    }
+    std::cout << std::endl;
+}
+
+void TrajectoryRecorder::Capture(double time, const std::vector<std::shared_ptr<Vehicle>>& vehicles) {
+    if (!m_Writer.joinable()) return;
+    
+    m_Staging.resize(vehicles.size());
+    size_t count = 0;
+    for (const auto& vehicle : vehicles) {
+        int edgeId = vehicle->GetCurrentEdgeId();
+        if (edgeId < 0 || edgeId >= (int)m_EdgeCount) continue;
+        m_Staging[count++] = { vehicle->GetId(), edgeId, vehicle->GetOffset(), vehicle->GetSpeed(), vehicle->GetLane() };
+    }
+    m_Staging.resize(count);
+    
+    // Samples first: once the consumer sees the frame, its samples are already there
+    TrajectoryFrame frame = { time, (uint32_t)m_Staging.size() };
+    if (m_Frames->GetSize() < m_Frames->GetCapacity() &&
+        m_Samples->TryPush(m_Staging.data(), m_Staging.size())) {
+        m_Frames->TryPush(frame);
+        m_RecordedFrames++;
+    } else {
+        m_DroppedFrames++;
+    }
+}
+
+void TrajectoryRecorder::WriterLoop() {
+    while (true) {
+        TrajectoryFrame frame;
+        if (!m_Frames->TryPop(frame)) {
+            if (!m_Stop) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            // The producer has stopped; pick up a frame pushed just before it did
+            if (!m_Frames->TryPop(frame)) break;
+        }
+        
+        size_t start = m_ChunkSamples.size();
+        m_ChunkSamples.resize(start + frame.sampleCount);
+        size_t popped = 0;
+        while (popped < frame.sampleCount) {
+            popped += m_Samples->TryPop(m_ChunkSamples.data() + start + popped, frame.sampleCount - popped);
+        }
+        m_ChunkFrames.push_back(frame);
+        
+        if ((int)m_ChunkFrames.size() >= m_Options.framesPerChunk) {
+            WriteChunk();
+        }
+    }
+    
+    WriteChunk();
+    
+    // Chunk index for seeking
+    TrajectoryIndexFooter footer = {};
+    footer.indexOffset = m_FileOffset;
+    footer.chunkCount = (uint32_t)m_Index.size();
+    std::memcpy(footer.magic, TrajectoryFormat::IndexMagic, sizeof(footer.magic));
+    if (std::fwrite(m_Index.data(), sizeof(TrajectoryIndexEntry), m_Index.size(), m_File) != m_Index.size() ||
+        std::fwrite(&footer, sizeof(footer), 1, m_File) != 1) {
+        m_WriteFailed = true;
+    }
+    
+    if (std::fclose(m_File) != 0 || m_WriteFailed) {
+        std::cerr << "Failed to write trajectory file: " << m_Path << std::endl;
+    }
+    m_File = nullptr;
+}
+
+void TrajectoryRecorder::WriteChunk() {
+    if (m_ChunkFrames.empty()) return;
+    
+    m_Encoded.clear();
+    TrajectoryFormat::EncodeChunk(m_ChunkFrames, m_ChunkSamples, m_Options.offsetQuantum, m_Options.speedQuantum, m_Encoded);
+    if (std::fwrite(m_Encoded.data(), 1, m_Encoded.size(), m_File) != m_Encoded.size()) {
+        m_WriteFailed = true;
+    }
+    
+    m_Index.push_back({ m_ChunkFrames.front().time, m_ChunkFrames.back().time, m_FileOffset });
+    m_FileOffset += m_Encoded.size();
+    m_ChunkFrames.clear();
+    m_ChunkSamples.clear();
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Graph.h"
+#include "Vehicle.h"
+#include "TrajectoryFormat.h"
+#include "../Core/SpscRing.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records per-tick vehicle state to a .tstraj file without stalling the tick.
+// The simulation thread only copies compact samples into a lock-free ring; a
+// background thread encodes, compresses and writes them in chunks.
+class TrajectoryRecorder {
+public:
+    struct Options {
+        size_t ringCapacity = 1 << 22;  // Samples buffered between the two threads
+        int framesPerChunk = 60;        // Seek granularity of the replay
+        float offsetQuantum = 0.01f;
+        float speedQuantum = 0.01f;
+    };
+    
+    TrajectoryRecorder() = default;
+    ~TrajectoryRecorder();
+    
+    bool Start(const std::string& path, Graph& graph, const Options& options);
+    bool Start(const std::string& path, Graph& graph) { return Start(path, graph, Options()); }
+    
+    // Drains the ring, writes the chunk index and closes the file
+    void Stop();
+    
+    bool IsRecording() const { return m_Writer.joinable(); }
+    
+    // Simulation thread. If the writer falls behind the frame is dropped, never waited for.
+    void Capture(double time, const std::vector<std::shared_ptr<Vehicle>>& vehicles);
+    
+    uint64_t GetRecordedFrames() const { return m_RecordedFrames; }
+    uint64_t GetDroppedFrames() const { return m_DroppedFrames; }
+    
+private:
+    void WriterLoop();
+    void WriteChunk();
+    
+    Options m_Options;
+    FILE* m_File = nullptr;
+    std::string m_Path;
+    
+    std::unique_ptr<SpscRing<TrajectorySample>> m_Samples;
+    std::unique_ptr<SpscRing<TrajectoryFrame>> m_Frames;
+    std::vector<TrajectorySample> m_Staging;  // Simulation thread only
+    size_t m_EdgeCount = 0;
+    
+    std::thread m_Writer;
+    std::atomic<bool> m_Stop{ false };
+    std::atomic<uint64_t> m_RecordedFrames{ 0 };
+    std::atomic<uint64_t> m_DroppedFrames{ 0 };
+    
+    // Writer thread only
+    std::vector<TrajectoryFrame> m_ChunkFrames;
+    std::vector<TrajectorySample> m_ChunkSamples;
+    std::vector<TrajectoryIndexEntry> m_Index;
+    std::vector<uint8_t> m_Encoded;
+    uint64_t m_FileOffset = 0;
+    bool m_WriteFailed = false;
+};
@@ -0,0 +1,343 @@
+#include "TransitNetwork.h"
+#include "Pathfinding.h"
+#include "../Core/Log.h"
+#include "../Core/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+    // How a stop was reached in a round: on which trip, boarded where, and if
+    // walking from another stop reached by trip in the same round was quicker
+    // still, from which one
+    struct Label {
+        int32_t route = -1;     // -1 if no trip improved the stop in this round
+        int32_t trip = -1;
+        uint32_t boardIndex = 0;
+        uint32_t alightIndex = 0;
+        int32_t walkFrom = -1;  // -1 if not reached on foot
+    };
+
+    struct Walk {
+        int32_t from;
+        int32_t to;
+        float arrival;
+    };
+
+    // Every GeneratedStopSpacing-th node of the path, and its last
+    std::vector<int> StopsAlong(const std::vector<int>& path) {
+        std::vector<int> stops;
+        for (size_t i = 0; i + 1 < path.size(); i += TransitNetwork::GeneratedStopSpacing) {
+            stops.push_back(path[i]);
+        }
+        stops.push_back(path.back());
+        return stops;
+    }
+
+}
+
+void TransitNetwork::Build(std::shared_ptr<Graph> graph, const Scenario& scenario, uint32_t seed) {
+    TS_PROFILE_SCOPE(ProfilePhase::Routing);
+    m_Lines.clear();
+    m_Routes.clear();
+    m_RouteStops.clear();
+    m_StopTimes.clear();
+    m_StopNodes.clear();
+    m_NodeStops.assign(graph->GetNodeCount(), -1);
+
+    float serviceEnd = scenario.transitServiceHours * 3600.0f;
+    for (size_t i = 0; i < scenario.lines.size(); i++) {
+        const TransitLineSpec& spec = scenario.lines[i];
+        std::vector<int> stops(spec.stops.begin(), spec.stops.end());
+        if (!AddLine(graph, spec.mode, stops, spec.headway, serviceEnd)) {
+            TS_LOG_WARNING(Simulation, "Transit line %zu has no road between two of its stops, skipped", i + 1);
+        }
+    }
+
+    // Generated lines: out along a shortest path between two far-apart nodes,
+    // back along the shortest return path (one-way streets differ)
+    int nodeCount = (int)graph->GetNodeCount();
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> nodes(0, std::max(nodeCount - 1, 0));
+    for (int i = 0; i < scenario.transitLines && nodeCount > 1; i++) {
+        TransitMode mode = i % 3 == 2 ? TransitMode::Tram : TransitMode::Bus;
+        for (int attempt = 0; attempt < 20; attempt++) {
+            int from = nodes(rng);
+            int to = nodes(rng);
+            if (glm::length(graph->GetPosition(to) - graph->GetPosition(from)) / scenario.spacing < 10.0f) continue;
+
+            std::vector<int> outbound = Pathfinding::AStar(graph, from, to);
+            std::vector<int> inbound = Pathfinding::AStar(graph, to, from);
+            if (outbound.empty() || inbound.empty()) continue;
+            AddLine(graph, mode, StopsAlong(outbound), scenario.transitHeadway, serviceEnd);
+            AddLine(graph, mode, StopsAlong(inbound), scenario.transitHeadway, serviceEnd);
+            break;
+        }
+    }
+
+    // Routes per stop, as compressed sparse rows
+    m_StopRouteOffsets.assign(m_StopNodes.size() + 1, 0);
+    for (int32_t stop : m_RouteStops) {
+        m_StopRouteOffsets[stop + 1]++;
+    }
+    for (size_t stop = 1; stop < m_StopRouteOffsets.size(); stop++) {
+        m_StopRouteOffsets[stop] += m_StopRouteOffsets[stop - 1];
+    }
+    m_StopRoutes.resize(m_RouteStops.size());
+    std::vector<uint32_t> next(m_StopRouteOffsets.begin(), m_StopRouteOffsets.end() - 1);
+    for (uint32_t route = 0; route < m_Routes.size(); route++) {
+        for (uint32_t index = 0; index < m_Routes[route].stopCount; index++) {
+            m_StopRoutes[next[GetRouteStop(route, index)]++] = { route, index };
+        }
+    }
+
+    BuildTransfers(*graph);
+}
+
+void TransitNetwork::BuildTransfers(const Graph& graph) {
+    // Stops bucketed on a grid of WalkDistance cells, so only neighbouring cells are compared
+    auto cellOf = [](const glm::vec3& position) {
+        int64_t x = (int64_t)std::floor(position.x / WalkDistance);
+        int64_t z = (int64_t)std::floor(position.z / WalkDistance);
+        return std::make_pair(x, z);
+    };
+    auto key = [](int64_t x, int64_t z) { return (uint64_t)(x & 0xFFFFFFFF) << 32 | (uint64_t)(z & 0xFFFFFFFF); };
+    std::unordered_map<uint64_t, std::vector<int32_t>> cells;
+    for (int32_t stop = 0; stop < (int32_t)m_StopNodes.size(); stop++) {
+        auto [x, z] = cellOf(graph.GetPosition(m_StopNodes[stop]));
+        cells[key(x, z)].push_back(stop);
+    }
+
+    m_TransferOffsets.assign(m_StopNodes.size() + 1, 0);
+    m_Transfers.clear();
+    for (int32_t stop = 0; stop < (int32_t)m_StopNodes.size(); stop++) {
+        const glm::vec3& position = graph.GetPosition(m_StopNodes[stop]);
+        auto [x, z] = cellOf(position);
+        size_t first = m_Transfers.size();
+        for (int64_t dx = -1; dx <= 1; dx++) {
+            for (int64_t dz = -1; dz <= 1; dz++) {
+                auto it = cells.find(key(x + dx, z + dz));
+                if (it == cells.end()) continue;
+                for (int32_t other : it->second) {
+                    float distance = glm::length(graph.GetPosition(m_StopNodes[other]) - position);
+                    if (other != stop && distance <= WalkDistance) {
+                        m_Transfers.push_back({ other, distance / WalkSpeed });
+                    }
+                }
+            }
+        }
+        std::sort(m_Transfers.begin() + first, m_Transfers.end(),
+            [](const Transfer& a, const Transfer& b) { return a.stop < b.stop; });
+        m_TransferOffsets[stop + 1] = (uint32_t)m_Transfers.size();
+    }
+}
+
+float TransitNetwork::GetWalkTime(int fromStop, int toStop) const {
+    if (fromStop == toStop) return 0.0f;
+    for (uint32_t i = m_TransferOffsets[fromStop]; i < m_TransferOffsets[fromStop + 1]; i++) {
+        if (m_Transfers[i].stop == toStop) return m_Transfers[i].duration;
+    }
+    return -1.0f;
+}
+
+bool TransitNetwork::AddLine(const std::shared_ptr<Graph>& graph, TransitMode mode, const std::vector<int>& stopNodes,
+                             float headway, float serviceEnd) {
+    if (stopNodes.size() < 2 || !graph->HasNode(stopNodes[0])) return false;
+
+    Line line;
+    line.mode = mode;
+    line.nodePath = { stopNodes[0] };
+    line.stopPathIndices = { 0 };
+    std::vector<float> driveTimes;  // From each stop to the next
+    for (size_t i = 1; i < stopNodes.size(); i++) {
+        if (stopNodes[i] == line.nodePath.back()) continue;
+        std::vector<int> path = Pathfinding::AStar(graph, line.nodePath.back(), stopNodes[i]);
+        if (path.empty()) return false;
+
+        float length = 0.0f;
+        for (size_t j = 1; j < path.size(); j++) {
+            length += graph->GetEdgeLength(graph->FindEdge(path[j - 1], path[j]));
+        }
+        line.nodePath.insert(line.nodePath.end(), path.begin() + 1, path.end());
+        line.stopPathIndices.push_back((uint32_t)line.nodePath.size() - 1);
+        driveTimes.push_back(length / CruiseSpeed * ScheduleSlack);
+    }
+    if (line.stopPathIndices.size() < 2) return false;
+
+    Route route;
+    route.firstStop = (uint32_t)m_RouteStops.size();
+    route.stopCount = (uint32_t)line.stopPathIndices.size();
+    route.firstStopTime = (uint32_t)m_StopTimes.size();
+    route.tripCount = (uint32_t)(serviceEnd / headway) + 1;
+    for (uint32_t pathIndex : line.stopPathIndices) {
+        m_RouteStops.push_back(GetOrAddStop(line.nodePath[pathIndex]));
+    }
+
+    // Trips enter service every headway and dwell at every stop but the last
+    float dwell = GetDwellTime(mode);
+    for (uint32_t trip = 0; trip < route.tripCount; trip++) {
+        float time = trip * headway;
+        for (uint32_t index = 0; index < route.stopCount; index++) {
+            if (index > 0) time += driveTimes[index - 1];
+            float departure = index + 1 < route.stopCount ? time + dwell : time;
+            m_StopTimes.push_back({ time, departure });
+            time = departure;
+        }
+    }
+
+    m_Lines.push_back(std::move(line));
+    m_Routes.push_back(route);
+    return true;
+}
+
+int TransitNetwork::GetOrAddStop(int nodeId) {
+    if (m_NodeStops[nodeId] < 0) {
+        m_NodeStops[nodeId] = (int32_t)m_StopNodes.size();
+        m_StopNodes.push_back(nodeId);
+    }
+    return m_NodeStops[nodeId];
+}
+
+size_t TransitNetwork::GetTripCount() const {
+    size_t count = 0;
+    for (const auto& route : m_Routes) {
+        count += route.tripCount;
+    }
+    return count;
+}
+
+int TransitNetwork::FindTrip(const Route& route, uint32_t index, float time) const {
+    // Trips never overtake, so departures rise with the trip index at every stop
+    uint32_t low = 0, high = route.tripCount;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (m_StopTimes[route.firstStopTime + (size_t)middle * route.stopCount + index].departure < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < route.tripCount ? (int)low : -1;
+}
+
+std::vector<TransitNetwork::Leg> TransitNetwork::FindJourney(int originStop, int destinationStop, float time) const {
+    TS_PROFILE_SCOPE(ProfilePhase::Routing);
+
+    size_t stopCount = m_StopNodes.size();
+    if (originStop < 0 || destinationStop < 0 || (size_t)originStop >= stopCount ||
+        (size_t)destinationStop >= stopCount || originStop == destinationStop) return {};
+
+    // Arrival and label per round and stop; round 0 is being at the origin
+    const float never = std::numeric_limits<float>::max();
+    std::vector<float> arrivals((MaxRounds + 1) * stopCount, never);
+    std::vector<Label> labels((MaxRounds + 1) * stopCount);
+    std::vector<float> best(stopCount, never);
+    std::vector<uint8_t> marked(stopCount, 0);
+    std::vector<uint32_t> scanFrom(m_Routes.size(), UINT32_MAX);
+    std::vector<int32_t> markedStops = { originStop };
+    std::vector<uint32_t> queuedRoutes;
+    std::vector<Walk> walks;
+    arrivals[originStop] = best[originStop] = time;
+
+    int bestRound = 0;
+    for (int round = 1; round <= MaxRounds && !markedStops.empty(); round++) {
+        const float* previous = arrivals.data() + (round - 1) * stopCount;
+        float* current = arrivals.data() + round * stopCount;
+        Label* currentLabels = labels.data() + round * stopCount;
+        std::copy(previous, previous + stopCount, current);
+
+        // Every route through a stop improved last round, from its first such stop
+        queuedRoutes.clear();
+        for (int32_t stop : markedStops) {
+            marked[stop] = 0;
+            for (uint32_t i = m_StopRouteOffsets[stop]; i < m_StopRouteOffsets[stop + 1]; i++) {
+                const RouteVisit& visit = m_StopRoutes[i];
+                if (scanFrom[visit.route] == UINT32_MAX) queuedRoutes.push_back(visit.route);
+                scanFrom[visit.route] = std::min(scanFrom[visit.route], visit.index);
+            }
+        }
+        markedStops.clear();
+
+        for (uint32_t routeIndex : queuedRoutes) {
+            const Route& route = m_Routes[routeIndex];
+            uint32_t first = scanFrom[routeIndex];
+            scanFrom[routeIndex] = UINT32_MAX;
+
+            int trip = -1;
+            uint32_t boardIndex = 0;
+            for (uint32_t index = first; index < route.stopCount; index++) {
+                int32_t stop = m_RouteStops[route.firstStop + index];
+                const StopTime* stopTimes = m_StopTimes.data() + route.firstStopTime + index;
+
+                // Ride on: improves the stop unless it, or the destination, is already reached sooner
+                if (trip >= 0) {
+                    float arrival = stopTimes[(size_t)trip * route.stopCount].arrival;
+                    if (arrival < std::min(best[stop], best[destinationStop])) {
+                        current[stop] = best[stop] = arrival;
+                        currentLabels[stop] = { (int32_t)routeIndex, trip, boardIndex, index };
+                        if (!marked[stop]) {
+                            marked[stop] = 1;
+                            markedStops.push_back(stop);
+                        }
+                    }
+                }
+
+                // Or catch an earlier trip here, if we were at this stop a round ago
+                if (previous[stop] == never) continue;
+                float ready = previous[stop] + (stop == originStop ? 0.0f : TransferTime);
+                if (trip < 0 || ready <= stopTimes[(size_t)trip * route.stopCount].departure) {
+                    int earliest = FindTrip(route, index, ready);
+                    if (earliest >= 0 && (trip < 0 || earliest < trip)) {
+                        trip = earliest;
+                        boardIndex = index;
+                    }
+                }
+            }
+        }
+
+        // Then walk on from every stop this round's trips improved. The walks are
+        // applied afterwards, so each one starts from a trip's arrival.
+        walks.clear();
+        for (int32_t stop : markedStops) {
+            for (uint32_t j = m_TransferOffsets[stop]; j < m_TransferOffsets[stop + 1]; j++) {
+                walks.push_back({ stop, m_Transfers[j].stop, current[stop] + m_Transfers[j].duration });
+            }
+        }
+        for (const Walk& walk : walks) {
+            if (walk.arrival < std::min(best[walk.to], best[destinationStop])) {
+                current[walk.to] = best[walk.to] = walk.arrival;
+                currentLabels[walk.to].walkFrom = walk.from;
+                if (!marked[walk.to]) {
+                    marked[walk.to] = 1;
+                    markedStops.push_back(walk.to);
+                }
+            }
+        }
+
+        const Label& reached = currentLabels[destinationStop];
+        if (reached.route >= 0 || reached.walkFrom >= 0) bestRound = round;
+    }
+    if (bestRound == 0) return {};
+
+    // Walk the labels back from the destination, one trip per round
+    std::vector<Leg> legs;
+    int32_t stop = destinationStop;
+    for (int round = bestRound; round > 0; round--) {
+        const Label* label = &labels[round * stopCount + stop];
+        if (label->walkFrom >= 0) {
+            // On foot from where the trip got off
+            stop = label->walkFrom;
+            label = &labels[round * stopCount + stop];
+        }
+        if (label->route < 0) continue;  // Reached in an earlier round
+        legs.push_back({ label->route, label->trip, label->boardIndex, label->alightIndex,
+                         GetStopTime(label->route, label->trip, label->boardIndex).departure,
+                         GetStopTime(label->route, label->trip, label->alightIndex).arrival });
+        stop = GetRouteStop(label->route, label->boardIndex);
+    }
+    std::reverse(legs.begin(), legs.end());
+    return legs;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "Graph.h"
+#include "Scenario.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bus and tram lines on the road network: stops at nodes, the roads driven
+// between them and a timetable of trips, plus journey planning over it.
+//
+// Journeys are planned with RAPTOR (round-based public transit routing).
+// Round k finds the earliest arrival at every stop using k trips: each line
+// serving a stop improved in round k - 1 is scanned once, in stop order,
+// hopping on the earliest trip that can still be caught. There is no graph
+// search and no priority queue; the timetable is a set of flat arrays (stops
+// per route, stop times per trip, routes per stop) walked front to back.
+//
+// After each round, passengers may walk from a stop they reached by trip to
+// any stop within WalkDistance (RAPTOR's footpaths). Walks are not chained,
+// and a stop already reached sooner is not walked on from.
+//
+// A line runs one way from its first stop to its last and is one RAPTOR route:
+// its trips all stop at the same stops and never overtake each other.
+// Built once per network and scenario, read-only after that.
+class TransitNetwork {
+public:
+    static constexpr float CruiseSpeed = 5.0f;      // Speed between stops, as ResolveVehicle drives
+    static constexpr float ScheduleSlack = 1.3f;    // Timetabled driving time over free flow, for signals and traffic
+    static constexpr float TransferTime = 30.0f;    // Seconds from alighting to boarding another line
+    static constexpr float WalkDistance = 15.0f;    // Passengers walk between stops up to this far apart
+    static constexpr float WalkSpeed = 1.2f;
+    static constexpr int MaxRounds = 4;             // Trips per journey
+    static constexpr int GeneratedStopSpacing = 3;  // Nodes between the stops of generated lines
+
+    struct Line {
+        TransitMode mode;
+        std::vector<int> nodePath;                // First stop to last
+        std::vector<uint32_t> stopPathIndices;    // Index in nodePath of every stop
+    };
+
+    struct StopTime {
+        float arrival;    // Simulation seconds
+        float departure;
+    };
+
+    // One trip of a journey. Positions are indices along the route's stops; if
+    // the next leg boards at another stop, the passenger walks there.
+    struct Leg {
+        int32_t route;
+        int32_t trip;
+        uint32_t boardIndex;
+        uint32_t alightIndex;
+        float departure;
+        float arrival;
+    };
+
+    // Lines the scenario lists, then its generated ones, with trips every
+    // headway until the service ends. Lines without a road between two of
+    // their stops are reported and left out.
+    void Build(std::shared_ptr<Graph> graph, const Scenario& scenario, uint32_t seed);
+
+    // Earliest arrival from one stop at another, leaving at 'time' or later;
+    // of equally early journeys the one with the fewest trips. Empty if none.
+    // The last leg may end at a stop within walking distance of the destination.
+    std::vector<Leg> FindJourney(int originStop, int destinationStop, float time) const;
+
+    size_t GetRouteCount() const { return m_Routes.size(); }
+    size_t GetStopCount() const { return m_StopNodes.size(); }
+    size_t GetTripCount() const;
+    const Line& GetLine(int route) const { return m_Lines[route]; }
+    uint32_t GetRouteStopCount(int route) const { return m_Routes[route].stopCount; }
+    uint32_t GetTripCount(int route) const { return m_Routes[route].tripCount; }
+    int GetRouteStop(int route, uint32_t index) const { return m_RouteStops[m_Routes[route].firstStop + index]; }
+    const StopTime& GetStopTime(int route, int trip, uint32_t index) const {
+        const Route& r = m_Routes[route];
+        return m_StopTimes[r.firstStopTime + (size_t)trip * r.stopCount + index];
+    }
+    int GetStopNode(int stop) const { return m_StopNodes[stop]; }
+    // Seconds on foot between two stops, 0 for the same stop, negative if too far
+    float GetWalkTime(int fromStop, int toStop) const;
+
+    static float GetDwellTime(TransitMode mode) { return mode == TransitMode::Tram ? 8.0f : 12.0f; }
+    static int GetCapacity(TransitMode mode) { return mode == TransitMode::Tram ? 150 : 60; }
+
+private:
+    struct Route {
+        uint32_t firstStop;      // Into m_RouteStops
+        uint32_t stopCount;
+        uint32_t firstStopTime;  // Into m_StopTimes; trip t's stops follow trip t - 1's
+        uint32_t tripCount;
+    };
+
+    // A route calling at a stop, 'index' stops after the route's first
+    struct RouteVisit {
+        uint32_t route;
+        uint32_t index;
+    };
+
+    struct Transfer {
+        int32_t stop;
+        float duration;  // Seconds
+    };
+
+    void BuildTransfers(const Graph& graph);
+    bool AddLine(const std::shared_ptr<Graph>& graph, TransitMode mode, const std::vector<int>& stopNodes,
+                 float headway, float serviceEnd);
+    int GetOrAddStop(int nodeId);
+    // First trip leaving the route's stop 'index' at 'time' or later, -1 if none
+    int FindTrip(const Route& route, uint32_t index, float time) const;
+
+    std::vector<Line> m_Lines;         // Per route
+    std::vector<Route> m_Routes;
+    std::vector<int32_t> m_RouteStops;
+    std::vector<StopTime> m_StopTimes;
+    std::vector<uint32_t> m_StopRouteOffsets;  // Routes at stop s: m_StopRoutes[offsets[s] .. offsets[s + 1])
+    std::vector<RouteVisit> m_StopRoutes;
+    std::vector<uint32_t> m_TransferOffsets;   // Footpaths from stop s: m_Transfers[offsets[s] .. offsets[s + 1])
+    std::vector<Transfer> m_Transfers;
+    std::vector<int32_t> m_StopNodes;  // Stop -> node ID
+    std::vector<int32_t> m_NodeStops;  // Node ID -> stop, -1 if none
+};
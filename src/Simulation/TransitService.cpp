@@ -0,0 +1,202 @@
+#include "TransitService.h"
+#include "../Core/BinaryStream.h"
+#include <algorithm>
+
+TransitService::TransitService(std::shared_ptr<const TransitNetwork> network)
+    : m_Network(std::move(network)) {
+    m_NextTrip.assign(m_Network->GetRouteCount(), 0);
+    m_Waiting.resize(m_Network->GetStopCount());
+}
+
+void TransitService::TakeDepartures(double time, std::vector<Trip>& trips) {
+    for (int route = 0; route < (int)m_NextTrip.size(); route++) {
+        uint32_t& trip = m_NextTrip[route];
+        while (trip < m_Network->GetTripCount(route) && m_Network->GetStopTime(route, trip, 0).arrival <= time) {
+            trips.push_back({ route, (int32_t)trip++ });
+        }
+    }
+}
+
+void TransitService::AddVehicle(int vehicleId, const Trip& trip) {
+    m_Vehicles.push_back({ vehicleId, trip, 0, {} });
+}
+
+float TransitService::OnStopsReached(int vehicleId, uint32_t stopsReached, double time) {
+    auto it = std::find_if(m_Vehicles.begin(), m_Vehicles.end(),
+        [vehicleId](const ServiceVehicle& vehicle) { return vehicle.vehicleId == vehicleId; });
+    if (it == m_Vehicles.end() || it->stopsServed >= stopsReached) return 0.0f;
+
+    uint32_t stopCount = m_Network->GetRouteStopCount(it->trip.route);
+    stopsReached = std::min(stopsReached, stopCount);
+    while (it->stopsServed < stopsReached) {
+        ServeStop(*it, it->stopsServed++, time);
+    }
+
+    if (it->stopsServed == stopCount) {
+        // End of the line
+        m_Vehicles.erase(it);
+        return 0.0f;
+    }
+    const auto& stopTime = m_Network->GetStopTime(it->trip.route, it->trip.trip, it->stopsServed - 1);
+    return std::max((float)(stopTime.departure - time), 0.0f);
+}
+
+void TransitService::ServeStop(ServiceVehicle& vehicle, uint32_t index, double time) {
+    int route = vehicle.trip.route;
+    int stop = m_Network->GetRouteStop(route, index);
+    std::vector<Passenger>& waiting = m_Waiting[stop];
+
+    // Off first: done, or waiting here or nearby for the next leg
+    auto stays = std::stable_partition(vehicle.riders.begin(), vehicle.riders.end(),
+        [index](const Passenger& passenger) { return passenger.legs[passenger.legIndex].alightIndex != index; });
+    for (auto it = stays; it != vehicle.riders.end(); ++it) {
+        Passenger& passenger = *it;
+        m_Statistics.riding--;
+        if (++passenger.legIndex == passenger.legCount) {
+            // Walking the rest of the way if the trip ended near the destination
+            float walk = std::max(m_Network->GetWalkTime(stop, passenger.destinationStop), 0.0f);
+            m_Statistics.completed++;
+            m_Statistics.journeyTime += time + walk - passenger.requestTime;
+            m_Statistics.plannedTime += passenger.plannedArrival - passenger.requestTime;
+        } else {
+            const TransitNetwork::Leg& next = passenger.legs[passenger.legIndex];
+            int nextStop = m_Network->GetRouteStop(next.route, next.boardIndex);
+            passenger.readyTime = (float)time + std::max(m_Network->GetWalkTime(stop, nextStop), 0.0f);
+            m_Waiting[nextStop].push_back(passenger);
+            m_Statistics.waiting++;
+        }
+    }
+    vehicle.riders.erase(stays, vehicle.riders.end());
+
+    // Then on, in order of arrival, while there is room
+    size_t capacity = (size_t)TransitNetwork::GetCapacity(m_Network->GetLine(route).mode);
+    auto boarding = std::stable_partition(waiting.begin(), waiting.end(),
+        [&](const Passenger& passenger) {
+            const TransitNetwork::Leg& leg = passenger.legs[passenger.legIndex];
+            return leg.route != route || leg.boardIndex != index || passenger.readyTime > time;
+        });
+    size_t boarded = std::min<size_t>(waiting.end() - boarding, capacity - std::min(capacity, vehicle.riders.size()));
+    vehicle.riders.insert(vehicle.riders.end(), boarding, boarding + boarded);
+    waiting.erase(boarding, boarding + boarded);
+    m_Statistics.waiting -= boarded;
+    m_Statistics.riding += boarded;
+}
+
+void TransitService::SpawnPassengers(double time, float deltaTime, float demand, std::mt19937& rng) {
+    size_t stopCount = m_Network->GetStopCount();
+    if (stopCount < 2) return;
+
+    m_DemandCarry += demand * deltaTime / 60.0;
+    std::uniform_int_distribution<int> stops(0, (int)stopCount - 1);
+    for (; m_DemandCarry >= 1.0; m_DemandCarry -= 1.0) {
+        int origin = stops(rng);
+        int destination = stops(rng);
+        if (destination == origin) destination = (destination + 1) % (int)stopCount;
+
+        m_Statistics.requested++;
+        std::vector<TransitNetwork::Leg> legs = m_Network->FindJourney(origin, destination, (float)time);
+        if (legs.empty()) {
+            m_Statistics.unserved++;
+            continue;
+        }
+
+        Passenger passenger = {};
+        passenger.id = m_NextPassengerId++;
+        passenger.legCount = (uint32_t)legs.size();
+        passenger.requestTime = (float)time;
+        passenger.destinationStop = destination;
+        int lastStop = m_Network->GetRouteStop(legs.back().route, legs.back().alightIndex);
+        passenger.plannedArrival = legs.back().arrival + std::max(m_Network->GetWalkTime(lastStop, destination), 0.0f);
+        passenger.readyTime = (float)time;
+        std::copy(legs.begin(), legs.end(), passenger.legs);
+        m_Waiting[origin].push_back(passenger);
+        m_Statistics.waiting++;
+    }
+}
+
+bool TransitService::IsValid(const Passenger& passenger) const {
+    if (passenger.destinationStop < 0 || (size_t)passenger.destinationStop >= m_Network->GetStopCount() ||
+        passenger.legCount == 0 || passenger.legCount > (uint32_t)TransitNetwork::MaxRounds ||
+        passenger.legIndex >= passenger.legCount) return false;
+    for (uint32_t i = 0; i < passenger.legCount; i++) {
+        const TransitNetwork::Leg& leg = passenger.legs[i];
+        if (leg.route < 0 || (size_t)leg.route >= m_Network->GetRouteCount()) return false;
+        uint32_t stopCount = m_Network->GetRouteStopCount(leg.route);
+        if (leg.boardIndex >= stopCount || leg.alightIndex >= stopCount) return false;
+    }
+    return true;
+}
+
+void TransitService::Save(BinaryWriter& writer) const {
+    writer.WriteArray(m_NextTrip);
+    writer.Write(m_Statistics);
+    writer.Write(m_DemandCarry);
+    writer.Write(m_NextPassengerId);
+
+    writer.Write<uint64_t>(m_Vehicles.size());
+    for (const auto& vehicle : m_Vehicles) {
+        writer.Write(vehicle.vehicleId);
+        writer.Write(vehicle.trip);
+        writer.Write(vehicle.stopsServed);
+        writer.WriteArray(vehicle.riders);
+    }
+
+    writer.Write<uint64_t>(m_Waiting.size());
+    for (const auto& waiting : m_Waiting) {
+        writer.WriteArray(waiting);
+    }
+}
+
+bool TransitService::Load(BinaryReader& reader) {
+    std::vector<uint32_t> nextTrip;
+    Statistics statistics;
+    double demandCarry = 0.0;
+    int32_t nextPassengerId = 0;
+    reader.ReadArray(nextTrip);
+    reader.Read(statistics);
+    reader.Read(demandCarry);
+    reader.Read(nextPassengerId);
+
+    uint64_t vehicleCount = 0;
+    reader.Read(vehicleCount);
+    std::vector<ServiceVehicle> vehicles;
+    for (uint64_t i = 0; i < vehicleCount && reader.IsOk(); i++) {
+        ServiceVehicle vehicle;
+        reader.Read(vehicle.vehicleId);
+        reader.Read(vehicle.trip);
+        reader.Read(vehicle.stopsServed);
+        reader.ReadArray(vehicle.riders);
+        vehicles.push_back(std::move(vehicle));
+    }
+
+    uint64_t stopCount = 0;
+    reader.Read(stopCount);
+    if (!reader.IsOk() || stopCount != m_Network->GetStopCount() || nextTrip.size() != m_Network->GetRouteCount()) return false;
+    std::vector<std::vector<Passenger>> waiting(m_Network->GetStopCount());
+    for (auto& passengers : waiting) {
+        reader.ReadArray(passengers);
+    }
+    if (!reader.IsOk()) return false;
+
+    // Everything must refer to this timetable
+    for (const auto& vehicle : vehicles) {
+        if (vehicle.trip.route < 0 || (size_t)vehicle.trip.route >= m_Network->GetRouteCount() ||
+            vehicle.trip.trip < 0 || (uint32_t)vehicle.trip.trip >= m_Network->GetTripCount(vehicle.trip.route)) return false;
+        for (const auto& passenger : vehicle.riders) {
+            if (!IsValid(passenger)) return false;
+        }
+    }
+    for (const auto& passengers : waiting) {
+        for (const auto& passenger : passengers) {
+            if (!IsValid(passenger)) return false;
+        }
+    }
+
+    m_NextTrip = std::move(nextTrip);
+    m_Statistics = statistics;
+    m_DemandCarry = demandCarry;
+    m_NextPassengerId = nextPassengerId;
+    m_Vehicles = std::move(vehicles);
+    m_Waiting = std::move(waiting);
+    return true;
+}
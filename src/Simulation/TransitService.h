@@ -0,0 +1,90 @@
+#pragma once
+#include "TransitNetwork.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+class BinaryWriter;
+class BinaryReader;
+
+// Runs a TransitNetwork's timetable inside one simulation: sends trips out as
+// they become due and moves passengers. Passengers turn up at random stops at
+// the scenario's demand rate, get a journey from RAPTOR and wait at their stop
+// for a vehicle of the planned line (any trip of it: the real ones can run
+// late). They ride it to the planned stop, change (walking to the next stop
+// if it is another one), and are done when the last leg ends.
+//
+// Driving is left to the simulation, where transit vehicles are ordinary
+// Vehicles with scheduled stops. After every tick it reports how many stops
+// each has reached, and holds them there until the timetabled departure so
+// none leaves its passengers behind by running early.
+class TransitService {
+public:
+    struct Trip {
+        int32_t route;
+        int32_t trip;
+    };
+
+    struct Statistics {
+        uint64_t requested = 0;    // Journeys asked for
+        uint64_t unserved = 0;     // Of those, the ones the timetable has no journey for
+        uint64_t completed = 0;
+        double journeyTime = 0.0;  // Request to arrival, summed over the completed journeys
+        double plannedTime = 0.0;  // The same as the timetable promised it
+        uint64_t waiting = 0;
+        uint64_t riding = 0;
+    };
+
+    explicit TransitService(std::shared_ptr<const TransitNetwork> network);
+
+    // Trips due to enter service by 'time', each returned once, route by route
+    void TakeDepartures(double time, std::vector<Trip>& trips);
+    // The vehicle now runs the trip
+    void AddVehicle(int vehicleId, const Trip& trip);
+    // Alights and boards at the stops the vehicle reached since the last call
+    // ('stopsReached' counts from its first stop). Returns the seconds it should
+    // hold at the stop it has just reached to keep to the timetable.
+    float OnStopsReached(int vehicleId, uint32_t stopsReached, double time);
+    // New passengers for a tick of 'deltaTime', at 'demand' journeys per minute
+    void SpawnPassengers(double time, float deltaTime, float demand, std::mt19937& rng);
+
+    const TransitNetwork& GetNetwork() const { return *m_Network; }
+    const Statistics& GetStatistics() const { return m_Statistics; }
+    size_t GetVehicleCount() const { return m_Vehicles.size(); }
+
+    // Checkpointing: trips in service, passengers and counters. Loading fails,
+    // leaving the service as it was, if they do not fit this timetable.
+    void Save(BinaryWriter& writer) const;
+    bool Load(BinaryReader& reader);
+
+private:
+    struct Passenger {
+        int32_t id;
+        int32_t destinationStop;
+        uint32_t legIndex;  // Leg being waited for or ridden
+        uint32_t legCount;
+        float requestTime;
+        float plannedArrival;
+        float readyTime;    // Walking to the stop waited at until then
+        TransitNetwork::Leg legs[TransitNetwork::MaxRounds];
+    };
+
+    struct ServiceVehicle {
+        int32_t vehicleId;
+        Trip trip;
+        uint32_t stopsServed;
+        std::vector<Passenger> riders;
+    };
+
+    void ServeStop(ServiceVehicle& vehicle, uint32_t index, double time);
+    bool IsValid(const Passenger& passenger) const;
+
+    std::shared_ptr<const TransitNetwork> m_Network;
+    std::vector<uint32_t> m_NextTrip;               // Per route, the first trip not sent out yet
+    std::vector<ServiceVehicle> m_Vehicles;         // In service, in departure order
+    std::vector<std::vector<Passenger>> m_Waiting;  // Per stop, in order of arrival
+    Statistics m_Statistics;
+    double m_DemandCarry = 0.0;  // Passengers owed to the next tick, below one
+    int32_t m_NextPassengerId = 0;
+};
@@ -1,145 +1,396 @@
 #include "TransportSimulation.h"
+#include "GridGenerator.h"
+#include "NetworkFile.h"
+#include "OsmImporter.h"
+#include "../Core/Log.h"
+#include "../Core/Profiler.h"
 #include <iostream>
+#include <limits>
 #include <random>
 #include <algorithm>
+#include <thread>
 
 TransportSimulation::TransportSimulation() {
     m_Graph = std::make_shared<Graph>();
+    SetSeed(std::random_device()());
 }
 
-void TransportSimulation::Initialize() {
-    CreateRoadNetwork();
-    SpawnInitialVehicles();
+void TransportSimulation::SetSeed(uint32_t seed) {
+    // Independent streams so signal setup does not shift the spawn sequence
+    m_Seed = seed;
+    m_SpawnRng.seed(seed);
+    m_SignalRng.seed(seed ^ 0x9E3779B9u);
+    m_TransitRng.seed(seed ^ 0x85EBCA6Bu);
 }
 
-void TransportSimulation::CreateRoadNetwork() {
-    // Create 20x20 grid
-    const int gridSize = 20;
-    const float spacing = 10.0f;
-    
-    // Create nodes (intersections)
-    std::vector<std::vector<int>> nodeGrid(gridSize, std::vector<int>(gridSize));
-    
-    for (int x = 0; x < gridSize; x++) {
-        for (int z = 0; z < gridSize; z++) {
-            glm::vec3 position(x * spacing, 0.0f, z * spacing);
-            int nodeId = m_Graph->AddNode(position);
-            nodeGrid[x][z] = nodeId;
+void TransportSimulation::SetScenario(const Scenario& scenario) {
+    m_Scenario = scenario;
+    if (scenario.hasSeed) {
+        SetSeed(scenario.seed);
+    }
+}
+
+void TransportSimulation::Initialize() {
+    if (m_Scenario.network.empty() || !LoadNetwork()) {
+        if (!m_Scenario.network.empty()) {
+            std::cerr << "Falling back to the procedural grid network" << std::endl;
+            m_Graph = std::make_shared<Graph>();
         }
+        CreateRoadNetwork();
     }
+    m_Statistics.Reset(*m_Graph);
+    PrepareRouting();
+    PrepareTransit();
+    m_Partition = std::make_unique<RegionPartition>(*this, m_ThreadCount);
+    BuildSpawnCells();
+    SpawnInitialVehicles();
+}
+
+void TransportSimulation::Initialize(std::shared_ptr<Graph> graph, const SignalTable& signals) {
+    m_Graph = std::move(graph);
+    m_Signals = signals;
+    MarkAllSignalsChanged();
+    m_Statistics.Reset(*m_Graph);
+    PrepareRouting();
+    PrepareTransit();
+    m_Partition = std::make_unique<RegionPartition>(*this, m_ThreadCount);
+    BuildSpawnCells();
+    SpawnInitialVehicles();
+}
+
+bool TransportSimulation::LoadNetwork() {
+    const std::string suffix = ".tsnet";
+    const std::string& path = m_Scenario.network;
+    bool isBinary = path.size() >= suffix.size() &&
+        path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
     
-    // Create roads with mix of one-way and two-way
-    for (int x = 0; x < gridSize; x++) {
-        for (int z = 0; z < gridSize; z++) {
-            // Horizontal roads
-            if (x < gridSize - 1) {
-                if (z % 2 == 0) {
-                    m_Graph->AddBidirectionalEdge(nodeGrid[x][z], nodeGrid[x + 1][z], spacing);
-                } else {
-                    m_Graph->AddEdge(nodeGrid[x][z], nodeGrid[x + 1][z], spacing);
-                }
-            }
-            
-            // Vertical roads
-            if (z < gridSize - 1) {
-                if (x % 2 == 0) {
-                    m_Graph->AddBidirectionalEdge(nodeGrid[x][z], nodeGrid[x][z + 1], spacing);
-                } else {
-                    m_Graph->AddEdge(nodeGrid[x][z], nodeGrid[x][z + 1], spacing);
-                }
+    if (isBinary) {
+        // Prebuilt network: mapped and used in place, including the signal layout
+        NetworkFile file;
+        if (!file.Open(path, m_Scenario.verifyNetwork)) return false;
+        file.BuildGraph(*m_Graph);
+        
+        if (file.GetSignalLayout()) {
+            if (!ApplySignalLayout(file.GetSignalLayout())) {
+                std::cerr << "Network file has an invalid signal layout: " << path << std::endl;
+                return false;
             }
+        } else {
+            InitializeTrafficLights();
         }
+        
+        // Next hops precomputed when the network was exported
+        size_t sectionSize = 0;
+        const uint8_t* section = file.FindSection((uint32_t)NetworkSection::NextHops, sectionSize);
+        auto nextHops = std::make_shared<NextHopTable>();
+        if (section && nextHops->Deserialize(section, sectionSize, m_Graph->GetNodeCount())) {
+            m_NextHops = nextHops;
+        }
+    } else {
+        if (!OsmImporter::Import(path, *m_Graph)) return false;
+        InitializeTrafficLights();
     }
     
-    // Add selective diagonal shortcuts (less frequent for large grid)
-    float diagonalDist = spacing * sqrt(2.0f);
+    std::cout << "Loaded road network with " << m_Graph->GetNodeCount() << " nodes" << std::endl;
+    return true;
+}
+
+bool TransportSimulation::ExportNetwork(const std::string& path) const {
+    std::vector<NetworkFile::ExtraSection> extraSections;
+    if (m_NextHops) {
+        extraSections.push_back({ (uint32_t)NetworkSection::NextHops, m_NextHops->Serialize() });
+    }
+    return NetworkFile::Write(path, *m_Graph, m_Signals, extraSections);
+}
+
+void TransportSimulation::PrepareRouting() {
+    size_t nodeCount = m_Graph->GetNodeCount();
+    RoutingMode mode = m_Scenario.routing;
+    if (mode == RoutingMode::Auto) {
+        mode = nodeCount <= NextHopTable::AutoNodeThreshold ? RoutingMode::Table :
+               nodeCount >= RouteOverlay::AutoNodeThreshold ? RoutingMode::Hierarchical : RoutingMode::AStar;
+    }
     
-    for (int x = 0; x < gridSize - 1; x += 4) { // Every 4th block
-        for (int z = 0; z < gridSize - 1; z += 4) {
-            m_Graph->AddBidirectionalEdge(nodeGrid[x][z], nodeGrid[x + 1][z + 1], diagonalDist);
-            if (x + 1 < gridSize && z + 1 < gridSize) {
-                m_Graph->AddBidirectionalEdge(nodeGrid[x + 1][z], nodeGrid[x][z + 1], diagonalDist);
-            }
-        }
+    // Keep an overlay given to SetRouteOverlay
+    if (mode != RoutingMode::Hierarchical) {
+        m_RouteOverlay.reset();
+    } else if (!m_RouteOverlay || m_RouteOverlay->GetNodeCount() != nodeCount) {
+        auto overlay = std::make_shared<RouteOverlay>(*m_Graph);
+        TS_LOG_INFO(Routing, "Route overlay: %zu cells, %zu arcs", overlay->GetCellCount(), overlay->GetArcCount());
+        m_RouteOverlay = overlay;
     }
     
+    // Keep a table that came with the network file or from SetNextHopTable
+    if (mode != RoutingMode::Table) {
+        m_NextHops.reset();
+        return;
+    }
+    if (m_NextHops && m_NextHops->GetNodeCount() == nodeCount) return;
+    
+    auto nextHops = std::make_shared<NextHopTable>();
+    int threads = std::max((int)std::thread::hardware_concurrency(), m_ThreadCount);
+    if (!nextHops->Build(*m_Graph, threads)) {
+        TS_LOG_WARNING(Routing, "Network too large for a next-hop table, routing with A*");
+        m_NextHops.reset();
+        return;
+    }
+    m_NextHops = nextHops;
+    TS_LOG_INFO(Routing, "Next-hop table: %zu runs, %zu KiB", m_NextHops->GetRunCount(), m_NextHops->GetMemoryBytes() / 1024);
+}
+
+void TransportSimulation::PrepareTransit() {
+    m_Transit.reset();
+    m_TransitVehicles.clear();
+    if (m_Scenario.lines.empty() && m_Scenario.transitLines == 0) return;
+    
+    auto network = std::make_shared<TransitNetwork>();
+    network->Build(m_Graph, m_Scenario, m_Seed);
+    if (network->GetRouteCount() == 0) {
+        TS_LOG_WARNING(Simulation, "No transit line could be laid out on this network");
+        return;
+    }
+    TS_LOG_INFO(Simulation, "Transit: %zu lines, %zu stops, %zu trips",
+                network->GetRouteCount(), network->GetStopCount(), network->GetTripCount());
+    m_Transit = std::make_unique<TransitService>(network);
+}
+
+void TransportSimulation::UpdateTransit(float deltaTime) {
+    TS_PROFILE_SCOPE(ProfilePhase::SimTransit);
+    
+    for (const auto& vehicle : m_TransitVehicles) {
+        float hold = m_Transit->OnStopsReached(vehicle->GetId(), vehicle->GetStopsReached(), m_SimulationTime);
+        if (hold > 0.0f) vehicle->HoldAtStop(hold);
+    }
+    m_TransitVehicles.erase(std::remove_if(m_TransitVehicles.begin(), m_TransitVehicles.end(),
+        [](const std::shared_ptr<Vehicle>& vehicle) { return vehicle->IsDestinationReached(); }), m_TransitVehicles.end());
+    
+    // Due trips enter the roads at their first stop, as ordinary vehicles
+    std::vector<TransitService::Trip> departures;
+    m_Transit->TakeDepartures(m_SimulationTime, departures);
+    for (const auto& trip : departures) {
+        const TransitNetwork::Line& line = m_Transit->GetNetwork().GetLine(trip.route);
+        auto vehicle = std::make_shared<Vehicle>(m_NextVehicleId++);
+        vehicle->SetPath(line.nodePath, *m_Graph);
+        vehicle->SetStops(line.stopPathIndices, TransitNetwork::GetDwellTime(line.mode));
+        m_Vehicles.push_back(vehicle);
+        m_TransitVehicles.push_back(vehicle);
+        m_Statistics.OnSpawn(*vehicle);
+        m_Partition->Insert(vehicle.get());
+        m_Transit->AddVehicle(vehicle->GetId(), trip);
+    }
+    
+    m_Transit->SpawnPassengers(m_SimulationTime, deltaTime, m_Scenario.transitDemand, m_TransitRng);
+}
+
+void TransportSimulation::SetThreadCount(int threadCount) {
+    threadCount = std::max(threadCount, 1);
+    if (threadCount == m_ThreadCount && m_Partition) return;
+    m_ThreadCount = threadCount;
+    if (!m_Partition) return;  // Not initialized yet
+    
+    // Re-partition the network and hand every live vehicle and booked
+    // intersection slot to its new tile
+    std::vector<IntersectionManager::Reservation> reservations = m_Partition->GetReservations();
+    m_Partition.reset();
+    m_Partition = std::make_unique<RegionPartition>(*this, m_ThreadCount);
+    for (const auto& vehicle : m_Vehicles) {
+        m_Partition->Insert(vehicle.get());
+    }
+    for (const auto& reservation : reservations) {
+        m_Partition->RestoreReservation(reservation);
+    }
+    
+    TS_LOG_INFO(Simulation, "Simulation threads: %d", m_ThreadCount);
+}
+
+void TransportSimulation::CreateRoadNetwork() {
+    // Grid of intersections with a mix of one-way and two-way streets and
+    // occasional diagonal shortcuts, as laid out by the scenario
+    GeneratedNetwork network;
+    int threads = std::max((int)std::thread::hardware_concurrency(), m_ThreadCount);
+    GridGenerator::Generate(m_Scenario, m_Seed, threads, network);
+    
+    // The generated arrays become the graph as they are
+    m_Graph->Build(std::move(network.positions), std::move(network.offsets),
+                   std::move(network.targets), std::move(network.weights));
+    ApplySignalLayout(network.signalLayout.data());
+    
+    std::cout << "Created road network with " << m_Graph->GetNodeCount() << " nodes" << std::endl;
+    std::cout << "Grid: " << m_Scenario.gridWidth << "x" << m_Scenario.gridHeight << std::endl;
+}
+
+void TransportSimulation::InitializeTrafficLights() {
+    // Timers and durations carry over when lights are re-enabled
+    m_Signals.lights.resize(m_Graph->GetEdgeCount());
+    m_Signals.intersections.resize(m_Graph->GetNodeCount());
+    
     // Initialize Traffic Lights (Per-Path)
-    for (const auto& [id, node] : m_Graph->GetNodes()) {
-        // Find all incoming edges to this node
-        std::vector<int> incomingNeighbors;
-        for (const auto& [otherId, otherNode] : m_Graph->GetNodes()) {
-            for (const auto& edge : otherNode->edges) {
-                if (edge->to->id == id) {
-                    incomingNeighbors.push_back(otherId);
-                }
-            }
-        }
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    
+    for (int id = 0; id < (int)m_Graph->GetNodeCount(); id++) {
+        IntersectionSignals& signals = m_Signals.intersections[id];
+        auto incoming = m_Graph->GetIncomingEdges(id);
         
         // If it's an intersection (more than 1 incoming road), add lights
-        if (incomingNeighbors.size() > 1 && rand() % 4 == 0) { // 25% chance
-            for (int neighborId : incomingNeighbors) {
-                node->incomingLights[neighborId] = TrafficLightState::RED;
+        if (incoming.size() > 1 && chance(m_SignalRng) < m_Scenario.signalDensity) {
+            for (uint32_t edgeId : incoming) {
+                m_Signals.lights[edgeId] = TrafficLightState::RED;
             }
             
-            // Set one random neighbor to GREEN initially
-            if (!incomingNeighbors.empty()) {
-                int greenIdx = rand() % incomingNeighbors.size();
-                node->currentGreenNodeId = incomingNeighbors[greenIdx];
-                node->incomingLights[node->currentGreenNodeId] = TrafficLightState::GREEN;
-            }
+            // Set one random road to GREEN initially
+            int greenIdx = m_SignalRng() % incoming.size();
+            signals.greenEdge = (int32_t)incoming[greenIdx];
+            m_Signals.lights[signals.greenEdge] = TrafficLightState::GREEN;
         } else {
             // No lights (OFF)
-            for (int neighborId : incomingNeighbors) {
-                node->incomingLights[neighborId] = TrafficLightState::OFF;
+            for (uint32_t edgeId : incoming) {
+                m_Signals.lights[edgeId] = TrafficLightState::OFF;
             }
+            signals.greenEdge = -1;
         }
     }
+    MarkAllSignalsChanged();
+}
+
+bool TransportSimulation::ApplySignalLayout(const int32_t* greenNeighbor) {
+    int nodeCount = (int)m_Graph->GetNodeCount();
+    m_Signals.lights.assign(m_Graph->GetEdgeCount(), TrafficLightState::OFF);
+    m_Signals.intersections.assign(nodeCount, IntersectionSignals());
+    MarkAllSignalsChanged();
     
-    std::cout << "Created road network with " << m_Graph->GetNodeCount() << " nodes" << std::endl;
-    std::cout << "Grid: " << gridSize << "x" << gridSize << std::endl;
+    for (int id = 0; id < nodeCount; id++) {
+        if (greenNeighbor[id] == -1) continue;
+        
+        IntersectionSignals& signals = m_Signals.intersections[id];
+        for (uint32_t edgeId : m_Graph->GetIncomingEdges(id)) {
+            m_Signals.lights[edgeId] = TrafficLightState::RED;
+            if (m_Graph->GetEdgeSource(edgeId) == greenNeighbor[id] && signals.greenEdge < 0) {
+                signals.greenEdge = (int32_t)edgeId;
+            }
+        }
+        if (signals.greenEdge < 0) {
+            m_Signals.lights.assign(m_Graph->GetEdgeCount(), TrafficLightState::OFF);
+            m_Signals.intersections.assign(nodeCount, IntersectionSignals());
+            return false;
+        }
+        m_Signals.lights[signals.greenEdge] = TrafficLightState::GREEN;
+    }
+    return true;
+}
+
+void TransportSimulation::BuildSpawnCells() {
+    m_SpawnCells = SpawnCells();
+    int nodeCount = (int)m_Graph->GetNodeCount();
+    if (nodeCount == 0) return;
+    
+    glm::vec2 minimum(std::numeric_limits<float>::max());
+    glm::vec2 maximum(std::numeric_limits<float>::lowest());
+    for (int id = 0; id < nodeCount; id++) {
+        const glm::vec3& position = m_Graph->GetPosition(id);
+        minimum.x = std::min(minimum.x, position.x);
+        minimum.y = std::min(minimum.y, position.z);
+        maximum.x = std::max(maximum.x, position.x);
+        maximum.y = std::max(maximum.y, position.z);
+    }
+    
+    SpawnCells cells;
+    cells.origin = minimum;
+    cells.size = std::max(MaxTripBlocks * m_Scenario.spacing, 1.0f);
+    cells.columns = (int)((maximum.x - minimum.x) / cells.size) + 1;
+    cells.rows = (int)((maximum.y - minimum.y) / cells.size) + 1;
+    // A start's neighbourhood already covers the whole network
+    if (cells.columns <= 3 && cells.rows <= 3) return;
+    
+    auto cellOf = [&](int id) {
+        const glm::vec3& position = m_Graph->GetPosition(id);
+        int column = std::min((int)((position.x - cells.origin.x) / cells.size), cells.columns - 1);
+        int row = std::min((int)((position.z - cells.origin.y) / cells.size), cells.rows - 1);
+        return row * cells.columns + column;
+    };
+    cells.offsets.assign((size_t)cells.columns * cells.rows + 1, 0);
+    for (int id = 0; id < nodeCount; id++) {
+        cells.offsets[cellOf(id) + 1]++;
+    }
+    for (size_t cell = 1; cell < cells.offsets.size(); cell++) {
+        cells.offsets[cell] += cells.offsets[cell - 1];
+    }
+    cells.nodes.resize(nodeCount);
+    std::vector<uint32_t> next(cells.offsets.begin(), cells.offsets.end() - 1);
+    for (int id = 0; id < nodeCount; id++) {
+        cells.nodes[next[cellOf(id)]++] = id;
+    }
+    m_SpawnCells = std::move(cells);
+}
+
+int TransportSimulation::DrawNearbyNode(int startNodeId) {
+    const SpawnCells& cells = m_SpawnCells;
+    const glm::vec3& position = m_Graph->GetPosition(startNodeId);
+    int column = std::min((int)((position.x - cells.origin.x) / cells.size), cells.columns - 1);
+    int row = std::min((int)((position.z - cells.origin.y) / cells.size), cells.rows - 1);
+    
+    std::uniform_int_distribution<int> neighbour(0, 8);
+    int offset = neighbour(m_SpawnRng);
+    column += offset % 3 - 1;
+    row += offset / 3 - 1;
+    if (column < 0 || column >= cells.columns || row < 0 || row >= cells.rows) return -1;
+    
+    int cell = row * cells.columns + column;
+    uint32_t count = cells.offsets[cell + 1] - cells.offsets[cell];
+    if (count == 0) return -1;
+    std::uniform_int_distribution<uint32_t> pick(0, count - 1);
+    return cells.nodes[cells.offsets[cell] + pick(m_SpawnRng)];
 }
 
 void TransportSimulation::SpawnInitialVehicles() {
-    // Initial spawn
-    const int initialVehicles = 150;
-    for (int i = 0; i < initialVehicles; i++) {
-        SpawnVehicle();
+    // Nothing has moved yet, so occupied start nodes are tracked directly
+    // instead of scanning every vehicle spawned so far
+    std::vector<uint8_t> occupiedStarts(m_Graph->GetNodeCount(), 0);
+    for (int i = 0; i < m_Scenario.initialVehicles; i++) {
+        SpawnVehicle(&occupiedStarts);
     }
 }
 
 void TransportSimulation::SpawnVehicle() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    SpawnVehicle(nullptr);
+}
+
+void TransportSimulation::SpawnVehicle(std::vector<uint8_t>* occupiedStarts) {
     std::uniform_int_distribution<> dis(0, (int)m_Graph->GetNodeCount() - 1);
     
-    int startNodeId = dis(gen);
-    auto startNode = m_Graph->GetNode(startNodeId);
-    if (!startNode) return;
+    int startNodeId = dis(m_SpawnRng);
+    if (!m_Graph->HasNode(startNodeId)) return;
     
     // Check if node is already occupied
-    for (const auto& v : m_Vehicles) {
-        if (glm::length(v->GetPosition() - startNode->position) < 5.0f) {
-            return; // Node occupied, skip spawn
+    if (occupiedStarts) {
+        if ((*occupiedStarts)[startNodeId]) return;
+    } else {
+        // Within 5 units of the node along the edge being driven, on either end
+        for (const auto& v : m_Vehicles) {
+            if (!m_Graph->HasEdge(v->GetCurrentEdgeId())) continue;
+            if ((v->GetFromNodeId() == startNodeId && v->GetOffset() < 5.0f) ||
+                (v->GetTargetNodeId() == startNodeId && m_Graph->GetEdgeLength(v->GetCurrentEdgeId()) - v->GetOffset() < 5.0f)) {
+                return; // Node occupied, skip spawn
+            }
         }
     }
     
     // Find a valid goal node within distance range (5-70 blocks)
-    // Since grid spacing is 10.0f, 5 blocks = 50.0f, 70 blocks = 700.0f
     int goalNodeId = -1;
     int attempts = 0;
     
     while (attempts < 20) {
-        int candidateId = dis(gen);
+        int candidateId = m_SpawnCells.nodes.empty() ? dis(m_SpawnRng) : DrawNearbyNode(startNodeId);
         if (candidateId == startNodeId) continue;
-        
-        auto candidateNode = m_Graph->GetNode(candidateId);
-        if (!candidateNode) continue;
+        if (candidateId < 0) {
+            attempts++;
+            continue;
+        }
         
         // Manhattan distance approximation for grid blocks
-        float dist = glm::length(candidateNode->position - startNode->position);
-        float blocks = dist / 10.0f; // spacing is 10.0f
+        float dist = glm::length(m_Graph->GetPosition(candidateId) - m_Graph->GetPosition(startNodeId));
+        float blocks = dist / m_Scenario.spacing;
         
-        if (blocks >= 5.0f && blocks <= 70.0f) {
+        if (blocks >= MinTripBlocks && blocks <= MaxTripBlocks) {
             goalNodeId = candidateId;
             break;
         }
@@ -148,338 +399,409 @@ void TransportSimulation::SpawnVehicle() {
     
     if (goalNodeId == -1) return; // Could not find valid goal
     
-    auto vehicle = std::make_shared<Vehicle>(m_NextVehicleId++, startNode->position);
+    auto vehicle = std::make_shared<Vehicle>(m_NextVehicleId++);
     
-    auto path = Pathfinding::AStar(m_Graph, startNodeId, goalNodeId);
-    if (!path.empty()) {
-        vehicle->SetPath(path, m_Graph);
+    if (PlanRoute(*vehicle, startNodeId, goalNodeId)) {
         m_Vehicles.push_back(vehicle);
+        m_Statistics.OnSpawn(*vehicle);
+        m_Partition->Insert(vehicle.get());
+        if (occupiedStarts) (*occupiedStarts)[startNodeId] = 1;
     }
 }
 
-// Helper to count vehicles on a specific edge (approaching 'toNode' from 'fromNode')
-int GetVehicleCountOnEdge(const std::vector<std::shared_ptr<Vehicle>>& vehicles, int fromId, int toId, std::shared_ptr<Graph> graph) {
-    int count = 0;
-    auto fromNode = graph->GetNode(fromId);
-    auto toNode = graph->GetNode(toId);
-    if (!fromNode || !toNode) return 0;
+bool TransportSimulation::PlanRoute(Vehicle& vehicle, int startNodeId, int goalNodeId) const {
+    if (m_NextHops) {
+        std::vector<int> path = m_NextHops->FindPath(*m_Graph, startNodeId, goalNodeId);
+        if (!path.empty()) {
+            vehicle.SetPath(path, *m_Graph);
+            return true;
+        }
+    }
     
-    for (const auto& v : vehicles) {
-        if (v->IsDestinationReached()) continue;
-        
-        // Check if vehicle is on this edge segment
-        // Simple check: Vehicle is close to fromNode or between fromNode and toNode
-        // Better check: Look at vehicle's current path target
-        const auto& path = v->GetNodePath();
-        size_t idx = v->GetCurrentWaypointIndex();
-        
-        if (idx < path.size()) {
-            int targetId = path[idx];
-            // If vehicle is targeting 'toNode'
-            if (targetId == toId) {
-                // And it's coming from 'fromNode' direction (check distance)
-                float distToTarget = glm::length(v->GetPosition() - toNode->position);
-                float distFromSource = glm::length(v->GetPosition() - fromNode->position);
-                float edgeLen = glm::length(toNode->position - fromNode->position);
-                
-                // If within the edge bounds
-                if (distToTarget <= edgeLen && distFromSource <= edgeLen) {
-                    count++;
-                }
-            }
+    if (m_RouteOverlay) {
+        std::vector<int32_t> corridor = m_RouteOverlay->FindCorridor(startNodeId, goalNodeId);
+        size_t reached = 0;
+        std::vector<int> path = corridor.empty() ? std::vector<int>() :
+            m_RouteOverlay->Refine(*m_Graph, startNodeId, goalNodeId, corridor, 0, reached);
+        if (path.size() > 1) {
+            vehicle.SetPath(path, *m_Graph);
+            vehicle.SetPlan(goalNodeId, std::move(corridor), reached);
+            return true;
         }
     }
-    return count;
+    
+    auto path = Pathfinding::AStar(m_Graph, startNodeId, goalNodeId);
+    if (path.empty()) return false;
+    vehicle.SetPath(path, *m_Graph);
+    return true;
 }
 
-void TransportSimulation::Update(float deltaTime) {
-    // 1. Update Traffic Lights (Sensor Based)
-    if (m_TrafficLightsEnabled) {
-        for (const auto& [id, node] : m_Graph->GetNodes()) {
-            // Skip nodes without active lights
-            bool hasActiveLights = false;
-            for (const auto& [neighbor, state] : node->incomingLights) {
-                if (state != TrafficLightState::OFF) {
-                    hasActiveLights = true;
-                    break;
+void TransportSimulation::RefineRoute(Vehicle& vehicle) const {
+    int lastNodeId = vehicle.GetNodePath().back();
+    size_t reached = 0;
+    std::vector<int> path;
+    if (m_RouteOverlay) {
+        path = m_RouteOverlay->Refine(*m_Graph, lastNodeId, vehicle.GetGoalNodeId(),
+                                      vehicle.GetCorridor(), vehicle.GetCorridorIndex(), reached);
+    }
+    if (path.size() < 2) {
+        // No way through the corridor (or restored without an overlay): plan the rest in full
+        path = Pathfinding::AStar(m_Graph, lastNodeId, vehicle.GetGoalNodeId());
+    }
+    vehicle.ExtendPath(path, reached);
+}
+
+static bool HasActiveLights(const Graph& graph, const SignalTable& signals, int nodeId) {
+    for (uint32_t edgeId : graph.GetIncomingEdges(nodeId)) {
+        if (signals.lights[edgeId] != TrafficLightState::OFF) return true;
+    }
+    return false;
+}
+
+void TransportSimulation::TakeChangedSignals(std::vector<uint32_t>& edges) {
+    for (uint32_t edgeId : m_ChangedSignals) {
+        m_SignalChanged[edgeId] = 0;
+    }
+    edges.insert(edges.end(), m_ChangedSignals.begin(), m_ChangedSignals.end());
+    m_ChangedSignals.clear();
+}
+
+void TransportSimulation::MarkSignalsChanged(int nodeId) {
+    for (uint32_t edgeId : m_Graph->GetIncomingEdges(nodeId)) {
+        if (m_SignalChanged[edgeId]) continue;
+        m_SignalChanged[edgeId] = 1;
+        m_ChangedSignals.push_back(edgeId);
+    }
+}
+
+void TransportSimulation::MarkAllSignalsChanged() {
+    m_SignalChanged.assign(m_Signals.lights.size(), 1);
+    m_ChangedSignals.resize(m_Signals.lights.size());
+    for (size_t i = 0; i < m_ChangedSignals.size(); i++) {
+        m_ChangedSignals[i] = (uint32_t)i;
+    }
+}
+
+bool TransportSimulation::UpdateTrafficLight(int nodeId, const EdgeBuckets& vehicles, float deltaTime) {
+    // Skip nodes without active lights
+    if (!HasActiveLights(*m_Graph, m_Signals, nodeId)) return false;
+    
+    IntersectionSignals& signals = m_Signals.intersections[nodeId];
+    auto& lights = m_Signals.lights;
+    auto incoming = m_Graph->GetIncomingEdges(nodeId);
+    
+    signals.lightTimer += deltaTime;
+    
+    // State Machine for the Intersection
+    // We only switch phases if:
+    // a) Current green lane is empty AND another lane has cars
+    // b) Max green duration exceeded AND another lane has cars
+    // c) Yellow phase complete
+    
+    // Find current green road
+    int currentGreen = signals.greenEdge;
+    
+    // Check if we are in Yellow phase
+    bool isYellow = false;
+    if (currentGreen != -1 && lights[currentGreen] == TrafficLightState::YELLOW) {
+        isYellow = true;
+    }
+    
+    if (isYellow) {
+        if (signals.lightTimer >= 2.0f) {
+            // Switch to Red, then pick next Green
+            lights[currentGreen] = TrafficLightState::RED;
+            
+            // Pick next green based on sensor (most cars)
+            int bestEdge = -1;
+            int maxCars = -1;
+            
+            for (uint32_t edgeId : incoming) {
+                if ((int)edgeId == currentGreen) continue; // Don't pick same again immediately
+                
+                int cars = vehicles.GetCount(edgeId);
+                if (cars > maxCars) {
+                    maxCars = cars;
+                    bestEdge = edgeId;
+                }
+            }
+            
+            // If no cars found anywhere, just pick random next or keep red?
+            // Let's pick random if no cars to keep cycle moving (or just wait)
+            if (bestEdge == -1) {
+                // Pick first available
+                for (uint32_t edgeId : incoming) {
+                    if ((int)edgeId != currentGreen) {
+                        bestEdge = edgeId;
+                        break;
+                    }
                 }
             }
-            if (!hasActiveLights) continue;
             
-            node->lightTimer += deltaTime;
+            if (bestEdge != -1) {
+                signals.greenEdge = bestEdge;
+                lights[bestEdge] = TrafficLightState::GREEN;
+                signals.lightTimer = 0.0f;
+            }
+            return true;
+        }
+    } else {
+        // Currently Green
+        if (currentGreen != -1) {
+            int carsOnGreen = vehicles.GetCount(currentGreen);
             
-            // State Machine for the Intersection
-            // We only switch phases if:
-            // a) Current green lane is empty AND another lane has cars
-            // b) Max green duration exceeded AND another lane has cars
-            // c) Yellow phase complete
+            // Check other lanes
+            int maxCarsOther = 0;
+            for (uint32_t edgeId : incoming) {
+                if ((int)edgeId != currentGreen) {
+                    int cars = vehicles.GetCount(edgeId);
+                    if (cars > maxCarsOther) maxCarsOther = cars;
+                }
+            }
             
-            // Find current green neighbor
-            int currentGreen = node->currentGreenNodeId;
+            bool shouldSwitch = false;
             
-            // Check if we are in Yellow phase
-            bool isYellow = false;
-            if (currentGreen != -1 && node->incomingLights[currentGreen] == TrafficLightState::YELLOW) {
-                isYellow = true;
+            // Rule 1: Empty Green Lane & Waiting Cars elsewhere
+            if (carsOnGreen == 0 && maxCarsOther > 0 && signals.lightTimer > signals.minGreenDuration) {
+                shouldSwitch = true;
             }
             
-            if (isYellow) {
-                if (node->lightTimer >= 2.0f) {
-                    // Switch to Red, then pick next Green
-                    node->incomingLights[currentGreen] = TrafficLightState::RED;
-                    
-                    // Pick next green based on sensor (most cars)
-                    int bestNeighbor = -1;
-                    int maxCars = -1;
-                    
-                    for (const auto& [neighbor, state] : node->incomingLights) {
-                        if (neighbor == currentGreen) continue; // Don't pick same again immediately
-                        
-                        int cars = GetVehicleCountOnEdge(m_Vehicles, neighbor, id, m_Graph);
-                        if (cars > maxCars) {
-                            maxCars = cars;
-                            bestNeighbor = neighbor;
-                        }
-                    }
-                    
-                    // If no cars found anywhere, just pick random next or keep red?
-                    // Let's pick random if no cars to keep cycle moving (or just wait)
-                    if (bestNeighbor == -1) {
-                        // Pick first available
-                        for (const auto& [neighbor, state] : node->incomingLights) {
-                            if (neighbor != currentGreen) {
-                                bestNeighbor = neighbor;
-                                break;
-                            }
-                        }
-                    }
-                    
-                    if (bestNeighbor != -1) {
-                        node->currentGreenNodeId = bestNeighbor;
-                        node->incomingLights[bestNeighbor] = TrafficLightState::GREEN;
-                        node->lightTimer = 0.0f;
-                    }
-                }
-            } else {
-                // Currently Green
-                if (currentGreen != -1) {
-                    int carsOnGreen = GetVehicleCountOnEdge(m_Vehicles, currentGreen, id, m_Graph);
-                    
-                    // Check other lanes
-                    int maxCarsOther = 0;
-                    for (const auto& [neighbor, state] : node->incomingLights) {
-                        if (neighbor != currentGreen) {
-                            int cars = GetVehicleCountOnEdge(m_Vehicles, neighbor, id, m_Graph);
-                            if (cars > maxCarsOther) maxCarsOther = cars;
-                        }
-                    }
-                    
-                    bool shouldSwitch = false;
-                    
-                    // Rule 1: Empty Green Lane & Waiting Cars elsewhere
-                    if (carsOnGreen == 0 && maxCarsOther > 0 && node->lightTimer > node->minGreenDuration) {
-                        shouldSwitch = true;
-                    }
-                    
-                    // Rule 2: Max Duration Exceeded & Waiting Cars elsewhere
-                    if (node->lightTimer > node->maxGreenDuration && maxCarsOther > 0) {
-                        shouldSwitch = true;
-                    }
-                    
-                    if (shouldSwitch) {
-                        node->incomingLights[currentGreen] = TrafficLightState::YELLOW;
-                        node->lightTimer = 0.0f;
-                    }
-                }
+            // Rule 2: Max Duration Exceeded & Waiting Cars elsewhere
+            if (signals.lightTimer > signals.maxGreenDuration && maxCarsOther > 0) {
+                shouldSwitch = true;
+            }
+            
+            if (shouldSwitch) {
+                lights[currentGreen] = TrafficLightState::YELLOW;
+                signals.lightTimer = 0.0f;
+                return true;
             }
         }
     }
+    return false;
+}
 
-    // 2. Update Vehicles
-    for (auto& vehicle : m_Vehicles) {
-        vehicle->Update(deltaTime, m_Graph);
-    }
-    
-    // 3. Collision Avoidance & Junction Logic
+void TransportSimulation::ResolveVehicle(Vehicle& vehicle, const EdgeBuckets& neighbours,
+                                         IntersectionManager* intersections, float deltaTime) {
     const float safeDistance = 4.0f; 
-    const float criticalDistance = 1.5f;
 
-    for (size_t i = 0; i < m_Vehicles.size(); i++) {
-        auto& vehicleA = m_Vehicles[i];
-        if (vehicleA->IsStopped()) continue; // Already stopped at red light
-        
-        bool shouldStop = false;
-        float targetSpeed = 5.0f;
-        bool isBlockedByVehicle = false;
-        
-        // 0. Don't Block the Box (Gridlock Prevention)
-        // Check if the NEXT edge (after the intersection) is full
-        const auto& path = vehicleA->GetNodePath();
-        size_t idx = vehicleA->GetCurrentWaypointIndex();
-        
-        // Only check if we are approaching an intersection (target node)
-        if (idx < path.size()) {
-            int targetNodeId = path[idx];
-            auto targetNode = m_Graph->GetNode(targetNodeId);
-            
-            if (targetNode) {
-                float distToIntersection = glm::length(targetNode->position - vehicleA->GetPosition());
-                
-                // If we are close to entering the intersection (e.g. < 15.0f)
-                if (distToIntersection < 15.0f) {
-                    // Check the NEXT edge
-                    if (idx + 1 < path.size()) {
-                        int nextNodeId = path[idx + 1];
-                        auto nextNode = m_Graph->GetNode(nextNodeId);
-                        
-                        if (nextNode) {
-                            // Calculate capacity of the target edge
-                            float edgeLen = glm::length(nextNode->position - targetNode->position);
-                            int capacity = (int)(edgeLen / 8.0f); // Assume ~8 units per car (incl gap)
-                            
-                            // Count cars on that edge
-                            int carsOnNextEdge = GetVehicleCountOnEdge(m_Vehicles, targetNodeId, nextNodeId, m_Graph);
-                            
-                            if (carsOnNextEdge >= capacity) {
-                                shouldStop = true;
-                                // std::cout << "Vehicle " << vehicleA->GetId() << " waiting for gridlock at " << targetNodeId << std::endl;
-                            }
-                        }
-                    }
+    if (vehicle.IsStopped()) return; // Already stopped at red light
+    
+    bool shouldStop = false;
+    float targetSpeed = 5.0f;
+    bool isBlockedByVehicle = false;
+    
+    int edge = vehicle.GetCurrentEdgeId();
+    if (!m_Graph->HasEdge(edge)) return;
+    float distToIntersection = m_Graph->GetEdgeLength(edge) - vehicle.GetOffset();
+    
+    // The edge after the intersection we are approaching, if any
+    const auto& path = vehicle.GetNodePath();
+    size_t idx = vehicle.GetPathIndex();
+    int nextEdge = idx + 1 < path.size() ? m_Graph->FindEdge(path[idx], path[idx + 1]) : -1;
+    
+    // 0. Don't Block the Box (Gridlock Prevention)
+    // If we are close to entering the intersection (e.g. < 15.0f), check whether the NEXT edge is full.
+    // Not while still inside the box we just crossed: waiting there blocks it just the same.
+    if (nextEdge >= 0 && distToIntersection < 15.0f && vehicle.GetOffset() > IntersectionManager::JunctionRadius) {
+        int capacity = (int)(m_Graph->GetEdgeLength(nextEdge) / 8.0f); // Assume ~8 units per car (incl gap)
+        int carsOnNextEdge = neighbours.GetCount(nextEdge);
+        if (carsOnNextEdge >= capacity) {
+            shouldStop = true;
+        }
+    }
+    
+    // Unsignalised junction: only enter the box within a reserved slot. Vehicles
+    // already inside it keep going.
+    if (intersections && !shouldStop && nextEdge >= 0 && distToIntersection < IntersectionManager::ApproachDistance &&
+        distToIntersection > IntersectionManager::JunctionRadius) {
+        if (m_Graph->GetIncomingEdges(path[idx]).size() > 1 && !HasActiveLights(*m_Graph, m_Signals, path[idx])) {
+            double slot = intersections->FindSlot(path[idx], vehicle.GetId());
+            if (slot >= 0.0 && m_SimulationTime > slot + IntersectionManager::SlotMargin) {
+                // Held up past our slot: give it back and book a new one
+                intersections->Cancel(path[idx], vehicle.GetId());
+                slot = -1.0;
+            }
+            if (slot < 0.0) {
+                // Assume we cruise through the box
+                double entryTime = m_SimulationTime + (distToIntersection - IntersectionManager::JunctionRadius) / targetSpeed;
+                double exitTime = m_SimulationTime + (distToIntersection + IntersectionManager::JunctionRadius) / targetSpeed;
+                IntersectionManager::Movement movement = { path[idx - 1], path[idx], path[idx + 1] };
+                bool granted = intersections->Request(*m_Graph, movement, vehicle.GetId(), entryTime, exitTime);
+                if (!granted && distToIntersection - IntersectionManager::JunctionRadius < IntersectionManager::HoldDistance) {
+                    shouldStop = true;
                 }
             }
         }
-        
-        // A. Check against other vehicles
-        for (size_t j = 0; j < m_Vehicles.size(); j++) {
-            if (i == j) continue;
-            auto& vehicleB = m_Vehicles[j];
-            
-            if (vehicleB->IsDestinationReached()) continue;
-            
-            glm::vec3 toOther = vehicleB->GetPosition() - vehicleA->GetPosition();
-            float dist = glm::length(toOther);
-            
-            // 0. Ignore oncoming traffic (Head-on on two-way roads)
-            // If vehicles are moving in opposite directions (dot product < -0.5), they are in different lanes
-            if (glm::dot(vehicleA->GetDirection(), vehicleB->GetDirection()) < -0.5f) {
-                continue;
-            }
-            
-            // 1. Critical Proximity (Anti-Clipping) - Absolute stop
-            if (dist < criticalDistance) {
-                shouldStop = true;
+    }
+    
+    // A. Check against the vehicles ahead in our lane, on this edge or just past the intersection.
+    // Everything else (other roads, the opposite direction of a two-way road) is ignored.
+    // Both edges list their vehicles by offset, so only those within following distance are visited.
+    auto isBlockedBy = [&](const VehicleProxy& other, float gap) {
+        if (other.id == vehicle.GetId() || other.lane != vehicle.GetLane()) return false;
+        // Behind us; side by side, the lower ID goes first
+        return gap >= 0.0f && !(gap == 0.0f && other.id > vehicle.GetId());
+    };
+    auto ahead = neighbours.GetVehicles(edge);
+    auto first = std::lower_bound(ahead.begin(), ahead.end(), vehicle.GetOffset(),
+        [](const VehicleProxy& other, float offset) { return other.offset < offset; });
+    for (auto it = first; it != ahead.end(); ++it) {
+        float gap = it->offset - vehicle.GetOffset();
+        if (gap >= safeDistance) break;
+        if (isBlockedBy(*it, gap)) {
+            isBlockedByVehicle = true;
+            break;
+        }
+    }
+    if (nextEdge >= 0 && !isBlockedByVehicle) {
+        for (const auto& other : neighbours.GetVehicles(nextEdge)) {
+            float gap = distToIntersection + other.offset;
+            if (gap >= safeDistance) break;
+            if (isBlockedBy(other, gap)) {
                 isBlockedByVehicle = true;
                 break;
             }
-            
-            // 2. Standard Following Distance
-            if (dist < safeDistance) {
-                // Check if B is strictly in front (narrower cone)
-                // 0.8f is approx 37 degrees
-                if (glm::dot(glm::normalize(toOther), vehicleA->GetDirection()) > 0.8f) {
-                    
-                    // Lateral Distance Check (Lane Logic)
-                    glm::vec3 right = glm::cross(vehicleA->GetDirection(), glm::vec3(0.0f, 1.0f, 0.0f));
-                    float lateralDist = std::abs(glm::dot(toOther, right));
-                    
-                    // If lateral distance is significant (different lane/offset), don't stop completely
-                    if (lateralDist > 1.5f) { // 1.5f allows for some passing
-                         if (lateralDist < 3.0f) {
-                             // Tight squeeze, slow down
-                             targetSpeed = std::min(targetSpeed, 2.5f);
-                         }
-                         // If > 3.0f, ignore (safe pass)
-                    } else {
-                        // Same lane, must stop
-                        shouldStop = true;
-                        isBlockedByVehicle = true;
-                        break;
-                    }
-                }
-            }
         }
-        
-        if (shouldStop) {
-            // "Wait 5s then Pass" Logic
-            // Only apply if blocked by vehicle (not red light) and we are stopped
-            if (isBlockedByVehicle) {
-                vehicleA->IncrementBlockedTimer(deltaTime);
-                
-                if (vehicleA->GetBlockedTimer() > 5.0f) {
-                    // Creep forward slowly to attempt pass
-                    vehicleA->SetSpeed(1.0f); 
-                    // Debug Log (occasional)
-                    if (vehicleA->GetId() % 20 == 0) {
-                        // std::cout << "Vehicle " << vehicleA->GetId() << " forcing pass after wait." << std::endl;
-                    }
-                } else {
-                    vehicleA->SetSpeed(0.0f);
+    }
+    // Same lane, within following distance: must stop
+    if (isBlockedByVehicle) {
+        shouldStop = true;
+    }
+    
+    if (shouldStop) {
+        // "Wait 5s then Pass" Logic
+        // Only apply if blocked by vehicle (not red light) and we are stopped
+        if (isBlockedByVehicle) {
+            vehicle.IncrementBlockedTimer(deltaTime);
+            
+            if (vehicle.GetBlockedTimer() > 5.0f) {
+                // Creep forward slowly to attempt pass
+                vehicle.SetSpeed(1.0f); 
+                // Debug Log (occasional)
+                if (vehicle.GetId() % 20 == 0) {
+                    // std::cout << "Vehicle " << vehicle.GetId() << " forcing pass after wait." << std::endl;
                 }
             } else {
-                // Blocked by red light or other reason, reset timer
-                vehicleA->ResetBlockedTimer();
-                vehicleA->SetSpeed(0.0f);
+                vehicle.SetSpeed(0.0f);
             }
         } else {
-            vehicleA->ResetBlockedTimer();
-            vehicleA->SetSpeed(targetSpeed);
+            // Blocked by red light or other reason, reset timer
+            vehicle.ResetBlockedTimer();
+            vehicle.SetSpeed(0.0f);
         }
+    } else {
+        vehicle.ResetBlockedTimer();
+        vehicle.SetSpeed(targetSpeed);
+    }
+}
+
+void TransportSimulation::Update(float deltaTime) {
+    TS_PROFILE_SCOPE(ProfilePhase::SimUpdate);
+    m_SimulationTime += deltaTime;
+    
+    // 1-3. Traffic lights, vehicle movement and collision avoidance run per tile
+    m_Partition->Step(deltaTime);
+    
+    if (m_Transit) {
+        UpdateTransit(deltaTime);
     }
     
     // Debug: Print total stopped vehicles periodically
-    static float logTimer = 0.0f;
-    logTimer += deltaTime;
-    if (logTimer > 1.0f) {
-        int stoppedCount = 0;
-        for (const auto& v : m_Vehicles) {
-            if (v->GetSpeed() < 0.1f) stoppedCount++;
+    m_LogTimer += deltaTime;
+    if (m_LogTimer > 1.0f) {
+        const TrafficStatistics::Snapshot& stats = m_Statistics.GetSnapshot();
+        TS_LOG_INFO(Simulation, "Active Vehicles: %zu | Stopped: %zu", stats.active, stats.halted);
+        if (m_Transit) {
+            const TransitService::Statistics& transit = m_Transit->GetStatistics();
+            TS_LOG_INFO(Simulation, "Transit: %zu vehicles | %llu waiting | %llu riding | %llu arrived",
+                        m_TransitVehicles.size(), (unsigned long long)transit.waiting,
+                        (unsigned long long)transit.riding, (unsigned long long)transit.completed);
         }
-        std::cout << "Active Vehicles: " << m_Vehicles.size() << " | Stopped: " << stoppedCount << std::endl;
-        logTimer = 0.0f;
+        m_LogTimer = 0.0f;
     }
     
     // 4. Vehicle Lifecycle (Destroy & Respawn)
-    auto it = m_Vehicles.begin();
-    while (it != m_Vehicles.end()) {
-        if ((*it)->IsDestinationReached()) {
-            // Add to spawn queue with delay
-            m_SpawnQueue.push_back({ 5.0f }); // 5 second delay
-            it = m_Vehicles.erase(it);
-        } else {
-            ++it;
+    {
+        TS_PROFILE_SCOPE(ProfilePhase::SimLifecycle);
+        auto it = m_Vehicles.begin();
+        while (it != m_Vehicles.end()) {
+            if ((*it)->IsDestinationReached()) {
+                m_Statistics.OnArrival(**it);
+                // Cars are replaced after a 5 second delay; transit vehicles run to the timetable
+                if (!(*it)->IsTransit()) {
+                    m_SpawnQueue.push_back({ 5.0f });
+                }
+                it = m_Vehicles.erase(it);
+            } else {
+                ++it;
+            }
         }
     }
     
     // Process Spawn Queue
-    for (auto& req : m_SpawnQueue) {
-        req.timer -= deltaTime;
+    {
+        TS_PROFILE_SCOPE(ProfilePhase::SimSpawnQueue);
+        for (auto& req : m_SpawnQueue) {
+            req.timer -= deltaTime;
+        }
+        
+        // Remove ready spawns and spawn vehicles
+        auto readyIt = std::remove_if(m_SpawnQueue.begin(), m_SpawnQueue.end(), 
+            [this](const SpawnRequest& req) {
+                if (req.timer <= 0.0f) {
+                    SpawnVehicle();
+                    return true;
+                }
+                return false;
+            });
+        m_SpawnQueue.erase(readyIt, m_SpawnQueue.end());
+        
+        // Maintain vehicle count at the scenario's fleet size
+        size_t totalVehicles = m_Vehicles.size() - m_TransitVehicles.size() + m_SpawnQueue.size();
+        if (totalVehicles < (size_t)m_Scenario.maxVehicles) {
+            SpawnVehicle();
+        }
     }
     
-    // Remove ready spawns and spawn vehicles
-    auto readyIt = std::remove_if(m_SpawnQueue.begin(), m_SpawnQueue.end(), 
-        [this](const SpawnRequest& req) {
-            if (req.timer <= 0.0f) {
-                SpawnVehicle();
-                return true;
-            }
-            return false;
-        });
-    m_SpawnQueue.erase(readyIt, m_SpawnQueue.end());
+    m_Statistics.Advance(deltaTime);
     
-    // Maintain vehicle count (cap at 200)
-    size_t totalVehicles = m_Vehicles.size() + m_SpawnQueue.size();
-    if (totalVehicles < 200) {
-        SpawnVehicle();
+    if (m_Recorder) {
+        m_Recorder->Capture(m_SimulationTime, m_Vehicles);
+    }
+}
+
+bool TransportSimulation::StartRecording(const std::string& path) {
+    if (!m_Recorder) {
+        m_Recorder = std::make_unique<TrajectoryRecorder>();
+    }
+    return m_Recorder->Start(path, *m_Graph);
+}
+
+void TransportSimulation::StopRecording() {
+    if (m_Recorder) {
+        m_Recorder->Stop();
     }
 }
 
 void TransportSimulation::AddVehicle(int startNodeId) {
-    auto startNode = m_Graph->GetNode(startNodeId);
-    if (!startNode) return;
+    if (!m_Graph->HasNode(startNodeId)) return;
     
-    auto vehicle = std::make_shared<Vehicle>(m_NextVehicleId++, startNode->position);
+    auto vehicle = std::make_shared<Vehicle>(m_NextVehicleId++);
+    vehicle->SetPath({ startNodeId }, *m_Graph);
     m_Vehicles.push_back(vehicle);
+    m_Statistics.OnSpawn(*vehicle);
+    if (m_Partition) m_Partition->Insert(vehicle.get());
+}
+
+void TransportSimulation::AddVehicle(const std::vector<int>& path) {
+    if (path.size() < 2 || !m_Graph->HasNode(path[0])) return;
+    
+    auto vehicle = std::make_shared<Vehicle>(m_NextVehicleId++);
+    vehicle->SetPath(path, *m_Graph);
+    m_Vehicles.push_back(vehicle);
+    m_Statistics.OnSpawn(*vehicle);
+    if (m_Partition) m_Partition->Insert(vehicle.get());
 }
 
 void TransportSimulation::SetTrafficLightsEnabled(bool enabled) {
@@ -487,38 +809,10 @@ void TransportSimulation::SetTrafficLightsEnabled(bool enabled) {
     
     // If disabled, turn off all lights
     if (!enabled) {
-        for (auto& [id, node] : m_Graph->GetNodes()) {
-            for (auto& [neighbor, state] : node->incomingLights) {
-                state = TrafficLightState::OFF;
-            }
-        }
+        std::fill(m_Signals.lights.begin(), m_Signals.lights.end(), TrafficLightState::OFF);
+        MarkAllSignalsChanged();
     } else {
         // Re-initialize lights
-        for (auto& [id, node] : m_Graph->GetNodes()) {
-            // Check if it should have lights (same logic as creation)
-             std::vector<int> incomingNeighbors;
-            for (const auto& [otherId, otherNode] : m_Graph->GetNodes()) {
-                for (const auto& edge : otherNode->edges) {
-                    if (edge->to->id == id) {
-                        incomingNeighbors.push_back(otherId);
-                    }
-                }
-            }
-            
-            if (incomingNeighbors.size() > 1 && rand() % 4 == 0) {
-                for (int neighborId : incomingNeighbors) {
-                    node->incomingLights[neighborId] = TrafficLightState::RED;
-                }
-                if (!incomingNeighbors.empty()) {
-                    int greenIdx = rand() % incomingNeighbors.size();
-                    node->currentGreenNodeId = incomingNeighbors[greenIdx];
-                    node->incomingLights[node->currentGreenNodeId] = TrafficLightState::GREEN;
-                }
-            } else {
-                for (int neighborId : incomingNeighbors) {
-                    node->incomingLights[neighborId] = TrafficLightState::OFF;
-                }
-            }
-        }
+        InitializeTrafficLights();
     }
 }
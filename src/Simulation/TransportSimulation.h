@@ -1,42 +1,156 @@
 #pragma once
 #include "Graph.h"
 #include "Vehicle.h"
+#include "NextHopTable.h"
 #include "Pathfinding.h"
+#include "RegionPartition.h"
+#include "RouteOverlay.h"
+#include "Scenario.h"
+#include "TrafficStatistics.h"
+#include "TransitService.h"
+#include "TrajectoryRecorder.h"
 #include <memory>
+#include <random>
+#include <string>
 #include <vector>
 
 // Manages the entire transport simulation
 class TransportSimulation {
 public:
+    // Spawned trips go to a goal this many blocks (scenario spacings) away, as the crow flies
+    static constexpr float MinTripBlocks = 5.0f;
+    static constexpr float MaxTripBlocks = 70.0f;
+    
     TransportSimulation();
     ~TransportSimulation() = default;
     
+    // Network, grid layout, signal density, fleet size and seed (call before Initialize)
+    void SetScenario(const Scenario& scenario);
+    const Scenario& GetScenario() const { return m_Scenario; }
+    
+    // Road network to load in Initialize (.tsnet / .osm / .osm.pbf); empty = procedural grid
+    void SetNetworkFile(const std::string& path) { m_Scenario.network = path; }
+    const std::string& GetNetworkFile() const { return m_Scenario.network; }
+    
     void Initialize();
+    // Starts on a network another simulation has already loaded. The graph is
+    // shared and only read from here on; the signals start as a copy of 'signals'.
+    void Initialize(std::shared_ptr<Graph> graph, const SignalTable& signals);
+    
+    // Saves the current network in the binary .tsnet format for fast startup,
+    // with the next-hop table if there is one
+    bool ExportNetwork(const std::string& path) const;
+    
+    // Next-hop table and route overlay routing. One set before Initialize is used
+    // instead of building it, e.g. to share it between simulations of the same network.
+    std::shared_ptr<const NextHopTable> GetNextHopTable() const { return m_NextHops; }
+    void SetNextHopTable(std::shared_ptr<const NextHopTable> nextHops) { m_NextHops = std::move(nextHops); }
+    std::shared_ptr<const RouteOverlay> GetRouteOverlay() const { return m_RouteOverlay; }
+    void SetRouteOverlay(std::shared_ptr<const RouteOverlay> overlay) { m_RouteOverlay = std::move(overlay); }
     void Update(float deltaTime);
     
     // Getters
     std::shared_ptr<Graph> GetGraph() const { return m_Graph; }
+    // Signal state per edge and node, this simulation's own
+    const SignalTable& GetSignals() const { return m_Signals; }
+    // Appends the lights (edge IDs) that changed since the last call, each once.
+    // Meant for a single consumer (SimulationThread, feeding the light renderer).
+    void TakeChangedSignals(std::vector<uint32_t>& edges);
     const std::vector<std::shared_ptr<Vehicle>>& GetVehicles() const { return m_Vehicles; }
+    // Kept current from simulation events; cheap to read every frame
+    const TrafficStatistics& GetStatistics() const { return m_Statistics; }
+    TrafficStatistics& GetStatistics() { return m_Statistics; }
+    // Bus and tram service, null if the scenario has no transit lines
+    const TransitService* GetTransit() const { return m_Transit.get(); }
     
     // Add a vehicle at a specific node
     void AddVehicle(int startNodeId);
+    // Add a vehicle that drives the given node path (scripted scenarios, benchmarks)
+    void AddVehicle(const std::vector<int>& path);
     void SpawnVehicle();
     
     // Traffic Light Control
     void SetTrafficLightsEnabled(bool enabled);
     bool AreTrafficLightsEnabled() const { return m_TrafficLightsEnabled; }
+    
+    // Seeds the spawn and signal random streams (call before Initialize)
+    void SetSeed(uint32_t seed);
+    
+    // Binary snapshot of all mutable state. Restoring requires the same road network
+    // and reproduces the subsequent run bit for bit (given the same time steps).
+    bool SaveCheckpoint(const std::string& path) const;
+    bool LoadCheckpoint(const std::string& path);
+    
+    // Trajectory recording (.tstraj), captured at the end of every Update
+    bool StartRecording(const std::string& path);
+    void StopRecording();
+    bool IsRecording() const { return m_Recorder && m_Recorder->IsRecording(); }
+    
+    double GetSimulationTime() const { return m_SimulationTime; }
+    
+    // Spatial threading: the network is split into one tile per thread
+    void SetThreadCount(int threadCount);
+    int GetThreadCount() const { return m_ThreadCount; }
 
 private:
+    friend class RegionPartition;
+    
+    bool LoadNetwork();
     void CreateRoadNetwork();
+    void InitializeTrafficLights();
+    // False if a green neighbour is not a node with a road into the intersection
+    bool ApplySignalLayout(const int32_t* greenNeighbor);
     void SpawnInitialVehicles();
+    void SpawnVehicle(std::vector<uint8_t>* occupiedStarts);
+    void BuildSpawnCells();
+    // Random node in or next to the start node's spawn cell, -1 if that cell is empty
+    int DrawNearbyNode(int startNodeId);
+    void PrepareRouting();  // Overlay or next-hop table, as the scenario's routing mode asks
+    void PrepareTransit();  // Lines and timetable, if the scenario has any
+    // Serves the stops transit vehicles reached this tick, sends out due trips
+    // and adds passengers
+    void UpdateTransit(float deltaTime);
+    // Gives the vehicle a route from start to goal; false if there is none
+    bool PlanRoute(Vehicle& vehicle, int startNodeId, int goalNodeId) const;
+    
+    // Per-intersection and per-vehicle steps, called concurrently from tile workers.
+    // They only write to the intersection / vehicle / reservations they are given;
+    // an intersection's signals are its entry in m_Signals and the lights of the
+    // roads into it. Returns true when any of its lights changed.
+    bool UpdateTrafficLight(int nodeId, const EdgeBuckets& vehicles, float deltaTime);
+    // 'intersections' manages the node the vehicle drives towards, null if another tile owns it
+    void ResolveVehicle(Vehicle& vehicle, const EdgeBuckets& neighbours,
+                        IntersectionManager* intersections, float deltaTime);
+    // Plans the next stretch of a partly planned route
+    void RefineRoute(Vehicle& vehicle) const;
+    void MarkSignalsChanged(int nodeId);  // The lights of the roads into the node
+    void MarkAllSignalsChanged();
     
-    std::shared_ptr<Graph> m_Graph;
+    std::shared_ptr<Graph> m_Graph;  // Read-only once loaded, may be shared
+    SignalTable m_Signals;
+    std::vector<uint32_t> m_ChangedSignals;
+    std::vector<uint8_t> m_SignalChanged;  // Already in m_ChangedSignals
+    Scenario m_Scenario;
     std::shared_ptr<Pathfinding> m_Pathfinding;
+    std::shared_ptr<const RouteOverlay> m_RouteOverlay;  // Hierarchical routing, may be shared; null otherwise
+    std::shared_ptr<const NextHopTable> m_NextHops;  // Table routing, may be shared; null otherwise
     
     std::vector<std::shared_ptr<Vehicle>> m_Vehicles;
+    std::unique_ptr<TransitService> m_Transit;
+    std::vector<std::shared_ptr<Vehicle>> m_TransitVehicles;  // The buses and trams among m_Vehicles
+    TrafficStatistics m_Statistics;
+    std::unique_ptr<RegionPartition> m_Partition;
+    int m_ThreadCount = 1;
+    double m_SimulationTime = 0.0;
     float m_SpawnTimer = 0.0f;
+    float m_LogTimer = 0.0f;
     int m_NextVehicleId = 0;
     
+    uint32_t m_Seed = 0;
+    std::mt19937 m_SpawnRng;
+    std::mt19937 m_SignalRng;
+    std::mt19937 m_TransitRng;  // Passenger origins and destinations
+    
     // Spawn Queue
     struct SpawnRequest {
         float timer;
@@ -44,4 +158,19 @@ private:
     std::vector<SpawnRequest> m_SpawnQueue;
     
     bool m_TrafficLightsEnabled = true;
+    
+    // Nodes bucketed into square cells as wide as the longest trip, so goals on
+    // large networks are drawn near the start rather than from the whole map.
+    // Unused (empty) when the network spans only a few cells.
+    struct SpawnCells {
+        glm::vec2 origin = glm::vec2(0.0f);
+        float size = 1.0f;
+        int columns = 0;
+        int rows = 0;
+        std::vector<uint32_t> offsets;  // Nodes in cell c: nodes[offsets[c] .. offsets[c + 1])
+        std::vector<int32_t> nodes;
+    };
+    SpawnCells m_SpawnCells;
+    
+    std::unique_ptr<TrajectoryRecorder> m_Recorder;
 };
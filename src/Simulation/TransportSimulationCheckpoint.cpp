@@ -0,0 +1,284 @@
+#include "TransportSimulation.h"
+#include "../Core/BinaryStream.h"
+#include "../Core/Compression.h"
+#include "../Core/Log.h"
+#include "../Core/MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// Checkpoint file: header followed by a BinaryWriter payload.
+// The road network itself is not stored, only a fingerprint of it.
+namespace {
+
+    const char kMagic[4] = { 'T', 'S', 'C', 'P' };
+    constexpr uint32_t kVersion = 8;
+
+    struct CheckpointHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t payloadSize;
+        uint32_t checksum;  // Adler-32 of the payload
+        uint32_t reserved;
+    };
+
+    // Identifies the road network a checkpoint belongs to
+    uint32_t NetworkFingerprint(const Graph& graph) {
+        const GraphArrays& arrays = graph.GetArrays();
+        size_t nodeCount = graph.GetNodeCount();
+        size_t edgeCount = graph.GetEdgeCount();
+        uint32_t hash = 1;
+        hash = Compression::Adler32((const uint8_t*)arrays.positions, nodeCount * sizeof(glm::vec3), hash);
+        hash = Compression::Adler32((const uint8_t*)arrays.edgeOffsets, (nodeCount + 1) * sizeof(uint32_t), hash);
+        hash = Compression::Adler32((const uint8_t*)arrays.edgeTargets, edgeCount * sizeof(uint32_t), hash);
+        hash = Compression::Adler32((const uint8_t*)arrays.edgeWeights, edgeCount * sizeof(float), hash);
+        return hash;
+    }
+
+    // Lights in range, and every green road one that enters its intersection
+    bool AreSignalsValid(const Graph& graph, const SignalTable& signals) {
+        if (signals.lights.size() != graph.GetEdgeCount() || signals.intersections.size() != graph.GetNodeCount()) {
+            return false;
+        }
+        for (TrafficLightState light : signals.lights) {
+            if ((uint8_t)light > (uint8_t)TrafficLightState::OFF) return false;
+        }
+        for (int id = 0; id < (int)signals.intersections.size(); id++) {
+            int greenEdge = signals.intersections[id].greenEdge;
+            if (greenEdge != -1 && (!graph.HasEdge(greenEdge) || graph.GetEdgeTarget(greenEdge) != id)) return false;
+        }
+        return true;
+    }
+
+    // A random stream as binary words: the engine's state as its textual form
+    // gives it (624 words, then the position on implementations that add it),
+    // converted once instead of stored as text
+    void WriteRng(BinaryWriter& writer, const std::mt19937& rng) {
+        std::stringstream stream;
+        stream << rng;
+        std::vector<uint32_t> words;
+        words.reserve(std::mt19937::state_size + 1);
+        uint32_t word = 0;
+        while (stream >> word) {
+            words.push_back(word);
+        }
+        writer.WriteArray(words);
+    }
+
+    bool ReadRng(BinaryReader& reader, std::mt19937& rng) {
+        std::vector<uint32_t> words;
+        if (!reader.ReadArray(words) || words.size() < std::mt19937::state_size ||
+            words.size() > std::mt19937::state_size + 1) return false;
+        std::stringstream stream;
+        for (uint32_t word : words) {
+            stream << word << ' ';
+        }
+        stream >> rng;
+        return !stream.fail();
+    }
+
+}
+
+bool TransportSimulation::SaveCheckpoint(const std::string& path) const {
+    BinaryWriter writer;
+    writer.Reserve(1024 + m_Vehicles.size() * 512 + m_Graph->GetNodeCount() * 64);
+    
+    // Network identity
+    writer.Write<uint32_t>((uint32_t)m_Graph->GetNodeCount());
+    writer.Write<uint32_t>(NetworkFingerprint(*m_Graph));
+    
+    // Simulation scalars and random streams
+    writer.Write(m_SimulationTime);
+    writer.Write(m_SpawnTimer);
+    writer.Write(m_LogTimer);
+    writer.Write(m_NextVehicleId);
+    writer.Write(m_TrafficLightsEnabled);
+    WriteRng(writer, m_SpawnRng);
+    WriteRng(writer, m_SignalRng);
+    
+    std::vector<float> spawnTimers;
+    for (const auto& request : m_SpawnQueue) {
+        spawnTimers.push_back(request.timer);
+    }
+    writer.WriteArray(spawnTimers);
+    
+    // Signals: intersections by node ID, lights by edge ID
+    writer.WriteArray(m_Signals.intersections);
+    writer.WriteArray(m_Signals.lights);
+    
+    // Slots booked at unsignalised intersections
+    writer.WriteArray(m_Partition->GetReservations());
+    
+    // Vehicles, in update order
+    writer.Write<uint64_t>(m_Vehicles.size());
+    for (const auto& vehicle : m_Vehicles) {
+        vehicle->Save(writer);
+    }
+    
+    // Transit trips in service and passengers
+    writer.Write<uint8_t>(m_Transit ? 1 : 0);
+    if (m_Transit) {
+        WriteRng(writer, m_TransitRng);
+        m_Transit->Save(writer);
+    }
+    
+    const std::vector<uint8_t>& payload = writer.GetData();
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.payloadSize = payload.size();
+    header.checksum = Compression::Adler32(payload.data(), payload.size());
+    
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create checkpoint: " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write checkpoint: " << path << std::endl;
+        return false;
+    }
+    
+    std::cout << "Saved checkpoint with " << m_Vehicles.size() << " vehicles to " << path << std::endl;
+    return true;
+}
+
+bool TransportSimulation::LoadCheckpoint(const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path)) return false;
+    
+    CheckpointHeader header;
+    if (file.GetSize() < sizeof(header)) {
+        std::cerr << "Not a checkpoint file: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    const uint8_t* payload = file.GetData() + sizeof(header);
+    
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        std::cerr << "Unsupported checkpoint file: " << path << std::endl;
+        return false;
+    }
+    if (header.payloadSize != file.GetSize() - sizeof(header) ||
+        Compression::Adler32(payload, (size_t)header.payloadSize) != header.checksum) {
+        std::cerr << "Checkpoint is truncated or corrupt: " << path << std::endl;
+        return false;
+    }
+    
+    BinaryReader reader(payload, (size_t)header.payloadSize);
+    
+    uint32_t nodeCount = 0, fingerprint = 0;
+    reader.Read(nodeCount);
+    reader.Read(fingerprint);
+    if (nodeCount != m_Graph->GetNodeCount() || fingerprint != NetworkFingerprint(*m_Graph)) {
+        std::cerr << "Checkpoint was saved for a different road network: " << path << std::endl;
+        return false;
+    }
+    
+    // Read everything into temporaries so a bad file leaves the simulation untouched
+    double simulationTime = 0.0;
+    float spawnTimer = 0.0f, logTimer = 0.0f;
+    int nextVehicleId = 0;
+    bool lightsEnabled = true;
+    std::mt19937 spawnRng, signalRng;
+    std::vector<float> spawnTimers;
+    reader.Read(simulationTime);
+    reader.Read(spawnTimer);
+    reader.Read(logTimer);
+    reader.Read(nextVehicleId);
+    reader.Read(lightsEnabled);
+    bool rngValid = ReadRng(reader, spawnRng) && ReadRng(reader, signalRng);
+    reader.ReadArray(spawnTimers);
+    
+    if (!reader.IsOk() || !rngValid) {
+        std::cerr << "Checkpoint is corrupt: " << path << std::endl;
+        return false;
+    }
+    
+    SignalTable signals;
+    reader.ReadArray(signals.intersections);
+    reader.ReadArray(signals.lights);
+    
+    std::vector<IntersectionManager::Reservation> reservations;
+    reader.ReadArray(reservations);
+    
+    uint64_t vehicleCount = 0;
+    reader.Read(vehicleCount);
+    std::vector<std::shared_ptr<Vehicle>> vehicles;
+    for (uint64_t i = 0; i < vehicleCount && reader.IsOk(); i++) {
+        auto vehicle = std::make_shared<Vehicle>(0);
+        if (vehicle->Load(reader)) {
+            vehicles.push_back(vehicle);
+        }
+    }
+    
+    // The timetable comes from the scenario, so it must have the same transit lines
+    uint8_t hasTransit = 0;
+    reader.Read(hasTransit);
+    std::mt19937 transitRng;
+    std::unique_ptr<TransitService> transit;
+    if (reader.IsOk() && (hasTransit != 0) != (m_Transit != nullptr)) {
+        TS_LOG_ERROR(Simulation, "Checkpoint was saved with different transit lines: %s", path.c_str());
+        return false;
+    }
+    if (hasTransit) {
+        transit = std::make_unique<TransitService>(*m_Transit);
+        if (!ReadRng(reader, transitRng) || !transit->Load(reader)) {
+            TS_LOG_ERROR(Simulation, "Checkpoint is corrupt or has different transit lines: %s", path.c_str());
+            return false;
+        }
+    }
+    
+    bool reservationsValid = std::all_of(reservations.begin(), reservations.end(),
+        [nodeCount](const IntersectionManager::Reservation& reservation) {
+            return reservation.nodeId >= 0 && (uint32_t)reservation.nodeId < nodeCount;
+        });
+    if (!reader.IsOk() || !reader.IsAtEnd() || !reservationsValid || !AreSignalsValid(*m_Graph, signals)) {
+        std::cerr << "Checkpoint is corrupt: " << path << std::endl;
+        return false;
+    }
+    
+    // Commit
+    m_SimulationTime = simulationTime;
+    m_SpawnTimer = spawnTimer;
+    m_LogTimer = logTimer;
+    m_NextVehicleId = nextVehicleId;
+    m_TrafficLightsEnabled = lightsEnabled;
+    m_SpawnRng = spawnRng;
+    m_SignalRng = signalRng;
+    if (transit) {
+        m_Transit = std::move(transit);
+        m_TransitRng = transitRng;
+    }
+    
+    m_SpawnQueue.clear();
+    for (float timer : spawnTimers) {
+        m_SpawnQueue.push_back({ timer });
+    }
+    
+    m_Signals = std::move(signals);
+    MarkAllSignalsChanged();
+    
+    m_Partition.reset();
+    m_Vehicles = std::move(vehicles);
+    m_TransitVehicles.clear();
+    for (const auto& vehicle : m_Vehicles) {
+        if (vehicle->IsTransit()) m_TransitVehicles.push_back(vehicle);
+    }
+    m_Statistics.Rebuild(m_Vehicles);
+    m_Partition = std::make_unique<RegionPartition>(*this, m_ThreadCount);
+    for (const auto& vehicle : m_Vehicles) {
+        m_Partition->Insert(vehicle.get());
+    }
+    for (const auto& reservation : reservations) {
+        m_Partition->RestoreReservation(reservation);
+    }
+    
+    std::cout << "Restored checkpoint with " << m_Vehicles.size() << " vehicles from " << path << std::endl;
+    return true;
+}
@@ -1,129 +1,185 @@
 #include "Vehicle.h"
-#include <iostream>
-#include <glm/gtc/constants.hpp>
+#include "../Core/BinaryStream.h"
+#include <algorithm>
 
-Vehicle::Vehicle(int id, const glm::vec3& position)
-    : m_Id(id), m_Position(position), m_Velocity(0.0f) {
+// Unit direction of travel along an edge (forward if its end nodes coincide)
+static glm::vec3 GetEdgeDirection(const Graph& graph, int edgeId) {
+    float length = graph.GetEdgeLength(edgeId);
+    if (length <= 0.0f) return glm::vec3(0.0f, 0.0f, 1.0f);
+    return (graph.GetPosition(graph.GetEdgeTarget(edgeId)) - graph.GetPosition(graph.GetEdgeSource(edgeId))) / length;
 }
 
-void Vehicle::Update(float deltaTime, std::shared_ptr<Graph> graph) {
-    if (m_Path.empty() || m_CurrentWaypointIndex >= m_Path.size()) {
-        m_Velocity = glm::vec3(0.0f);
+Vehicle::Vehicle(int id)
+    : m_Id(id) {
+}
+
+void Vehicle::Update(float deltaTime, const Graph& graph, const SignalTable& signals) {
+    if (!graph.HasEdge(m_CurrentEdgeId)) return;
+    float length = graph.GetEdgeLength(m_CurrentEdgeId);
+    m_EdgeTime += deltaTime;
+    
+    if (m_DwellTimer > 0.0f) {
+        m_DwellTimer = std::max(m_DwellTimer - deltaTime, 0.0f);
+        m_IsStopped = true;
+        m_Speed = 0.0f;
         return;
     }
     
-    // Check traffic light at the target intersection
+    // Check the traffic light for our incoming road at the end of the edge
     m_IsStopped = false;
-    if (m_CurrentWaypointIndex < m_NodePath.size()) {
-        int targetNodeId = m_NodePath[m_CurrentWaypointIndex];
-        auto node = graph->GetNode(targetNodeId);
-        
-        // We need to know where we are coming FROM to check the correct light
-        // If we are at the start, we might not have a previous node in path, 
-        // but we can infer it or check if we are close to the target.
-        // Better: Use the previous node in the path if available.
-        int fromNodeId = -1;
-        if (m_CurrentWaypointIndex > 0) {
-            fromNodeId = m_NodePath[m_CurrentWaypointIndex - 1];
-        } else {
-            // Special case: Just spawned or at start. 
-            // We can try to find the closest neighbor that aligns with our direction?
-            // For now, let's assume if we are just starting, we are "entering" the network 
-            // and might not need to check a light immediately unless we are right at an intersection.
-            // But usually we spawn at a node and move to next.
-        }
-
-        if (node && fromNodeId != -1) {
-            // Check if there is a light for our incoming path
-            auto it = node->incomingLights.find(fromNodeId);
-            if (it != node->incomingLights.end() && it->second == TrafficLightState::RED) {
-                // Check distance to intersection
-                float distToNode = glm::length(node->position - m_Position);
-                if (distToNode < 6.0f) {  // Stop before the intersection
-                    m_IsStopped = true;
-                    m_Velocity = glm::vec3(0.0f);
-                    // Debug Log
-
-                    return;
-                }
-            }
-        }
+    if (length - m_Offset < StopDistance && signals.lights[m_CurrentEdgeId] == TrafficLightState::RED) {
+        m_IsStopped = true;
+        return;
     }
     
-    const glm::vec3& targetWaypoint = m_Path[m_CurrentWaypointIndex];
-    glm::vec3 direction = targetWaypoint - m_Position;
-    float distance = glm::length(direction);
+    m_Offset += m_Speed * deltaTime;
     
-    // Check if we've reached the current waypoint
-    if (distance < 0.5f) {
-        m_CurrentWaypointIndex++;
-        if (m_CurrentWaypointIndex >= m_Path.size()) {
-            // Reached end of path
-            m_DestinationReached = true;
-            m_Velocity = glm::vec3(0.0f);
-            m_Path.clear(); // Signal for destruction
-            m_NodePath.clear();
-            return;
-        }
-        return;  // Move to next waypoint in next frame
+    // The node we came from is our next stop: halt once past the junction
+    bool leavingStop = m_StopsReached < m_StopPathIndices.size() && m_StopPathIndices[m_StopsReached] + 1 == m_PathIndex;
+    float stopOffset = std::min(TransitStopOffset, length);
+    if (leavingStop && m_Offset >= stopOffset) {
+        m_Offset = stopOffset;
+        m_StopsReached++;
+        m_DwellTimer = m_DwellTime;
+        m_IsStopped = true;
+        m_Speed = 0.0f;
+        return;
     }
+    if (m_Offset < length) return;
     
-    // Move towards waypoint
-    direction = glm::normalize(direction);
-    m_Direction = direction; // Update direction
-    m_Velocity = direction * m_Speed;
-    m_Position += m_Velocity * deltaTime;
+    // End of the edge: carry the distance left over onto the next one
+    float overshoot = m_Offset - length;
+    m_PathIndex++;
+    int next = m_PathIndex < m_NodePath.size() ? graph.FindEdge(m_NodePath[m_PathIndex - 1], m_NodePath[m_PathIndex]) : -1;
+    if (next < 0 && !IsPathComplete()) {
+        // The next stretch is not planned yet: wait at the end of the edge
+        m_PathIndex--;
+        m_Offset = length;
+        m_Speed = 0.0f;
+        return;
+    }
+    if (next < 0) {
+        // Reached end of path (or a path that leaves the network ends here)
+        if (m_StopsReached < m_StopPathIndices.size() && m_StopPathIndices[m_StopsReached] + 1 == m_PathIndex) {
+            m_StopsReached++;  // The terminus
+        }
+        m_DestinationReached = true;
+        m_NodePath.clear();
+        m_PathIndex = 0;
+        m_CurrentEdgeId = -1;
+        m_Offset = 0.0f;
+        return;
+    }
+    m_CurrentEdgeId = next;
+    m_Offset = std::min(overshoot, graph.GetEdgeLength(next));
 }
 
-void Vehicle::SetPath(const std::vector<int>& path, std::shared_ptr<Graph> graph) {
-    m_Path.clear();
-    m_NodePath = path;  // Store node IDs
-    m_CurrentWaypointIndex = 0;
+void Vehicle::SetPath(const std::vector<int>& path, const Graph& graph) {
+    m_NodePath = path;
+    m_Corridor.clear();
+    m_GoalNodeId = -1;
+    m_CorridorIndex = 0;
+    m_PathIndex = path.size() > 1 ? 1 : 0;
+    m_Offset = 0.0f;
     m_IsStopped = false;
     m_DestinationReached = false;
-    m_WaitTimer = 0.0f;
+    m_StopPathIndices.clear();
+    m_StopsReached = 0;
+    m_DwellTimer = 0.0f;
     
-    // Convert node IDs to positions
-    // Lane Offset Logic
-    float laneOffset = 0.1f; // Offset to the right (Road width is 0.4, lane width 0.2, center at 0.1)
-    glm::vec3 up(0.0f, 1.0f, 0.0f);
-
-    for (size_t i = 0; i < path.size(); ++i) {
-        auto node = graph->GetNode(path[i]);
-        if (!node) continue;
+    m_CurrentEdgeId = path.size() > 1 ? graph.FindEdge(path[0], path[1]) : -1;
+}
 
-        glm::vec3 position = node->position;
-        glm::vec3 dir(0.0f);
+void Vehicle::SetStops(std::vector<uint32_t> pathIndices, float dwellTime) {
+    m_StopPathIndices = std::move(pathIndices);
+    m_StopsReached = 0;
+    m_DwellTime = dwellTime;
+    m_DwellTimer = 0.0f;
+}
 
-        // Determine direction for offset
-        if (i < path.size() - 1) {
-            // Use direction to next node
-            auto nextNode = graph->GetNode(path[i+1]);
-            if (nextNode) {
-                dir = glm::normalize(nextNode->position - node->position);
-            }
-        } else if (i > 0) {
-            // Last node: Use direction from previous node
-            auto prevNode = graph->GetNode(path[i-1]);
-            if (prevNode) {
-                dir = glm::normalize(node->position - prevNode->position);
-            }
-        }
+void Vehicle::SetPlan(int goalNodeId, std::vector<int32_t> corridor, size_t corridorIndex) {
+    bool reached = !m_NodePath.empty() && m_NodePath.back() == goalNodeId;
+    m_GoalNodeId = reached ? -1 : goalNodeId;
+    m_Corridor = reached ? std::vector<int32_t>() : std::move(corridor);
+    m_CorridorIndex = (uint32_t)corridorIndex;
+}
 
-        // Apply offset if we have a valid direction
-        if (glm::length(dir) > 0.01f) {
-            glm::vec3 right = glm::normalize(glm::cross(dir, up));
-            position += right * laneOffset;
-        }
+void Vehicle::ExtendPath(const std::vector<int>& path, size_t corridorIndex) {
+    if (IsPathComplete()) return;
+    if (path.size() < 2 || m_NodePath.empty() || path.front() != m_NodePath.back()) {
+        SetPlan(-1, {}, 0);
+        return;
+    }
+    
+    // Keep the node we came from: it names the edge being driven
+    if (m_PathIndex > 1) {
+        m_NodePath.erase(m_NodePath.begin(), m_NodePath.begin() + (m_PathIndex - 1));
+        m_PathIndex = 1;
+    }
+    m_NodePath.insert(m_NodePath.end(), path.begin() + 1, path.end());
+    SetPlan(m_GoalNodeId, std::move(m_Corridor), corridorIndex);
+}
 
-        m_Path.push_back(position);
+glm::vec3 Vehicle::GetPosition(const Graph& graph) const {
+    if (!graph.HasEdge(m_CurrentEdgeId)) {
+        // Parked on a node (no path yet, or a single-node path)
+        int nodeId = m_NodePath.empty() ? -1 : m_NodePath[std::min<size_t>(m_PathIndex, m_NodePath.size() - 1)];
+        return graph.HasNode(nodeId) ? graph.GetPosition(nodeId) : glm::vec3(0.0f);
     }
     
-    // Set initial direction and position (snap to first waypoint)
-    if (!m_Path.empty()) {
-        m_Position = m_Path[0]; // Snap to lane center
-        if (m_Path.size() > 1) {
-            m_Direction = glm::normalize(m_Path[1] - m_Position);
-        }
+    glm::vec3 direction = GetEdgeDirection(graph, m_CurrentEdgeId);
+    glm::vec3 position = graph.GetPosition(graph.GetEdgeSource(m_CurrentEdgeId)) + direction * m_Offset;
+    
+    // Lanes are to the right of the centreline
+    glm::vec3 right = glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f));
+    float rightLength = glm::length(right);
+    if (rightLength > 0.01f) {
+        position += right / rightLength * ((m_Lane + 0.5f) * LaneWidth);
     }
+    return position;
+}
+
+glm::vec3 Vehicle::GetDirection(const Graph& graph) const {
+    return graph.HasEdge(m_CurrentEdgeId) ? GetEdgeDirection(graph, m_CurrentEdgeId) : glm::vec3(0.0f, 0.0f, 1.0f);
+}
+
+void Vehicle::Save(BinaryWriter& writer) const {
+    writer.Write(m_Id);
+    writer.Write(m_CurrentEdgeId);
+    writer.Write(m_PathIndex);
+    writer.Write(m_Offset);
+    writer.Write(m_Speed);
+    writer.Write(m_BlockedTimer);
+    writer.Write(m_Lane);
+    writer.Write(m_IsStopped);
+    writer.Write(m_DestinationReached);
+    writer.WriteArray(m_NodePath);
+    writer.Write(m_GoalNodeId);
+    writer.Write(m_CorridorIndex);
+    writer.WriteArray(m_Corridor);
+    writer.WriteArray(m_StopPathIndices);
+    writer.Write(m_StopsReached);
+    writer.Write(m_DwellTime);
+    writer.Write(m_DwellTimer);
+}
+
+bool Vehicle::Load(BinaryReader& reader) {
+    reader.Read(m_Id);
+    reader.Read(m_CurrentEdgeId);
+    reader.Read(m_PathIndex);
+    reader.Read(m_Offset);
+    reader.Read(m_Speed);
+    reader.Read(m_BlockedTimer);
+    reader.Read(m_Lane);
+    reader.Read(m_IsStopped);
+    reader.Read(m_DestinationReached);
+    reader.ReadArray(m_NodePath);
+    reader.Read(m_GoalNodeId);
+    reader.Read(m_CorridorIndex);
+    reader.ReadArray(m_Corridor);
+    reader.ReadArray(m_StopPathIndices);
+    reader.Read(m_StopsReached);
+    reader.Read(m_DwellTime);
+    reader.Read(m_DwellTimer);
+    return reader.IsOk();
 }
@@ -1,53 +1,111 @@
 #pragma once
 #include "Graph.h"
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
-// Vehicle agent that moves through the network
+class BinaryWriter;
+class BinaryReader;
+
+// Vehicle agent that moves through the network.
+// State is edge-relative: the edge being driven, the lane on it and the
+// distance covered along it. Following, stopping and edge membership are all
+// 1D arithmetic on offsets; world positions are only derived for rendering.
 class Vehicle {
 public:
-    Vehicle(int id, const glm::vec3& position);
+    static constexpr float LaneWidth = 0.2f;         // Lane 0 is centred LaneWidth / 2 right of the centreline
+    static constexpr float StopDistance = 6.0f;      // Distance before a red light at which vehicles hold
+    static constexpr float TransitStopOffset = 4.0f; // Transit vehicles halt this far past a stop's node, clear of the junction
+
+    explicit Vehicle(int id);
     ~Vehicle() = default;
+
+    // Update vehicle position (move along path), stopping at red lights in 'signals'
+    void Update(float deltaTime, const Graph& graph, const SignalTable& signals);
+
+    // Set a new path for the vehicle to follow, starting at the beginning of its first edge
+    void SetPath(const std::vector<int>& path, const Graph& graph);
     
-    // Update vehicle position (move along path)
-    void Update(float deltaTime, std::shared_ptr<Graph> graph);
-    
-    // Set a new path for the vehicle to follow
-    void SetPath(const std::vector<int>& path, std::shared_ptr<Graph> graph);
-    
+    // Hierarchical routes (RouteOverlay): the path set above only covers the first
+    // cells of a corridor towards 'goalNodeId'. 'corridorIndex' is the corridor cell
+    // the path ends in.
+    void SetPlan(int goalNodeId, std::vector<int32_t> corridor, size_t corridorIndex);
+    // Appends the next stretch, which starts at the path's current last node. Nodes
+    // already driven past are dropped. The plan is complete once the goal is reached,
+    // or when 'path' is empty (nothing better found: the vehicle stops where its path ends).
+    void ExtendPath(const std::vector<int>& path, size_t corridorIndex);
+    bool IsPathComplete() const { return m_GoalNodeId < 0; }
+    int GetGoalNodeId() const { return m_GoalNodeId; }
+    const std::vector<int32_t>& GetCorridor() const { return m_Corridor; }
+    size_t GetCorridorIndex() const { return m_CorridorIndex; }
+    // Planned nodes not yet reached
+    size_t GetNodesAhead() const { return m_NodePath.size() - std::min<size_t>(m_PathIndex, m_NodePath.size()); }
+
+    // Scheduled stops (buses, trams): indices into the node path at which the
+    // vehicle halts for 'dwellTime' seconds, just past the node. Call after SetPath.
+    void SetStops(std::vector<uint32_t> pathIndices, float dwellTime);
+    bool IsTransit() const { return !m_StopPathIndices.empty(); }
+    uint32_t GetStopsReached() const { return m_StopsReached; }
+    bool IsDwelling() const { return m_DwellTimer > 0.0f; }
+    // Stays at the current stop for at least 'seconds' more
+    void HoldAtStop(float seconds) { if (IsDwelling()) m_DwellTimer = std::max(m_DwellTimer, seconds); }
+
     // Getters
     int GetId() const { return m_Id; }
-    const glm::vec3& GetPosition() const { return m_Position; }
-    const glm::vec3& GetVelocity() const { return m_Velocity; }
-    const glm::vec3& GetDirection() const { return m_Direction; }
     float GetSpeed() const { return m_Speed; }
-    bool IsMoving() const { return !m_Path.empty(); }
+    bool IsMoving() const { return m_CurrentEdgeId >= 0; }
     bool IsStopped() const { return m_IsStopped; }
     bool IsDestinationReached() const { return m_DestinationReached; }
-    
+    // Held at a red light, by traffic or at a stop (what the statistics count as stopped)
+    bool IsHalted() const { return m_IsStopped || m_Speed < 0.1f; }
+
     const std::vector<int>& GetNodePath() const { return m_NodePath; }
-    size_t GetCurrentWaypointIndex() const { return m_CurrentWaypointIndex; }
-    
+    size_t GetPathIndex() const { return m_PathIndex; }  // Index in GetNodePath() of the node driven towards
+    int GetCurrentEdgeId() const { return m_CurrentEdgeId; }  // Edge being driven, -1 if none
+    float GetOffset() const { return m_Offset; }      // Distance driven along the current edge
+    uint8_t GetLane() const { return m_Lane; }
+    int GetFromNodeId() const { return m_PathIndex > 0 && m_PathIndex <= m_NodePath.size() ? m_NodePath[m_PathIndex - 1] : -1; }
+    int GetTargetNodeId() const { return m_PathIndex < m_NodePath.size() ? m_NodePath[m_PathIndex] : -1; }
+
+    // World-space pose, for rendering
+    glm::vec3 GetPosition(const Graph& graph) const;
+    glm::vec3 GetDirection(const Graph& graph) const;
+
     // Setters
     void SetSpeed(float speed) { m_Speed = speed; }
     void IncrementBlockedTimer(float deltaTime) { m_BlockedTimer += deltaTime; }
     void ResetBlockedTimer() { m_BlockedTimer = 0.0f; }
     float GetBlockedTimer() const { return m_BlockedTimer; }
-    
+
+    // Bookkeeping for TrafficStatistics, not part of the simulated state (not checkpointed)
+    float GetEdgeTime() const { return m_EdgeTime; }  // Seconds since entering the current edge
+    void ResetEdgeTime() { m_EdgeTime = 0.0f; }
+    bool IsCountedHalted() const { return m_CountedHalted; }
+    void SetCountedHalted(bool halted) { m_CountedHalted = halted; }
+
+    // Checkpointing: exact copy of the vehicle state
+    void Save(BinaryWriter& writer) const;
+    bool Load(BinaryReader& reader);
+
 private:
-    int m_Id;
-    glm::vec3 m_Position;
-    glm::vec3 m_Velocity;
-    glm::vec3 m_Direction = glm::vec3(0.0f, 0.0f, 1.0f); // Default forward
+    std::vector<int> m_NodePath;    // Route as node IDs
+    std::vector<int32_t> m_Corridor;  // Cells still to be refined into m_NodePath (hierarchical routes)
+    int32_t m_GoalNodeId = -1;        // Destination beyond the end of m_NodePath, -1 once fully planned
+    uint32_t m_CorridorIndex = 0;
+    std::vector<uint32_t> m_StopPathIndices;  // Scheduled stops, empty for cars
+    uint32_t m_StopsReached = 0;
+    float m_DwellTime = 0.0f;
+    float m_DwellTimer = 0.0f;                 // Seconds left at the current stop
+    int32_t m_Id;
+    int32_t m_CurrentEdgeId = -1;
+    uint32_t m_PathIndex = 0;
+    float m_Offset = 0.0f;
     float m_Speed = 5.0f;  // Units per second
+    float m_BlockedTimer = 0.0f; // Timer for "Wait then Pass" logic
+    float m_EdgeTime = 0.0f;
+    uint8_t m_Lane = 0;    // Roads have one lane per direction for now
     bool m_IsStopped = false;
-    
-    // Lifecycle
     bool m_DestinationReached = false;
-    float m_WaitTimer = 0.0f;
-    float m_BlockedTimer = 0.0f; // Timer for "Wait then Pass" logic
-    
-    std::vector<glm::vec3> m_Path;  // Waypoints to follow
-    std::vector<int> m_NodePath;    // Node IDs corresponding to waypoints
-    size_t m_CurrentWaypointIndex = 0;
+    bool m_CountedHalted = false;
 };
@@ -1,9 +1,25 @@
 #include <iostream>
 #include "Core/Application.h"
+#include "Core/CommandLine.h"
+#include "Core/Headless.h"
+#include "Core/Log.h"
 
-int main() {
-    Application* app = new Application();
+int main(int argc, char** argv) {
+    CommandLineArgs args = ParseCommandLine(argc, argv);
+    if (args.ensembleRuns > 0) {
+        int result = RunEnsemble(args);
+        Log::Shutdown();
+        return result;
+    }
+    if (args.headlessSeconds > 0.0f) {
+        int result = RunHeadless(args);
+        Log::Shutdown();
+        return result;
+    }
+    
+    Application* app = new Application(args);
     app->Run();
     delete app;
+    Log::Shutdown();
     return 0;
 }